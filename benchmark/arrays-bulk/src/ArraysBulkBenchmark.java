@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class ArraysBulkBenchmark {
+    public static final int LENGTH = 1024;
+
+    public static byte[] bytes1 = new byte[LENGTH];
+    public static byte[] bytes2 = new byte[LENGTH];
+    public static int[] ints1 = new int[LENGTH];
+    public static int[] ints2 = new int[LENGTH];
+
+    static {
+        for (int i = 0; i < LENGTH; ++i) {
+            bytes1[i] = bytes2[i] = (byte) i;
+            ints1[i] = ints2[i] = i;
+        }
+    }
+
+    public void timeFillByte(int count) {
+        byte[] array = new byte[LENGTH];
+        for (int i = 0; i < count; ++i) {
+            Arrays.fill(array, (byte) i);
+        }
+        if (count != 0 && array[LENGTH - 1] != (byte) (count - 1)) {
+            throw new AssertionError();
+        }
+    }
+
+    public void timeFillInt(int count) {
+        int[] array = new int[LENGTH];
+        for (int i = 0; i < count; ++i) {
+            Arrays.fill(array, i);
+        }
+        if (count != 0 && array[LENGTH - 1] != count - 1) {
+            throw new AssertionError();
+        }
+    }
+
+    public void timeEqualsByte(int count) {
+        byte[] a = bytes1;
+        byte[] b = bytes2;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += Arrays.equals(a, b) ? 1 : 0;  // Make sure the call is not optimized away.
+        }
+        if (sum != count) {
+            throw new AssertionError();
+        }
+    }
+
+    public void timeEqualsInt(int count) {
+        int[] a = ints1;
+        int[] b = ints2;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += Arrays.equals(a, b) ? 1 : 0;
+        }
+        if (sum != count) {
+            throw new AssertionError();
+        }
+    }
+
+    public void timeHashCodeInt(int count) {
+        int[] array = ints1;
+        int expected = Arrays.hashCode(array);
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += Arrays.hashCode(array);
+        }
+        if (sum != count * expected) {
+            throw new AssertionError();
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "jni.h"
+
+#include "class_linker.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace {
+
+static constexpr size_t kNumDescriptors = 1024u;
+
+// Written once by initDescriptors() before the lookup threads start.
+std::vector<std::string> boot_class_descriptors;
+std::vector<std::string> missing_descriptors;
+
+extern "C" JNIEXPORT void JNICALL Java_ClassTableBenchmark_initDescriptors(JNIEnv* env, jclass) {
+  ScopedObjectAccess soa(env);
+  if (!boot_class_descriptors.empty()) {
+    return;
+  }
+  ClassFuncVisitor visitor([](ObjPtr<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (klass->GetClassLoader() == nullptr && !klass->IsArrayClass()) {
+      std::string temp;
+      std::string descriptor = klass->GetDescriptor(&temp);
+      boot_class_descriptors.push_back(descriptor);
+      // Same length and package depth, but not a boot class.
+      missing_descriptors.push_back("Lbenchmark/" + descriptor.substr(1u));
+    }
+    return boot_class_descriptors.size() != kNumDescriptors;
+  });
+  Runtime::Current()->GetClassLinker()->VisitClasses(&visitor);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_ClassTableBenchmark_lookupBootClasses(
+    JNIEnv* env, jclass, jboolean missing, jint reps) {
+  ScopedObjectAccess soa(env);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  const std::vector<std::string>& descriptors =
+      missing ? missing_descriptors : boot_class_descriptors;
+  for (jint i = 0; i < reps; ++i) {
+    for (const std::string& descriptor : descriptors) {
+      ObjPtr<mirror::Class> klass =
+          class_linker->LookupClass(soa.Self(), descriptor.c_str(), /*class_loader=*/ nullptr);
+      CHECK_EQ(klass == nullptr, static_cast<bool>(missing)) << descriptor;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace art
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class ClassTableBenchmark {
+  public ClassTableBenchmark() {
+    // Make sure to link methods before benchmark starts.
+    System.loadLibrary("artbenchmark");
+    initDescriptors();
+  }
+
+  private static native void initDescriptors();
+  // Looks up the descriptors collected by initDescriptors() in the boot class table `reps`
+  // times. If `missing`, looks up descriptors that are not in the table instead.
+  private static native void lookupBootClasses(boolean missing, int reps);
+
+  private static void lookupOnThreads(int numThreads, final boolean missing, final int reps)
+      throws InterruptedException {
+    Thread[] threads = new Thread[numThreads];
+    for (int i = 0; i < numThreads; ++i) {
+      threads[i] = new Thread() {
+        public void run() {
+          lookupBootClasses(missing, reps);
+        }
+      };
+      threads[i].start();
+    }
+    for (Thread thread : threads) {
+      thread.join();
+    }
+  }
+
+  public void timeLookup1Thread(int reps) throws InterruptedException {
+    lookupOnThreads(1, false, reps);
+  }
+
+  public void timeLookup2Threads(int reps) throws InterruptedException {
+    lookupOnThreads(2, false, reps);
+  }
+
+  public void timeLookup4Threads(int reps) throws InterruptedException {
+    lookupOnThreads(4, false, reps);
+  }
+
+  public void timeLookup8Threads(int reps) throws InterruptedException {
+    lookupOnThreads(8, false, reps);
+  }
+
+  public void timeLookupMissing1Thread(int reps) throws InterruptedException {
+    lookupOnThreads(1, true, reps);
+  }
+
+  public void timeLookupMissing4Threads(int reps) throws InterruptedException {
+    lookupOnThreads(4, true, reps);
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include "jni.h"
+
+#include "base/bit_utils.h"
+#include "base/globals.h"
+#include "base/mem_map.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "image.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace {
+
+// One boot image component, compressed the same way as ImageWriter does it.
+struct CompressedImage {
+  size_t image_size;
+  std::vector<uint8_t> data;
+  std::vector<ImageHeader::Block> blocks;
+};
+
+std::vector<CompressedImage> CompressBootImage(uint32_t max_block_size) {
+  std::vector<CompressedImage> result;
+  for (gc::space::ImageSpace* space : Runtime::Current()->GetHeap()->GetBootImageSpaces()) {
+    const uint8_t* image_begin = space->Begin();
+    CompressedImage image;
+    image.image_size = space->GetImageHeader().GetImageSize();
+    uint32_t offset = sizeof(ImageHeader);
+    uint32_t size = image.image_size - sizeof(ImageHeader);
+    while (size != 0u) {
+      uint32_t cur_size = std::min(size, max_block_size);
+      if (cur_size != size) {
+        uint32_t aligned_end = RoundDown(offset + cur_size, kPageSize);
+        if (aligned_end > offset) {
+          cur_size = aligned_end - offset;
+        }
+      }
+      size_t data_offset = image.data.size();
+      image.data.resize(data_offset + LZ4_compressBound(cur_size));
+      size_t data_size = LZ4_compress_HC(reinterpret_cast<const char*>(image_begin + offset),
+                                         reinterpret_cast<char*>(image.data.data() + data_offset),
+                                         cur_size,
+                                         image.data.size() - data_offset,
+                                         LZ4HC_CLEVEL_MAX);
+      CHECK_NE(data_size, 0u);
+      image.data.resize(data_offset + data_size);
+      image.blocks.emplace_back(ImageHeader::kStorageModeLZ4HC,
+                                /*data_offset=*/ data_offset,
+                                /*data_size=*/ data_size,
+                                /*image_offset=*/ offset,
+                                /*image_size=*/ cur_size);
+      offset += cur_size;
+      size -= cur_size;
+    }
+    result.push_back(std::move(image));
+  }
+  return result;
+}
+
+// Same worker count as the runtime thread pool used by ImageSpace to decompress images.
+ThreadPool* GetThreadPool(Thread* self) {
+  static constexpr size_t kMaxRuntimeWorkers = 4u;
+  static constexpr size_t kStackSize = 64 * KB;
+  static ThreadPool* thread_pool = nullptr;
+  if (thread_pool == nullptr) {
+    const size_t num_workers =
+        std::min(static_cast<size_t>(std::thread::hardware_concurrency()), kMaxRuntimeWorkers);
+    thread_pool = new ThreadPool("Image decompress benchmark",
+                                 num_workers,
+                                 /*create_peers=*/ false,
+                                 kStackSize);
+    thread_pool->StartWorkers(self);
+  }
+  return thread_pool;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_ImageDecompressBenchmark_getBootImageSize(
+    JNIEnv*, jclass) {
+  size_t size = 0u;
+  for (gc::space::ImageSpace* space : Runtime::Current()->GetHeap()->GetBootImageSpaces()) {
+    size += space->GetImageHeader().GetImageSize();
+  }
+  return static_cast<jlong>(size);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_ImageDecompressBenchmark_decompressBootImage(
+    JNIEnv*, jclass, jint max_block_size, jboolean parallel, jint reps) {
+  static std::map<jint, std::vector<CompressedImage>> compressed_images;
+  auto it = compressed_images.find(max_block_size);
+  if (it == compressed_images.end()) {
+    it = compressed_images.emplace(max_block_size, CompressBootImage(max_block_size)).first;
+  }
+  const std::vector<CompressedImage>& images = it->second;
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = parallel ? GetThreadPool(self) : nullptr;
+  for (jint i = 0; i < reps; ++i) {
+    for (const CompressedImage& image : images) {
+      // Decompress into new memory so that page faults are included, as at boot.
+      std::string error_msg;
+      MemMap map = MemMap::MapAnonymous("image decompress benchmark",
+                                        image.image_size,
+                                        PROT_READ | PROT_WRITE,
+                                        /*low_4gb=*/ false,
+                                        &error_msg);
+      CHECK(map.IsValid()) << error_msg;
+      for (const ImageHeader::Block& block : image.blocks) {
+        auto function = [&map, &image, &block](Thread*) {
+          std::string block_error_msg;
+          CHECK(block.Decompress(map.Begin(), image.data.data(), &block_error_msg))
+              << block_error_msg;
+        };
+        if (thread_pool != nullptr) {
+          thread_pool->AddTask(self, new FunctionTask(std::move(function)));
+        } else {
+          function(self);
+        }
+      }
+      if (thread_pool != nullptr) {
+        thread_pool->Wait(self, /*do_work=*/ true, /*may_hold_locks=*/ false);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace art
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class ImageDecompressBenchmark {
+  private static final int KB = 1024;
+  private static final int MB = 1024 * KB;
+
+  public ImageDecompressBenchmark() {
+    // Make sure to link methods before benchmark starts.
+    System.loadLibrary("artbenchmark");
+    System.out.println("Boot image size: " + getBootImageSize());
+  }
+
+  // Decompresses the boot image compressed into blocks of at most `maxBlockSize` bytes,
+  // `reps` times. The compressed image is cached for each block size.
+  private static native void decompressBootImage(int maxBlockSize, boolean parallel, int reps);
+  private static native long getBootImageSize();
+
+  public void timeDecompress16K(int reps) {
+    decompressBootImage(16 * KB, true, reps);
+  }
+
+  public void timeDecompress64K(int reps) {
+    decompressBootImage(64 * KB, true, reps);
+  }
+
+  public void timeDecompress256K(int reps) {
+    decompressBootImage(256 * KB, true, reps);
+  }
+
+  public void timeDecompress512K(int reps) {
+    decompressBootImage(512 * KB, true, reps);
+  }
+
+  public void timeDecompress1M(int reps) {
+    decompressBootImage(1 * MB, true, reps);
+  }
+
+  public void timeDecompress4M(int reps) {
+    decompressBootImage(4 * MB, true, reps);
+  }
+
+  public void timeDecompressSolid(int reps) {
+    decompressBootImage(Integer.MAX_VALUE, true, reps);
+  }
+
+  public void timeDecompressSerial512K(int reps) {
+    decompressBootImage(512 * KB, false, reps);
+  }
+}
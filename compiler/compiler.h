@@ -17,10 +17,14 @@
 #ifndef ART_COMPILER_COMPILER_H_
 #define ART_COMPILER_COMPILER_H_
 
+#include <iosfwd>
+
+#include "base/array_ref.h"
 #include "base/mutex.h"
 #include "base/os.h"
 #include "compilation_kind.h"
 #include "dex/invoke_type.h"
+#include "dex/method_reference.h"
 
 namespace art {
 
@@ -44,6 +48,7 @@ class CompilerOptions;
 class DexFile;
 template<class T> class Handle;
 class Thread;
+class ThreadPool;
 
 class Compiler {
  public:
@@ -52,6 +57,16 @@ class Compiler {
     kOptimizing
   };
 
+  // Receives, for each method compiled successfully, the methods whose dex code the
+  // compiled code depends on because it was inlined or analyzed by the compiler.
+  class CodeDependencyRecorder {
+   public:
+    virtual ~CodeDependencyRecorder() {}
+
+    virtual void RecordCodeDependencies(MethodReference method,
+                                        ArrayRef<const MethodReference> dependencies) = 0;
+  };
+
   static Compiler* Create(const CompilerOptions& compiler_options,
                           CompiledMethodStorage* storage,
                           Kind kind);
@@ -85,12 +100,35 @@ class Compiler {
   virtual uintptr_t GetEntryPointOf(ArtMethod* method) const
      REQUIRES_SHARED(Locks::mutator_lock_) = 0;
 
+  // Returns the arenas kept across method compilations to the runtime's arena pool.
+  // Must not be called while methods are being compiled.
+  virtual void ReleaseArenaCaches() {}
+
+  // Returns the arenas kept for thread `self` to the runtime's arena pool.
+  // Must be called by `self` between method compilations.
+  virtual void ReleaseArenaCache(Thread* self ATTRIBUTE_UNUSED) {}
+
+  // Dumps statistics about the reuse of arenas across method compilations.
+  virtual void DumpArenaCacheStats(std::ostream& os ATTRIBUTE_UNUSED) const {}
+
   uint64_t GetMaximumCompilationTimeBeforeWarning() const {
     return maximum_compilation_time_before_warning_;
   }
 
   virtual ~Compiler() {}
 
+  // Sets the thread pool the compiler may use to parallelize the analysis of a single large
+  // method. The pool is not owned and must outlive any compilation that uses it.
+  void SetThreadPool(ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
+  // Sets the recorder of the code dependencies of compiled methods. The recorder is not
+  // owned and must outlive any compilation that uses it.
+  void SetCodeDependencyRecorder(CodeDependencyRecorder* recorder) {
+    code_dependency_recorder_ = recorder;
+  }
+
   // Returns whether the method to compile is such a pathological case that
   // it's not worth compiling.
   static bool IsPathologicalCase(const dex::CodeItem& code_item,
@@ -103,7 +141,9 @@ class Compiler {
            uint64_t warning) :
       compiler_options_(compiler_options),
       storage_(storage),
-      maximum_compilation_time_before_warning_(warning) {
+      maximum_compilation_time_before_warning_(warning),
+      thread_pool_(nullptr),
+      code_dependency_recorder_(nullptr) {
   }
 
   const CompilerOptions& GetCompilerOptions() const {
@@ -114,10 +154,20 @@ class Compiler {
     return storage_;
   }
 
+  ThreadPool* GetThreadPool() const {
+    return thread_pool_;
+  }
+
+  CodeDependencyRecorder* GetCodeDependencyRecorder() const {
+    return code_dependency_recorder_;
+  }
+
  private:
   const CompilerOptions& compiler_options_;
   CompiledMethodStorage* const storage_;
   const uint64_t maximum_compilation_time_before_warning_;
+  ThreadPool* thread_pool_;
+  CodeDependencyRecorder* code_dependency_recorder_;
 
   DISALLOW_COPY_AND_ASSIGN(Compiler);
 };
@@ -15,6 +15,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <ostream>
 
 #include "compiled_method_storage.h"
@@ -34,19 +35,26 @@ namespace art {
 namespace {  // anonymous namespace
 
 template <typename T>
-const LengthPrefixedArray<T>* CopyArray(SwapSpace* swap_space, const ArrayRef<const T>& array) {
+const LengthPrefixedArray<T>* CopyArray(SwapSpace* swap_space,
+                                        std::atomic<size_t>* stored_bytes,
+                                        const ArrayRef<const T>& array) {
   DCHECK(!array.empty());
   SwapAllocator<uint8_t> allocator(swap_space);
-  void* storage = allocator.allocate(LengthPrefixedArray<T>::ComputeSize(array.size()));
+  size_t size = LengthPrefixedArray<T>::ComputeSize(array.size());
+  stored_bytes->fetch_add(size, std::memory_order_relaxed);
+  void* storage = allocator.allocate(size);
   LengthPrefixedArray<T>* array_copy = new(storage) LengthPrefixedArray<T>(array.size());
   std::copy(array.begin(), array.end(), array_copy->begin());
   return array_copy;
 }
 
 template <typename T>
-void ReleaseArray(SwapSpace* swap_space, const LengthPrefixedArray<T>* array) {
+void ReleaseArray(SwapSpace* swap_space,
+                  std::atomic<size_t>* stored_bytes,
+                  const LengthPrefixedArray<T>* array) {
   SwapAllocator<uint8_t> allocator(swap_space);
   size_t size = LengthPrefixedArray<T>::ComputeSize(array->size());
+  stored_bytes->fetch_sub(size, std::memory_order_relaxed);
   array->~LengthPrefixedArray<T>();
   allocator.deallocate(const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(array)), size);
 }
@@ -60,7 +68,7 @@ inline const LengthPrefixedArray<T>* CompiledMethodStorage::AllocateOrDeduplicat
   if (data.empty()) {
     return nullptr;
   } else if (!DedupeEnabled()) {
-    return CopyArray(swap_space_.get(), data);
+    return CopyArray(swap_space_.get(), &stored_bytes_, data);
   } else {
     return dedupe_set->Add(Thread::Current(), data);
   }
@@ -70,7 +78,7 @@ template <typename T>
 inline void CompiledMethodStorage::ReleaseArrayIfNotDeduplicated(
     const LengthPrefixedArray<T>* array) {
   if (array != nullptr && !DedupeEnabled()) {
-    ReleaseArray(swap_space_.get(), array);
+    ReleaseArray(swap_space_.get(), &stored_bytes_, array);
   }
 }
 
@@ -88,20 +96,21 @@ class CompiledMethodStorage::DedupeHashFunc {
 template <typename T>
 class CompiledMethodStorage::LengthPrefixedArrayAlloc {
  public:
-  explicit LengthPrefixedArrayAlloc(SwapSpace* swap_space)
-      : swap_space_(swap_space) {
+  LengthPrefixedArrayAlloc(SwapSpace* swap_space, std::atomic<size_t>* stored_bytes)
+      : swap_space_(swap_space), stored_bytes_(stored_bytes) {
   }
 
   const LengthPrefixedArray<T>* Copy(const ArrayRef<const T>& array) {
-    return CopyArray(swap_space_, array);
+    return CopyArray(swap_space_, stored_bytes_, array);
   }
 
   void Destroy(const LengthPrefixedArray<T>* array) {
-    ReleaseArray(swap_space_, array);
+    ReleaseArray(swap_space_, stored_bytes_, array);
   }
 
  private:
   SwapSpace* const swap_space_;
+  std::atomic<size_t>* const stored_bytes_;
 };
 
 class CompiledMethodStorage::ThunkMapKey {
@@ -146,13 +155,17 @@ class CompiledMethodStorage::ThunkMapValue {
 
 CompiledMethodStorage::CompiledMethodStorage(int swap_fd)
     : swap_space_(swap_fd == -1 ? nullptr : new SwapSpace(swap_fd, 10 * MB)),
+      stored_bytes_(0u),
       dedupe_enabled_(true),
-      dedupe_code_("dedupe code", LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get())),
+      dedupe_code_("dedupe code",
+                   LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get(), &stored_bytes_)),
       dedupe_vmap_table_("dedupe vmap table",
-                         LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get())),
-      dedupe_cfi_info_("dedupe cfi info", LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get())),
-      dedupe_linker_patches_("dedupe cfi info",
-                             LengthPrefixedArrayAlloc<linker::LinkerPatch>(swap_space_.get())),
+                         LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get(), &stored_bytes_)),
+      dedupe_cfi_info_("dedupe cfi info",
+                       LengthPrefixedArrayAlloc<uint8_t>(swap_space_.get(), &stored_bytes_)),
+      dedupe_linker_patches_(
+          "dedupe cfi info",
+          LengthPrefixedArrayAlloc<linker::LinkerPatch>(swap_space_.get(), &stored_bytes_)),
       thunk_map_lock_("thunk_map_lock"),
       thunk_map_(std::less<ThunkMapKey>(), SwapAllocator<ThunkMapValueType>(swap_space_.get())) {
 }
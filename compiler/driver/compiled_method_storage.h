@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_DRIVER_COMPILED_METHOD_STORAGE_H_
 #define ART_COMPILER_DRIVER_COMPILED_METHOD_STORAGE_H_
 
+#include <atomic>
 #include <iosfwd>
 #include <map>
 #include <memory>
@@ -51,6 +52,16 @@ class CompiledMethodStorage {
     return SwapAllocator<void>(swap_space_.get());
   }
 
+  bool UsesSwapSpace() const {
+    return swap_space_ != nullptr;
+  }
+
+  // Returns the size of the code, vmap tables, CFI and linker patches currently stored,
+  // whether in memory or in the swap space.
+  size_t GetStoredBytes() const {
+    return stored_bytes_.load(std::memory_order_relaxed);
+  }
+
   const LengthPrefixedArray<uint8_t>* DeduplicateCode(const ArrayRef<const uint8_t>& code);
   void ReleaseCode(const LengthPrefixedArray<uint8_t>* code);
 
@@ -113,6 +124,9 @@ class CompiledMethodStorage {
   // as other fields rely on this.
   std::unique_ptr<SwapSpace> swap_space_;
 
+  // Updated by the array allocators used by the deduplication sets below.
+  std::atomic<size_t> stored_bytes_;
+
   bool dedupe_enabled_;
 
   ArrayDedupeSet<uint8_t> dedupe_code_;
@@ -76,11 +76,15 @@ CompilerOptions::CompilerOptions()
       check_linkage_conditions_(false),
       crash_on_linkage_violation_(false),
       deduplicate_code_(true),
+      cold_block_layout_(true),
+      profile_code_layout_(false),
+      deduplicate_across_images_(false),
       count_hotness_in_compiled_code_(false),
       resolve_startup_const_strings_(false),
       initialize_app_image_classes_(false),
       check_profiled_methods_(ProfileMethodsCheck::kNone),
       max_image_block_size_(std::numeric_limits<uint32_t>::max()),
+      image_compression_level_(kMaxImageCompressionLevel),
       register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
       passes_to_run_(nullptr) {
 }
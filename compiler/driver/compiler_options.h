@@ -67,6 +67,8 @@ class CompilerOptions final {
   static const bool kDefaultGenerateMiniDebugInfo = true;
   static const size_t kDefaultInlineMaxCodeUnits = 32;
   static constexpr size_t kUnsetInlineMaxCodeUnits = -1;
+  // Same as LZ4HC_CLEVEL_MAX, the default image compression level.
+  static constexpr uint32_t kMaxImageCompressionLevel = 12u;
 
   enum class CompilerType : uint8_t {
     kAotCompiler,             // AOT compiler.
@@ -349,6 +351,18 @@ class CompilerOptions final {
     return dump_stats_;
   }
 
+  bool ColdBlockLayout() const {
+    return cold_block_layout_;
+  }
+
+  bool ProfileCodeLayout() const {
+    return profile_code_layout_;
+  }
+
+  bool DeduplicateAcrossImages() const {
+    return deduplicate_across_images_;
+  }
+
   bool CountHotnessInCompiledCode() const {
     return count_hotness_in_compiled_code_;
   }
@@ -369,6 +383,14 @@ class CompilerOptions final {
     max_image_block_size_ = size;
   }
 
+  uint32_t GetImageCompressionLevel() const {
+    return image_compression_level_;
+  }
+
+  void SetImageCompressionLevel(uint32_t level) {
+    image_compression_level_ = level;
+  }
+
   bool InitializeAppImageClasses() const {
     return initialize_app_image_classes_;
   }
@@ -457,6 +479,17 @@ class CompilerOptions final {
   // Whether code should be deduplicated.
   bool deduplicate_code_;
 
+  // Whether blocks that always end in a throw should be laid out after the hot code.
+  bool cold_block_layout_;
+
+  // Whether the oat writer orders compiled methods by the profile's startup and hot methods
+  // and the calls between them, rather than only binning them by hotness flags.
+  bool profile_code_layout_;
+
+  // Whether a multi-image boot image compilation may point compiled methods at an identical
+  // CodeInfo in an earlier oat file instead of writing it again.
+  bool deduplicate_across_images_;
+
   // Whether compiled code should increment the hotness count of ArtMethod. Note that the increments
   // won't be atomic for performance reasons, so we accept races, just like in interpreter.
   bool count_hotness_in_compiled_code_;
@@ -475,6 +508,9 @@ class CompilerOptions final {
   // Maximum solid block size in the generated image.
   uint32_t max_image_block_size_;
 
+  // LZ4HC compression level for the generated image.
+  uint32_t image_compression_level_;
+
   RegisterAllocator::Strategy register_allocation_strategy_;
 
   // If not null, specifies optimization passes which will be run instead of defaults.
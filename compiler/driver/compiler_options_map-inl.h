@@ -88,6 +88,9 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
   }
   map.AssignIfExists(Base::VerboseMethods, &options->verbose_methods_);
   options->deduplicate_code_ = map.GetOrDefault(Base::DeduplicateCode);
+  options->cold_block_layout_ = map.GetOrDefault(Base::ColdBlockLayout);
+  options->profile_code_layout_ = map.GetOrDefault(Base::ProfileCodeLayout);
+  options->deduplicate_across_images_ = map.GetOrDefault(Base::DeduplicateAcrossImages);
   if (map.Exists(Base::CountHotnessInCompiledCode)) {
     options->count_hotness_in_compiled_code_ = true;
   }
@@ -97,6 +100,15 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
     options->check_profiled_methods_ = *map.Get(Base::CheckProfiledMethods);
   }
   map.AssignIfExists(Base::MaxImageBlockSize, &options->max_image_block_size_);
+  if (map.Exists(Base::ImageCompressionLevel)) {
+    uint32_t level = *map.Get(Base::ImageCompressionLevel);
+    if (level == 0u || level > CompilerOptions::kMaxImageCompressionLevel) {
+      *error_msg = android::base::StringPrintf("--image-compression-level must be between 1 and %u",
+                                               CompilerOptions::kMaxImageCompressionLevel);
+      return false;
+    }
+    options->image_compression_level_ = level;
+  }
 
   if (map.Exists(Base::DumpTimings)) {
     options->dump_timings_ = true;
@@ -175,6 +187,30 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
                     "symbol tagged with [DEDUPED].")
           .IntoKey(Map::DeduplicateCode)
 
+      .Define({"--cold-block-layout=_"})
+          .template WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .WithHelp("enable|disable moving blocks that always end in a throw after the hot code\n"
+                    "of each compiled method. Enabled by default.")
+          .IntoKey(Map::ColdBlockLayout)
+
+      .Define({"--profile-code-layout=_"})
+          .template WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .WithHelp("enable|disable laying out the compiled code of startup methods together,\n"
+                    "approximately in the order they first run, followed by the other hot\n"
+                    "methods grouped with their callees. Requires a profile. Disabled by default.")
+          .IntoKey(Map::ProfileCodeLayout)
+
+      .Define({"--deduplicate-across-images=_"})
+          .template WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .WithHelp("enable|disable sharing the CodeInfo of compiled methods with identical\n"
+                    "CodeInfo already written to an earlier oat file of a multi-image boot image.\n"
+                    "Tools that open one such oat file on its own cannot decode the shared\n"
+                    "CodeInfo. Disabled by default.")
+          .IntoKey(Map::DeduplicateAcrossImages)
+
       .Define({"--count-hotness-in-compiled-code"})
           .IntoKey(Map::CountHotnessInCompiledCode)
 
@@ -254,8 +290,16 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
 
       .Define("--max-image-block-size=_")
           .template WithType<unsigned int>()
-          .WithHelp("Maximum solid block size for compressed images.")
-          .IntoKey(Map::MaxImageBlockSize);
+          .WithHelp("Maximum solid block size for compressed images. Blocks are decompressed\n"
+                    "in parallel when the image is loaded, and block boundaries are rounded\n"
+                    "down to page boundaries when the block size allows it.")
+          .IntoKey(Map::MaxImageBlockSize)
+
+      .Define("--image-compression-level=_")
+          .template WithType<unsigned int>()
+          .WithHelp("Compression level for --image-format=lz4hc, from 1 (fastest) to 12\n"
+                    "(smallest, the default). Ignored for other image formats.")
+          .IntoKey(Map::ImageCompressionLevel);
 }
 
 #pragma GCC diagnostic pop
@@ -4470,6 +4470,10 @@ void CodeGeneratorARM64::MaybeGenerateInlineCacheCheck(HInstruction* instruction
     uint64_t address = reinterpret_cast64<uint64_t>(cache);
     vixl::aarch64::Label done;
     __ Mov(x8, address);
+    // Count the call site execution, used by the inliner to prioritize hot call sites.
+    __ Ldr(w9, MemOperand(x8, InlineCache::CountOffset().Int32Value()));
+    __ Add(w9, w9, 1);
+    __ Str(w9, MemOperand(x8, InlineCache::CountOffset().Int32Value()));
     __ Ldr(x9, MemOperand(x8, InlineCache::ClassesOffset().Int32Value()));
     // Fast path for a monomorphic cache.
     __ Cmp(klass, x9);
@@ -3522,6 +3522,10 @@ void CodeGeneratorARMVIXL::MaybeGenerateInlineCacheCheck(HInstruction* instructi
     UseScratchRegisterScope temps(GetVIXLAssembler());
     temps.Exclude(ip);
     __ Mov(r4, address);
+    // Count the call site execution, used by the inliner to prioritize hot call sites.
+    __ Ldr(ip, MemOperand(r4, InlineCache::CountOffset().Int32Value()));
+    __ Add(ip, ip, 1);
+    __ Str(ip, MemOperand(r4, InlineCache::CountOffset().Int32Value()));
     __ Ldr(ip, MemOperand(r4, InlineCache::ClassesOffset().Int32Value()));
     // Fast path for a monomorphic cache.
     __ Cmp(klass, ip);
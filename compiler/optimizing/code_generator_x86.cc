@@ -2659,6 +2659,8 @@ void CodeGeneratorX86::MaybeGenerateInlineCacheCheck(HInstruction* instruction,
     Register temp = EBP;
     NearLabel done;
     __ movl(temp, Immediate(address));
+    // Count the call site execution, used by the inliner to prioritize hot call sites.
+    __ addl(Address(temp, InlineCache::CountOffset().Int32Value()), Immediate(1));
     // Fast path for a monomorphic cache.
     __ cmpl(klass, Address(temp, InlineCache::ClassesOffset().Int32Value()));
     __ j(kEqual, &done);
@@ -2909,6 +2909,8 @@ void CodeGeneratorX86_64::MaybeGenerateInlineCacheCheck(HInstruction* instructio
     uint64_t address = reinterpret_cast64<uint64_t>(cache);
     NearLabel done;
     __ movq(CpuRegister(TMP), Immediate(address));
+    // Count the call site execution, used by the inliner to prioritize hot call sites.
+    __ addl(Address(CpuRegister(TMP), InlineCache::CountOffset().Int32Value()), Immediate(1));
     // Fast path for a monomorphic cache.
     __ cmpl(Address(CpuRegister(TMP), InlineCache::ClassesOffset().Int32Value()), klass);
     __ j(kEqual, &done);
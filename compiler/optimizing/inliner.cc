@@ -16,6 +16,8 @@
 
 #include "inliner.h"
 
+#include <algorithm>
+
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/logging.h"
@@ -163,46 +165,128 @@ bool HInliner::Run() {
   const bool honor_inline_directives =
       honor_noinline_directives && Runtime::Current()->IsAotCompiler();
 
-  // Keep a copy of all blocks when starting the visit.
-  ArenaVector<HBasicBlock*> blocks = graph_->GetReversePostOrder();
-  DCHECK(!blocks.empty());
-  // Because we are changing the graph when inlining,
-  // we just iterate over the blocks of the outer method.
-  // This avoids doing the inlining work again on the inlined blocks.
-  for (HBasicBlock* block : blocks) {
-    for (HInstruction* instruction = block->GetFirstInstruction(); instruction != nullptr;) {
-      HInstruction* next = instruction->GetNext();
-      HInvoke* call = instruction->AsInvoke();
+  // Because we are changing the graph when inlining, we collect the invokes
+  // of the outer method before starting the visit. This avoids doing the
+  // inlining work again on the inlined blocks.
+  ArenaVector<HInvoke*> invokes(graph_->GetAllocator()->Adapter(kArenaAllocOptimization));
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInvoke* call = it.Current()->AsInvoke();
       // As long as the call is not intrinsified, it is worth trying to inline.
       if (call != nullptr && call->GetIntrinsic() == Intrinsics::kNone) {
-        if (honor_noinline_directives) {
-          // Debugging case: directives in method names control or assert on inlining.
-          std::string callee_name =
-              call->GetMethodReference().PrettyMethod(/* with_signature= */ false);
-          // Tests prevent inlining by having $noinline$ in their method names.
-          if (callee_name.find("$noinline$") == std::string::npos) {
-            if (TryInline(call)) {
-              didInline = true;
-            } else if (honor_inline_directives) {
-              bool should_have_inlined = (callee_name.find("$inline$") != std::string::npos);
-              CHECK(!should_have_inlined) << "Could not inline " << callee_name;
-            }
-          }
-        } else {
-          DCHECK(!honor_inline_directives);
-          // Normal case: try to inline.
-          if (TryInline(call)) {
-            didInline = true;
-          }
+        invokes.push_back(call);
+      }
+    }
+  }
+  // Let the call sites that run most often spend the inlining budget first.
+  ArenaVector<uint32_t> counts(graph_->GetAllocator()->Adapter(kArenaAllocOptimization));
+  SortInvokesByCount(&invokes, &counts);
+
+  for (size_t i = 0, size = invokes.size(); i != size; ++i) {
+    HInvoke* call = invokes[i];
+    DCHECK(call->IsInBlock());
+    size_t number_of_instructions_before = total_number_of_instructions_;
+    bool inlined = false;
+    if (honor_noinline_directives) {
+      // Debugging case: directives in method names control or assert on inlining.
+      std::string callee_name =
+          call->GetMethodReference().PrettyMethod(/* with_signature= */ false);
+      // Tests prevent inlining by having $noinline$ in their method names.
+      if (callee_name.find("$noinline$") == std::string::npos) {
+        inlined = TryInline(call);
+        if (!inlined && honor_inline_directives) {
+          bool should_have_inlined = (callee_name.find("$inline$") != std::string::npos);
+          CHECK(!should_have_inlined) << "Could not inline " << callee_name;
         }
       }
-      instruction = next;
+    } else {
+      DCHECK(!honor_inline_directives);
+      // Normal case: try to inline.
+      inlined = TryInline(call);
+    }
+    if (inlined) {
+      didInline = true;
+      if (!counts.empty() && counts[i] != 0u) {
+        MaybeRecordStat(stats_, MethodCompilationStat::kInlinedProfiledCallSite);
+        MaybeRecordStat(stats_,
+                        MethodCompilationStat::kInliningBudgetUsedByProfiledCallSites,
+                        total_number_of_instructions_ - number_of_instructions_before);
+      }
     }
   }
 
   return didInline;
 }
 
+void HInliner::SortInvokesByCount(/*inout*/ ArenaVector<HInvoke*>* invokes,
+                                  /*out*/ ArenaVector<uint32_t>* counts) {
+  DCHECK(counts->empty());
+  if (invokes->size() < 2u) {
+    return;
+  }
+
+  // Find the call site counts of the method being compiled. The Zygote JIT compiles
+  // based on a profile, like the AOT compiler, see TryInlineFromInlineCache.
+  const ProfileCompilationInfo::InlineCacheMap* inline_caches = nullptr;
+  ProfilingInfo* profiling_info = nullptr;
+  if (Runtime::Current()->IsAotCompiler() || Runtime::Current()->IsZygote()) {
+    const ProfileCompilationInfo* pci =
+        codegen_->GetCompilerOptions().GetProfileCompilationInfo();
+    if (pci == nullptr) {
+      return;
+    }
+    ProfileCompilationInfo::MethodHotness hotness = pci->GetMethodHotness(MethodReference(
+        caller_compilation_unit_.GetDexFile(), caller_compilation_unit_.GetDexMethodIndex()));
+    if (!hotness.IsHot()) {
+      return;
+    }
+    inline_caches = hotness.GetInlineCacheMap();
+  } else {
+    profiling_info = graph_->GetProfilingInfo();
+    if (profiling_info == nullptr) {
+      return;
+    }
+  }
+
+  size_t number_of_counted_call_sites = 0u;
+  ArenaVector<std::pair<uint32_t, HInvoke*>> counted_invokes(
+      graph_->GetAllocator()->Adapter(kArenaAllocOptimization));
+  counted_invokes.reserve(invokes->size());
+  for (HInvoke* invoke : *invokes) {
+    uint32_t count = 0u;
+    if (inline_caches != nullptr) {
+      auto it = inline_caches->find(invoke->GetDexPc());
+      count = (it != inline_caches->end()) ? it->second.invoke_count : 0u;
+    } else {
+      count = profiling_info->GetInvokeCount(invoke->GetDexPc());
+    }
+    if (count != 0u) {
+      ++number_of_counted_call_sites;
+    }
+    counted_invokes.emplace_back(count, invoke);
+  }
+  if (number_of_counted_call_sites == 0u) {
+    return;
+  }
+  MaybeRecordStat(stats_,
+                  MethodCompilationStat::kProfiledCallSite,
+                  number_of_counted_call_sites);
+
+  // Hottest call sites first. Call sites without counts, such as static and direct
+  // calls which have no inline cache, keep their relative order after the counted ones.
+  std::stable_sort(counted_invokes.begin(),
+                   counted_invokes.end(),
+                   [](const std::pair<uint32_t, HInvoke*>& lhs,
+                      const std::pair<uint32_t, HInvoke*>& rhs) {
+                     return lhs.first > rhs.first;
+                   });
+  counts->reserve(counted_invokes.size());
+  for (size_t i = 0, size = counted_invokes.size(); i != size; ++i) {
+    counts->push_back(counted_invokes[i].first);
+    (*invokes)[i] = counted_invokes[i].second;
+  }
+}
+
 static bool IsMethodOrDeclaringClassFinal(ArtMethod* method)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   return method->IsFinal() || method->GetDeclaringClass()->IsFinal();
@@ -490,6 +574,7 @@ bool HInliner::TryInline(HInvoke* invoke_instruction) {
       // target.
       if (AlwaysThrows(actual_method)) {
         invoke_to_analyze->SetAlwaysThrows(true);
+        RecordCodeDependency(actual_method);
       }
     }
     return result;
@@ -1481,6 +1566,7 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
       LOG_SUCCESS() << "Successfully replaced pattern of invoke "
                     << method->PrettyMethod();
       MaybeRecordStat(stats_, MethodCompilationStat::kReplacedInvokeWithSimplePattern);
+      RecordCodeDependency(method);
       return true;
     }
     LOG_FAIL(stats_, MethodCompilationStat::kNotInlinedWont)
@@ -1512,12 +1598,19 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
 
   LOG_SUCCESS() << method->PrettyMethod();
   MaybeRecordStat(stats_, MethodCompilationStat::kInlinedInvoke);
+  RecordCodeDependency(method);
   if (outermost_graph_ == graph_) {
     MaybeRecordStat(stats_, MethodCompilationStat::kInlinedLastInvoke);
   }
   return true;
 }
 
+void HInliner::RecordCodeDependency(ArtMethod* method) {
+  // Record the dependency in the outermost graph, it is the one being compiled.
+  outermost_graph_->AddCodeDependency(
+      MethodReference(method->GetDexFile(), method->GetDexMethodIndex()));
+}
+
 static HInstruction* GetInvokeInputForArgVRegIndex(HInvoke* invoke_instruction,
                                                    size_t arg_vreg_index)
     REQUIRES_SHARED(Locks::mutator_lock_) {
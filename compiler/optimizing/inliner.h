@@ -72,6 +72,12 @@ class HInliner : public HOptimization {
 
   bool TryInline(HInvoke* invoke_instruction);
 
+  // Reorder `invokes` by decreasing execution count of the call sites, as recorded
+  // in the JIT profiling info or the AOT profile, and store the matching counts
+  // in `counts`. Leaves `invokes` untouched and `counts` empty if there are no counts.
+  void SortInvokesByCount(/*inout*/ ArenaVector<HInvoke*>* invokes,
+                          /*out*/ ArenaVector<uint32_t>* counts);
+
   // Try to inline `resolved_method` in place of `invoke_instruction`. `do_rtp` is whether
   // reference type propagation can run after the inlining. If the inlining is successful, this
   // method will replace and remove the `invoke_instruction`.
@@ -87,6 +93,10 @@ class HInliner : public HOptimization {
                          HInstruction** return_replacement)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Record that the code generated for the outermost graph depends on the dex code
+  // of `method`, either because it was inlined or because it was analyzed.
+  void RecordCodeDependency(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+
   bool TryBuildAndInlineHelper(HInvoke* invoke_instruction,
                                ArtMethod* resolved_method,
                                ReferenceTypeInfo receiver_type,
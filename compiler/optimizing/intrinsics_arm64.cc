@@ -64,6 +64,7 @@ using helpers::XRegisterFrom;
 using helpers::HRegisterFrom;
 using helpers::InputRegisterAt;
 using helpers::OutputRegister;
+using helpers::QRegisterFrom;
 
 namespace {
 
@@ -2805,6 +2806,290 @@ void IntrinsicCodeGeneratorARM64::VisitSystemArrayCopyChar(HInvoke* invoke) {
   __ Bind(slow_path->GetExitLabel());
 }
 
+// Arrays.fill(), Arrays.equals() and Arrays.hashCode() process 16 bytes per iteration with
+// NEON, followed by a scalar loop for the remaining elements.
+static constexpr size_t kArraysVectorSize = 16u;
+
+static void CreateArraysFillLocations(ArenaAllocator* allocator, HInvoke* invoke) {
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke,
+                                      invoke->InputAt(0)->CanBeNull()
+                                          ? LocationSummary::kCallOnSlowPath
+                                          : LocationSummary::kNoCall,
+                                      kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+static void GenerateArraysFill(HInvoke* invoke,
+                               CodeGeneratorARM64* codegen,
+                               DataType::Type type) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register array = WRegisterFrom(locations->InAt(0));
+  Register value = WRegisterFrom(locations->InAt(1));
+  Register length = WRegisterFrom(locations->GetTemp(0));
+  Register address = XRegisterFrom(locations->GetTemp(1));
+  VRegister vector = QRegisterFrom(locations->GetTemp(2));
+
+  const size_t element_size = DataType::Size(type);
+  const int32_t elements_per_vector = kArraysVectorSize / element_size;
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+
+  SlowPathCodeARM64* slow_path = nullptr;
+  if (invoke->InputAt(0)->CanBeNull()) {
+    // Let the called method throw the NullPointerException.
+    slow_path = new (codegen->GetScopedAllocator()) IntrinsicSlowPathARM64(invoke);
+    codegen->AddSlowPath(slow_path);
+    __ Cbz(array, slow_path->GetEntryLabel());
+  }
+
+  vixl::aarch64::Label vector_loop, scalar_tail, scalar_loop, done;
+  __ Ldr(length, MemOperand(array.X(), length_offset));
+  __ Add(address, array.X(), data_offset);
+  if (type == DataType::Type::kInt8) {
+    __ Dup(vector.V16B(), value);
+  } else {
+    DCHECK_EQ(type, DataType::Type::kInt32);
+    __ Dup(vector.V4S(), value);
+  }
+
+  __ Subs(length, length, elements_per_vector);
+  __ B(lt, &scalar_tail);
+  __ Bind(&vector_loop);
+  __ Str(vector, MemOperand(address, kArraysVectorSize, PostIndex));
+  __ Subs(length, length, elements_per_vector);
+  __ B(ge, &vector_loop);
+
+  __ Bind(&scalar_tail);
+  __ Adds(length, length, elements_per_vector);
+  __ B(eq, &done);
+  __ Bind(&scalar_loop);
+  if (type == DataType::Type::kInt8) {
+    __ Strb(value, MemOperand(address, element_size, PostIndex));
+  } else {
+    __ Str(value, MemOperand(address, element_size, PostIndex));
+  }
+  __ Subs(length, length, 1);
+  __ B(ne, &scalar_loop);
+  __ Bind(&done);
+
+  if (slow_path != nullptr) {
+    __ Bind(slow_path->GetExitLabel());
+  }
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysFillByte(HInvoke* invoke) {
+  CreateArraysFillLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysFillByte(HInvoke* invoke) {
+  GenerateArraysFill(invoke, codegen_, DataType::Type::kInt8);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysFillInt(HInvoke* invoke) {
+  CreateArraysFillLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysFillInt(HInvoke* invoke) {
+  GenerateArraysFill(invoke, codegen_, DataType::Type::kInt32);
+}
+
+static void CreateArraysEqualsLocations(ArenaAllocator* allocator, HInvoke* invoke) {
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke, LocationSummary::kNoCall, kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+static void GenerateArraysEquals(HInvoke* invoke,
+                                 CodeGeneratorARM64* codegen,
+                                 DataType::Type type) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register array1 = WRegisterFrom(locations->InAt(0));
+  Register array2 = WRegisterFrom(locations->InAt(1));
+  Register length = WRegisterFrom(locations->GetTemp(0));
+  Register address1 = XRegisterFrom(locations->GetTemp(1));
+  Register address2 = XRegisterFrom(locations->GetTemp(2));
+  VRegister vector1 = QRegisterFrom(locations->GetTemp(3));
+  VRegister vector2 = QRegisterFrom(locations->GetTemp(4));
+  Register out = WRegisterFrom(locations->Out());
+
+  UseScratchRegisterScope temps(masm);
+  Register temp = temps.AcquireW();
+
+  const size_t element_size = DataType::Size(type);
+  const int32_t elements_per_vector = kArraysVectorSize / element_size;
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+
+  vixl::aarch64::Label vector_loop, scalar_tail, scalar_loop, return_true, return_false, done;
+
+  // The same array (or both null) is equal to itself.
+  __ Cmp(array1, array2);
+  __ B(eq, &return_true);
+  __ Cbz(array1, &return_false);
+  __ Cbz(array2, &return_false);
+  __ Ldr(length, MemOperand(array1.X(), length_offset));
+  __ Ldr(temp, MemOperand(array2.X(), length_offset));
+  __ Cmp(length, temp);
+  __ B(ne, &return_false);
+  __ Add(address1, array1.X(), data_offset);
+  __ Add(address2, array2.X(), data_offset);
+
+  // Compare 16 bytes at a time. All the bytes must match, whatever the element type.
+  __ Subs(length, length, elements_per_vector);
+  __ B(lt, &scalar_tail);
+  __ Bind(&vector_loop);
+  __ Ldr(vector1, MemOperand(address1, kArraysVectorSize, PostIndex));
+  __ Ldr(vector2, MemOperand(address2, kArraysVectorSize, PostIndex));
+  __ Cmeq(vector1.V16B(), vector1.V16B(), vector2.V16B());
+  // The minimum lane is 0xff only if all the bytes are equal.
+  __ Uminv(vector1.B(), vector1.V16B());
+  __ Umov(temp, vector1.V16B(), 0);
+  __ Cbz(temp, &return_false);
+  __ Subs(length, length, elements_per_vector);
+  __ B(ge, &vector_loop);
+
+  __ Bind(&scalar_tail);
+  __ Adds(length, length, elements_per_vector);
+  __ B(eq, &return_true);
+  __ Bind(&scalar_loop);
+  if (type == DataType::Type::kInt8) {
+    __ Ldrb(temp, MemOperand(address1, element_size, PostIndex));
+    __ Ldrb(out, MemOperand(address2, element_size, PostIndex));
+  } else {
+    DCHECK_EQ(type, DataType::Type::kInt32);
+    __ Ldr(temp, MemOperand(address1, element_size, PostIndex));
+    __ Ldr(out, MemOperand(address2, element_size, PostIndex));
+  }
+  __ Cmp(temp, out);
+  __ B(ne, &return_false);
+  __ Subs(length, length, 1);
+  __ B(ne, &scalar_loop);
+
+  __ Bind(&return_true);
+  __ Mov(out, 1);
+  __ B(&done);
+  __ Bind(&return_false);
+  __ Mov(out, 0);
+  __ Bind(&done);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsByte(HInvoke* invoke) {
+  CreateArraysEqualsLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsByte(HInvoke* invoke) {
+  GenerateArraysEquals(invoke, codegen_, DataType::Type::kInt8);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsInt(HInvoke* invoke) {
+  CreateArraysEqualsLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsInt(HInvoke* invoke) {
+  GenerateArraysEquals(invoke, codegen_, DataType::Type::kInt32);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysHashCodeInt(HInvoke* invoke) {
+  LocationSummary* locations =
+      new (allocator_) LocationSummary(invoke, LocationSummary::kNoCall, kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysHashCodeInt(HInvoke* invoke) {
+  MacroAssembler* masm = GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register array = WRegisterFrom(locations->InAt(0));
+  Register length = WRegisterFrom(locations->GetTemp(0));
+  Register address = XRegisterFrom(locations->GetTemp(1));
+  VRegister sums = QRegisterFrom(locations->GetTemp(2));
+  VRegister factors = QRegisterFrom(locations->GetTemp(3));
+  VRegister data = QRegisterFrom(locations->GetTemp(4));
+  Register out = WRegisterFrom(locations->Out());
+
+  UseScratchRegisterScope temps(masm);
+  Register multiplier = temps.AcquireW();
+  Register temp = temps.AcquireW();
+
+  const int32_t elements_per_vector = kArraysVectorSize / sizeof(int32_t);
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+  constexpr int32_t k31Pow2 = 31 * 31;
+  constexpr int32_t k31Pow3 = 31 * k31Pow2;
+  constexpr int32_t k31Pow4 = 31 * k31Pow3;
+
+  vixl::aarch64::Label vector_loop, scalar_tail, scalar_loop, done;
+
+  // The hash code of a null array is 0.
+  __ Mov(out, 0);
+  __ Cbz(array, &done);
+  __ Ldr(length, MemOperand(array.X(), length_offset));
+  __ Add(address, array.X(), data_offset);
+  __ Mov(out, 1);
+
+  // With h(n) = 31 * h(n - 1) + a[n - 1] and h(0) = 1, after 4 * k elements
+  //   h(4 * k) = 31^(4 * k) + sum(lane j) * 31^(3 - j),
+  // where lane j accumulates a[4 * i + j] * 31^(4 * (k - 1 - i)) for i < k.
+  __ Subs(length, length, elements_per_vector);
+  __ B(lt, &scalar_tail);
+  __ Movi(sums.V4S(), 0);
+  __ Mov(multiplier, k31Pow4);
+  __ Dup(factors.V4S(), multiplier);
+  __ Bind(&vector_loop);
+  __ Ldr(data, MemOperand(address, kArraysVectorSize, PostIndex));
+  __ Mul(sums.V4S(), sums.V4S(), factors.V4S());
+  __ Add(sums.V4S(), sums.V4S(), data.V4S());
+  __ Mul(out, out, multiplier);
+  __ Subs(length, length, elements_per_vector);
+  __ B(ge, &vector_loop);
+  // Weight the lanes with {31^3, 31^2, 31, 1} and add them to the result.
+  __ Mov(temp, k31Pow3);
+  __ Mov(factors.V4S(), 0, temp);
+  __ Mov(temp, k31Pow2);
+  __ Mov(factors.V4S(), 1, temp);
+  __ Mov(temp, 31);
+  __ Mov(factors.V4S(), 2, temp);
+  __ Mov(temp, 1);
+  __ Mov(factors.V4S(), 3, temp);
+  __ Mul(sums.V4S(), sums.V4S(), factors.V4S());
+  __ Addv(sums.S(), sums.V4S());
+  __ Fmov(temp, sums.S());
+  __ Add(out, out, temp);
+
+  __ Bind(&scalar_tail);
+  __ Adds(length, length, elements_per_vector);
+  __ B(eq, &done);
+  __ Mov(multiplier, 31);
+  __ Bind(&scalar_loop);
+  __ Ldr(temp, MemOperand(address, sizeof(int32_t), PostIndex));
+  __ Madd(out, out, multiplier, temp);
+  __ Subs(length, length, 1);
+  __ B(ne, &scalar_loop);
+  __ Bind(&done);
+}
+
 // We can choose to use the native implementation there for longer copy lengths.
 static constexpr int32_t kSystemArrayCopyThreshold = 128;
 
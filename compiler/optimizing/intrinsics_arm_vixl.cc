@@ -5549,6 +5549,12 @@ UNIMPLEMENTED_INTRINSIC(ARMVIXL, StringBuilderToString);
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemArrayCopyByte);
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemArrayCopyInt);
 
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysFillByte)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysFillInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysHashCodeInt)
+
 // 1.8.
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathFmaDouble)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathFmaFloat)
@@ -4830,6 +4830,11 @@ void IntrinsicLocationsBuilderX86::VisitMathFmaFloat(HInvoke* invoke) {
 }
 
 UNIMPLEMENTED_INTRINSIC(X86, MathRoundDouble)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysFillByte)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysFillInt)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysHashCodeInt)
 UNIMPLEMENTED_INTRINSIC(X86, FloatIsInfinite)
 UNIMPLEMENTED_INTRINSIC(X86, DoubleIsInfinite)
 UNIMPLEMENTED_INTRINSIC(X86, IntegerHighestOneBit)
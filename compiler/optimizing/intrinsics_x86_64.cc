@@ -833,6 +833,302 @@ void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyInt(HInvoke* invoke) {
   CreateSystemArrayCopyLocations(invoke);
 }
 
+// Arrays.fill(), Arrays.equals() and Arrays.hashCode() process 16 bytes per iteration with
+// SSE, followed by a scalar loop for the remaining elements.
+static constexpr size_t kArraysVectorSize = 16u;
+
+static void CreateArraysFillLocations(ArenaAllocator* allocator, HInvoke* invoke) {
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke,
+                                      invoke->InputAt(0)->CanBeNull()
+                                          ? LocationSummary::kCallOnSlowPath
+                                          : LocationSummary::kNoCall,
+                                      kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+static void GenerateArraysFill(HInvoke* invoke,
+                               CodeGeneratorX86_64* codegen,
+                               DataType::Type type) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister array = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister value = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister length = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister address = locations->GetTemp(1).AsRegister<CpuRegister>();
+  XmmRegister vector = locations->GetTemp(2).AsFpuRegister<XmmRegister>();
+
+  const size_t element_size = DataType::Size(type);
+  const int32_t elements_per_vector = kArraysVectorSize / element_size;
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+
+  SlowPathCode* slow_path = nullptr;
+  if (invoke->InputAt(0)->CanBeNull()) {
+    // Let the called method throw the NullPointerException.
+    slow_path = new (codegen->GetScopedAllocator()) IntrinsicSlowPathX86_64(invoke);
+    codegen->AddSlowPath(slow_path);
+    __ testl(array, array);
+    __ j(kEqual, slow_path->GetEntryLabel());
+  }
+
+  NearLabel vector_loop, scalar_tail, scalar_loop, done;
+  __ movl(length, Address(array, length_offset));
+  __ leaq(address, Address(array, data_offset));
+
+  // Broadcast the value to all the lanes of the vector.
+  __ movd(vector, value, /* is64bit= */ false);
+  if (type == DataType::Type::kInt8) {
+    __ punpcklbw(vector, vector);
+    __ punpcklwd(vector, vector);
+  }
+  __ pshufd(vector, vector, Immediate(0));
+
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kLess, &scalar_tail);
+  __ Bind(&vector_loop);
+  __ movdqu(Address(address, 0), vector);
+  __ addq(address, Immediate(kArraysVectorSize));
+  __ subl(length, Immediate(elements_per_vector));
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kGreaterEqual, &vector_loop);
+
+  __ Bind(&scalar_tail);
+  __ testl(length, length);
+  __ j(kEqual, &done);
+  __ Bind(&scalar_loop);
+  if (type == DataType::Type::kInt8) {
+    __ movb(Address(address, 0), value);
+  } else {
+    DCHECK_EQ(type, DataType::Type::kInt32);
+    __ movl(Address(address, 0), value);
+  }
+  __ addq(address, Immediate(element_size));
+  __ subl(length, Immediate(1));
+  __ j(kNotEqual, &scalar_loop);
+  __ Bind(&done);
+
+  if (slow_path != nullptr) {
+    __ Bind(slow_path->GetExitLabel());
+  }
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysFillByte(HInvoke* invoke) {
+  CreateArraysFillLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysFillByte(HInvoke* invoke) {
+  GenerateArraysFill(invoke, codegen_, DataType::Type::kInt8);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysFillInt(HInvoke* invoke) {
+  CreateArraysFillLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysFillInt(HInvoke* invoke) {
+  GenerateArraysFill(invoke, codegen_, DataType::Type::kInt32);
+}
+
+static void CreateArraysEqualsLocations(ArenaAllocator* allocator, HInvoke* invoke) {
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke, LocationSummary::kNoCall, kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+static void GenerateArraysEquals(HInvoke* invoke,
+                                 CodeGeneratorX86_64* codegen,
+                                 DataType::Type type) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister array1 = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister array2 = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister length = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister address1 = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister address2 = locations->GetTemp(2).AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(3).AsRegister<CpuRegister>();
+  XmmRegister vector1 = locations->GetTemp(4).AsFpuRegister<XmmRegister>();
+  XmmRegister vector2 = locations->GetTemp(5).AsFpuRegister<XmmRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+
+  const size_t element_size = DataType::Size(type);
+  const int32_t elements_per_vector = kArraysVectorSize / element_size;
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+
+  NearLabel vector_loop, scalar_tail, scalar_loop, return_true, return_false, done;
+
+  // The same array (or both null) is equal to itself.
+  __ cmpl(array1, array2);
+  __ j(kEqual, &return_true);
+  __ testl(array1, array1);
+  __ j(kEqual, &return_false);
+  __ testl(array2, array2);
+  __ j(kEqual, &return_false);
+  __ movl(length, Address(array1, length_offset));
+  __ cmpl(length, Address(array2, length_offset));
+  __ j(kNotEqual, &return_false);
+  __ leaq(address1, Address(array1, data_offset));
+  __ leaq(address2, Address(array2, data_offset));
+
+  // Compare 16 bytes at a time. All the bytes must match, whatever the element type.
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kLess, &scalar_tail);
+  __ Bind(&vector_loop);
+  __ movdqu(vector1, Address(address1, 0));
+  __ movdqu(vector2, Address(address2, 0));
+  __ pcmpeqb(vector1, vector2);
+  __ pmovmskb(temp, vector1);
+  __ cmpl(temp, Immediate(0xffff));
+  __ j(kNotEqual, &return_false);
+  __ addq(address1, Immediate(kArraysVectorSize));
+  __ addq(address2, Immediate(kArraysVectorSize));
+  __ subl(length, Immediate(elements_per_vector));
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kGreaterEqual, &vector_loop);
+
+  __ Bind(&scalar_tail);
+  __ testl(length, length);
+  __ j(kEqual, &return_true);
+  __ Bind(&scalar_loop);
+  if (type == DataType::Type::kInt8) {
+    __ movzxb(temp, Address(address1, 0));
+    __ movzxb(out, Address(address2, 0));
+    __ cmpl(temp, out);
+  } else {
+    DCHECK_EQ(type, DataType::Type::kInt32);
+    __ movl(temp, Address(address1, 0));
+    __ cmpl(temp, Address(address2, 0));
+  }
+  __ j(kNotEqual, &return_false);
+  __ addq(address1, Immediate(element_size));
+  __ addq(address2, Immediate(element_size));
+  __ subl(length, Immediate(1));
+  __ j(kNotEqual, &scalar_loop);
+
+  __ Bind(&return_true);
+  __ movl(out, Immediate(1));
+  __ jmp(&done);
+  __ Bind(&return_false);
+  __ xorl(out, out);
+  __ Bind(&done);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  CreateArraysEqualsLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  GenerateArraysEquals(invoke, codegen_, DataType::Type::kInt8);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsInt(HInvoke* invoke) {
+  CreateArraysEqualsLocations(allocator_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsInt(HInvoke* invoke) {
+  GenerateArraysEquals(invoke, codegen_, DataType::Type::kInt32);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysHashCodeInt(HInvoke* invoke) {
+  // PMULLD requires SSE4.1 (and PHADDD SSSE3).
+  if (!codegen_->GetInstructionSetFeatures().HasSSE4_1()) {
+    return;
+  }
+  LocationSummary* locations =
+      new (allocator_) LocationSummary(invoke, LocationSummary::kNoCall, kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysHashCodeInt(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister array = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister length = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister address = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(2).AsRegister<CpuRegister>();
+  XmmRegister sums = locations->GetTemp(3).AsFpuRegister<XmmRegister>();
+  XmmRegister factors = locations->GetTemp(4).AsFpuRegister<XmmRegister>();
+  XmmRegister data = locations->GetTemp(5).AsFpuRegister<XmmRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+
+  const int32_t elements_per_vector = kArraysVectorSize / sizeof(int32_t);
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+  constexpr int32_t k31Pow2 = 31 * 31;
+  constexpr int32_t k31Pow3 = 31 * k31Pow2;
+  constexpr int32_t k31Pow4 = 31 * k31Pow3;
+
+  NearLabel vector_loop, scalar_tail, scalar_loop, done;
+
+  // The hash code of a null array is 0.
+  __ xorl(out, out);
+  __ testl(array, array);
+  __ j(kEqual, &done);
+  __ movl(length, Address(array, length_offset));
+  __ leaq(address, Address(array, data_offset));
+  __ movl(out, Immediate(1));
+
+  // With h(n) = 31 * h(n - 1) + a[n - 1] and h(0) = 1, after 4 * k elements
+  //   h(4 * k) = 31^(4 * k) + sum(lane j) * 31^(3 - j),
+  // where lane j accumulates a[4 * i + j] * 31^(4 * (k - 1 - i)) for i < k.
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kLess, &scalar_tail);
+  __ pxor(sums, sums);
+  codegen_->Load32BitValue(factors, k31Pow4);
+  __ pshufd(factors, factors, Immediate(0));
+  __ Bind(&vector_loop);
+  __ pmulld(sums, factors);
+  __ movdqu(data, Address(address, 0));
+  __ paddd(sums, data);
+  __ imull(out, out, Immediate(k31Pow4));
+  __ addq(address, Immediate(kArraysVectorSize));
+  __ subl(length, Immediate(elements_per_vector));
+  __ cmpl(length, Immediate(elements_per_vector));
+  __ j(kGreaterEqual, &vector_loop);
+  // Weight the lanes with {31^3, 31^2, 31, 1} and add them to the result.
+  codegen_->Load64BitValue(factors, (static_cast<int64_t>(k31Pow2) << 32) | k31Pow3);
+  codegen_->Load64BitValue(data, (INT64_C(1) << 32) | 31);
+  __ punpcklqdq(factors, data);
+  __ pmulld(sums, factors);
+  __ phaddd(sums, sums);
+  __ phaddd(sums, sums);
+  __ movd(temp, sums, /* is64bit= */ false);
+  __ addl(out, temp);
+
+  __ Bind(&scalar_tail);
+  __ testl(length, length);
+  __ j(kEqual, &done);
+  __ Bind(&scalar_loop);
+  __ imull(out, out, Immediate(31));
+  __ addl(out, Address(address, 0));
+  __ addq(address, Immediate(sizeof(int32_t)));
+  __ subl(length, Immediate(1));
+  __ j(kNotEqual, &scalar_loop);
+  __ Bind(&done);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopy(HInvoke* invoke) {
   // The only read barrier implementation supporting the
   // SystemArrayCopy intrinsic is the Baker-style read barriers.
@@ -16,6 +16,9 @@
 
 #include "linear_order.h"
 
+#include <algorithm>
+
+#include "base/arena_bit_vector.h"
 #include "base/scoped_arena_allocator.h"
 #include "base/scoped_arena_containers.h"
 
@@ -130,4 +133,69 @@ void LinearizeGraphInternal(const HGraph* graph, ArrayRef<HBasicBlock*> linear_o
   DCHECK(graph->HasIrreducibleLoops() || IsLinearOrderWellFormed(graph, linear_order));
 }
 
+size_t MoveColdBlocksToEnd(const HGraph* graph, ArrayRef<HBasicBlock*> linear_order) {
+  DCHECK_EQ(linear_order.size(), graph->GetReversePostOrder().size());
+  // Catch blocks can flow back into normal code, and irreducible loops do not
+  // guarantee the ordering properties we rely on below, so keep it simple.
+  if (graph->HasTryCatch() || graph->HasIrreducibleLoops()) {
+    return 0u;
+  }
+  ScopedArenaAllocator allocator(graph->GetArenaStack());
+  ArenaBitVector is_cold(
+      &allocator, graph->GetBlocks().size(), /* expandable= */ false, kArenaAllocLinearOrder);
+  // (1): Compute the cold blocks. A block is cold if it is not in a loop, does not
+  //      return, and all its successors are either the exit block or cold. Blocks
+  //      outside of loops only have forward edges, so visiting the linear order
+  //      backwards sees all the successors of a block before the block itself.
+  size_t number_of_cold_blocks = 0u;
+  for (HBasicBlock* block : ReverseRange(linear_order)) {
+    if (block->IsEntryBlock() || block->IsExitBlock() || block->IsInLoop()) {
+      continue;
+    }
+    HInstruction* last = block->GetLastInstruction();
+    if (last->IsReturn() || last->IsReturnVoid()) {
+      continue;
+    }
+    bool all_successors_cold = true;
+    for (HBasicBlock* successor : block->GetSuccessors()) {
+      if (!successor->IsExitBlock() && !is_cold.IsBitSet(successor->GetBlockId())) {
+        all_successors_cold = false;
+        break;
+      }
+    }
+    if (all_successors_cold) {
+      is_cold.SetBit(block->GetBlockId());
+      ++number_of_cold_blocks;
+    }
+  }
+  if (number_of_cold_blocks == 0u) {
+    return 0u;
+  }
+
+  // (2): Stable partition of the linear order into hot blocks, cold blocks and the
+  //      exit block. All the blocks reachable from a cold block are cold, so every
+  //      cold block is still preceded by its dominator and its predecessors. The exit
+  //      block goes last as it may have both hot and cold predecessors.
+  ScopedArenaVector<HBasicBlock*> cold_blocks(allocator.Adapter(kArenaAllocLinearOrder));
+  cold_blocks.reserve(number_of_cold_blocks);
+  HBasicBlock* exit_block = nullptr;
+  size_t num_hot = 0u;
+  for (HBasicBlock* block : linear_order) {
+    if (block->IsExitBlock()) {
+      exit_block = block;
+    } else if (is_cold.IsBitSet(block->GetBlockId())) {
+      cold_blocks.push_back(block);
+    } else {
+      linear_order[num_hot] = block;
+      ++num_hot;
+    }
+  }
+  std::copy(cold_blocks.begin(), cold_blocks.end(), linear_order.begin() + num_hot);
+  if (exit_block != nullptr) {
+    linear_order.back() = exit_block;
+  }
+  DCHECK(IsLinearOrderWellFormed(graph, linear_order));
+  return number_of_cold_blocks;
+}
+
 }  // namespace art
@@ -46,6 +46,14 @@ void LinearizeGraph(const HGraph* graph, Vector* linear_order) {
   LinearizeGraphInternal(graph, ArrayRef<HBasicBlock*>(*linear_order));
 }
 
+// Reorders an existing linear order of 'graph' so that cold blocks, i.e. blocks
+// from which every path ends in a throw, are placed after all the other blocks
+// (but before the exit block). This keeps the hot code of the method contiguous.
+// Blocks in loops are never moved, so the order still satisfies (1) and (2) above.
+//
+// Returns the number of blocks that were moved.
+size_t MoveColdBlocksToEnd(const HGraph* graph, ArrayRef<HBasicBlock*> linear_order);
+
 }  // namespace art
 
 #endif  // ART_COMPILER_OPTIMIZING_LINEAR_ORDER_H_
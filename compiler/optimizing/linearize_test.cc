@@ -244,4 +244,38 @@ TEST_F(LinearizeTest, CFG7) {
   TestCode(data, blocks);
 }
 
+TEST_F(LinearizeTest, ColdBlocksMovedToEnd) {
+  // Structure of this graph
+  //            Block0
+  //              |
+  //            Block1
+  //            /    \
+  //     (throw)      (return)
+  //            \    /
+  //             Exit
+  //
+  // The throwing block would naturally be laid out before the returning one,
+  // but it is cold and must be moved after all the hot blocks.
+  const std::vector<uint16_t> data = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_EQ, 3,
+    Instruction::THROW | 0,
+    Instruction::RETURN_VOID);
+
+  HGraph* graph = CreateCFG(data);
+  std::unique_ptr<CompilerOptions> compiler_options =
+      CommonCompilerTest::CreateCompilerOptions(kRuntimeISA, "default");
+  ASSERT_TRUE(compiler_options->ColdBlockLayout());
+  std::unique_ptr<CodeGenerator> codegen = CodeGenerator::Create(graph, *compiler_options);
+  SsaLivenessAnalysis liveness(graph, codegen.get(), GetScopedAllocator());
+  liveness.Analyze();
+
+  const ArenaVector<HBasicBlock*>& linear_order = graph->GetLinearOrder();
+  ASSERT_EQ(linear_order.size(), 5u);
+  ASSERT_EQ(linear_order[0], graph->GetEntryBlock());
+  ASSERT_TRUE(linear_order[2]->GetLastInstruction()->IsReturnVoid());
+  ASSERT_TRUE(linear_order[3]->GetLastInstruction()->IsThrow());
+  ASSERT_EQ(linear_order[4], graph->GetExitBlock());
+}
+
 }  // namespace art
@@ -423,7 +423,8 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
         cached_current_method_(nullptr),
         art_method_(nullptr),
         compilation_kind_(compilation_kind),
-        cha_single_implementation_list_(allocator->Adapter(kArenaAllocCHA)) {
+        cha_single_implementation_list_(allocator->Adapter(kArenaAllocCHA)),
+        code_dependencies_(allocator->Adapter(kArenaAllocMisc)) {
     blocks_.reserve(kDefaultNumberOfBlocks);
   }
 
@@ -682,6 +683,14 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
     cha_single_implementation_list_.insert(method);
   }
 
+  const ArenaSet<MethodReference>& GetCodeDependencies() const {
+    return code_dependencies_;
+  }
+
+  void AddCodeDependency(MethodReference method) {
+    code_dependencies_.insert(method);
+  }
+
   bool HasShouldDeoptimizeFlag() const {
     return number_of_cha_guards_ != 0 || debuggable_;
   }
@@ -888,6 +897,10 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   // List of methods that are assumed to have single implementation.
   ArenaSet<ArtMethod*> cha_single_implementation_list_;
 
+  // Methods whose dex code was inlined into this graph or analyzed to optimize a call
+  // to them. The generated code is stale as soon as the code of any of them changes.
+  ArenaSet<MethodReference> code_dependencies_;
+
   friend class SsaBuilder;           // For caching constants.
   friend class SsaLivenessAnalysis;  // For the linear order.
   friend class HInliner;             // For the reverse post order.
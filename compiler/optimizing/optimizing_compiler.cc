@@ -16,21 +16,25 @@
 
 #include "optimizing_compiler.h"
 
+#include <atomic>
 #include <fstream>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 #include <stdint.h>
 
 #include "art_method-inl.h"
 #include "base/arena_allocator.h"
 #include "base/arena_containers.h"
+#include "base/caching_arena_pool.h"
 #include "base/dumpable.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "base/scoped_arena_allocator.h"
 #include "base/timing_logger.h"
+#include "base/utils.h"
 #include "builder.h"
 #include "code_generator.h"
 #include "compiled_method.h"
@@ -303,6 +307,12 @@ class OptimizingCompiler final : public Compiler {
       override
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  void ReleaseArenaCaches() override REQUIRES(!arena_caches_lock_);
+
+  void ReleaseArenaCache(Thread* self) override;
+
+  void DumpArenaCacheStats(std::ostream& os) const override REQUIRES(!arena_caches_lock_);
+
  private:
   bool RunOptimizations(HGraph* graph,
                         CodeGenerator* codegen,
@@ -403,8 +413,23 @@ class OptimizingCompiler final : public Compiler {
   // This must be called before any other function that dumps data to the cfg
   void DumpInstructionSetFeaturesToCfg() const;
 
+  // Returns the arena pool for an AOT compilation on thread `self`, which keeps the
+  // arenas of the thread warm across the compilation of successive methods. The pool
+  // is remembered in a thread-local slot, so only the first call on a thread locks.
+  ArenaPool* GetArenaPoolForThread(Thread* self) const REQUIRES(!arena_caches_lock_);
+
   std::unique_ptr<OptimizingCompilerStats> compilation_stats_;
 
+  // Identifies this compiler in the thread-local arena cache slot, which may still
+  // refer to the cache of a destroyed compiler.
+  const uint64_t compiler_id_;
+
+  // Owns the arena caches of all threads. Only needed to create a cache and to
+  // visit the caches of all threads.
+  mutable Mutex arena_caches_lock_;
+  mutable std::unordered_map<Thread*, std::unique_ptr<CachingArenaPool>> arena_caches_
+      GUARDED_BY(arena_caches_lock_);
+
   std::unique_ptr<std::ostream> visualizer_output_;
 
   DISALLOW_COPY_AND_ASSIGN(OptimizingCompiler);
@@ -412,9 +437,20 @@ class OptimizingCompiler final : public Compiler {
 
 static const int kMaximumCompilationTimeBeforeWarning = 100; /* ms */
 
+static std::atomic<uint64_t> next_compiler_id(1u);
+
+// The arena cache of the current thread, valid only for the compiler with `compiler_id`.
+struct ThreadArenaCache {
+  uint64_t compiler_id;
+  CachingArenaPool* pool;
+};
+static thread_local ThreadArenaCache thread_arena_cache = { 0u, nullptr };
+
 OptimizingCompiler::OptimizingCompiler(const CompilerOptions& compiler_options,
                                        CompiledMethodStorage* storage)
-    : Compiler(compiler_options, storage, kMaximumCompilationTimeBeforeWarning) {
+    : Compiler(compiler_options, storage, kMaximumCompilationTimeBeforeWarning),
+      compiler_id_(next_compiler_id.fetch_add(1u, std::memory_order_relaxed)),
+      arena_caches_lock_("OptimizingCompiler arena caches lock", kGenericBottomLock) {
   // Enable C1visualizer output.
   const std::string& cfg_file_name = compiler_options.GetDumpCfgFileName();
   if (!cfg_file_name.empty()) {
@@ -434,6 +470,60 @@ OptimizingCompiler::~OptimizingCompiler() {
   }
 }
 
+ArenaPool* OptimizingCompiler::GetArenaPoolForThread(Thread* self) const {
+  DCHECK_EQ(self, Thread::Current());
+  if (thread_arena_cache.compiler_id == compiler_id_) {
+    return thread_arena_cache.pool;
+  }
+  MutexLock mu(self, arena_caches_lock_);
+  std::unique_ptr<CachingArenaPool>& cache = arena_caches_[self];
+  if (cache == nullptr) {
+    cache.reset(new CachingArenaPool(Runtime::Current()->GetArenaPool()));
+  }
+  thread_arena_cache = { compiler_id_, cache.get() };
+  return cache.get();
+}
+
+void OptimizingCompiler::ReleaseArenaCaches() {
+  MutexLock mu(Thread::Current(), arena_caches_lock_);
+  for (auto& entry : arena_caches_) {
+    entry.second->ReclaimMemory();
+  }
+}
+
+void OptimizingCompiler::ReleaseArenaCache(Thread* self) {
+  DCHECK_EQ(self, Thread::Current());
+  // A thread without a slot for this compiler has no cache yet.
+  if (thread_arena_cache.compiler_id == compiler_id_) {
+    thread_arena_cache.pool->ReclaimMemory();
+  }
+}
+
+void OptimizingCompiler::DumpArenaCacheStats(std::ostream& os) const {
+  size_t num_reused_arenas = 0u;
+  size_t num_backing_arenas = 0u;
+  size_t trimmed_bytes = 0u;
+  size_t cached_bytes = 0u;
+  size_t num_threads = 0u;
+  {
+    MutexLock mu(Thread::Current(), arena_caches_lock_);
+    num_threads = arena_caches_.size();
+    for (const auto& entry : arena_caches_) {
+      num_reused_arenas += entry.second->GetNumReusedArenas();
+      num_backing_arenas += entry.second->GetNumBackingArenas();
+      trimmed_bytes += entry.second->GetTrimmedBytes();
+      cached_bytes += entry.second->GetCachedBytes();
+    }
+  }
+  size_t num_arenas = num_reused_arenas + num_backing_arenas;
+  os << "arena caches: threads=" << num_threads
+     << " reused=" << num_reused_arenas
+     << " (" << (num_arenas != 0u ? num_reused_arenas * 100u / num_arenas : 0u) << "%)"
+     << " from pool=" << num_backing_arenas
+     << " trimmed=" << PrettySize(trimmed_bytes)
+     << " cached=" << PrettySize(cached_bytes);
+}
+
 void OptimizingCompiler::DumpInstructionSetFeaturesToCfg() const {
   const CompilerOptions& compiler_options = GetCompilerOptions();
   const InstructionSetFeatures* features = compiler_options.GetInstructionSetFeatures();
@@ -577,7 +667,8 @@ static void AllocateRegisters(HGraph* graph,
                               CodeGenerator* codegen,
                               PassObserver* pass_observer,
                               RegisterAllocator::Strategy strategy,
-                              OptimizingCompilerStats* stats) {
+                              OptimizingCompilerStats* stats,
+                              ThreadPool* thread_pool) {
   {
     PassScope scope(PrepareForRegisterAllocation::kPrepareForRegisterAllocationPassName,
                     pass_observer);
@@ -586,7 +677,7 @@ static void AllocateRegisters(HGraph* graph,
   // Use local allocator shared by SSA liveness analysis and register allocator.
   // (Register allocator creates new objects in the liveness data.)
   ScopedArenaAllocator local_allocator(graph->GetArenaStack());
-  SsaLivenessAnalysis liveness(graph, codegen, &local_allocator);
+  SsaLivenessAnalysis liveness(graph, codegen, &local_allocator, stats, thread_pool);
   {
     PassScope scope(SsaLivenessAnalysis::kLivenessPassName, pass_observer);
     liveness.Analyze();
@@ -899,7 +990,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
                     codegen.get(),
                     &pass_observer,
                     regalloc_strategy,
-                    compilation_stats_.get());
+                    compilation_stats_.get(),
+                    GetThreadPool());
 
   codegen->Compile(code_allocator);
   pass_observer.DumpDisassembly();
@@ -989,7 +1081,8 @@ CodeGenerator* OptimizingCompiler::TryCompileIntrinsic(
                     codegen.get(),
                     &pass_observer,
                     compiler_options.GetRegisterAllocationStrategy(),
-                    compilation_stats_.get());
+                    compilation_stats_.get(),
+                    GetThreadPool());
   if (!codegen->IsLeafMethod()) {
     VLOG(compiler) << "Intrinsic method is not leaf: " << method->GetIntrinsic()
         << " " << graph->PrettyMethod();
@@ -1018,8 +1111,9 @@ CompiledMethod* OptimizingCompiler::Compile(const dex::CodeItem* code_item,
   CompiledMethod* compiled_method = nullptr;
   Runtime* runtime = Runtime::Current();
   DCHECK(runtime->IsAotCompiler());
-  ArenaAllocator allocator(runtime->GetArenaPool());
-  ArenaStack arena_stack(runtime->GetArenaPool());
+  ArenaPool* arena_pool = GetArenaPoolForThread(Thread::Current());
+  ArenaAllocator allocator(arena_pool);
+  ArenaStack arena_stack(arena_pool);
   CodeVectorAllocator code_allocator(&allocator);
   std::unique_ptr<CodeGenerator> codegen;
   bool compiled_intrinsic = false;
@@ -1083,6 +1177,15 @@ CompiledMethod* OptimizingCompiler::Compile(const dex::CodeItem* code_item,
     if (compiled_intrinsic) {
       compiled_method->MarkAsIntrinsic();
     }
+    CodeDependencyRecorder* recorder = GetCodeDependencyRecorder();
+    if (recorder != nullptr) {
+      const ArenaSet<MethodReference>& code_dependencies =
+          codegen->GetGraph()->GetCodeDependencies();
+      std::vector<MethodReference> dependencies(code_dependencies.begin(),
+                                                code_dependencies.end());
+      recorder->RecordCodeDependencies(MethodReference(&dex_file, method_idx),
+                                       ArrayRef<const MethodReference>(dependencies));
+    }
 
     if (kArenaAllocatorCountAllocations) {
       codegen.reset();  // Release codegen's ScopedArenaAllocator for memory accounting.
@@ -1135,8 +1238,9 @@ CompiledMethod* OptimizingCompiler::JniCompile(uint32_t access_flags,
                                                const DexFile& dex_file,
                                                Handle<mirror::DexCache> dex_cache) const {
   Runtime* runtime = Runtime::Current();
-  ArenaAllocator allocator(runtime->GetArenaPool());
-  ArenaStack arena_stack(runtime->GetArenaPool());
+  ArenaPool* arena_pool = GetArenaPoolForThread(Thread::Current());
+  ArenaAllocator allocator(arena_pool);
+  ArenaStack arena_stack(arena_pool);
 
   const CompilerOptions& compiler_options = GetCompilerOptions();
   if (compiler_options.IsBootImage()) {
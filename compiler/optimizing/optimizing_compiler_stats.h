@@ -122,6 +122,11 @@ enum class MethodCompilationStat {
   kPredicatedLoadAdded,
   kPredicatedStoreAdded,
   kDevirtualized,
+  kColdBlockMovedToEnd,
+  kParallelLivenessAnalysis,
+  kProfiledCallSite,
+  kInlinedProfiledCallSite,
+  kInliningBudgetUsedByProfiledCallSites,
   kLastStat
 };
 std::ostream& operator<<(std::ostream& os, MethodCompilationStat rhs);
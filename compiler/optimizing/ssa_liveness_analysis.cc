@@ -16,17 +16,36 @@
 
 #include "ssa_liveness_analysis.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "barrier.h"
 #include "base/bit_vector-inl.h"
 #include "code_generator.h"
+#include "driver/compiler_options.h"
 #include "linear_order.h"
 #include "nodes.h"
+#include "optimizing_compiler_stats.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
+// The fixed point calculation of the live_in and live_out sets is only split across
+// threads for methods with at least that many blocks...
+static constexpr size_t kMinimumBlocksForParallelLiveness = 512u;
+// ... and each thread gets at least that many storage words (32 SSA values each) of the sets.
+static constexpr size_t kMinimumWordsPerLivenessSlice = 32u;
+
 void SsaLivenessAnalysis::Analyze() {
   // Compute the linear order directly in the graph's data structure
   // (there are no more following graph mutations).
   LinearizeGraph(graph_, &graph_->linear_order_);
+  if (codegen_->GetCompilerOptions().ColdBlockLayout()) {
+    size_t moved = MoveColdBlocksToEnd(graph_, ArrayRef<HBasicBlock*>(graph_->linear_order_));
+    MaybeRecordStat(stats_, MethodCompilationStat::kColdBlockMovedToEnd, moved);
+  }
 
   // Liveness analysis.
   NumberInstructions();
@@ -270,6 +289,17 @@ void SsaLivenessAnalysis::ComputeLiveRanges() {
 }
 
 void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSets() {
+  if (thread_pool_ != nullptr && graph_->GetBlocks().size() >= kMinimumBlocksForParallelLiveness) {
+    size_t number_of_words = GetLiveInSet(*graph_->GetEntryBlock())->GetStorageSize();
+    size_t num_slices = std::min(number_of_words / kMinimumWordsPerLivenessSlice,
+                                 thread_pool_->GetThreadCount() + 1u);
+    if (num_slices > 1u) {
+      ComputeLiveInAndLiveOutSetsInParallel(num_slices);
+      MaybeRecordStat(stats_, MethodCompilationStat::kParallelLivenessAnalysis);
+      return;
+    }
+  }
+
   bool changed;
   do {
     changed = false;
@@ -288,6 +318,88 @@ void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSets() {
   } while (changed);
 }
 
+void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSetsForWords(size_t start_word,
+                                                              size_t end_word) {
+  bool changed;
+  do {
+    changed = false;
+
+    for (const HBasicBlock* block : graph_->GetPostOrder()) {
+      uint32_t* live_out = GetLiveOutSet(*block)->GetRawStorage();
+      bool live_out_changed = false;
+      for (HBasicBlock* successor : block->GetSuccessors()) {
+        const uint32_t* successor_live_in = GetLiveInSet(*successor)->GetRawStorage();
+        for (size_t i = start_word; i != end_word; ++i) {
+          uint32_t word = live_out[i] | successor_live_in[i];
+          live_out_changed |= (word != live_out[i]);
+          live_out[i] = word;
+        }
+      }
+      if (!live_out_changed) {
+        continue;
+      }
+      uint32_t* live_in = GetLiveInSet(*block)->GetRawStorage();
+      const uint32_t* kill = GetKillSet(*block)->GetRawStorage();
+      for (size_t i = start_word; i != end_word; ++i) {
+        uint32_t word = live_in[i] | (live_out[i] & ~kill[i]);
+        changed |= (word != live_in[i]);
+        live_in[i] = word;
+      }
+    }
+  } while (changed);
+}
+
+namespace {
+
+// State shared between the compiling thread and the pool tasks. It is reference counted
+// so that tasks which only run after the calculation has completed find no slice left
+// and never touch the (by then freed) liveness data.
+struct ParallelLivenessState {
+  explicit ParallelLivenessState(size_t slices)
+      : num_slices(slices), next_slice(0u), barrier(0) {}
+
+  const size_t num_slices;
+  std::atomic<size_t> next_slice;
+  // Passed once per processed slice.
+  Barrier barrier;
+};
+
+}  // namespace
+
+void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSetsInParallel(size_t num_slices) {
+  DCHECK_GT(num_slices, 1u);
+  Thread* self = Thread::Current();
+  size_t number_of_words = GetLiveInSet(*graph_->GetEntryBlock())->GetStorageSize();
+  size_t words_per_slice = (number_of_words + num_slices - 1u) / num_slices;
+  std::shared_ptr<ParallelLivenessState> state =
+      std::make_shared<ParallelLivenessState>(num_slices);
+  auto process_slices = [this, state, number_of_words, words_per_slice](Thread* thread) {
+    for (size_t slice = state->next_slice.fetch_add(1u, std::memory_order_relaxed);
+         slice < state->num_slices;
+         slice = state->next_slice.fetch_add(1u, std::memory_order_relaxed)) {
+      size_t start_word = slice * words_per_slice;
+      size_t end_word = std::min(start_word + words_per_slice, number_of_words);
+      if (start_word < end_word) {
+        ComputeLiveInAndLiveOutSetsForWords(start_word, end_word);
+      }
+      state->barrier.Pass(thread);
+    }
+  };
+  for (size_t i = 1u; i != num_slices; ++i) {
+    thread_pool_->AddTask(self, new FunctionTask(process_slices));
+  }
+  // Do not wait for the pool: its workers may be busy compiling other methods, in which
+  // case this thread processes the remaining slices itself.
+  process_slices(self);
+  state->barrier.Increment<Barrier::kAllowHoldingLocks>(self, static_cast<int>(num_slices));
+
+  if (kIsDebugBuild) {
+    for (const HBasicBlock* block : graph_->GetPostOrder()) {
+      CheckNoLiveInIrreducibleLoop(*block);
+    }
+  }
+}
+
 bool SsaLivenessAnalysis::UpdateLiveOut(const HBasicBlock& block) {
   BitVector* live_out = GetLiveOutSet(block);
   bool changed = false;
@@ -28,7 +28,9 @@
 namespace art {
 
 class CodeGenerator;
+class OptimizingCompilerStats;
 class SsaLivenessAnalysis;
+class ThreadPool;
 
 static constexpr int kNoRegister = -1;
 
@@ -1172,10 +1174,16 @@ class LiveInterval : public ArenaObject<kArenaAllocSsaLiveness> {
  */
 class SsaLivenessAnalysis : public ValueObject {
  public:
-  SsaLivenessAnalysis(HGraph* graph, CodeGenerator* codegen, ScopedArenaAllocator* allocator)
+  SsaLivenessAnalysis(HGraph* graph,
+                      CodeGenerator* codegen,
+                      ScopedArenaAllocator* allocator,
+                      OptimizingCompilerStats* stats = nullptr,
+                      ThreadPool* thread_pool = nullptr)
       : graph_(graph),
         codegen_(codegen),
         allocator_(allocator),
+        stats_(stats),
+        thread_pool_(thread_pool),
         block_infos_(graph->GetBlocks().size(),
                      nullptr,
                      allocator_->Adapter(kArenaAllocSsaLiveness)),
@@ -1260,6 +1268,15 @@ class SsaLivenessAnalysis : public ValueObject {
   // backwards branches.
   void ComputeLiveInAndLiveOutSets();
 
+  // Same as ComputeLiveInAndLiveOutSets(), but only for the SSA values held in the storage
+  // words [start_word, end_word) of the sets. The liveness of an SSA value does not depend
+  // on other SSA values, so disjoint word ranges can be computed concurrently.
+  void ComputeLiveInAndLiveOutSetsForWords(size_t start_word, size_t end_word);
+
+  // Split the fixed point calculation in `num_slices` word ranges, processed by the
+  // calling thread and by the idle workers of `thread_pool_`.
+  void ComputeLiveInAndLiveOutSetsInParallel(size_t num_slices);
+
   // Update the live_in set of the block and returns whether it has changed.
   bool UpdateLiveIn(const HBasicBlock& block);
 
@@ -1316,6 +1333,11 @@ class SsaLivenessAnalysis : public ValueObject {
   // This allocator must remain alive while doing register allocation.
   ScopedArenaAllocator* const allocator_;
 
+  OptimizingCompilerStats* const stats_;
+
+  // Optional thread pool used for the fixed point calculation of very large methods.
+  ThreadPool* const thread_pool_;
+
   ScopedArenaVector<BlockInfo*> block_infos_;
 
   // Temporary array used when computing live_in, live_out, and kill sets.
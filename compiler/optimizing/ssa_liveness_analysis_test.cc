@@ -21,9 +21,13 @@
 #include "base/arena_allocator.h"
 #include "base/arena_containers.h"
 #include "code_generator.h"
+#include "common_compiler_test.h"
 #include "driver/compiler_options.h"
 #include "nodes.h"
+#include "optimizing_compiler_stats.h"
 #include "optimizing_unit_test.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -217,4 +221,121 @@ TEST_F(SsaLivenessAnalysisTest, TestDeoptimize) {
   }
 }
 
+// The parallel fixpoint needs worker threads, and those attach to a runtime.
+class SsaLivenessAnalysisParallelTest : public CommonCompilerTest, public OptimizingUnitTestHelper {
+ public:
+  SsaLivenessAnalysisParallelTest() {
+    use_boot_image_ = true;  // Make the Runtime creation cheaper.
+  }
+
+ protected:
+  static constexpr size_t kNumValues = 4096u;
+  static constexpr size_t kNumLoops = 200u;
+
+  // Builds a chain of `kNumLoops` loops between the definitions of `kNumValues` values and
+  // a block that uses all of them, so every value is live across every loop.
+  HGraph* BuildGraphWithManyLoops() {
+    HGraph* graph = CreateGraph();
+    HBasicBlock* entry = AddNewBlock();
+    graph->SetEntryBlock(entry);
+    HInstruction* param = MakeParam(DataType::Type::kInt32);
+    entry->AddInstruction(new (GetAllocator()) HGoto());
+
+    HBasicBlock* defs = AddNewBlock();
+    entry->AddSuccessor(defs);
+    std::vector<HInstruction*> values;
+    for (size_t i = 0; i != kNumValues; ++i) {
+      HInstruction* value = new (GetAllocator()) HAdd(
+          DataType::Type::kInt32, param, graph->GetIntConstant(static_cast<int32_t>(i)));
+      defs->AddInstruction(value);
+      values.push_back(value);
+    }
+    defs->AddInstruction(new (GetAllocator()) HGoto());
+
+    HBasicBlock* pre_header = defs;
+    for (size_t i = 0; i != kNumLoops; ++i) {
+      HBasicBlock* header = AddNewBlock();
+      HBasicBlock* body = AddNewBlock();
+      HBasicBlock* loop_exit = AddNewBlock();
+      pre_header->AddSuccessor(header);
+      header->AddSuccessor(loop_exit);  // true successor
+      header->AddSuccessor(body);       // false successor
+      body->AddSuccessor(header);
+
+      HPhi* phi = new (GetAllocator()) HPhi(GetAllocator(), 0, 0, DataType::Type::kInt32);
+      HInstruction* cmp = new (GetAllocator()) HLessThan(phi, values[kNumValues - 1u - i]);
+      header->AddPhi(phi);
+      header->AddInstruction(cmp);
+      header->AddInstruction(new (GetAllocator()) HIf(cmp));
+
+      HInstruction* acc =
+          new (GetAllocator()) HAdd(DataType::Type::kInt32, phi, values[(i * 37u) % kNumValues]);
+      body->AddInstruction(acc);
+      body->AddInstruction(new (GetAllocator()) HGoto());
+      phi->AddInput(values[i]);
+      phi->AddInput(acc);
+
+      loop_exit->AddInstruction(new (GetAllocator()) HGoto());
+      pre_header = loop_exit;
+    }
+
+    HBasicBlock* return_block = AddNewBlock();
+    pre_header->AddSuccessor(return_block);
+    HInstruction* sum = param;
+    for (HInstruction* value : values) {
+      sum = new (GetAllocator()) HAdd(DataType::Type::kInt32, sum, value);
+      return_block->AddInstruction(sum);
+    }
+    return_block->AddInstruction(new (GetAllocator()) HReturn(sum));
+
+    HBasicBlock* exit = AddNewBlock();
+    return_block->AddSuccessor(exit);
+    graph->SetExitBlock(exit);
+    exit->AddInstruction(new (GetAllocator()) HExit());
+
+    graph->BuildDominatorTree();
+    return graph;
+  }
+};
+
+TEST_F(SsaLivenessAnalysisParallelTest, MatchesSequentialLiveness) {
+  HGraph* sequential_graph = BuildGraphWithManyLoops();
+  std::unique_ptr<CodeGenerator> sequential_codegen =
+      CodeGenerator::Create(sequential_graph, *compiler_options_);
+  ASSERT_TRUE(sequential_codegen != nullptr);
+  SsaLivenessAnalysis sequential(sequential_graph, sequential_codegen.get(), GetScopedAllocator());
+  sequential.Analyze();
+
+  HGraph* parallel_graph = BuildGraphWithManyLoops();
+  ASSERT_GE(parallel_graph->GetBlocks().size(), 512u);
+  ASSERT_EQ(sequential_graph->GetBlocks().size(), parallel_graph->GetBlocks().size());
+  std::unique_ptr<CodeGenerator> parallel_codegen =
+      CodeGenerator::Create(parallel_graph, *compiler_options_);
+  ASSERT_TRUE(parallel_codegen != nullptr);
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Liveness test thread pool", /*num_threads=*/ 3u);
+  thread_pool.StartWorkers(self);
+  OptimizingCompilerStats stats;
+  SsaLivenessAnalysis parallel(
+      parallel_graph, parallel_codegen.get(), GetScopedAllocator(), &stats, &thread_pool);
+  parallel.Analyze();
+  EXPECT_EQ(1u, stats.GetStat(MethodCompilationStat::kParallelLivenessAnalysis));
+
+  for (HBasicBlock* block : sequential_graph->GetBlocks()) {
+    if (block == nullptr) {
+      continue;
+    }
+    HBasicBlock* other = parallel_graph->GetBlocks()[block->GetBlockId()];
+    ASSERT_TRUE(other != nullptr) << block->GetBlockId();
+    EXPECT_TRUE(sequential.GetLiveInSet(*block)->Equal(parallel.GetLiveInSet(*other)))
+        << block->GetBlockId();
+    EXPECT_TRUE(sequential.GetLiveOutSet(*block)->Equal(parallel.GetLiveOutSet(*other)))
+        << block->GetBlockId();
+  }
+  // Values defined before the loops are live into the block that sums them.
+  HBasicBlock* return_block = parallel_graph->GetExitBlock()->GetSinglePredecessor();
+  const BitVector* live_in = parallel.GetLiveInSet(*return_block);
+  EXPECT_GE(live_in->NumSetBits(), kNumValues);
+}
+
 }  // namespace art
@@ -77,9 +77,11 @@
 #include "dex/verification_results.h"
 #include "dex2oat_options.h"
 #include "dexlayout.h"
+#include "driver/compilation_record.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
 #include "driver/compiler_options_map-inl.h"
+#include "driver/memory_budget.h"
 #include "elf_file.h"
 #include "gc/space/image_space.h"
 #include "gc/space/space-inl.h"
@@ -178,8 +180,9 @@ static std::string StrippedCommandLine() {
       continue;
     }
 
-    // The image format is dropped.
-    if (android::base::StartsWith(original_argv[i], "--image-format=")) {
+    // The image format and compression level are dropped.
+    if (android::base::StartsWith(original_argv[i], "--image-format=") ||
+        android::base::StartsWith(original_argv[i], "--image-compression-level=")) {
       continue;
     }
 
@@ -542,6 +545,8 @@ class Dex2Oat final {
         avoid_storing_invocation_(false),
         swap_fd_(File::kInvalidFd),
         app_image_fd_(File::kInvalidFd),
+        input_compilation_record_fd_(File::kInvalidFd),
+        output_compilation_record_fd_(File::kInvalidFd),
         timings_(timings),
         force_determinism_(false),
         check_linkage_conditions_(false),
@@ -823,6 +828,16 @@ class Dex2Oat final {
       Usage("--dirty-image-objects and --dirty-image-objects-fd should not be both specified");
     }
 
+    if (!input_compilation_record_.empty() && input_compilation_record_fd_ != -1) {
+      Usage("--input-compilation-record and --input-compilation-record-fd should not be both "
+            "specified");
+    }
+
+    if (!output_compilation_record_.empty() && output_compilation_record_fd_ != -1) {
+      Usage("--output-compilation-record and --output-compilation-record-fd should not be both "
+            "specified");
+    }
+
     if (!cpu_set_.empty()) {
       SetCpuAffinity(cpu_set_);
     }
@@ -1075,9 +1090,15 @@ class Dex2Oat final {
     AssignIfExists(args, M::SwapFileFd, &swap_fd_);
     AssignIfExists(args, M::SwapDexSizeThreshold, &min_dex_file_cumulative_size_for_swap_);
     AssignIfExists(args, M::SwapDexCountThreshold, &min_dex_files_for_swap_);
+    AssignIfExists(args, M::MemoryBudget, &memory_budget_mb_);
     AssignIfExists(args, M::VeryLargeAppThreshold, &very_large_threshold_);
     AssignIfExists(args, M::AppImageFile, &app_image_file_name_);
     AssignIfExists(args, M::AppImageFileFd, &app_image_fd_);
+    AssignIfExists(args, M::InputCompilationRecord, &input_compilation_record_);
+    AssignIfExists(args, M::InputCompilationRecordFd, &input_compilation_record_fd_);
+    AssignIfExists(args, M::OutputCompilationRecord, &output_compilation_record_);
+    AssignIfExists(args, M::OutputCompilationRecordFd, &output_compilation_record_fd_);
+    AssignIfExists(args, M::CompiledMethodCacheDir, &compiled_method_cache_dir_);
     AssignIfExists(args, M::NoInlineFrom, &no_inline_from_string_);
     AssignIfExists(args, M::ClasspathDir, &classpath_dir_);
     AssignIfExists(args, M::DirtyImageObjects, &dirty_image_objects_filename_);
@@ -1686,6 +1707,8 @@ class Dex2Oat final {
       } else {
         LOG(INFO) << "Large app, accepted running with swap.";
       }
+    } else if (memory_budget_mb_ != 0u) {
+      LOG(WARNING) << "Memory budget without a swap file, compiled code stays in memory.";
     }
     // Note that dex2oat won't close the swap_fd_. The compiler driver's swap space will do that.
 
@@ -1869,6 +1892,9 @@ class Dex2Oat final {
                                      compiler_kind_,
                                      thread_count_,
                                      swap_fd_));
+    if (memory_budget_mb_ != 0u) {
+      driver_->SetMemoryBudget(memory_budget_mb_ * MB);
+    }
 
     driver_->PrepareDexFilesForOatFile(timings_);
 
@@ -1877,6 +1903,7 @@ class Dex2Oat final {
     }
 
     const bool compile_individually = ShouldCompileDexFilesIndividually();
+    SetupCompilationRecord(compile_individually);
     if (compile_individually) {
       // Set the compiler driver in the callbacks so that we can avoid re-verification. This not
       // only helps performance but also prevents reverifying quickened bytecodes. Attempting
@@ -1952,6 +1979,9 @@ class Dex2Oat final {
                         &compiler_options_->image_classes_);
     callbacks_->SetVerificationResults(nullptr);  // Should not be needed anymore.
     compiler_options_->verification_results_ = verification_results_.get();
+    if (compilation_record_ != nullptr) {
+      compilation_record_->SelectCacheableDexFiles(class_loader);
+    }
     driver_->CompileAll(class_loader, dex_files, timings_);
     driver_->FreeThreadPools();
     return class_loader;
@@ -2047,7 +2077,8 @@ class Dex2Oat final {
                                                   oat_filenames_,
                                                   dex_file_oat_index_map_,
                                                   class_loader,
-                                                  dirty_image_objects_.get()));
+                                                  dirty_image_objects_.get(),
+                                                  thread_count_));
 
       // We need to prepare method offsets in the image address space for resolving linker patches.
       TimingLogger::ScopedTiming t2("dex2oat Prepare image address space", timings_);
@@ -2088,6 +2119,11 @@ class Dex2Oat final {
         std::unique_ptr<linker::OatWriter>& oat_writer = oat_writers_[i];
 
         oat_writer->PrepareLayout(&patcher);
+        if (compiler_options_->ProfileCodeLayout() && profile_compilation_info_ != nullptr) {
+          LOG(INFO) << "Startup code in " << oat_files_[i]->GetPath() << " spans "
+                    << oat_writer->GetStartupCodePages() << " pages, "
+                    << oat_writer->GetMinStartupCodePages() << " if contiguous";
+        }
         elf_writer->PrepareDynamicSection(oat_writer->GetOatHeader().GetExecutableOffset(),
                                           oat_writer->GetCodeSize(),
                                           oat_writer->GetDataBimgRelRoSize(),
@@ -2276,9 +2312,109 @@ class Dex2Oat final {
     if (compiler_options_->GetDumpTimings() ||
         (kIsDebugBuild && timings_->GetTotalNs() > MsToNs(1000))) {
       LOG(INFO) << Dumpable<TimingLogger>(*timings_);
+      if (compilation_record_ != nullptr) {
+        LOG(INFO) << "Reused " << compilation_record_->GetNumberOfReusedMethods() << " of "
+                  << compilation_record_->GetNumberOfReusableMethods()
+                  << " methods from the input compilation record and "
+                  << compilation_record_->GetNumberOfCacheHits()
+                  << " methods from the compiled method cache";
+      }
+    }
+  }
+
+  bool UseCompilationRecord() const {
+    return !input_compilation_record_.empty() || input_compilation_record_fd_ != -1 ||
+           !output_compilation_record_.empty() || output_compilation_record_fd_ != -1 ||
+           !compiled_method_cache_dir_.empty();
+  }
+
+  // Create the record of this compilation and read the record of the previous compilation,
+  // if any, so that the driver reuses the code of methods that did not change.
+  void SetupCompilationRecord(bool compile_individually) {
+    if (!UseCompilationRecord()) {
+      return;
+    }
+    if (IsImage() || compile_individually) {
+      LOG(WARNING) << "Compilation records and the compiled method cache are not supported for "
+                   << "images or for very large apps compiled one dex file at a time";
+      return;
+    }
+    TimingLogger::ScopedTiming t("dex2oat Read compilation record", timings_);
+    compilation_record_.reset(new CompilationRecord(*compiler_options_, *key_value_store_));
+    if (!compiled_method_cache_dir_.empty()) {
+      std::string error_msg;
+      if (!compilation_record_->SetCacheDirectory(compiled_method_cache_dir_, &error_msg)) {
+        LOG(WARNING) << "Not using the compiled method cache: " << error_msg;
+      }
+    }
+    std::unique_ptr<File> input_file;
+    if (input_compilation_record_fd_ != -1) {
+      input_file.reset(new File(DupCloexec(input_compilation_record_fd_),
+                                "input-compilation-record",
+                                /*check_usage=*/ false,
+                                /*read_only_mode=*/ true));
+    } else if (!input_compilation_record_.empty() &&
+               OS::FileExists(input_compilation_record_.c_str())) {
+      input_file.reset(OS::OpenFileForReading(input_compilation_record_.c_str()));
+      if (input_file == nullptr) {
+        PLOG(WARNING) << "Failed to open compilation record " << input_compilation_record_;
+      }
+    }
+    if (input_file != nullptr) {
+      std::string error_msg;
+      if (!compilation_record_->ReadPrevious(input_file.get(), &error_msg)) {
+        LOG(WARNING) << error_msg;
+      }
+    }
+    driver_->SetCompilationRecord(compilation_record_.get());
+  }
+
+  // Write the record of this compilation. Failing to write it does not fail the compilation,
+  // the next compilation will just not be able to reuse any code.
+  void WriteCompilationRecord() {
+    if (compilation_record_ == nullptr ||
+        (output_compilation_record_.empty() && output_compilation_record_fd_ == -1)) {
+      return;
+    }
+    TimingLogger::ScopedTiming t("dex2oat Write compilation record", timings_);
+    std::unique_ptr<File> output_file;
+    if (output_compilation_record_fd_ != -1) {
+      output_file.reset(new File(DupCloexec(output_compilation_record_fd_),
+                                 "output-compilation-record",
+                                 /*check_usage=*/ true));
+      if (output_file->SetLength(0) != 0) {
+        PLOG(WARNING) << "Failed to truncate compilation record";
+        output_file->Erase();
+        return;
+      }
+    } else {
+      output_file.reset(OS::CreateEmptyFile(output_compilation_record_.c_str()));
+      if (output_file == nullptr) {
+        PLOG(WARNING) << "Failed to create compilation record " << output_compilation_record_;
+        return;
+      }
+    }
+    std::string error_msg;
+    if (!compilation_record_->Write(*driver_, output_file.get(), &error_msg)) {
+      LOG(WARNING) << error_msg;
+      output_file->Erase();
+      return;
+    }
+    if (output_file->FlushCloseOrErase() != 0) {
+      PLOG(WARNING) << "Failed to flush and close compilation record " << output_file->GetPath();
     }
   }
 
+  // Add the compiled methods to the compiled method cache, if any. Like the compilation
+  // record, the cache is best effort.
+  void WriteCompiledMethodCache() {
+    if (compilation_record_ == nullptr) {
+      return;
+    }
+    TimingLogger::ScopedTiming t("dex2oat Write compiled method cache", timings_);
+    compilation_record_->WriteToCache(*driver_);
+  }
+
   bool IsImage() const {
     return IsAppImage() || IsBootImage() || IsBootImageExtension();
   }
@@ -2476,14 +2612,21 @@ class Dex2Oat final {
       // Don't use swap, we know generation should succeed, and we don't want to slow it down.
       return false;
     }
-    if (dex_files.size() < min_dex_files_for_swap_) {
-      // If there are less dex files than the threshold, assume it's gonna be fine.
-      return false;
-    }
     size_t dex_files_size = 0;
     for (const auto* dex_file : dex_files) {
       dex_files_size += dex_file->GetHeader().file_size_;
     }
+    if (memory_budget_mb_ != 0u) {
+      // The compiled code is kept until the oat file is written. Use swap if keeping it in
+      // memory is expected to exceed the budget, regardless of the thresholds below.
+      size_t expected_footprint = MemoryBudget::GetResidentSetSize() +
+                                  MemoryBudget::EstimateCompiledCodeSize(dex_files_size);
+      return expected_footprint > memory_budget_mb_ * MB;
+    }
+    if (dex_files.size() < min_dex_files_for_swap_) {
+      // If there are less dex files than the threshold, assume it's gonna be fine.
+      return false;
+    }
     return dex_files_size >= min_dex_file_cumulative_size_for_swap_;
   }
 
@@ -2904,6 +3047,7 @@ class Dex2Oat final {
   std::vector<OutputStream*> rodata_;
   std::vector<std::unique_ptr<OutputStream>> vdex_out_;
   std::unique_ptr<linker::ImageWriter> image_writer_;
+  std::unique_ptr<CompilationRecord> compilation_record_;
   std::unique_ptr<CompilerDriver> driver_;
 
   std::vector<MemMap> opened_dex_files_maps_;
@@ -2915,9 +3059,15 @@ class Dex2Oat final {
   int swap_fd_;
   size_t min_dex_files_for_swap_ = kDefaultMinDexFilesForSwap;
   size_t min_dex_file_cumulative_size_for_swap_ = kDefaultMinDexFileCumulativeSizeForSwap;
+  size_t memory_budget_mb_ = 0u;
   size_t very_large_threshold_ = std::numeric_limits<size_t>::max();
   std::string app_image_file_name_;
   int app_image_fd_;
+  std::string input_compilation_record_;
+  int input_compilation_record_fd_;
+  std::string output_compilation_record_;
+  int output_compilation_record_fd_;
+  std::string compiled_method_cache_dir_;
   std::vector<std::string> profile_files_;
   std::vector<int> profile_file_fds_;
   std::unique_ptr<ProfileCompilationInfo> profile_compilation_info_;
@@ -3019,6 +3169,9 @@ static dex2oat::ReturnCode DoCompilation(Dex2Oat& dex2oat) {
     return dex2oat::ReturnCode::kOther;
   }
 
+  dex2oat.WriteCompilationRecord();
+  dex2oat.WriteCompiledMethodCache();
+
   // Creates the boot.art and patches the oat files.
   if (!dex2oat.HandleImage()) {
     return dex2oat::ReturnCode::kOther;
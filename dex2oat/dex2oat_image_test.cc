@@ -16,6 +16,7 @@
 
 #include <fstream>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -34,15 +35,19 @@
 #include "base/file_utils.h"
 #include "base/macros.h"
 #include "base/mem_map.h"
+#include "base/stl_util.h"
 #include "base/string_view_cpp20.h"
 #include "base/unix_file/fd_file.h"
 #include "base/utils.h"
 #include "dex/art_dex_file_loader.h"
+#include "dex/class_accessor-inl.h"
 #include "dex/dex_file-inl.h"
 #include "dex/dex_file_loader.h"
 #include "dex/method_reference.h"
 #include "dex/type_reference.h"
 #include "gc/space/image_space.h"
+#include "oat_file.h"
+#include "oat_quick_method_header.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
@@ -662,4 +667,166 @@ TEST_F(Dex2oatImageTest, TestExtension) {
   }
 }
 
+TEST_F(Dex2oatImageTest, DeduplicateCodeInfoAcrossImages) {
+  TEST_DISABLED_FOR_MEMORY_TOOL_WITH_HEAP_POISONING_WITHOUT_READ_BARRIERS();
+  if (kIsTargetBuild) {
+    // This test is too slow for target builds.
+    return;
+  }
+  std::string error_msg;
+  MemMap reservation = ReserveCoreImageAddressSpace(&error_msg);
+  ASSERT_TRUE(reservation.IsValid()) << error_msg;
+
+  ScratchDir scratch;
+  const std::string& scratch_dir = scratch.GetPath();
+  std::string image_dir = scratch_dir + GetInstructionSetString(kRuntimeISA);
+  int mkdir_result = mkdir(image_dir.c_str(), 0700);
+  ASSERT_EQ(0, mkdir_result);
+  std::string filename_prefix = image_dir + "/boot";
+
+  // Copy the libcore dex files so that we do not load pre-compiled core images.
+  std::string jar_dir = scratch_dir + "jars";
+  mkdir_result = mkdir(jar_dir.c_str(), 0700);
+  ASSERT_EQ(0, mkdir_result);
+  jar_dir += '/';
+  std::vector<std::string> libcore_dex_files = GetLibCoreDexFileNames();
+  CopyDexFiles(jar_dir, &libcore_dex_files);
+  ArrayRef<const std::string> full_bcp(libcore_dex_files);
+
+  // Compile all methods into a multi-image boot image, one oat file per dex file.
+  ScratchFile profile_file;
+  GenerateBootProfile(full_bcp,
+                      profile_file.GetFile(),
+                      /*method_frequency=*/ 1u,
+                      /*type_frequency=*/ 1u);
+  std::vector<std::string> extra_args;
+  extra_args.push_back("--profile-file=" + profile_file.GetFilename());
+  extra_args.push_back("--compiler-filter=speed-profile");
+  extra_args.push_back("--deduplicate-across-images");
+  extra_args.push_back(android::base::StringPrintf("--base=0x%08x", kBaseAddress));
+  bool ok = CompileBootImage(extra_args, filename_prefix, full_bcp, &error_msg);
+  ASSERT_TRUE(ok) << error_msg;
+
+  reservation = MemMap::Invalid();  // Free the reserved memory for loading images.
+
+  // Load the oat files at their relative positions, shared CodeInfo is found by distance.
+  std::vector<std::unique_ptr<gc::space::ImageSpace>> boot_image_spaces;
+  MemMap extra_reservation;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    ok = gc::space::ImageSpace::LoadBootImage(/*boot_class_path=*/ libcore_dex_files,
+                                              /*boot_class_path_locations=*/ libcore_dex_files,
+                                              /*boot_class_path_fds=*/ std::vector<int>(),
+                                              /*boot_class_path_image_fds=*/ std::vector<int>(),
+                                              /*boot_class_path_vdex_fds=*/ std::vector<int>(),
+                                              /*boot_class_path_oat_fds=*/ std::vector<int>(),
+                                              { scratch_dir + "boot.art" },
+                                              kRuntimeISA,
+                                              /*relocate=*/ false,
+                                              /*executable=*/ true,
+                                              /*extra_reservation_size=*/ 0u,
+                                              &boot_image_spaces,
+                                              &extra_reservation);
+  }
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(full_bcp.size(), boot_image_spaces.size());
+
+  // Collect the method headers of each oat file.
+  std::vector<std::vector<const OatQuickMethodHeader*>> method_headers(boot_image_spaces.size());
+  for (size_t i = 0; i != boot_image_spaces.size(); ++i) {
+    const OatFile* oat_file = boot_image_spaces[i]->GetOatFile();
+    ASSERT_TRUE(oat_file != nullptr);
+    for (const OatDexFile* oat_dex_file : oat_file->GetOatDexFiles()) {
+      std::unique_ptr<const DexFile> dex_file = oat_dex_file->OpenDexFile(&error_msg);
+      ASSERT_TRUE(dex_file != nullptr) << error_msg;
+      for (ClassAccessor accessor : dex_file->GetClasses()) {
+        OatFile::OatClass oat_class = oat_dex_file->GetOatClass(accessor.GetClassDefIndex());
+        for (uint32_t method_index = 0; method_index != accessor.NumMethods(); ++method_index) {
+          const void* code = oat_class.GetOatMethod(method_index).GetQuickCode();
+          if (code != nullptr) {
+            const OatQuickMethodHeader* method_header =
+                OatQuickMethodHeader::FromEntryPoint(code);
+            if (method_header->IsOptimized()) {
+              method_headers[i].push_back(method_header);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // A method header points at a CodeInfo in its own oat file or, for an identical CodeInfo,
+  // at the copy written to an earlier oat file for one of its methods.
+  std::set<const uint8_t*> earlier_code_infos;
+  size_t num_shared = 0u;
+  for (size_t i = 0; i != boot_image_spaces.size(); ++i) {
+    const OatFile* oat_file = boot_image_spaces[i]->GetOatFile();
+    std::set<const uint8_t*> code_infos;
+    for (const OatQuickMethodHeader* method_header : method_headers[i]) {
+      const uint8_t* code_info = method_header->GetOptimizedCodeInfoPtr();
+      if (code_info >= oat_file->Begin() && code_info < oat_file->End()) {
+        code_infos.insert(code_info);
+      } else {
+        ASSERT_TRUE(ContainsElement(earlier_code_infos, code_info)) << "oat file " << i;
+        ++num_shared;
+      }
+      // The CodeInfo decodes to the size of code that ends within this oat file.
+      EXPECT_NE(method_header->GetCodeSize(), 0u);
+      EXPECT_LE(method_header->GetCode() + method_header->GetCodeSize(), oat_file->End());
+    }
+    earlier_code_infos.insert(code_infos.begin(), code_infos.end());
+  }
+  EXPECT_NE(num_shared, 0u);
+}
+
+// Test that resolving and verifying with several threads does not change the boot image.
+TEST_F(Dex2oatImageTest, ThreadCount) {
+  TEST_DISABLED_FOR_MEMORY_TOOL_WITH_HEAP_POISONING_WITHOUT_READ_BARRIERS();
+  if (kIsTargetBuild) {
+    // This test is too slow for target builds.
+    return;
+  }
+  // Compile only a subset of the libcore dex files to make this test shorter.
+  std::vector<std::string> libcore_dex_files = GetLibCoreDexFileNames();
+  ASSERT_NE(std::string::npos, libcore_dex_files[0].find("core-oj"));
+  ASSERT_NE(std::string::npos, libcore_dex_files[1].find("core-libart"));
+  ArrayRef<const std::string> dex_files =
+      ArrayRef<const std::string>(libcore_dex_files).SubArray(/*pos=*/ 0u, /*length=*/ 2u);
+
+  // Make all classes image classes so that most of them are resolved and initialized.
+  ScratchFile profile_file;
+  GenerateBootProfile(dex_files,
+                      profile_file.GetFile(),
+                      /*method_frequency=*/ 1u,
+                      /*type_frequency=*/ 1u);
+
+  ScratchDir scratch;
+  std::string filename_prefix = scratch.GetPath() + "boot";
+  std::vector<std::string> outputs;
+  for (const char* thread_arg : {"-j1", "-j4", "-j4"}) {
+    std::vector<std::string> extra_args;
+    extra_args.push_back("--profile-file=" + profile_file.GetFilename());
+    extra_args.push_back("--compiler-filter=speed-profile");
+    extra_args.push_back("--single-image");
+    extra_args.push_back("--avoid-storing-invocation");  // For comparison below.
+    extra_args.push_back(android::base::StringPrintf("--base=0x%08x", kBaseAddress));
+    extra_args.push_back(thread_arg);
+    std::string error_msg;
+    bool ok = CompileBootImage(extra_args, filename_prefix, dex_files, &error_msg);
+    ASSERT_TRUE(ok) << thread_arg << " " << error_msg;
+    // Keep the output, the image refers to the oat file by location so it must not change.
+    const std::string suffix = std::to_string(outputs.size() / 3u);
+    for (const char* extension : {".art", ".oat", ".vdex"}) {
+      std::string output = scratch.GetPath() + "threads" + suffix + extension;
+      ASSERT_EQ(0, rename((filename_prefix + extension).c_str(), output.c_str())) << output;
+      outputs.push_back(output);
+    }
+  }
+
+  // Verify that all runs produced the same files (art, oat and vdex).
+  for (size_t i = 3u; i != outputs.size(); ++i) {
+    EXPECT_TRUE(CompareFiles(outputs[i % 3u], outputs[i])) << outputs[i];
+  }
+}
+
 }  // namespace art
@@ -233,7 +233,14 @@ static void AddSwapMappings(Builder& builder) {
       .Define("--swap-dex-count-threshold=_")
           .WithType<unsigned int>()
           .WithHelp("specifies the minimum number of dex file to allow the use of swap.")
-          .IntoKey(M::SwapDexCountThreshold);
+          .IntoKey(M::SwapDexCountThreshold)
+      .Define("--memory-budget=_")
+          .WithType<unsigned int>()
+          .WithHelp("Specify the memory budget in megabytes. The swap file is used when the\n"
+                    "compiled code is expected to exceed the budget, overriding the swap\n"
+                    "thresholds, and fewer threads compile while the resident memory is over\n"
+                    "the budget. Eg: --memory-budget=512")
+          .IntoKey(M::MemoryBudget);
 }
 
 static void AddCompilerMappings(Builder& builder) {
@@ -255,7 +262,37 @@ static void AddCompilerMappings(Builder& builder) {
           .IntoKey(M::ProfileFd)
       .Define("--no-inline-from=_")
           .WithType<std::string>()
-          .IntoKey(M::NoInlineFrom);
+          .IntoKey(M::NoInlineFrom)
+      .Define("--input-compilation-record=_")
+          .WithType<std::string>()
+          .WithHelp("Specify the compilation record of a previous compilation of the same app.\n"
+                    "The code of methods that did not change since is reused instead of\n"
+                    "being compiled again. Not supported for images.\n"
+                    "Eg: --input-compilation-record=/data/misc/app.icr")
+          .IntoKey(M::InputCompilationRecord)
+      .Define("--input-compilation-record-fd=_")
+          .WithType<int>()
+          .WithHelp("Same as --input-compilation-record but takes a file descriptor.")
+          .IntoKey(M::InputCompilationRecordFd)
+      .Define("--output-compilation-record=_")
+          .WithType<std::string>()
+          .WithHelp("Specify a file to write the compilation record to, for use with\n"
+                    "--input-compilation-record in a later compilation.")
+          .IntoKey(M::OutputCompilationRecord)
+      .Define("--output-compilation-record-fd=_")
+          .WithType<int>()
+          .WithHelp("Same as --output-compilation-record but takes a file descriptor.")
+          .IntoKey(M::OutputCompilationRecordFd)
+      .Define("--compiled-method-cache-dir=_")
+          .WithType<std::string>()
+          .WithHelp("Specify a directory of compiled methods shared by compilations of different\n"
+                    "apps. Methods of dex files that depend only on themselves and the boot\n"
+                    "class path are looked up there before being compiled, and added to it\n"
+                    "after compilation. The directory must be owned by the user running\n"
+                    "dex2oat and not be writable by group or others, as its entries are\n"
+                    "trusted as compiled code. Not supported for images.\n"
+                    "Eg: --compiled-method-cache-dir=/data/misc/dex2oat-cache")
+          .IntoKey(M::CompiledMethodCacheDir);
 }
 
 static void AddTargetMappings(Builder& builder) {
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -41,6 +44,7 @@
 #include "dex/code_item_accessors-inl.h"
 #include "dex/dex_file-inl.h"
 #include "dex/dex_file_loader.h"
+#include "dex/string_lookup_table.h"
 #include "dex2oat_environment_test.h"
 #include "elf_file.h"
 #include "elf_file_impl.h"
@@ -1209,7 +1213,53 @@ TEST_F(Dex2oatClassLoaderContextTest, ContextWithSharedLibrariesDependenciesAndI
           /*generate_image=*/ true);
 }
 
-class Dex2oatDeterminism : public Dex2oatTest {};
+class Dex2oatDeterminism : public Dex2oatTest {
+ protected:
+  struct ReuseStats {
+    size_t reused = 0u;
+    size_t reusable = 0u;
+    size_t cache_hits = 0u;
+  };
+
+  // Parse the methods reused from a compilation record or the compiled method cache, as
+  // logged by the last compilation with --dump-timings. The output of all compilations of
+  // the test accumulates in `output_`.
+  ReuseStats ParseReuseStats() {
+    std::regex stats_regex("Reused ([0-9]+) of ([0-9]+) methods from the input compilation "
+                           "record and ([0-9]+) methods from the compiled method cache");
+    std::smatch stats_match;
+    bool found = false;
+    for (auto it = std::sregex_iterator(output_.begin(), output_.end(), stats_regex);
+         it != std::sregex_iterator();
+         ++it) {
+      stats_match = *it;
+      found = true;
+    }
+    if (!found) {
+      EXPECT_TRUE(found) << output_;
+      return ReuseStats();
+    }
+    ReuseStats stats;
+    stats.reused = std::stoul(stats_match[1].str());
+    stats.reusable = std::stoul(stats_match[2].str());
+    stats.cache_hits = std::stoul(stats_match[3].str());
+    return stats;
+  }
+
+  std::vector<std::string> ListCacheEntries(const std::string& cache_dir) {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(cache_dir.c_str());
+    CHECK(dir != nullptr);
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        entries.push_back(cache_dir + "/" + entry->d_name);
+      }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+  }
+};
 
 TEST_F(Dex2oatDeterminism, UnloadCompile) {
   Runtime* const runtime = Runtime::Current();
@@ -1266,6 +1316,388 @@ TEST_F(Dex2oatDeterminism, UnloadCompile) {
       << unload_vdex_name << " " << no_unload_vdex_name;
 }
 
+// Test that verification with several threads produces the same output as single-threaded
+// verification when determinism is forced.
+TEST_F(Dex2oatDeterminism, ThreadCount) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  const std::string base_vdex_name = out_dir + "/base.vdex";
+  std::string error_msg;
+  std::vector<std::unique_ptr<File>> oat_files;
+  std::vector<std::unique_ptr<File>> vdex_files;
+  for (const char* thread_arg : {"-j1", "-j4", "-j4"}) {
+    const int res = GenerateOdexForTestWithStatus(
+        GetLibCoreDexFileNames(),
+        base_oat_name,
+        CompilerFilter::Filter::kVerify,
+        &error_msg,
+        {"--force-determinism", "--avoid-storing-invocation", thread_arg});
+    ASSERT_EQ(res, 0) << error_msg;
+    const std::string suffix = std::to_string(oat_files.size());
+    const std::string oat_name = out_dir + "/threads" + suffix + ".oat";
+    const std::string vdex_name = out_dir + "/threads" + suffix + ".vdex";
+    Copy(base_oat_name, oat_name);
+    Copy(base_vdex_name, vdex_name);
+    oat_files.emplace_back(OS::OpenFileForReading(oat_name.c_str()));
+    vdex_files.emplace_back(OS::OpenFileForReading(vdex_name.c_str()));
+    ASSERT_TRUE(oat_files.back() != nullptr);
+    ASSERT_TRUE(vdex_files.back() != nullptr);
+    EXPECT_GT(oat_files.back()->GetLength(), 0u);
+    EXPECT_GT(vdex_files.back()->GetLength(), 0u);
+  }
+  // Verify that all runs produced the same files (odex and vdex).
+  for (size_t i = 1; i != oat_files.size(); ++i) {
+    EXPECT_EQ(oat_files[0]->GetLength(), oat_files[i]->GetLength());
+    EXPECT_EQ(vdex_files[0]->GetLength(), vdex_files[i]->GetLength());
+    EXPECT_EQ(oat_files[0]->Compare(oat_files[i].get()), 0) << i;
+    EXPECT_EQ(vdex_files[0]->Compare(vdex_files[i].get()), 0) << i;
+  }
+}
+
+// Test that the order in which methods are compiled by several threads does not affect
+// the compiled code.
+TEST_F(Dex2oatDeterminism, CompileThreadCount) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  std::string error_msg;
+  std::vector<std::unique_ptr<File>> oat_files;
+  for (const char* thread_arg : {"-j1", "-j4"}) {
+    const int res = GenerateOdexForTestWithStatus(
+        {GetTestDexFileName("ManyMethods")},
+        base_oat_name,
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        {"--force-determinism", "--avoid-storing-invocation", thread_arg});
+    ASSERT_EQ(res, 0) << error_msg;
+    const std::string oat_name = out_dir + "/threads" + std::to_string(oat_files.size()) + ".oat";
+    Copy(base_oat_name, oat_name);
+    oat_files.emplace_back(OS::OpenFileForReading(oat_name.c_str()));
+    ASSERT_TRUE(oat_files.back() != nullptr);
+  }
+  EXPECT_EQ(oat_files[0]->GetLength(), oat_files[1]->GetLength());
+  EXPECT_EQ(oat_files[0]->Compare(oat_files[1].get()), 0);
+}
+
+// Test that copying and fixing up the app image with several threads produces the same
+// image as with one thread.
+TEST_F(Dex2oatDeterminism, AppImageThreadCount) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  const std::string base_art_name = out_dir + "/base.art";
+  std::string error_msg;
+  std::vector<std::unique_ptr<File>> art_files;
+  for (const char* thread_arg : {"-j1", "-j4"}) {
+    const int res = GenerateOdexForTestWithStatus(
+        {GetTestDexFileName("ManyMethods")},
+        base_oat_name,
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        {"--force-determinism",
+         "--avoid-storing-invocation",
+         "--app-image-file=" + base_art_name,
+         thread_arg});
+    ASSERT_EQ(res, 0) << error_msg;
+    const std::string art_name = out_dir + "/threads" + std::to_string(art_files.size()) + ".art";
+    Copy(base_art_name, art_name);
+    art_files.emplace_back(OS::OpenFileForReading(art_name.c_str()));
+    ASSERT_TRUE(art_files.back() != nullptr);
+    EXPECT_GT(art_files.back()->GetLength(), 0u);
+  }
+  EXPECT_EQ(art_files[0]->GetLength(), art_files[1]->GetLength());
+  EXPECT_EQ(art_files[0]->Compare(art_files[1].get()), 0);
+}
+
+// Test that a memory budget far below the footprint of dex2oat, which throttles compilation
+// down to one thread, does not affect the compiled code.
+TEST_F(Dex2oatDeterminism, MemoryBudget) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  std::string error_msg;
+  std::vector<std::unique_ptr<File>> oat_files;
+  for (bool with_budget : {false, true}) {
+    std::vector<std::string> extra_args =
+        {"--force-determinism", "--avoid-storing-invocation", "-j4"};
+    if (with_budget) {
+      extra_args.push_back("--memory-budget=1");
+    }
+    const int res = GenerateOdexForTestWithStatus(
+        {GetTestDexFileName("ManyMethods")},
+        base_oat_name,
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        extra_args);
+    ASSERT_EQ(res, 0) << error_msg;
+    if (with_budget) {
+      // The first sample, taken before the first work item, is over the budget and allows
+      // one fewer thread to compile.
+      std::regex budget_regex("memory budget=.* min threads=([0-9]+)/([0-9]+)"
+                              " throttle steps=([0-9]+)");
+      std::smatch budget_match;
+      ASSERT_TRUE(std::regex_search(output_, budget_match, budget_regex)) << output_;
+      EXPECT_LT(std::stoul(budget_match[1].str()), std::stoul(budget_match[2].str()));
+      EXPECT_NE(std::stoul(budget_match[3].str()), 0u);
+    }
+    const std::string oat_name = out_dir + "/budget" + std::to_string(oat_files.size()) + ".oat";
+    Copy(base_oat_name, oat_name);
+    oat_files.emplace_back(OS::OpenFileForReading(oat_name.c_str()));
+    ASSERT_TRUE(oat_files.back() != nullptr);
+  }
+  EXPECT_EQ(oat_files[0]->GetLength(), oat_files[1]->GetLength());
+  EXPECT_EQ(oat_files[0]->Compare(oat_files[1].get()), 0);
+}
+
+// Test that reusing the code recorded by a previous compilation produces the same output
+// as compiling everything again.
+TEST_F(Dex2oatDeterminism, CompilationRecord) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  const std::string first_record_name = out_dir + "/first.icr";
+  const std::string second_record_name = out_dir + "/second.icr";
+  const std::string full_oat_name = out_dir + "/full.oat";
+  const std::string incremental_oat_name = out_dir + "/incremental.oat";
+  std::string error_msg;
+  int res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("ManyMethods")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--force-determinism",
+       "--avoid-storing-invocation",
+       "--output-compilation-record=" + first_record_name});
+  ASSERT_EQ(res, 0) << error_msg;
+  Copy(base_oat_name, full_oat_name);
+  res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("ManyMethods")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--force-determinism",
+       "--avoid-storing-invocation",
+       "--dump-timings",
+       "--input-compilation-record=" + first_record_name,
+       "--output-compilation-record=" + second_record_name});
+  ASSERT_EQ(res, 0) << error_msg;
+  Copy(base_oat_name, incremental_oat_name);
+  // Nothing changed, so all recorded methods were reused.
+  ReuseStats stats = ParseReuseStats();
+  EXPECT_NE(stats.reusable, 0u);
+  EXPECT_EQ(stats.reused, stats.reusable);
+
+  std::unique_ptr<File> full_oat(OS::OpenFileForReading(full_oat_name.c_str()));
+  std::unique_ptr<File> incremental_oat(OS::OpenFileForReading(incremental_oat_name.c_str()));
+  std::unique_ptr<File> first_record(OS::OpenFileForReading(first_record_name.c_str()));
+  std::unique_ptr<File> second_record(OS::OpenFileForReading(second_record_name.c_str()));
+  ASSERT_TRUE(full_oat != nullptr);
+  ASSERT_TRUE(incremental_oat != nullptr);
+  ASSERT_TRUE(first_record != nullptr);
+  ASSERT_TRUE(second_record != nullptr);
+  EXPECT_EQ(full_oat->GetLength(), incremental_oat->GetLength());
+  EXPECT_EQ(full_oat->Compare(incremental_oat.get()), 0);
+  // All methods were reused, so the second record has the same contents as the first one.
+  EXPECT_GT(first_record->GetLength(), 0u);
+  EXPECT_EQ(first_record->GetLength(), second_record->GetLength());
+  EXPECT_EQ(first_record->Compare(second_record.get()), 0);
+}
+
+// Test that the recorded code of a method is not reused when its code item or the code item
+// of a method it inlined changed, and that the other methods are still reused.
+TEST_F(Dex2oatDeterminism, CompilationRecordInvalidation) {
+  std::string out_dir = GetScratchDir();
+  const std::string base_oat_name = out_dir + "/base.oat";
+  const std::string record_name = out_dir + "/base.icr";
+  const std::string full_oat_name = out_dir + "/full.oat";
+  const std::string incremental_oat_name = out_dir + "/incremental.oat";
+  std::string error_msg;
+
+  // Compile the modified dex file without a record, for comparison.
+  int res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecordModified")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--force-determinism", "--avoid-storing-invocation"});
+  ASSERT_EQ(res, 0) << error_msg;
+  Copy(base_oat_name, full_oat_name);
+
+  res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecord")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--force-determinism",
+       "--avoid-storing-invocation",
+       "--output-compilation-record=" + record_name});
+  ASSERT_EQ(res, 0) << error_msg;
+
+  // callee() changed and caller() inlines it, the other methods are unchanged.
+  res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecordModified")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--force-determinism",
+       "--avoid-storing-invocation",
+       "--dump-timings",
+       "--input-compilation-record=" + record_name});
+  ASSERT_EQ(res, 0) << error_msg;
+  ReuseStats stats = ParseReuseStats();
+  ASSERT_GT(stats.reusable, 2u);
+  EXPECT_EQ(stats.reused, stats.reusable - 2u);
+  Copy(base_oat_name, incremental_oat_name);
+
+  std::unique_ptr<File> full_oat(OS::OpenFileForReading(full_oat_name.c_str()));
+  std::unique_ptr<File> incremental_oat(OS::OpenFileForReading(incremental_oat_name.c_str()));
+  ASSERT_TRUE(full_oat != nullptr);
+  ASSERT_TRUE(incremental_oat != nullptr);
+  EXPECT_EQ(full_oat->GetLength(), incremental_oat->GetLength());
+  EXPECT_EQ(full_oat->Compare(incremental_oat.get()), 0);
+}
+
+// Test that a malformed compilation record does not fail the compilation.
+TEST_F(Dex2oatTest, MalformedCompilationRecord) {
+  ScratchFile record;
+  const char garbage[] = "not a compilation record";
+  ASSERT_TRUE(record.GetFile()->WriteFully(garbage, sizeof(garbage)));
+  ASSERT_EQ(record.GetFile()->Flush(), 0);
+  std::string out_dir = GetScratchDir();
+  std::string error_msg;
+  int res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("ManyMethods")},
+      out_dir + "/base.oat",
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--input-compilation-record=" + record.GetFilename()});
+  EXPECT_EQ(res, 0) << error_msg;
+}
+
+// Test that reusing methods from the compiled method cache produces the same output as
+// compiling them, and that corrupted cache entries are ignored.
+TEST_F(Dex2oatDeterminism, CompiledMethodCache) {
+  std::string out_dir = GetScratchDir();
+  const std::string cache_dir = out_dir + "/cache";
+  ASSERT_EQ(mkdir(cache_dir.c_str(), 0700), 0);
+  const std::string base_oat_name = out_dir + "/base.oat";
+
+  std::vector<std::unique_ptr<File>> oat_files;
+  std::vector<std::string> cache_entries;
+  for (const char* name : { "uncached", "cached", "corrupted" }) {
+    std::string error_msg;
+    int res = GenerateOdexForTestWithStatus(
+        {GetTestDexFileName("ManyMethods")},
+        base_oat_name,
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        {"--force-determinism",
+         "--avoid-storing-invocation",
+         "--dump-timings",
+         "--compiled-method-cache-dir=" + cache_dir});
+    ASSERT_EQ(res, 0) << error_msg;
+    const std::string oat_name = out_dir + "/" + name + ".oat";
+    Copy(base_oat_name, oat_name);
+    oat_files.emplace_back(OS::OpenFileForReading(oat_name.c_str()));
+    ASSERT_TRUE(oat_files.back() != nullptr);
+
+    size_t cache_hits = ParseReuseStats().cache_hits;
+    if (cache_entries.empty()) {
+      // ManyMethods only references classes of its own and of the boot class path.
+      EXPECT_EQ(cache_hits, 0u);
+      cache_entries = ListCacheEntries(cache_dir);
+      ASSERT_FALSE(cache_entries.empty());
+    } else {
+      // All methods come from the cache unless its entries were corrupted.
+      EXPECT_EQ(cache_hits, (oat_files.size() == 2u) ? cache_entries.size() : 0u);
+      EXPECT_EQ(cache_entries, ListCacheEntries(cache_dir));
+    }
+    if (oat_files.size() == 2u) {
+      const char garbage[] = "not a cache entry";
+      for (const std::string& entry : cache_entries) {
+        std::unique_ptr<File> file(OS::CreateEmptyFile(entry.c_str()));
+        ASSERT_TRUE(file != nullptr);
+        ASSERT_TRUE(file->WriteFully(garbage, sizeof(garbage)));
+        ASSERT_EQ(file->FlushCloseOrErase(), 0);
+      }
+    }
+  }
+  for (size_t i = 1; i != oat_files.size(); ++i) {
+    EXPECT_EQ(oat_files[0]->GetLength(), oat_files[i]->GetLength());
+    EXPECT_EQ(oat_files[0]->Compare(oat_files[i].get()), 0);
+  }
+}
+
+// Test that a method whose code item or whose inlined callee changed misses the compiled
+// method cache, while the other methods of the dex file are still found there.
+TEST_F(Dex2oatDeterminism, CompiledMethodCacheMiss) {
+  std::string out_dir = GetScratchDir();
+  const std::string cache_dir = out_dir + "/cache";
+  ASSERT_EQ(mkdir(cache_dir.c_str(), 0700), 0);
+  const std::string base_oat_name = out_dir + "/base.oat";
+  const std::string full_oat_name = out_dir + "/full.oat";
+  const std::string cached_oat_name = out_dir + "/cached.oat";
+  const std::vector<std::string> args = {"--force-determinism",
+                                         "--avoid-storing-invocation",
+                                         "--dump-timings"};
+  const std::string cache_arg = "--compiled-method-cache-dir=" + cache_dir;
+  std::string error_msg;
+
+  // Compile the modified dex file without the cache, for comparison.
+  int res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecordModified")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      args);
+  ASSERT_EQ(res, 0) << error_msg;
+  Copy(base_oat_name, full_oat_name);
+
+  std::vector<std::string> cache_args = args;
+  cache_args.push_back(cache_arg);
+  res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecord")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      cache_args);
+  ASSERT_EQ(res, 0) << error_msg;
+  size_t num_entries = ListCacheEntries(cache_dir).size();
+  ASSERT_NE(num_entries, 0u);
+
+  // callee() changed and caller() inlines it, the other methods are unchanged.
+  res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("CompilationRecordModified")},
+      base_oat_name,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      cache_args);
+  ASSERT_EQ(res, 0) << error_msg;
+  EXPECT_EQ(ParseReuseStats().cache_hits, num_entries - 2u);
+  Copy(base_oat_name, cached_oat_name);
+
+  std::unique_ptr<File> full_oat(OS::OpenFileForReading(full_oat_name.c_str()));
+  std::unique_ptr<File> cached_oat(OS::OpenFileForReading(cached_oat_name.c_str()));
+  ASSERT_TRUE(full_oat != nullptr);
+  ASSERT_TRUE(cached_oat != nullptr);
+  EXPECT_EQ(full_oat->GetLength(), cached_oat->GetLength());
+  EXPECT_EQ(full_oat->Compare(cached_oat.get()), 0);
+}
+
+// Test that a compiled method cache directory writable by others is not used.
+TEST_F(Dex2oatDeterminism, CompiledMethodCacheUntrustedDirectory) {
+  std::string out_dir = GetScratchDir();
+  const std::string cache_dir = out_dir + "/cache";
+  ASSERT_EQ(mkdir(cache_dir.c_str(), 0700), 0);
+  ASSERT_EQ(chmod(cache_dir.c_str(), 0770), 0);
+  std::string error_msg;
+  int res = GenerateOdexForTestWithStatus(
+      {GetTestDexFileName("ManyMethods")},
+      out_dir + "/base.oat",
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--compiled-method-cache-dir=" + cache_dir});
+  ASSERT_EQ(res, 0) << error_msg;
+  EXPECT_NE(output_.find("Not using the compiled method cache"), std::string::npos) << output_;
+  EXPECT_TRUE(ListCacheEntries(cache_dir).empty());
+}
+
 // Test that dexlayout section info is correctly written to the oat file for profile based
 // compilation.
 TEST_F(Dex2oatTest, LayoutSections) {
@@ -1428,6 +1860,136 @@ TEST_F(Dex2oatTest, LayoutSections) {
   }
 }
 
+TEST_F(Dex2oatTest, ProfileCodeLayout) {
+  using Hotness = ProfileCompilationInfo::MethodHotness;
+  std::unique_ptr<const DexFile> dex(OpenTestDexFile("ManyMethods"));
+  const dex::TypeId* type_id = dex->FindTypeId("LManyMethods;");
+  ASSERT_TRUE(type_id != nullptr);
+  const dex::ClassDef* class_def = dex->FindClassDef(dex->GetIndexForTypeId(*type_id));
+  ASSERT_TRUE(class_def != nullptr);
+  std::vector<uint16_t> methods;
+  for (const ClassAccessor::Method& method : ClassAccessor(*dex, *class_def).GetMethods()) {
+    if (method.GetCodeItemOffset() != 0u) {
+      methods.push_back(method.GetIndex());
+    }
+  }
+  ASSERT_GE(methods.size(), 8u);
+  // Alternate hot startup methods with hot methods that do not run at startup. By default,
+  // the hot methods that do not run at startup are laid out first.
+  std::vector<uint16_t> startup_methods;
+  std::vector<uint16_t> hot_methods;
+  for (size_t i = 0; i != methods.size(); ++i) {
+    ((i % 2u == 0u) ? startup_methods : hot_methods).push_back(methods[i]);
+  }
+  ProfileCompilationInfo info;
+  info.AddMethodsForDex(static_cast<Hotness::Flag>(Hotness::kFlagHot | Hotness::kFlagStartup),
+                        dex.get(),
+                        startup_methods.begin(),
+                        startup_methods.end());
+  info.AddMethodsForDex(Hotness::kFlagHot, dex.get(), hot_methods.begin(), hot_methods.end());
+  ScratchFile profile_file;
+  ASSERT_TRUE(info.Save(profile_file.GetFd()));
+
+  const std::string oat_filename = GetScratchDir() + "/base.oat";
+  std::string error_msg;
+  const int res = GenerateOdexForTestWithStatus(
+      {dex->GetLocation()},
+      oat_filename,
+      CompilerFilter::Filter::kSpeedProfile,
+      &error_msg,
+      {"--profile-file=" + profile_file.GetFilename(), "--profile-code-layout=true"});
+  ASSERT_EQ(res, 0) << error_msg;
+  std::unique_ptr<OatFile> odex_file(OatFile::Open(/*zip_fd=*/ -1,
+                                                   oat_filename.c_str(),
+                                                   oat_filename.c_str(),
+                                                   /*executable=*/ false,
+                                                   /*low_4gb=*/ false,
+                                                   dex->GetLocation(),
+                                                   &error_msg));
+  ASSERT_TRUE(odex_file != nullptr) << error_msg;
+  ASSERT_EQ(odex_file->GetOatDexFiles().size(), 1u);
+  const OatDexFile* oat_dex_file = odex_file->GetOatDexFiles()[0];
+  OatFile::OatClass oat_class = oat_dex_file->GetOatClass(dex->GetIndexForClassDef(*class_def));
+
+  // The code of all startup methods comes before the code of the other hot methods.
+  uint32_t max_startup_offset = 0u;
+  uint32_t min_other_offset = std::numeric_limits<uint32_t>::max();
+  uint32_t class_def_method_index = 0u;
+  for (const ClassAccessor::Method& method : ClassAccessor(*dex, *class_def).GetMethods()) {
+    uint32_t code_offset = oat_class.GetOatMethod(class_def_method_index).GetCodeOffset();
+    ++class_def_method_index;
+    if (ContainsElement(startup_methods, method.GetIndex())) {
+      ASSERT_NE(code_offset, 0u);
+      max_startup_offset = std::max(max_startup_offset, code_offset);
+    } else if (ContainsElement(hot_methods, method.GetIndex())) {
+      ASSERT_NE(code_offset, 0u);
+      min_other_offset = std::min(min_other_offset, code_offset);
+    }
+  }
+  // Identical code is shared, so a hot method may use the code of a startup method.
+  EXPECT_LE(max_startup_offset, min_other_offset);
+}
+
+TEST_F(Dex2oatTest, ProfileCodeLayoutCallAffinity) {
+  using Hotness = ProfileCompilationInfo::MethodHotness;
+  std::unique_ptr<const DexFile> dex(OpenTestDexFile("CodeLayout"));
+  const dex::TypeId* type_id = dex->FindTypeId("LCodeLayout;");
+  ASSERT_TRUE(type_id != nullptr);
+  const dex::ClassDef* class_def = dex->FindClassDef(dex->GetIndexForTypeId(*type_id));
+  ASSERT_TRUE(class_def != nullptr);
+  std::map<std::string, uint16_t> method_indexes;
+  for (const ClassAccessor::Method& method : ClassAccessor(*dex, *class_def).GetMethods()) {
+    method_indexes.emplace(dex->GetMethodName(method.GetIndex()), method.GetIndex());
+  }
+  const std::vector<std::string> hot_method_names = {"a0Caller", "a1Other", "a2Other", "a3Callee"};
+  std::vector<uint16_t> hot_methods;
+  for (const std::string& name : hot_method_names) {
+    ASSERT_TRUE(method_indexes.find(name) != method_indexes.end()) << name;
+    hot_methods.push_back(method_indexes[name]);
+  }
+  ProfileCompilationInfo info;
+  info.AddMethodsForDex(Hotness::kFlagHot, dex.get(), hot_methods.begin(), hot_methods.end());
+  ScratchFile profile_file;
+  ASSERT_TRUE(info.Save(profile_file.GetFd()));
+
+  const std::string oat_filename = GetScratchDir() + "/base.oat";
+  std::string error_msg;
+  const int res = GenerateOdexForTestWithStatus(
+      {dex->GetLocation()},
+      oat_filename,
+      CompilerFilter::Filter::kSpeedProfile,
+      &error_msg,
+      {"--profile-file=" + profile_file.GetFilename(), "--profile-code-layout=true"});
+  ASSERT_EQ(res, 0) << error_msg;
+  std::unique_ptr<OatFile> odex_file(OatFile::Open(/*zip_fd=*/ -1,
+                                                   oat_filename.c_str(),
+                                                   oat_filename.c_str(),
+                                                   /*executable=*/ false,
+                                                   /*low_4gb=*/ false,
+                                                   dex->GetLocation(),
+                                                   &error_msg));
+  ASSERT_TRUE(odex_file != nullptr) << error_msg;
+  ASSERT_EQ(odex_file->GetOatDexFiles().size(), 1u);
+  const OatDexFile* oat_dex_file = odex_file->GetOatDexFiles()[0];
+  OatFile::OatClass oat_class = oat_dex_file->GetOatClass(dex->GetIndexForClassDef(*class_def));
+
+  std::map<std::string, uint32_t> code_offsets;
+  uint32_t class_def_method_index = 0u;
+  for (const ClassAccessor::Method& method : ClassAccessor(*dex, *class_def).GetMethods()) {
+    uint32_t code_offset = oat_class.GetOatMethod(class_def_method_index).GetCodeOffset();
+    ++class_def_method_index;
+    code_offsets.emplace(dex->GetMethodName(method.GetIndex()), code_offset);
+  }
+  for (const std::string& name : hot_method_names) {
+    ASSERT_NE(code_offsets[name], 0u) << name;
+  }
+  // The callee is placed right after its caller, ahead of the hot methods that come before it
+  // in the method order.
+  EXPECT_LT(code_offsets["a0Caller"], code_offsets["a3Callee"]);
+  EXPECT_LT(code_offsets["a3Callee"], code_offsets["a1Other"]);
+  EXPECT_LT(code_offsets["a3Callee"], code_offsets["a2Other"]);
+}
+
 // Test that generating compact dex works.
 TEST_F(Dex2oatTest, GenerateCompactDex) {
   // Generate a compact dex based odex.
@@ -1807,6 +2369,63 @@ TEST_F(Dex2oatTest, VerifyNoCompilationReason) {
   ASSERT_EQ(nullptr, odex_file->GetCompilationReason());
 }
 
+TEST_F(Dex2oatTest, StringLookupTables) {
+  std::string dex_location = GetScratchDir() + "/StringLookupTables.jar";
+  std::string odex_location = GetOdexDir() + "/StringLookupTables.odex";
+  Copy(GetTestDexFileName("MultiDex"), dex_location);
+
+  ASSERT_TRUE(GenerateOdexForTest(dex_location, odex_location, CompilerFilter::kVerify));
+  std::string error_msg;
+  std::unique_ptr<OatFile> odex_file(OatFile::Open(/*zip_fd=*/ -1,
+                                                   odex_location.c_str(),
+                                                   odex_location.c_str(),
+                                                   /*executable=*/ false,
+                                                   /*low_4gb=*/ false,
+                                                   dex_location,
+                                                   &error_msg));
+  ASSERT_TRUE(odex_file != nullptr) << error_msg;
+  std::vector<const OatDexFile*> oat_dex_files = odex_file->GetOatDexFiles();
+  ASSERT_EQ(oat_dex_files.size(), 2u);
+
+  // The vdex file has a string lookup table for each dex file.
+  const VdexFile* vdex_file = odex_file->GetVdexFile();
+  ASSERT_TRUE(vdex_file != nullptr);
+  ASSERT_TRUE(vdex_file->HasStringLookupTableSection());
+  uint32_t num_tables = 0u;
+  for (const uint8_t* table_data = vdex_file->GetNextStringLookupTableData(nullptr, 0u);
+       table_data != nullptr;
+       table_data = vdex_file->GetNextStringLookupTableData(table_data, ++num_tables)) {
+    ASSERT_LT(num_tables, oat_dex_files.size());
+    EXPECT_NE(reinterpret_cast<const uint32_t*>(table_data)[0], 0u) << num_tables;
+  }
+  EXPECT_EQ(num_tables, oat_dex_files.size());
+
+  // Lookups through the tables agree with the binary search of the dex files.
+  for (const OatDexFile* oat_dex_file : oat_dex_files) {
+    const StringLookupTable& table = oat_dex_file->GetStringLookupTable();
+    ASSERT_TRUE(table.Valid()) << oat_dex_file->GetDexFileLocation();
+    std::unique_ptr<const DexFile> dex_file = oat_dex_file->OpenDexFile(&error_msg);
+    ASSERT_TRUE(dex_file != nullptr) << error_msg;
+    ASSERT_EQ(dex_file->GetOatDexFile(), oat_dex_file);
+    for (uint32_t i = 0; i != dex_file->NumStringIds(); ++i) {
+      const dex::StringId& string_id = dex_file->GetStringId(dex::StringIndex(i));
+      const char* string = dex_file->GetStringData(string_id);
+      EXPECT_EQ(table.Lookup(*dex_file, string), i) << string;
+      EXPECT_EQ(OatDexFile::FindStringId(*dex_file, string), &string_id) << string;
+      EXPECT_EQ(dex_file->FindStringId(string), &string_id) << string;
+    }
+    for (uint32_t i = 0; i != dex_file->NumTypeIds(); ++i) {
+      const dex::TypeId& type_id = dex_file->GetTypeId(dex::TypeIndex(i));
+      const char* descriptor = dex_file->GetTypeDescriptor(type_id);
+      EXPECT_EQ(OatDexFile::FindTypeId(*dex_file, descriptor), &type_id) << descriptor;
+    }
+    static constexpr const char* kMissingString = "Not a string of the dex file";
+    EXPECT_EQ(table.Lookup(*dex_file, kMissingString), dex::kDexNoIndex);
+    EXPECT_TRUE(OatDexFile::FindStringId(*dex_file, kMissingString) == nullptr);
+    EXPECT_TRUE(dex_file->FindStringId(kMissingString) == nullptr);
+  }
+}
+
 TEST_F(Dex2oatTest, DontExtract) {
   std::unique_ptr<const DexFile> dex(OpenTestDexFile("ManyMethods"));
   std::string error_msg;
@@ -0,0 +1,1136 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compilation_record.h"
+
+#include <openssl/sha.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+
+#include "android-base/stringprintf.h"
+
+#include "arch/instruction_set_features.h"
+#include "base/leb128.h"
+#include "base/logging.h"  // For VLOG.
+#include "class_linker.h"
+#include "compiled_method-inl.h"
+#include "compiler_driver.h"
+#include "dex/class_accessor-inl.h"
+#include "dex/class_reference.h"
+#include "dex/code_item_accessors-inl.h"
+#include "dex/dex_file-inl.h"
+#include "driver/compiled_method_storage.h"
+#include "driver/compiler_options.h"
+#include "linker/linker_patch.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "oat.h"
+#include "profile/profile_compilation_info.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+static constexpr std::array<uint8_t, 4> kRecordMagic { { 'i', 'c', 'r', '\n' } };
+static constexpr std::array<uint8_t, 4> kRecordVersion { { '0', '0', '1', '\0' } };
+static constexpr std::array<uint8_t, 4> kCacheEntryMagic { { 'i', 'c', 'm', '\n' } };
+static constexpr std::array<uint8_t, 4> kCacheEntryVersion { { '0', '0', '1', '\0' } };
+
+// Encoding of the dex file targeted by a linker patch, see EncodeTargetDexFile().
+static constexpr uint32_t kNoTargetDexFile = 0xffffffffu;
+static constexpr uint32_t kBootClassPathTargetFlag = 0x80000000u;
+
+namespace {
+
+class Sha1Hasher {
+ public:
+  Sha1Hasher() {
+    SHA1_Init(&ctx_);
+  }
+
+  void Update(const void* data, size_t size) {
+    SHA1_Update(&ctx_, data, size);
+  }
+
+  template <typename T>
+  void UpdateValue(T value) {
+    static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+    Update(&value, sizeof(value));
+  }
+
+  void UpdateString(std::string_view str) {
+    UpdateValue<uint32_t>(str.size());
+    Update(str.data(), str.size());
+  }
+
+  std::array<uint8_t, SHA_DIGEST_LENGTH> Finish() {
+    std::array<uint8_t, SHA_DIGEST_LENGTH> digest;
+    SHA1_Final(digest.data(), &ctx_);
+    return digest;
+  }
+
+ private:
+  SHA_CTX ctx_;
+};
+
+// A section of the data area holding variable-size items of one type. Items in the
+// section are referenced by their offset, which changes whenever any preceding item
+// changes. Hashing the section as a whole and references as offsets relative to the
+// start of the section makes the hash independent of other sections.
+class DataSection {
+ public:
+  DataSection(const DexFile& dex_file, uint16_t type)
+      : dex_file_(dex_file), begin_(0u), end_(0u) {
+    const dex::MapList* map_list = dex_file.GetMapList();
+    for (uint32_t i = 0; i != map_list->size_; ++i) {
+      if (map_list->list_[i].type_ == type) {
+        begin_ = map_list->list_[i].offset_;
+        end_ = dex_file.DataSize();
+      }
+    }
+    for (uint32_t i = 0; i != map_list->size_; ++i) {
+      uint32_t offset = map_list->list_[i].offset_;
+      if (offset > begin_ && offset < end_) {
+        end_ = offset;
+      }
+    }
+  }
+
+  void HashContents(Sha1Hasher* hasher) const {
+    hasher->UpdateValue(end_ - begin_);
+    hasher->Update(dex_file_.DataBegin() + begin_, end_ - begin_);
+  }
+
+  void HashReference(uint32_t offset, Sha1Hasher* hasher) const {
+    DCHECK(offset == 0u || (offset >= begin_ && offset < end_)) << dex_file_.GetLocation();
+    hasher->UpdateValue<uint32_t>((offset != 0u) ? offset - begin_ + 1u : 0u);
+  }
+
+ private:
+  const DexFile& dex_file_;
+  uint32_t begin_;
+  uint32_t end_;
+};
+
+class RecordReader {
+ public:
+  explicit RecordReader(ArrayRef<const uint8_t> data)
+      : ptr_(data.data()), end_(data.data() + data.size()) {}
+
+  bool ReadUnsigned(/*out*/ uint32_t* value) {
+    return DecodeUnsignedLeb128Checked(&ptr_, end_, value);
+  }
+
+  bool ReadBytes(size_t size, /*out*/ const uint8_t** data) {
+    if (static_cast<size_t>(end_ - ptr_) < size) {
+      return false;
+    }
+    *data = ptr_;
+    ptr_ += size;
+    return true;
+  }
+
+  template <size_t kSize>
+  bool ReadArray(/*out*/ std::array<uint8_t, kSize>* array) {
+    const uint8_t* data;
+    if (!ReadBytes(kSize, &data)) {
+      return false;
+    }
+    std::copy_n(data, kSize, array->begin());
+    return true;
+  }
+
+  bool ReadVector(/*out*/ std::vector<uint8_t>* vector) {
+    uint32_t size;
+    const uint8_t* data;
+    if (!ReadUnsigned(&size) || !ReadBytes(size, &data)) {
+      return false;
+    }
+    vector->assign(data, data + size);
+    return true;
+  }
+
+  bool IsAtEnd() const {
+    return ptr_ == end_;
+  }
+
+ private:
+  const uint8_t* ptr_;
+  const uint8_t* const end_;
+};
+
+template <size_t kSize>
+void WriteArray(const std::array<uint8_t, kSize>& array, /*inout*/ std::vector<uint8_t>* buffer) {
+  buffer->insert(buffer->end(), array.begin(), array.end());
+}
+
+void WriteBytes(ArrayRef<const uint8_t> data, /*inout*/ std::vector<uint8_t>* buffer) {
+  EncodeUnsignedLeb128(buffer, data.size());
+  buffer->insert(buffer->end(), data.begin(), data.end());
+}
+
+void HashTypeList(const dex::TypeList* type_list, Sha1Hasher* hasher) {
+  uint32_t size = (type_list != nullptr) ? type_list->Size() : 0u;
+  hasher->UpdateValue(size);
+  for (uint32_t i = 0; i != size; ++i) {
+    hasher->UpdateValue(type_list->GetTypeItem(i).type_idx_.index_);
+  }
+}
+
+void HashAnnotationSet(const dex::AnnotationSetItem* set_item,
+                       const DataSection& annotation_items,
+                       Sha1Hasher* hasher) {
+  uint32_t size = (set_item != nullptr) ? set_item->size_ : 0u;
+  hasher->UpdateValue(size);
+  for (uint32_t i = 0; i != size; ++i) {
+    annotation_items.HashReference(set_item->entries_[i], hasher);
+  }
+}
+
+void HashAnnotationsDirectory(const DexFile& dex_file,
+                              const dex::AnnotationsDirectoryItem* directory,
+                              const DataSection& annotation_items,
+                              Sha1Hasher* hasher) {
+  hasher->UpdateValue(directory != nullptr);
+  if (directory == nullptr) {
+    return;
+  }
+  HashAnnotationSet(dex_file.GetClassAnnotationSet(directory), annotation_items, hasher);
+  hasher->UpdateValue(directory->fields_size_);
+  const dex::FieldAnnotationsItem* fields = dex_file.GetFieldAnnotations(directory);
+  for (uint32_t i = 0; i != directory->fields_size_; ++i) {
+    hasher->UpdateValue(fields[i].field_idx_);
+    HashAnnotationSet(dex_file.GetFieldAnnotationSetItem(fields[i]), annotation_items, hasher);
+  }
+  hasher->UpdateValue(directory->methods_size_);
+  const dex::MethodAnnotationsItem* methods = dex_file.GetMethodAnnotations(directory);
+  for (uint32_t i = 0; i != directory->methods_size_; ++i) {
+    hasher->UpdateValue(methods[i].method_idx_);
+    HashAnnotationSet(dex_file.GetMethodAnnotationSetItem(methods[i]), annotation_items, hasher);
+  }
+  hasher->UpdateValue(directory->parameters_size_);
+  const dex::ParameterAnnotationsItem* parameters = dex_file.GetParameterAnnotations(directory);
+  for (uint32_t i = 0; i != directory->parameters_size_; ++i) {
+    hasher->UpdateValue(parameters[i].method_idx_);
+    const dex::AnnotationSetRefList* ref_list =
+        dex_file.GetParameterAnnotationSetRefList(&parameters[i]);
+    uint32_t size = (ref_list != nullptr) ? ref_list->size_ : 0u;
+    hasher->UpdateValue(size);
+    for (uint32_t j = 0; j != size; ++j) {
+      HashAnnotationSet(dex_file.GetSetRefItemItem(&ref_list->list_[j]), annotation_items, hasher);
+    }
+  }
+}
+
+// Hash everything in the dex file that compiled code may depend on, except method bodies.
+void HashLayout(const DexFile& dex_file, Sha1Hasher* hasher) {
+  hasher->UpdateValue(dex_file.NumStringIds());
+  for (uint32_t i = 0; i != dex_file.NumStringIds(); ++i) {
+    uint32_t utf16_length;
+    const char* data = dex_file.GetStringDataAndUtf16Length(dex::StringIndex(i), &utf16_length);
+    hasher->UpdateValue(utf16_length);
+    hasher->UpdateString(data);
+  }
+  hasher->UpdateValue(dex_file.NumTypeIds());
+  for (uint32_t i = 0; i != dex_file.NumTypeIds(); ++i) {
+    hasher->UpdateValue(dex_file.GetTypeId(dex::TypeIndex(i)).descriptor_idx_.index_);
+  }
+  hasher->UpdateValue(dex_file.NumProtoIds());
+  for (uint32_t i = 0; i != dex_file.NumProtoIds(); ++i) {
+    const dex::ProtoId& proto_id = dex_file.GetProtoId(dex::ProtoIndex(i));
+    hasher->UpdateValue(proto_id.shorty_idx_.index_);
+    hasher->UpdateValue(proto_id.return_type_idx_.index_);
+    HashTypeList(dex_file.GetProtoParameters(proto_id), hasher);
+  }
+  hasher->UpdateValue(dex_file.NumFieldIds());
+  for (uint32_t i = 0; i != dex_file.NumFieldIds(); ++i) {
+    const dex::FieldId& field_id = dex_file.GetFieldId(i);
+    hasher->UpdateValue(field_id.class_idx_.index_);
+    hasher->UpdateValue(field_id.type_idx_.index_);
+    hasher->UpdateValue(field_id.name_idx_.index_);
+  }
+  hasher->UpdateValue(dex_file.NumMethodIds());
+  for (uint32_t i = 0; i != dex_file.NumMethodIds(); ++i) {
+    const dex::MethodId& method_id = dex_file.GetMethodId(i);
+    hasher->UpdateValue(method_id.class_idx_.index_);
+    hasher->UpdateValue(method_id.proto_idx_.index_);
+    hasher->UpdateValue(method_id.name_idx_.index_);
+  }
+  hasher->UpdateValue(dex_file.NumMethodHandles());
+  for (uint32_t i = 0; i != dex_file.NumMethodHandles(); ++i) {
+    const dex::MethodHandleItem& method_handle = dex_file.GetMethodHandle(i);
+    hasher->UpdateValue(method_handle.method_handle_type_);
+    hasher->UpdateValue(method_handle.field_or_method_idx_);
+  }
+
+  DataSection encoded_arrays(dex_file, DexFile::kDexTypeEncodedArrayItem);
+  encoded_arrays.HashContents(hasher);
+  hasher->UpdateValue(dex_file.NumCallSiteIds());
+  for (uint32_t i = 0; i != dex_file.NumCallSiteIds(); ++i) {
+    encoded_arrays.HashReference(dex_file.GetCallSiteId(i).data_off_, hasher);
+  }
+
+  DataSection annotation_items(dex_file, DexFile::kDexTypeAnnotationItem);
+  annotation_items.HashContents(hasher);
+  hasher->UpdateValue(dex_file.NumClassDefs());
+  for (ClassAccessor accessor : dex_file.GetClasses()) {
+    const dex::ClassDef& class_def = accessor.GetClassDef();
+    hasher->UpdateValue(class_def.class_idx_.index_);
+    hasher->UpdateValue(class_def.access_flags_);
+    hasher->UpdateValue(class_def.superclass_idx_.index_);
+    HashTypeList(dex_file.GetInterfacesList(class_def), hasher);
+    encoded_arrays.HashReference(class_def.static_values_off_, hasher);
+    HashAnnotationsDirectory(
+        dex_file, dex_file.GetAnnotationsDirectory(class_def), annotation_items, hasher);
+    hasher->UpdateValue(accessor.NumFields());
+    for (const ClassAccessor::Field& field : accessor.GetFields()) {
+      hasher->UpdateValue(field.GetIndex());
+      hasher->UpdateValue(field.GetAccessFlags());
+    }
+    hasher->UpdateValue(accessor.NumMethods());
+    for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      hasher->UpdateValue(method.GetIndex());
+      hasher->UpdateValue(method.GetAccessFlags());
+      hasher->UpdateValue(method.GetCodeItemOffset() != 0u);
+    }
+  }
+}
+
+// Hash the parts of the code item that compiled code depends on. This excludes the
+// debug info which is read from the dex file when writing the oat file.
+std::array<uint8_t, SHA_DIGEST_LENGTH> ComputeCodeKey(const DexFile& dex_file,
+                                                      const dex::CodeItem* code_item) {
+  CodeItemDataAccessor accessor(dex_file, code_item);
+  Sha1Hasher hasher;
+  hasher.UpdateValue(accessor.RegistersSize());
+  hasher.UpdateValue(accessor.InsSize());
+  hasher.UpdateValue(accessor.OutsSize());
+  hasher.UpdateValue(accessor.TriesSize());
+  const uint8_t* insns = reinterpret_cast<const uint8_t*>(accessor.Insns());
+  const uint8_t* end = reinterpret_cast<const uint8_t*>(code_item) +
+                       dex_file.GetCodeItemSize(*code_item);
+  hasher.Update(insns, end - insns);
+  return hasher.Finish();
+}
+
+}  // namespace
+
+struct CompilationRecord::PreviousMethod {
+  Digest method_key;
+  std::vector<MethodEntry> dependencies;
+  InstructionSet instruction_set;
+  bool is_intrinsic;
+  std::vector<uint8_t> code;
+  std::vector<uint8_t> vmap_table;
+  std::vector<uint8_t> cfi_info;
+  std::vector<linker::LinkerPatch> patches;
+
+  // Read everything but the keys and dependencies, as written by WriteMethodCode().
+  bool ReadCode(const std::vector<const DexFile*>& dex_files, RecordReader* reader);
+
+  CompiledMethod* Allocate(CompilerDriver* driver) const;
+};
+
+CompilationRecord::CompilationRecord(const CompilerOptions& compiler_options,
+                                     const SafeMap<std::string, std::string>& key_value_store)
+    : dex_files_(compiler_options.GetDexFilesForOatFile()),
+      profile_compilation_info_(compiler_options.GetProfileCompilationInfo()),
+      number_of_reused_methods_(0u),
+      number_of_cache_hits_(0u),
+      lock_("compilation record lock", kGenericBottomLock) {
+  Sha1Hasher compilation_hasher;
+  compilation_hasher.Update(OatHeader::kOatVersion.data(), OatHeader::kOatVersion.size());
+  compilation_hasher.UpdateValue(kIsDebugBuild);
+  compilation_hasher.UpdateValue(compiler_options.GetInstructionSet());
+  compilation_hasher.UpdateString(
+      compiler_options.GetInstructionSetFeatures()->GetFeatureString());
+  compilation_hasher.UpdateValue(compiler_options.GetCompilerFilter());
+  compilation_hasher.UpdateValue(compiler_options.IsAppImage());
+  compilation_hasher.UpdateValue(compiler_options.GetCompilePic());
+  compilation_hasher.UpdateValue(compiler_options.GetDebuggable());
+  compilation_hasher.UpdateValue(compiler_options.IsBaseline());
+  compilation_hasher.UpdateValue(compiler_options.GetGenerateDebugInfo());
+  compilation_hasher.UpdateValue(compiler_options.GetGenerateMiniDebugInfo());
+  compilation_hasher.UpdateValue(compiler_options.GetImplicitNullChecks());
+  compilation_hasher.UpdateValue(compiler_options.GetImplicitStackOverflowChecks());
+  compilation_hasher.UpdateValue(compiler_options.GetImplicitSuspendChecks());
+  compilation_hasher.UpdateValue(compiler_options.GetInlineMaxCodeUnits());
+  compilation_hasher.UpdateValue(compiler_options.GetHugeMethodThreshold());
+  compilation_hasher.UpdateValue(compiler_options.GetLargeMethodThreshold());
+  compilation_hasher.UpdateValue(compiler_options.GetRegisterAllocationStrategy());
+  compilation_hasher.UpdateValue(compiler_options.ColdBlockLayout());
+  compilation_hasher.UpdateValue(compiler_options.CountHotnessInCompiledCode());
+  compilation_hasher.UpdateValue(compiler_options.CompileArtTest());
+  const std::vector<std::string>* passes_to_run = compiler_options.GetPassesToRun();
+  compilation_hasher.UpdateValue(passes_to_run != nullptr);
+  if (passes_to_run != nullptr) {
+    for (const std::string& pass : *passes_to_run) {
+      compilation_hasher.UpdateString(pass);
+    }
+  }
+  compilation_hasher.UpdateValue(compiler_options.GetNoInlineFromDexFile().size());
+  for (const DexFile* dex_file : compiler_options.GetNoInlineFromDexFile()) {
+    compilation_hasher.UpdateString(dex_file->GetLocation());
+    compilation_hasher.UpdateValue(dex_file->GetLocationChecksum());
+  }
+  // The boot class path and class loader context keys include the checksums of the
+  // dex files that compiled code may inline from or make assumptions about.
+  auto hash_key = [&](Sha1Hasher* hasher, const char* key) {
+    auto it = key_value_store.find(key);
+    hasher->UpdateString(key);
+    hasher->UpdateValue(it != key_value_store.end());
+    if (it != key_value_store.end()) {
+      hasher->UpdateString(it->second);
+    }
+  };
+  for (const char* key : { OatHeader::kBootClassPathKey,
+                           OatHeader::kBootClassPathChecksumsKey,
+                           OatHeader::kApexVersionsKey,
+                           OatHeader::kDebuggableKey,
+                           OatHeader::kNativeDebuggableKey,
+                           OatHeader::kConcurrentCopying }) {
+    hash_key(&compilation_hasher, key);
+  }
+  // Code shared through the cache depends only on its own dex file and the boot class
+  // path, see SelectCacheableDexFiles().
+  Sha1Hasher cache_compilation_hasher = compilation_hasher;
+  cache_compilation_key_ = cache_compilation_hasher.Finish();
+  hash_key(&compilation_hasher, OatHeader::kClassPathKey);
+  compilation_key_ = compilation_hasher.Finish();
+
+  Sha1Hasher layout_hasher;
+  layout_hasher.UpdateValue(dex_files_.size());
+  code_keys_.resize(dex_files_.size());
+  dex_layout_keys_.reserve(dex_files_.size());
+  for (size_t i = 0; i != dex_files_.size(); ++i) {
+    const DexFile& dex_file = *dex_files_[i];
+    Sha1Hasher dex_layout_hasher;
+    HashLayout(dex_file, &dex_layout_hasher);
+    dex_layout_keys_.push_back(dex_layout_hasher.Finish());
+    layout_hasher.Update(dex_layout_keys_.back().data(), dex_layout_keys_.back().size());
+    std::vector<CodeKey>& code_keys = code_keys_[i];
+    code_keys.resize(dex_file.NumMethodIds(), CodeKey{Digest{}, 0u, false, false});
+    for (ClassAccessor accessor : dex_file.GetClasses()) {
+      for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+        CodeKey& code_key = code_keys[method.GetIndex()];
+        if (code_key.is_defined) {
+          continue;  // Duplicate method definition. The first one is used at runtime.
+        }
+        code_key.is_defined = true;
+        code_key.class_def_idx = accessor.GetClassDefIndex();
+        if (method.GetCodeItem() != nullptr) {
+          code_key.has_code = true;
+          code_key.digest = ComputeCodeKey(dex_file, method.GetCodeItem());
+        }
+      }
+    }
+  }
+  layout_key_ = layout_hasher.Finish();
+}
+
+CompilationRecord::~CompilationRecord() {}
+
+uint32_t CompilationRecord::GetDexFileIndex(const DexFile* dex_file) const {
+  return std::find(dex_files_.begin(), dex_files_.end(), dex_file) - dex_files_.begin();
+}
+
+CompilationRecord::Digest CompilationRecord::ComputeMethodKey(
+    const CompilerDriver& driver,
+    MethodEntry method,
+    const std::vector<MethodEntry>& dependencies,
+    bool for_cache) const {
+  Sha1Hasher hasher;
+  auto hash_method = [&](MethodEntry entry) {
+    const DexFile* dex_file = dex_files_[entry.first];
+    const CodeKey& code_key = code_keys_[entry.first][entry.second];
+    DCHECK(!for_cache || entry.first == method.first);
+    hasher.UpdateValue(for_cache ? 0u : entry.first);
+    hasher.UpdateValue(entry.second);
+    hasher.UpdateValue(code_key.is_defined);
+    hasher.UpdateValue(code_key.has_code);
+    hasher.Update(code_key.digest.data(), code_key.digest.size());
+    if (code_key.is_defined) {
+      hasher.UpdateValue(
+          driver.GetClassStatus(ClassReference(dex_file, code_key.class_def_idx)));
+    }
+    // Profile data of inlined methods is used when inlining their callees.
+    if (profile_compilation_info_ != nullptr) {
+      ProfileCompilationInfo::MethodHotness hotness =
+          profile_compilation_info_->GetMethodHotness(MethodReference(dex_file, entry.second));
+      hasher.UpdateValue(hotness.IsHot());
+      const ProfileCompilationInfo::InlineCacheMap* inline_caches = hotness.GetInlineCacheMap();
+      if (hotness.IsHot() && inline_caches != nullptr) {
+        hasher.UpdateValue(inline_caches->size());
+        for (const auto& [dex_pc, dex_pc_data] : *inline_caches) {
+          hasher.UpdateValue(dex_pc);
+          hasher.UpdateValue(dex_pc_data.is_missing_types);
+          hasher.UpdateValue(dex_pc_data.is_megamorphic);
+          hasher.UpdateValue(dex_pc_data.invoke_count);
+          hasher.UpdateValue(dex_pc_data.classes.size());
+          for (dex::TypeIndex type_index : dex_pc_data.classes) {
+            hasher.UpdateString(profile_compilation_info_->GetTypeDescriptor(dex_file, type_index));
+          }
+        }
+      }
+    }
+  };
+  hash_method(method);
+  hasher.UpdateValue(dependencies.size());
+  for (MethodEntry dependency : dependencies) {
+    hash_method(dependency);
+  }
+  return hasher.Finish();
+}
+
+void CompilationRecord::RecordCodeDependencies(MethodReference method,
+                                               ArrayRef<const MethodReference> dependencies) {
+  MethodEntry entry(GetDexFileIndex(method.dex_file), method.index);
+  if (entry.first == dex_files_.size()) {
+    return;
+  }
+  // Methods outside of the oat file are covered by the compilation key.
+  std::vector<MethodEntry> entries;
+  for (MethodReference dependency : dependencies) {
+    MethodEntry dependency_entry(GetDexFileIndex(dependency.dex_file), dependency.index);
+    if (dependency_entry.first != dex_files_.size() && dependency_entry != entry) {
+      entries.push_back(dependency_entry);
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  MutexLock mu(Thread::Current(), lock_);
+  dependencies_.insert_or_assign(entry, std::move(entries));
+}
+
+CompiledMethod* CompilationRecord::TryReuse(CompilerDriver* driver, MethodReference method_ref) {
+  MethodEntry entry(GetDexFileIndex(method_ref.dex_file), method_ref.index);
+  auto it = previous_methods_.find(entry);
+  if (it == previous_methods_.end()) {
+    return TryReuseFromCache(driver, entry);
+  }
+  const PreviousMethod& previous = *it->second;
+  if (ComputeMethodKey(*driver, entry, previous.dependencies, /*for_cache=*/ false) !=
+      previous.method_key) {
+    return TryReuseFromCache(driver, entry);
+  }
+  CompiledMethod* compiled_method = previous.Allocate(driver);
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    dependencies_.insert_or_assign(entry, previous.dependencies);
+  }
+  number_of_reused_methods_.fetch_add(1u, std::memory_order_relaxed);
+  return compiled_method;
+}
+
+static bool EncodeTargetDexFile(const std::vector<const DexFile*>& dex_files,
+                                const DexFile* dex_file,
+                                /*out*/ uint32_t* value) {
+  if (dex_file == nullptr) {
+    *value = kNoTargetDexFile;
+    return true;
+  }
+  auto it = std::find(dex_files.begin(), dex_files.end(), dex_file);
+  if (it != dex_files.end()) {
+    *value = it - dex_files.begin();
+    return true;
+  }
+  const std::vector<const DexFile*>& boot_class_path =
+      Runtime::Current()->GetClassLinker()->GetBootClassPath();
+  it = std::find(boot_class_path.begin(), boot_class_path.end(), dex_file);
+  if (it != boot_class_path.end()) {
+    *value = (it - boot_class_path.begin()) | kBootClassPathTargetFlag;
+    return true;
+  }
+  return false;
+}
+
+static bool DecodeTargetDexFile(const std::vector<const DexFile*>& dex_files,
+                                uint32_t value,
+                                /*out*/ const DexFile** dex_file) {
+  if (value == kNoTargetDexFile) {
+    *dex_file = nullptr;
+    return true;
+  }
+  const std::vector<const DexFile*>& target_dex_files = ((value & kBootClassPathTargetFlag) != 0u)
+      ? Runtime::Current()->GetClassLinker()->GetBootClassPath()
+      : dex_files;
+  uint32_t index = value & ~kBootClassPathTargetFlag;
+  if (index >= target_dex_files.size()) {
+    return false;
+  }
+  *dex_file = target_dex_files[index];
+  return true;
+}
+
+// Encodes a patch as its type, literal offset, target dex file and two values.
+static bool EncodeLinkerPatch(const std::vector<const DexFile*>& dex_files,
+                              const linker::LinkerPatch& patch,
+                              /*inout*/ std::vector<uint8_t>* buffer) {
+  using Type = linker::LinkerPatch::Type;
+  const DexFile* target_dex_file = nullptr;
+  uint32_t value1 = 0u;
+  uint32_t value2 = 0u;
+  switch (patch.GetType()) {
+    case Type::kIntrinsicReference:
+      value1 = patch.IntrinsicData();
+      value2 = patch.PcInsnOffset();
+      break;
+    case Type::kDataBimgRelRo:
+      value1 = patch.BootImageOffset();
+      value2 = patch.PcInsnOffset();
+      break;
+    case Type::kMethodRelative:
+    case Type::kMethodBssEntry:
+    case Type::kJniEntrypointRelative:
+      target_dex_file = patch.TargetMethod().dex_file;
+      value1 = patch.TargetMethod().index;
+      value2 = patch.PcInsnOffset();
+      break;
+    case Type::kCallRelative:
+      target_dex_file = patch.TargetMethod().dex_file;
+      value1 = patch.TargetMethod().index;
+      break;
+    case Type::kTypeRelative:
+    case Type::kTypeBssEntry:
+    case Type::kPublicTypeBssEntry:
+    case Type::kPackageTypeBssEntry:
+      target_dex_file = patch.TargetTypeDexFile();
+      value1 = patch.TargetTypeIndex().index_;
+      value2 = patch.PcInsnOffset();
+      break;
+    case Type::kStringRelative:
+    case Type::kStringBssEntry:
+      target_dex_file = patch.TargetStringDexFile();
+      value1 = patch.TargetStringIndex().index_;
+      value2 = patch.PcInsnOffset();
+      break;
+    case Type::kCallEntrypoint:
+      value1 = patch.EntrypointOffset();
+      break;
+    case Type::kBakerReadBarrierBranch:
+      value1 = patch.GetBakerCustomValue1();
+      value2 = patch.GetBakerCustomValue2();
+      break;
+  }
+  uint32_t target_dex_file_value;
+  if (!EncodeTargetDexFile(dex_files, target_dex_file, &target_dex_file_value)) {
+    return false;
+  }
+  buffer->push_back(static_cast<uint8_t>(patch.GetType()));
+  EncodeUnsignedLeb128(buffer, patch.LiteralOffset());
+  EncodeUnsignedLeb128(buffer, target_dex_file_value);
+  EncodeUnsignedLeb128(buffer, value1);
+  EncodeUnsignedLeb128(buffer, value2);
+  return true;
+}
+
+static bool DecodeLinkerPatch(const std::vector<const DexFile*>& dex_files,
+                              RecordReader* reader,
+                              /*out*/ std::vector<linker::LinkerPatch>* patches) {
+  using LinkerPatch = linker::LinkerPatch;
+  using Type = LinkerPatch::Type;
+  const uint8_t* type_data;
+  uint32_t literal_offset;
+  uint32_t target_dex_file_value;
+  uint32_t value1;
+  uint32_t value2;
+  const DexFile* target_dex_file;
+  if (!reader->ReadBytes(1u, &type_data) ||
+      !reader->ReadUnsigned(&literal_offset) ||
+      !reader->ReadUnsigned(&target_dex_file_value) ||
+      !reader->ReadUnsigned(&value1) ||
+      !reader->ReadUnsigned(&value2) ||
+      !IsUint<24>(literal_offset) ||
+      !DecodeTargetDexFile(dex_files, target_dex_file_value, &target_dex_file)) {
+    return false;
+  }
+  const DexFile* dex = target_dex_file;
+  switch (static_cast<Type>(*type_data)) {
+    case Type::kIntrinsicReference:
+      patches->push_back(LinkerPatch::IntrinsicReferencePatch(literal_offset, value2, value1));
+      return true;
+    case Type::kDataBimgRelRo:
+      patches->push_back(LinkerPatch::DataBimgRelRoPatch(literal_offset, value2, value1));
+      return true;
+    case Type::kMethodRelative:
+      patches->push_back(LinkerPatch::RelativeMethodPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kMethodBssEntry:
+      patches->push_back(LinkerPatch::MethodBssEntryPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kJniEntrypointRelative:
+      patches->push_back(
+          LinkerPatch::RelativeJniEntrypointPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kCallRelative:
+      patches->push_back(LinkerPatch::RelativeCodePatch(literal_offset, dex, value1));
+      return dex != nullptr;
+    case Type::kTypeRelative:
+      patches->push_back(LinkerPatch::RelativeTypePatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kTypeBssEntry:
+      patches->push_back(LinkerPatch::TypeBssEntryPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kPublicTypeBssEntry:
+      patches->push_back(
+          LinkerPatch::PublicTypeBssEntryPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kPackageTypeBssEntry:
+      patches->push_back(
+          LinkerPatch::PackageTypeBssEntryPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kStringRelative:
+      patches->push_back(LinkerPatch::RelativeStringPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kStringBssEntry:
+      patches->push_back(LinkerPatch::StringBssEntryPatch(literal_offset, dex, value2, value1));
+      return dex != nullptr;
+    case Type::kCallEntrypoint:
+      patches->push_back(LinkerPatch::CallEntrypointPatch(literal_offset, value1));
+      return true;
+    case Type::kBakerReadBarrierBranch:
+      patches->push_back(LinkerPatch::BakerReadBarrierBranchPatch(literal_offset, value1, value2));
+      return true;
+  }
+  return false;
+}
+
+bool CompilationRecord::PreviousMethod::ReadCode(const std::vector<const DexFile*>& dex_files,
+                                                 RecordReader* reader) {
+  const uint8_t* flags;
+  uint32_t number_of_patches;
+  if (!reader->ReadBytes(2u, &flags) ||
+      !reader->ReadVector(&code) ||
+      !reader->ReadVector(&vmap_table) ||
+      !reader->ReadVector(&cfi_info) ||
+      !reader->ReadUnsigned(&number_of_patches)) {
+    return false;
+  }
+  instruction_set = static_cast<InstructionSet>(flags[0]);
+  is_intrinsic = (flags[1] != 0u);
+  for (uint32_t i = 0; i != number_of_patches; ++i) {
+    if (!DecodeLinkerPatch(dex_files, reader, &patches)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+CompiledMethod* CompilationRecord::PreviousMethod::Allocate(CompilerDriver* driver) const {
+  CompiledMethod* compiled_method = CompiledMethod::SwapAllocCompiledMethod(
+      driver->GetCompiledMethodStorage(),
+      instruction_set,
+      ArrayRef<const uint8_t>(code),
+      ArrayRef<const uint8_t>(vmap_table),
+      ArrayRef<const uint8_t>(cfi_info),
+      ArrayRef<const linker::LinkerPatch>(patches));
+  if (is_intrinsic) {
+    compiled_method->MarkAsIntrinsic();
+  }
+  return compiled_method;
+}
+
+// Returns false if the code references a dex file that cannot be encoded.
+static bool WriteMethodCode(const std::vector<const DexFile*>& dex_files,
+                            const CompiledMethod* compiled_method,
+                            /*inout*/ std::vector<uint8_t>* buffer) {
+  std::vector<uint8_t> patches_buffer;
+  for (const linker::LinkerPatch& patch : compiled_method->GetPatches()) {
+    if (!EncodeLinkerPatch(dex_files, patch, &patches_buffer)) {
+      return false;
+    }
+  }
+  buffer->push_back(static_cast<uint8_t>(compiled_method->GetInstructionSet()));
+  buffer->push_back(compiled_method->IsIntrinsic() ? 1u : 0u);
+  WriteBytes(compiled_method->GetQuickCode(), buffer);
+  WriteBytes(compiled_method->GetVmapTable(), buffer);
+  WriteBytes(compiled_method->GetCFIInfo(), buffer);
+  EncodeUnsignedLeb128(buffer, compiled_method->GetPatches().size());
+  buffer->insert(buffer->end(), patches_buffer.begin(), patches_buffer.end());
+  return true;
+}
+
+static bool ReadFile(File* file, /*out*/ std::vector<uint8_t>* data) {
+  int64_t length = file->GetLength();
+  if (length < 0) {
+    return false;
+  }
+  data->resize(static_cast<size_t>(length));
+  return file->PreadFully(data->data(), data->size(), /*offset=*/ 0u);
+}
+
+bool CompilationRecord::ReadPrevious(File* file, /*out*/ std::string* error_msg) {
+  std::vector<uint8_t> data;
+  if (!ReadFile(file, &data)) {
+    *error_msg = StringPrintf("Failed to read compilation record '%s'", file->GetPath().c_str());
+    return false;
+  }
+  RecordReader reader{ArrayRef<const uint8_t>(data)};
+  auto malformed = [&]() {
+    *error_msg = StringPrintf("Malformed compilation record '%s'", file->GetPath().c_str());
+    previous_methods_.clear();
+    return false;
+  };
+
+  std::array<uint8_t, 4> magic;
+  std::array<uint8_t, 4> version;
+  if (!reader.ReadArray(&magic) || magic != kRecordMagic || !reader.ReadArray(&version)) {
+    return malformed();
+  }
+  Digest compilation_key;
+  Digest layout_key;
+  if (version != kRecordVersion ||
+      !reader.ReadArray(&compilation_key) ||
+      compilation_key != compilation_key_) {
+    VLOG(compiler) << "Compilation record " << file->GetPath()
+                   << " is from a different compilation, not reusing any code";
+    return true;
+  }
+  if (!reader.ReadArray(&layout_key) || layout_key != layout_key_) {
+    VLOG(compiler) << "Compilation record " << file->GetPath()
+                   << " is for different dex file layouts, not reusing any code";
+    return true;
+  }
+
+  auto is_valid_method = [&](MethodEntry entry) {
+    return entry.first < code_keys_.size() &&
+           entry.second < code_keys_[entry.first].size() &&
+           code_keys_[entry.first][entry.second].has_code;
+  };
+  uint32_t number_of_methods;
+  if (!reader.ReadUnsigned(&number_of_methods)) {
+    return malformed();
+  }
+  for (uint32_t i = 0; i != number_of_methods; ++i) {
+    MethodEntry entry;
+    std::unique_ptr<PreviousMethod> method(new PreviousMethod());
+    uint32_t number_of_dependencies;
+    if (!reader.ReadUnsigned(&entry.first) ||
+        !reader.ReadUnsigned(&entry.second) ||
+        !is_valid_method(entry) ||
+        !reader.ReadArray(&method->method_key) ||
+        !reader.ReadUnsigned(&number_of_dependencies)) {
+      return malformed();
+    }
+    for (uint32_t j = 0; j != number_of_dependencies; ++j) {
+      MethodEntry dependency;
+      if (!reader.ReadUnsigned(&dependency.first) ||
+          !reader.ReadUnsigned(&dependency.second) ||
+          dependency.first >= code_keys_.size() ||
+          dependency.second >= code_keys_[dependency.first].size()) {
+        return malformed();
+      }
+      method->dependencies.push_back(dependency);
+    }
+    if (!method->ReadCode(dex_files_, &reader)) {
+      return malformed();
+    }
+    previous_methods_[entry] = std::move(method);
+  }
+  if (!reader.IsAtEnd()) {
+    return malformed();
+  }
+  return true;
+}
+
+bool CompilationRecord::Write(const CompilerDriver& driver,
+                              File* file,
+                              /*out*/ std::string* error_msg) {
+  std::vector<uint8_t> methods_buffer;
+  uint32_t number_of_methods = 0u;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    for (const auto& [entry, dependencies] : dependencies_) {
+      CompiledMethod* compiled_method =
+          driver.GetCompiledMethod(MethodReference(dex_files_[entry.first], entry.second));
+      if (compiled_method == nullptr || compiled_method->GetQuickCode().empty()) {
+        continue;
+      }
+      std::vector<uint8_t> code_buffer;
+      if (!WriteMethodCode(dex_files_, compiled_method, &code_buffer)) {
+        continue;  // The code references a dex file we cannot find in a later compilation.
+      }
+      EncodeUnsignedLeb128(&methods_buffer, entry.first);
+      EncodeUnsignedLeb128(&methods_buffer, entry.second);
+      WriteArray(ComputeMethodKey(driver, entry, dependencies, /*for_cache=*/ false),
+                 &methods_buffer);
+      EncodeUnsignedLeb128(&methods_buffer, dependencies.size());
+      for (MethodEntry dependency : dependencies) {
+        EncodeUnsignedLeb128(&methods_buffer, dependency.first);
+        EncodeUnsignedLeb128(&methods_buffer, dependency.second);
+      }
+      methods_buffer.insert(methods_buffer.end(), code_buffer.begin(), code_buffer.end());
+      ++number_of_methods;
+    }
+  }
+
+  std::vector<uint8_t> buffer;
+  WriteArray(kRecordMagic, &buffer);
+  WriteArray(kRecordVersion, &buffer);
+  WriteArray(compilation_key_, &buffer);
+  WriteArray(layout_key_, &buffer);
+  EncodeUnsignedLeb128(&buffer, number_of_methods);
+  buffer.insert(buffer.end(), methods_buffer.begin(), methods_buffer.end());
+  if (!file->WriteFully(buffer.data(), buffer.size())) {
+    *error_msg = StringPrintf("Failed to write compilation record '%s'", file->GetPath().c_str());
+    return false;
+  }
+  VLOG(compiler) << "Wrote compilation record with " << number_of_methods << " methods";
+  return true;
+}
+
+void CompilationRecord::SelectCacheableDexFiles(jobject class_loader) {
+  if (cache_directory_.empty()) {
+    return;
+  }
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  const std::vector<const DexFile*>& boot_class_path = class_linker->GetBootClassPath();
+  auto is_boot_class = [&](const char* descriptor) {
+    for (const DexFile* boot_dex_file : boot_class_path) {
+      const dex::TypeId* type_id = boot_dex_file->FindTypeId(descriptor);
+      if (type_id != nullptr &&
+          boot_dex_file->FindClassDef(boot_dex_file->GetIndexForTypeId(*type_id)) != nullptr) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  ObjPtr<mirror::ClassLoader> loader = soa.Decode<mirror::ClassLoader>(class_loader);
+  cacheable_dex_files_.assign(dex_files_.size(), false);
+  for (size_t i = 0; i != dex_files_.size(); ++i) {
+    const DexFile& dex_file = *dex_files_[i];
+    bool cacheable = true;
+    for (uint32_t j = 0; cacheable && j != dex_file.NumTypeIds(); ++j) {
+      const char* descriptor = dex_file.GetTypeDescriptor(dex_file.GetTypeId(dex::TypeIndex(j)));
+      while (*descriptor == '[') {
+        ++descriptor;
+      }
+      if (*descriptor != 'L') {
+        continue;  // Primitive type.
+      }
+      const dex::TypeId* type_id = dex_file.FindTypeId(descriptor);
+      if (type_id != nullptr &&
+          dex_file.FindClassDef(dex_file.GetIndexForTypeId(*type_id)) != nullptr) {
+        // The class must have been loaded from this dex file and not from another one
+        // earlier in the class path.
+        ObjPtr<mirror::Class> klass = class_linker->LookupClass(self, descriptor, loader);
+        cacheable = (klass != nullptr) && (&klass->GetDexFile() == &dex_file);
+      } else {
+        // Classes of the boot class path are found first by any class loader.
+        cacheable = is_boot_class(descriptor);
+      }
+    }
+    cacheable_dex_files_[i] = cacheable;
+    VLOG(compiler) << "Dex file " << dex_file.GetLocation()
+                   << (cacheable ? " can" : " cannot") << " use the compiled method cache";
+  }
+}
+
+bool CompilationRecord::SetCacheDirectory(const std::string& directory,
+                                          /*out*/ std::string* error_msg) {
+  // Cache entries are loaded as compiled code, so only dex2oat may be able to write them.
+  struct stat st;
+  if (stat(directory.c_str(), &st) != 0) {
+    *error_msg = StringPrintf("Failed to stat %s: %s", directory.c_str(), strerror(errno));
+    return false;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    *error_msg = StringPrintf("%s is not a directory", directory.c_str());
+    return false;
+  }
+  if (st.st_uid != geteuid()) {
+    *error_msg = StringPrintf("%s is owned by uid %u rather than %u",
+                              directory.c_str(),
+                              static_cast<uint32_t>(st.st_uid),
+                              static_cast<uint32_t>(geteuid()));
+    return false;
+  }
+  if ((st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    *error_msg = StringPrintf("%s is writable by group or others", directory.c_str());
+    return false;
+  }
+  cache_directory_ = directory;
+  return true;
+}
+
+bool CompilationRecord::IsCacheable(MethodEntry method) const {
+  return method.first < cacheable_dex_files_.size() && cacheable_dex_files_[method.first];
+}
+
+CompilationRecord::Digest CompilationRecord::ComputeCacheKey(MethodEntry method) const {
+  Sha1Hasher hasher;
+  hasher.Update(cache_compilation_key_.data(), cache_compilation_key_.size());
+  hasher.Update(dex_layout_keys_[method.first].data(), dex_layout_keys_[method.first].size());
+  hasher.UpdateValue(method.second);
+  const Digest& code_key = code_keys_[method.first][method.second].digest;
+  hasher.Update(code_key.data(), code_key.size());
+  return hasher.Finish();
+}
+
+std::string CompilationRecord::GetCacheEntryPath(const Digest& cache_key) const {
+  std::string path = cache_directory_ + "/";
+  for (uint8_t byte : cache_key) {
+    path += StringPrintf("%02x", byte);
+  }
+  return path;
+}
+
+CompiledMethod* CompilationRecord::TryReuseFromCache(CompilerDriver* driver,
+                                                     MethodEntry entry) {
+  if (!IsCacheable(entry)) {
+    return nullptr;
+  }
+  Digest cache_key = ComputeCacheKey(entry);
+  std::string path = GetCacheEntryPath(cache_key);
+  std::unique_ptr<File> file(OS::OpenFileForReading(path.c_str()));
+  if (file == nullptr) {
+    return nullptr;
+  }
+  std::vector<uint8_t> data;
+  if (!ReadFile(file.get(), &data)) {
+    PLOG(WARNING) << "Failed to read compiled method cache entry " << path;
+    return nullptr;
+  }
+
+  // Entries are written by other compilations, possibly by other versions of dex2oat,
+  // so any mismatch is a miss rather than an error.
+  RecordReader reader{ArrayRef<const uint8_t>(data)};
+  std::array<uint8_t, 4> magic;
+  std::array<uint8_t, 4> version;
+  Digest entry_cache_key;
+  PreviousMethod method;
+  uint32_t number_of_dependencies;
+  if (!reader.ReadArray(&magic) ||
+      magic != kCacheEntryMagic ||
+      !reader.ReadArray(&version) ||
+      version != kCacheEntryVersion ||
+      !reader.ReadArray(&entry_cache_key) ||
+      entry_cache_key != cache_key ||
+      !reader.ReadArray(&method.method_key) ||
+      !reader.ReadUnsigned(&number_of_dependencies)) {
+    VLOG(compiler) << "Ignoring malformed compiled method cache entry " << path;
+    return nullptr;
+  }
+  const DexFile* dex_file = dex_files_[entry.first];
+  for (uint32_t i = 0; i != number_of_dependencies; ++i) {
+    MethodEntry dependency(entry.first, 0u);
+    if (!reader.ReadUnsigned(&dependency.second) ||
+        dependency.second >= dex_file->NumMethodIds()) {
+      VLOG(compiler) << "Ignoring malformed compiled method cache entry " << path;
+      return nullptr;
+    }
+    method.dependencies.push_back(dependency);
+  }
+  if (!method.ReadCode({ dex_file }, &reader) || !reader.IsAtEnd()) {
+    VLOG(compiler) << "Ignoring malformed compiled method cache entry " << path;
+    return nullptr;
+  }
+  if (ComputeMethodKey(*driver, entry, method.dependencies, /*for_cache=*/ true) !=
+      method.method_key) {
+    return nullptr;
+  }
+
+  CompiledMethod* compiled_method = method.Allocate(driver);
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    dependencies_.insert_or_assign(entry, method.dependencies);
+    cache_hits_.insert(entry);
+  }
+  number_of_cache_hits_.fetch_add(1u, std::memory_order_relaxed);
+  return compiled_method;
+}
+
+void CompilationRecord::WriteToCache(const CompilerDriver& driver) {
+  if (cache_directory_.empty()) {
+    return;
+  }
+  std::vector<std::pair<MethodEntry, std::vector<MethodEntry>>> methods;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    for (const auto& [entry, dependencies] : dependencies_) {
+      MethodEntry method = entry;  // Structured bindings cannot be captured before C++20.
+      if (IsCacheable(method) &&
+          cache_hits_.find(method) == cache_hits_.end() &&
+          std::all_of(dependencies.begin(),
+                      dependencies.end(),
+                      [&](MethodEntry dependency) { return dependency.first == method.first; })) {
+        methods.emplace_back(entry, dependencies);
+      }
+    }
+  }
+
+  size_t number_of_written_methods = 0u;
+  for (const auto& [entry, dependencies] : methods) {
+    const DexFile* dex_file = dex_files_[entry.first];
+    CompiledMethod* compiled_method =
+        driver.GetCompiledMethod(MethodReference(dex_file, entry.second));
+    if (compiled_method == nullptr || compiled_method->GetQuickCode().empty()) {
+      continue;
+    }
+    std::vector<uint8_t> code_buffer;
+    if (!WriteMethodCode({ dex_file }, compiled_method, &code_buffer)) {
+      continue;  // The code references another dex file of the oat file.
+    }
+    Digest cache_key = ComputeCacheKey(entry);
+    std::vector<uint8_t> buffer;
+    WriteArray(kCacheEntryMagic, &buffer);
+    WriteArray(kCacheEntryVersion, &buffer);
+    WriteArray(cache_key, &buffer);
+    WriteArray(ComputeMethodKey(driver, entry, dependencies, /*for_cache=*/ true), &buffer);
+    EncodeUnsignedLeb128(&buffer, dependencies.size());
+    for (MethodEntry dependency : dependencies) {
+      EncodeUnsignedLeb128(&buffer, dependency.second);
+    }
+    buffer.insert(buffer.end(), code_buffer.begin(), code_buffer.end());
+
+    // Other compilations may read and write the same entry concurrently. Write to a
+    // temporary file and rename it so that readers never see a partial entry.
+    std::string path = GetCacheEntryPath(cache_key);
+    std::string temp_path = StringPrintf("%s.%d.tmp", path.c_str(), getpid());
+    std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(temp_path.c_str()));
+    if (file == nullptr) {
+      PLOG(WARNING) << "Failed to create compiled method cache entry " << temp_path;
+      return;
+    }
+    if (!file->WriteFully(buffer.data(), buffer.size())) {
+      PLOG(WARNING) << "Failed to write compiled method cache entry " << temp_path;
+      file->Erase(/*unlink=*/ true);
+      return;
+    }
+    if (file->FlushCloseOrErase() != 0 || rename(temp_path.c_str(), path.c_str()) != 0) {
+      PLOG(WARNING) << "Failed to add compiled method cache entry " << path;
+      unlink(temp_path.c_str());
+      return;
+    }
+    ++number_of_written_methods;
+  }
+  VLOG(compiler) << "Added " << number_of_written_methods << " methods to the compiled method "
+                 << "cache " << cache_directory_;
+}
+
+}  // namespace art
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_DEX2OAT_DRIVER_COMPILATION_RECORD_H_
+#define ART_DEX2OAT_DRIVER_COMPILATION_RECORD_H_
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "jni.h"
+
+#include "base/array_ref.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/os.h"
+#include "base/safe_map.h"
+#include "compiler.h"
+#include "dex/method_reference.h"
+
+namespace art {
+
+class CompiledMethod;
+class CompilerDriver;
+class CompilerOptions;
+class DexFile;
+class ProfileCompilationInfo;
+
+// The compiled code of an app together with what is needed to decide whether the code of
+// each method is still valid for a later compilation of an updated version of the app.
+//
+// The code of a method is reused when all of the following hold:
+//   - The compiler, its options, the boot class path and the class loader context are
+//     the same. Together they form the compilation key.
+//   - The dex files define the same ids, classes, fields, methods, annotations and static
+//     values, i.e. only method bodies changed. Together they form the layout key. Ids and
+//     class layouts are embedded in compiled code, so any change there invalidates all code.
+//   - The code item and profile data of the method, the code items of the methods it
+//     inlined or analyzed and the status of the classes defining all of them are unchanged.
+//     Together they form the method key.
+//
+// The oat file does not keep the linker patches and CFI of the compiled code, so the
+// record stores the compiled methods themselves rather than pointing into the old oat file.
+//
+// The record can also use a directory as a cache of compiled methods shared by different
+// compilations, e.g. of apps bundling the same library. Each cache entry is a file named
+// by a hash of the method's code key, the layout key of its own dex file and the
+// compilation key without the class loader context. Only methods of self-contained dex
+// files are shared, i.e. dex files whose classes are not shadowed and whose references
+// to other classes all resolve to the boot class path, as compiled code embeds the ids
+// and class layouts that the references resolve to. Their patches and dependencies
+// may only target the same dex file or the boot class path.
+//
+// Cache entries are trusted: their code is copied to the oat file after checking only
+// that the keys they store match the compilation, which guards against stale entries but
+// not against crafted ones. Anyone able to write to the cache directory can therefore
+// inject code into every app compiled with it. The directory must be owned by the user
+// dex2oat runs as and not be writable by group or others, and it must only be shared by
+// compilations whose outputs are equally trusted, e.g. those run by installd.
+class CompilationRecord final : public Compiler::CodeDependencyRecorder {
+ public:
+  CompilationRecord(const CompilerOptions& compiler_options,
+                    const SafeMap<std::string, std::string>& key_value_store);
+  ~CompilationRecord();
+
+  // Read the record of a previous compilation. Returns false if the file cannot be read
+  // or is malformed. A record with a different compilation key or layout key is valid
+  // but provides no code for reuse.
+  bool ReadPrevious(File* file, /*out*/ std::string* error_msg);
+
+  // Write the record of this compilation with the methods compiled by `driver`.
+  bool Write(const CompilerDriver& driver, File* file, /*out*/ std::string* error_msg)
+      REQUIRES(!lock_);
+
+  // Returns the code of the method from the previous compilation if it is still valid,
+  // or null otherwise. The returned method is allocated in the driver's storage.
+  CompiledMethod* TryReuse(CompilerDriver* driver, MethodReference method_ref)
+      REQUIRES(!lock_);
+
+  // Use `directory` as a cache of compiled methods shared with other compilations.
+  // Returns false and does not use it if it is not a directory owned by this process'
+  // user and writable only by that user.
+  bool SetCacheDirectory(const std::string& directory, /*out*/ std::string* error_msg);
+
+  // Select the dex files whose methods can be shared through the cache. Must be called
+  // after the classes of the dex files were loaded by `class_loader` and before compiling.
+  void SelectCacheableDexFiles(jobject class_loader) REQUIRES(!Locks::mutator_lock_);
+
+  // Add the methods compiled by `driver` that were not found in the cache to the cache.
+  // Failing to add a method does not fail the compilation.
+  void WriteToCache(const CompilerDriver& driver) REQUIRES(!lock_);
+
+  void RecordCodeDependencies(MethodReference method,
+                              ArrayRef<const MethodReference> dependencies) override
+      REQUIRES(!lock_);
+
+  size_t GetNumberOfReusableMethods() const {
+    return previous_methods_.size();
+  }
+
+  size_t GetNumberOfReusedMethods() const {
+    return number_of_reused_methods_.load(std::memory_order_relaxed);
+  }
+
+  size_t GetNumberOfCacheHits() const {
+    return number_of_cache_hits_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using Digest = std::array<uint8_t, 20>;
+
+  // A method of one of the dex files compiled to the oat file, identified by the index
+  // of the dex file in the oat file and the method index in that dex file.
+  using MethodEntry = std::pair<uint32_t, uint32_t>;
+
+  struct CodeKey {
+    Digest digest;
+    uint16_t class_def_idx;
+    bool is_defined;
+    bool has_code;
+  };
+
+  struct PreviousMethod;
+
+  // For the cache, the method and its dependencies must be in the same dex file and the
+  // index of that dex file in the oat file is not part of the key.
+  Digest ComputeMethodKey(const CompilerDriver& driver,
+                          MethodEntry method,
+                          const std::vector<MethodEntry>& dependencies,
+                          bool for_cache) const;
+
+  Digest ComputeCacheKey(MethodEntry method) const;
+  std::string GetCacheEntryPath(const Digest& cache_key) const;
+  bool IsCacheable(MethodEntry method) const;
+  CompiledMethod* TryReuseFromCache(CompilerDriver* driver, MethodEntry method)
+      REQUIRES(!lock_);
+
+  // Returns the index of `dex_file` in the oat file, or `dex_files_.size()` if it is
+  // not compiled to the oat file.
+  uint32_t GetDexFileIndex(const DexFile* dex_file) const;
+
+  const std::vector<const DexFile*>& dex_files_;
+  const ProfileCompilationInfo* const profile_compilation_info_;
+
+  Digest compilation_key_;
+  Digest layout_key_;
+  Digest cache_compilation_key_;
+  std::vector<Digest> dex_layout_keys_;
+
+  // Code keys of all methods, indexed by dex file index and method index.
+  std::vector<std::vector<CodeKey>> code_keys_;
+
+  // Methods of the previous compilation that may be reused.
+  std::map<MethodEntry, std::unique_ptr<PreviousMethod>> previous_methods_;
+
+  std::atomic<size_t> number_of_reused_methods_;
+
+  // Empty if the cache is not used.
+  std::string cache_directory_;
+  // Indexed by dex file index, empty until SelectCacheableDexFiles().
+  std::vector<bool> cacheable_dex_files_;
+  std::atomic<size_t> number_of_cache_hits_;
+
+  // Code dependencies of the methods compiled or reused in this compilation.
+  Mutex lock_ BOTTOM_MUTEX_ACQUIRED_AFTER;
+  std::map<MethodEntry, std::vector<MethodEntry>> dependencies_ GUARDED_BY(lock_);
+  // Methods reused from the cache, which need not be written back to it.
+  std::set<MethodEntry> cache_hits_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(CompilationRecord);
+};
+
+}  // namespace art
+
+#endif  // ART_DEX2OAT_DRIVER_COMPILATION_RECORD_H_
@@ -22,6 +22,7 @@
 #include <malloc.h>  // For mallinfo
 #endif
 
+#include <limits>
 #include <string_view>
 #include <vector>
 
@@ -43,6 +44,7 @@
 #include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "class_linker-inl.h"
+#include "compilation_record.h"
 #include "compiled_method-inl.h"
 #include "compiler.h"
 #include "compiler_callbacks.h"
@@ -64,6 +66,7 @@
 #include "intrinsics_list.h"
 #include "jni/jni_internal.h"
 #include "linker/linker_patch.h"
+#include "memory_budget.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/dex_cache-inl.h"
@@ -263,6 +266,7 @@ CompilerDriver::CompilerDriver(
       parallel_thread_count_(thread_count),
       stats_(new AOTCompilationStats),
       compiled_method_storage_(swap_fd),
+      compilation_record_(nullptr),
       max_arena_alloc_(0) {
   DCHECK(compiler_options_ != nullptr);
 
@@ -279,6 +283,15 @@ CompilerDriver::~CompilerDriver() {
   });
 }
 
+void CompilerDriver::SetCompilationRecord(CompilationRecord* compilation_record) {
+  compilation_record_ = compilation_record;
+  compiler_->SetCodeDependencyRecorder(compilation_record);
+}
+
+void CompilerDriver::SetMemoryBudget(size_t budget) {
+  memory_budget_ = std::make_unique<MemoryBudget>(
+      budget, parallel_thread_count_, &compiled_method_storage_, compiler_.get());
+}
 
 #define CREATE_TRAMPOLINE(type, abi, offset)                                            \
     if (Is64BitInstructionSet(GetCompilerOptions().GetInstructionSet())) {              \
@@ -505,15 +518,22 @@ static void CompileMethodQuick(
       compile = compile && ShouldCompileBasedOnProfile(compiler_options, profile_index, method_ref);
 
       if (compile) {
+        // Reuse the code from a previous compilation if it is still valid.
+        CompilationRecord* compilation_record = driver->GetCompilationRecord();
+        if (compilation_record != nullptr) {
+          compiled_method = compilation_record->TryReuse(driver, method_ref);
+        }
         // NOTE: if compiler declines to compile this method, it will return null.
-        compiled_method = driver->GetCompiler()->Compile(code_item,
-                                                         access_flags,
-                                                         invoke_type,
-                                                         class_def_idx,
-                                                         method_idx,
-                                                         class_loader,
-                                                         dex_file,
-                                                         dex_cache);
+        if (compiled_method == nullptr) {
+          compiled_method = driver->GetCompiler()->Compile(code_item,
+                                                           access_flags,
+                                                           invoke_type,
+                                                           class_def_idx,
+                                                           method_idx,
+                                                           class_loader,
+                                                           dex_file,
+                                                           dex_cache);
+        }
         ProfileMethodsCheck check_type = compiler_options.CheckProfiledMethodsCompiled();
         if (UNLIKELY(check_type != ProfileMethodsCheck::kNone)) {
           DCHECK(ShouldCompileBasedOnProfile(compiler_options, profile_index, method_ref));
@@ -556,21 +576,17 @@ static void CompileMethodQuick(
 void CompilerDriver::Resolve(jobject class_loader,
                              const std::vector<const DexFile*>& dex_files,
                              TimingLogger* timings) {
-  // Resolution allocates classes and needs to run single-threaded to be deterministic.
-  bool force_determinism = GetCompilerOptions().IsForceDeterminism();
-  ThreadPool* resolve_thread_pool = force_determinism
-                                     ? single_thread_pool_.get()
-                                     : parallel_thread_pool_.get();
-  size_t resolve_thread_count = force_determinism ? 1U : parallel_thread_count_;
-
+  // Resolution allocates classes in a thread-dependent order. This does not affect the
+  // output even with --force-determinism: the ImageWriter lays out classes and interns
+  // in dex file order and rebuilds the image class and intern tables from scratch.
   for (size_t i = 0; i != dex_files.size(); ++i) {
     const DexFile* dex_file = dex_files[i];
     CHECK(dex_file != nullptr);
     ResolveDexFile(class_loader,
                    *dex_file,
                    dex_files,
-                   resolve_thread_pool,
-                   resolve_thread_count,
+                   parallel_thread_pool_.get(),
+                   parallel_thread_count_,
                    timings);
   }
 }
@@ -1368,6 +1384,14 @@ class CompilationVisitor {
 
 class ParallelCompilationManager {
  public:
+  // Time spent by a task of ForAll() in the work function and the number of indexes it
+  // processed. Tasks are not bound to threads, but each task runs until all indexes are
+  // taken, so a task is busy for as long as the thread running it.
+  struct TaskUtilization {
+    uint64_t busy_ns = 0u;
+    size_t items = 0u;
+  };
+
   ParallelCompilationManager(ClassLinker* class_linker,
                              jobject class_loader,
                              CompilerDriver* compiler,
@@ -1380,7 +1404,10 @@ class ParallelCompilationManager {
       compiler_(compiler),
       dex_file_(dex_file),
       dex_files_(dex_files),
-      thread_pool_(thread_pool) {}
+      thread_pool_(thread_pool),
+      track_utilization_(false),
+      wall_ns_(0u),
+      memory_budget_(nullptr) {}
 
   ClassLinker* GetClassLinker() const {
     CHECK(class_linker_ != nullptr);
@@ -1405,6 +1432,24 @@ class ParallelCompilationManager {
     return dex_files_;
   }
 
+  // Measure the utilization of the tasks of subsequent calls to ForAll().
+  void TrackUtilization() {
+    track_utilization_ = true;
+  }
+
+  const std::vector<TaskUtilization>& GetTaskUtilization() const {
+    return task_utilization_;
+  }
+
+  uint64_t GetWallNs() const {
+    return wall_ns_;
+  }
+
+  // Keep the footprint of subsequent calls to ForAll() under `memory_budget`, if not null.
+  void SetMemoryBudget(MemoryBudget* memory_budget) {
+    memory_budget_ = memory_budget;
+  }
+
   void ForAll(size_t begin, size_t end, CompilationVisitor* visitor, size_t work_units)
       REQUIRES(!*Locks::mutator_lock_) {
     ForAllLambda(begin, end, [visitor](size_t index) { visitor->Visit(index); }, work_units);
@@ -1417,9 +1462,13 @@ class ParallelCompilationManager {
     self->AssertNoPendingException();
     CHECK_GT(work_units, 0U);
 
+    uint64_t start_ns = track_utilization_ ? NanoTime() : 0u;
+    task_utilization_.assign(track_utilization_ ? work_units : 0u, TaskUtilization());
     index_.store(begin, std::memory_order_relaxed);
     for (size_t i = 0; i < work_units; ++i) {
-      thread_pool_->AddTask(self, new ForAllClosureLambda<Fn>(this, end, fn));
+      TaskUtilization* utilization = track_utilization_ ? &task_utilization_[i] : nullptr;
+      thread_pool_->AddTask(
+          self, new ForAllClosureLambda<Fn>(this, end, fn, utilization, memory_budget_));
     }
     thread_pool_->StartWorkers(self);
 
@@ -1432,6 +1481,7 @@ class ParallelCompilationManager {
 
     // And stop the workers accepting jobs.
     thread_pool_->StopWorkers(self);
+    wall_ns_ = track_utilization_ ? NanoTime() - start_ns : 0u;
   }
 
   size_t NextIndex() {
@@ -1442,20 +1492,43 @@ class ParallelCompilationManager {
   template <typename Fn>
   class ForAllClosureLambda : public Task {
    public:
-    ForAllClosureLambda(ParallelCompilationManager* manager, size_t end, Fn fn)
+    ForAllClosureLambda(ParallelCompilationManager* manager,
+                        size_t end,
+                        Fn fn,
+                        TaskUtilization* utilization,
+                        MemoryBudget* memory_budget)
         : manager_(manager),
           end_(end),
-          fn_(fn) {}
+          fn_(fn),
+          utilization_(utilization),
+          memory_budget_(memory_budget) {}
 
     void Run(Thread* self) override {
+      if (memory_budget_ != nullptr) {
+        memory_budget_->ThreadStarted(self);
+      }
       while (true) {
+        if (memory_budget_ != nullptr) {
+          // May block this thread, so do it before taking an index.
+          memory_budget_->BetweenWorkItems(self);
+        }
         const size_t index = manager_->NextIndex();
         if (UNLIKELY(index >= end_)) {
           break;
         }
-        fn_(index);
+        if (utilization_ != nullptr) {
+          uint64_t start_ns = NanoTime();
+          fn_(index);
+          utilization_->busy_ns += NanoTime() - start_ns;
+          ++utilization_->items;
+        } else {
+          fn_(index);
+        }
         self->AssertNoPendingException();
       }
+      if (memory_budget_ != nullptr) {
+        memory_budget_->ThreadFinished(self);
+      }
     }
 
     void Finalize() override {
@@ -1466,6 +1539,8 @@ class ParallelCompilationManager {
     ParallelCompilationManager* const manager_;
     const size_t end_;
     Fn fn_;
+    TaskUtilization* const utilization_;
+    MemoryBudget* const memory_budget_;
   };
 
   AtomicInteger index_;
@@ -1475,6 +1550,10 @@ class ParallelCompilationManager {
   const DexFile* const dex_file_;
   const std::vector<const DexFile*>& dex_files_;
   ThreadPool* const thread_pool_;
+  bool track_utilization_;
+  std::vector<TaskUtilization> task_utilization_;
+  uint64_t wall_ns_;
+  MemoryBudget* memory_budget_;
 
   DISALLOW_COPY_AND_ASSIGN(ParallelCompilationManager);
 };
@@ -1759,18 +1838,16 @@ void CompilerDriver::Verify(jobject jclass_loader,
     }
   }
 
-  // Verification updates VerifierDeps and needs to run single-threaded to be deterministic.
-  bool force_determinism = GetCompilerOptions().IsForceDeterminism();
-  ThreadPool* verify_thread_pool =
-      force_determinism ? single_thread_pool_.get() : parallel_thread_pool_.get();
-  size_t verify_thread_count = force_determinism ? 1U : parallel_thread_count_;
+  // Verification records into per-thread VerifierDeps. Merging them is order-independent
+  // and the merged VerifierDeps is canonicalized below, so the verification can run with
+  // all threads even with --force-determinism.
   for (const DexFile* dex_file : dex_files) {
     CHECK(dex_file != nullptr);
     VerifyDexFile(jclass_loader,
                   *dex_file,
                   dex_files,
-                  verify_thread_pool,
-                  verify_thread_count,
+                  parallel_thread_pool_.get(),
+                  parallel_thread_count_,
                   timings);
   }
 
@@ -1782,6 +1859,7 @@ void CompilerDriver::Verify(jobject jclass_loader,
       main_verifier_deps->MergeWith(std::move(thread_deps),
                                     GetCompilerOptions().GetDexFilesForOatFile());
     }
+    main_verifier_deps->Canonicalize();
     Thread::Current()->SetVerifierDeps(nullptr);
   }
 }
@@ -2434,25 +2512,23 @@ void CompilerDriver::InitializeClasses(jobject jni_class_loader,
                                        TimingLogger* timings) {
   TimingLogger::ScopedTiming t("InitializeNoClinit", timings);
 
-  // Initialization allocates objects and needs to run single-threaded to be deterministic.
-  bool force_determinism = GetCompilerOptions().IsForceDeterminism();
-  ThreadPool* init_thread_pool = force_determinism
-                                     ? single_thread_pool_.get()
-                                     : parallel_thread_pool_.get();
-  size_t init_thread_count = force_determinism ? 1U : parallel_thread_count_;
-
-  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  ParallelCompilationManager context(class_linker, jni_class_loader, this, &dex_file, dex_files,
-                                     init_thread_pool);
-
+  size_t init_thread_count = parallel_thread_count_;
   if (GetCompilerOptions().IsBootImage() ||
       GetCompilerOptions().IsBootImageExtension() ||
       GetCompilerOptions().IsAppImage()) {
     // Set the concurrency thread to 1 to support initialization for images since transaction
-    // doesn't support multithreading now.
+    // doesn't support multithreading now. This also initializes classes in the canonical
+    // class def order, which the image contents depend on with --force-determinism.
     // TODO: remove this when transactional mode supports multithreading.
     init_thread_count = 1U;
   }
+  ThreadPool* init_thread_pool = (init_thread_count == 1U)
+                                     ? single_thread_pool_.get()
+                                     : parallel_thread_pool_.get();
+
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  ParallelCompilationManager context(class_linker, jni_class_loader, this, &dex_file, dex_files,
+                                     init_thread_pool);
   InitializeClassVisitor visitor(&context);
   context.ForAll(0, dex_file.NumClassDefs(), &visitor, init_thread_count);
 
@@ -2474,6 +2550,125 @@ void CompilerDriver::InitializeClasses(jobject class_loader,
   }
 }
 
+// A range of methods of a class to compile as one unit of work. Methods are numbered by
+// their position in the class data.
+struct CompileWorkItem {
+  uint32_t class_def_index;
+  uint32_t method_begin;
+  uint32_t method_end;
+  uint64_t cost;
+};
+
+// Estimated cost of compiling a method that has no code item, relative to the cost of a
+// method with code which is its number of code units.
+static constexpr uint64_t kNoCodeMethodCost = 8u;
+
+// Classes with a cost larger than 1/kWorkItemsPerThread of the average work of a thread are
+// split into several work items.
+static constexpr uint64_t kWorkItemsPerThread = 4u;
+
+// Do not split classes into work items smaller than this cost.
+static constexpr uint64_t kMinSplitWorkItemCost = 2000u;
+
+// Split the classes of the dex file into work items and order them by decreasing estimated
+// cost. Handing out the most expensive work first and splitting very large classes keeps
+// a single large class at the end of the dex file from leaving all but one thread idle.
+static std::vector<CompileWorkItem> GetCompileWorkItems(
+    const CompilerOptions& compiler_options,
+    const DexFile& dex_file,
+    ProfileCompilationInfo::ProfileIndexType profile_index,
+    size_t thread_count) {
+  std::vector<uint64_t> method_costs;
+  std::vector<uint32_t> method_indexes;
+  std::vector<std::pair<uint32_t, uint32_t>> class_methods;  // Begin and end in `method_costs`.
+  uint64_t total_cost = 0u;
+  class_methods.reserve(dex_file.NumClassDefs());
+  for (ClassAccessor accessor : dex_file.GetClasses()) {
+    uint32_t begin = method_costs.size();
+    for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      uint64_t cost = kNoCodeMethodCost;
+      if (method.GetCodeItem() != nullptr &&
+          ShouldCompileBasedOnProfile(
+              compiler_options, profile_index, MethodReference(&dex_file, method.GetIndex()))) {
+        cost += CodeItemInstructionAccessor(dex_file, method.GetCodeItem()).InsnsSizeInCodeUnits();
+      }
+      method_costs.push_back(cost);
+      method_indexes.push_back(method.GetIndex());
+      total_cost += cost;
+    }
+    class_methods.emplace_back(begin, method_costs.size());
+  }
+
+  uint64_t max_item_cost = std::numeric_limits<uint64_t>::max();
+  if (thread_count > 1u) {
+    max_item_cost =
+        std::max(total_cost / (thread_count * kWorkItemsPerThread), kMinSplitWorkItemCost);
+  }
+  std::vector<CompileWorkItem> work_items;
+  work_items.reserve(dex_file.NumClassDefs());
+  for (uint32_t class_def_index = 0; class_def_index != class_methods.size(); ++class_def_index) {
+    auto [begin, end] = class_methods[class_def_index];
+    CompileWorkItem item = { class_def_index, 0u, 0u, 0u };
+    for (uint32_t i = begin; i != end; ++i) {
+      // Do not separate methods sharing the same index, only the first one is compiled.
+      if (item.cost != 0u &&
+          item.cost + method_costs[i] > max_item_cost &&
+          method_indexes[i] != method_indexes[i - 1u]) {
+        item.method_end = i - begin;
+        work_items.push_back(item);
+        item = { class_def_index, i - begin, 0u, 0u };
+      }
+      item.cost += method_costs[i];
+    }
+    item.method_end = end - begin;
+    work_items.push_back(item);
+  }
+
+  std::stable_sort(work_items.begin(),
+                   work_items.end(),
+                   [](const CompileWorkItem& lhs, const CompileWorkItem& rhs) {
+                     return lhs.cost > rhs.cost;
+                   });
+  return work_items;
+}
+
+// The utilization of the threads in a parallel phase, accumulated over dex files.
+class PhaseUtilization {
+ public:
+  void Add(const ParallelCompilationManager& context) {
+    const std::vector<ParallelCompilationManager::TaskUtilization>& tasks =
+        context.GetTaskUtilization();
+    if (tasks_.size() < tasks.size()) {
+      tasks_.resize(tasks.size());
+    }
+    for (size_t i = 0; i != tasks.size(); ++i) {
+      tasks_[i].busy_ns += tasks[i].busy_ns;
+      tasks_[i].items += tasks[i].items;
+    }
+    wall_ns_ += context.GetWallNs();
+  }
+
+  void Dump(std::ostream& os) const {
+    os << "wall time " << PrettyDuration(wall_ns_) << ", thread utilization:";
+    uint64_t total_busy_ns = 0u;
+    for (const ParallelCompilationManager::TaskUtilization& task : tasks_) {
+      os << " " << BusyPercentage(task.busy_ns) << "% (" << task.items << ")";
+      total_busy_ns += task.busy_ns;
+    }
+    if (!tasks_.empty()) {
+      os << ", average " << BusyPercentage(total_busy_ns / tasks_.size()) << "%";
+    }
+  }
+
+ private:
+  double BusyPercentage(uint64_t busy_ns) const {
+    return (wall_ns_ != 0u) ? 100.0 * busy_ns / wall_ns_ : 0.0;
+  }
+
+  std::vector<ParallelCompilationManager::TaskUtilization> tasks_;
+  uint64_t wall_ns_ = 0u;
+};
+
 template <typename CompileFn>
 static void CompileDexFile(CompilerDriver* driver,
                            jobject class_loader,
@@ -2483,7 +2678,8 @@ static void CompileDexFile(CompilerDriver* driver,
                            size_t thread_count,
                            TimingLogger* timings,
                            const char* timing_name,
-                           CompileFn compile_fn) {
+                           CompileFn compile_fn,
+                           /*inout*/ PhaseUtilization* utilization) {
   TimingLogger::ScopedTiming t(timing_name, timings);
   ParallelCompilationManager context(Runtime::Current()->GetClassLinker(),
                                      class_loader,
@@ -2497,8 +2693,12 @@ static void CompileDexFile(CompilerDriver* driver,
   ProfileCompilationInfo::ProfileIndexType profile_index = (have_profile && use_profile)
       ? compiler_options.GetProfileCompilationInfo()->FindDexFile(dex_file)
       : ProfileCompilationInfo::MaxProfileIndex();
+  const std::vector<CompileWorkItem> work_items =
+      GetCompileWorkItems(compiler_options, dex_file, profile_index, thread_count);
 
-  auto compile = [&context, &compile_fn, profile_index](size_t class_def_index) {
+  auto compile = [&context, &compile_fn, &work_items, profile_index](size_t work_item_index) {
+    const CompileWorkItem& work_item = work_items[work_item_index];
+    const uint32_t class_def_index = work_item.class_def_index;
     const DexFile& dex_file = *context.GetDexFile();
     SCOPED_TRACE << "compile " << dex_file.GetLocation() << "@" << class_def_index;
     ClassLinker* class_linker = context.GetClassLinker();
@@ -2533,23 +2733,32 @@ static void CompileDexFile(CompilerDriver* driver,
     }
 
     // Avoid suspension if there are no methods to compile.
-    if (accessor.NumDirectMethods() + accessor.NumVirtualMethods() == 0) {
+    if (work_item.method_begin == work_item.method_end) {
       return;
     }
 
     // Go to native so that we don't block GC during compilation.
     ScopedThreadSuspension sts(soa.Self(), ThreadState::kNative);
 
-    // Compile direct and virtual methods.
+    // Compile the direct and virtual methods of the work item.
     int64_t previous_method_idx = -1;
+    uint32_t method_position = 0u;
     for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      if (method_position == work_item.method_end) {
+        break;
+      }
       const uint32_t method_idx = method.GetIndex();
+      const bool in_work_item = (method_position >= work_item.method_begin);
+      ++method_position;
       if (method_idx == previous_method_idx) {
         // smali can create dex files with two encoded_methods sharing the same method_idx
         // http://code.google.com/p/smali/issues/detail?id=119
         continue;
       }
       previous_method_idx = method_idx;
+      if (!in_work_item) {
+        continue;
+      }
       compile_fn(soa.Self(),
                  driver,
                  method.GetCodeItem(),
@@ -2563,7 +2772,14 @@ static void CompileDexFile(CompilerDriver* driver,
                  profile_index);
     }
   };
-  context.ForAllLambda(0, dex_file.NumClassDefs(), compile, thread_count);
+  if (utilization != nullptr) {
+    context.TrackUtilization();
+  }
+  context.SetMemoryBudget(driver->GetMemoryBudget());
+  context.ForAllLambda(0, work_items.size(), compile, thread_count);
+  if (utilization != nullptr) {
+    utilization->Add(context);
+  }
 }
 
 void CompilerDriver::Compile(jobject class_loader,
@@ -2578,6 +2794,7 @@ void CompilerDriver::Compile(jobject class_loader,
             : profile_compilation_info->DumpInfo(dex_files));
   }
 
+  PhaseUtilization utilization;
   for (const DexFile* dex_file : dex_files) {
     CHECK(dex_file != nullptr);
     CompileDexFile(this,
@@ -2588,7 +2805,9 @@ void CompilerDriver::Compile(jobject class_loader,
                    parallel_thread_count_,
                    timings,
                    "Compile Dex File Quick",
-                   CompileMethodQuick);
+                   CompileMethodQuick,
+                   GetCompilerOptions().GetDumpTimings() ? &utilization : nullptr);
+    compiler_->ReleaseArenaCaches();
     const ArenaPool* const arena_pool = Runtime::Current()->GetArenaPool();
     const size_t arena_alloc = arena_pool->GetBytesAllocated();
     max_arena_alloc_ = std::max(arena_alloc, max_arena_alloc_);
@@ -2596,6 +2815,20 @@ void CompilerDriver::Compile(jobject class_loader,
   }
 
   VLOG(compiler) << "Compile: " << GetMemoryUsageString(false);
+  if (GetCompilerOptions().GetDumpTimings()) {
+    std::ostringstream oss;
+    compiler_->DumpArenaCacheStats(oss);
+    LOG(INFO) << "Compile: " << oss.str();
+    std::ostringstream utilization_oss;
+    utilization.Dump(utilization_oss);
+    LOG(INFO) << "Compile: " << utilization_oss.str();
+  }
+  if (memory_budget_ != nullptr) {
+    memory_budget_->Sample(Thread::Current());
+    std::ostringstream oss;
+    memory_budget_->Dump(oss);
+    LOG(INFO) << "Compile: " << oss.str();
+  }
 }
 
 void CompilerDriver::AddCompiledMethod(const MethodReference& method_ref,
@@ -2712,9 +2945,12 @@ void CompilerDriver::InitializeThreadPools() {
   parallel_thread_pool_.reset(
       new ThreadPool("Compiler driver thread pool", parallel_count));
   single_thread_pool_.reset(new ThreadPool("Single-threaded Compiler driver thread pool", 0));
+  // Let the compiler use idle workers for the analyses of very large methods.
+  compiler_->SetThreadPool(parallel_count > 0 ? parallel_thread_pool_.get() : nullptr);
 }
 
 void CompilerDriver::FreeThreadPools() {
+  compiler_->SetThreadPool(nullptr);
   parallel_thread_pool_.reset();
   single_thread_pool_.reset();
 }
@@ -58,6 +58,7 @@ class VerifierDepsTest;
 
 class ArtField;
 class BitVector;
+class CompilationRecord;
 class CompiledMethod;
 class CompilerOptions;
 class DexCompilationUnit;
@@ -68,6 +69,7 @@ class InstructionSetFeatures;
 class InternTable;
 enum InvokeType : uint32_t;
 class MemberOffset;
+class MemoryBudget;
 template<class MirrorType> class ObjPtr;
 class ParallelCompilationManager;
 class ProfileCompilationInfo;
@@ -217,6 +219,21 @@ class CompilerDriver {
     return &compiled_method_storage_;
   }
 
+  // Set the record of compiled code to reuse code from and to record code dependencies in.
+  // The record is not owned and must outlive the compilation.
+  void SetCompilationRecord(CompilationRecord* compilation_record);
+
+  CompilationRecord* GetCompilationRecord() const {
+    return compilation_record_;
+  }
+
+  // Keep the memory footprint of the compilation of methods under `budget` bytes.
+  void SetMemoryBudget(size_t budget);
+
+  MemoryBudget* GetMemoryBudget() const {
+    return memory_budget_.get();
+  }
+
  private:
   void LoadImageClasses(TimingLogger* timings, /*inout*/ HashSet<std::string>* image_classes)
       REQUIRES(!Locks::mutator_lock_);
@@ -322,6 +339,10 @@ class CompilerDriver {
 
   CompiledMethodStorage compiled_method_storage_;
 
+  CompilationRecord* compilation_record_;
+
+  std::unique_ptr<MemoryBudget> memory_budget_;
+
   size_t max_arena_alloc_;
 
   friend class CommonCompilerDriverTest;
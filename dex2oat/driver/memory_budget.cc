@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_budget.h"
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+#include "base/arena_allocator.h"
+#include "base/globals.h"
+#include "base/time_utils.h"
+#include "base/utils.h"
+#include "compiler.h"
+#include "driver/compiled_method_storage.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+MemoryBudget::MemoryBudget(size_t budget,
+                           size_t max_threads,
+                           const CompiledMethodStorage* storage,
+                           Compiler* compiler)
+    : budget_(budget),
+      max_threads_(std::max<size_t>(max_threads, 1u)),
+      storage_(storage),
+      compiler_(compiler),
+      next_sample_ns_(0u),
+      over_budget_(false),
+      throttled_(false),
+      lock_("memory budget lock", kGenericBottomLock),
+      thread_allowed_cond_("memory budget thread allowed condition", lock_),
+      running_threads_(0u),
+      allowed_threads_(max_threads_),
+      peak_footprint_(0u),
+      peak_arena_bytes_(0u),
+      peak_compiled_code_bytes_(0u),
+      min_allowed_threads_(max_threads_),
+      num_samples_(0u),
+      num_samples_over_budget_(0u),
+      num_throttle_steps_(0u),
+      num_blocked_threads_(0u) {
+  DCHECK_NE(budget_, 0u);
+}
+
+void MemoryBudget::ThreadStarted(Thread* self) {
+  MutexLock mu(self, lock_);
+  ++running_threads_;
+}
+
+void MemoryBudget::ThreadFinished(Thread* self) {
+  MutexLock mu(self, lock_);
+  DCHECK_NE(running_threads_, 0u);
+  --running_threads_;
+  // A blocked thread may take the place of this one.
+  thread_allowed_cond_.Broadcast(self);
+}
+
+void MemoryBudget::BetweenWorkItems(Thread* self) {
+  uint64_t now = NanoTime();
+  uint64_t next_sample_ns = next_sample_ns_.load(std::memory_order_relaxed);
+  if (now >= next_sample_ns &&
+      next_sample_ns_.compare_exchange_strong(next_sample_ns,
+                                              now + kSamplingIntervalNs,
+                                              std::memory_order_relaxed)) {
+    Sample(self);
+  }
+  if (over_budget_.load(std::memory_order_relaxed)) {
+    // Only the thread itself may touch its arena cache, and it is idle between work items.
+    compiler_->ReleaseArenaCache(self);
+  }
+  if (!throttled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  MutexLock mu(self, lock_);
+  if (running_threads_ > allowed_threads_) {
+    --running_threads_;
+    ++num_blocked_threads_;
+    while (running_threads_ >= allowed_threads_) {
+      thread_allowed_cond_.Wait(self);
+    }
+    ++running_threads_;
+  }
+}
+
+void MemoryBudget::Sample(Thread* self) {
+  size_t footprint = GetResidentSetSize();
+  if (footprint == 0u) {
+    return;
+  }
+  ArenaPool* arena_pool = Runtime::Current()->GetArenaPool();
+  size_t arena_bytes = arena_pool->GetBytesAllocated();
+  size_t compiled_code_bytes = storage_->GetStoredBytes();
+  bool reclaim_arenas = false;
+  {
+    MutexLock mu(self, lock_);
+    ++num_samples_;
+    if (footprint > peak_footprint_) {
+      peak_footprint_ = footprint;
+      peak_arena_bytes_ = arena_bytes;
+      peak_compiled_code_bytes_ = compiled_code_bytes;
+    }
+    if (footprint > budget_) {
+      ++num_samples_over_budget_;
+      over_budget_.store(true, std::memory_order_relaxed);
+      reclaim_arenas = true;
+      // There is nothing to throttle when no thread is compiling, e.g. for the final sample.
+      if (allowed_threads_ > 1u && running_threads_ != 0u) {
+        --allowed_threads_;
+        min_allowed_threads_ = std::min(min_allowed_threads_, allowed_threads_);
+        ++num_throttle_steps_;
+        throttled_.store(true, std::memory_order_relaxed);
+      }
+    } else if (footprint < budget_ / 100u * kResumePercentage) {
+      over_budget_.store(false, std::memory_order_relaxed);
+      if (allowed_threads_ < max_threads_) {
+        ++allowed_threads_;
+        throttled_.store(allowed_threads_ < max_threads_, std::memory_order_relaxed);
+        thread_allowed_cond_.Broadcast(self);
+      }
+    }
+  }
+  if (reclaim_arenas) {
+    // Give the arenas returned by the compiling threads back to the system.
+    arena_pool->LockReclaimMemory();
+  }
+}
+
+size_t MemoryBudget::GetPeakFootprint() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return peak_footprint_;
+}
+
+void MemoryBudget::Dump(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "memory budget=" << PrettySize(budget_)
+     << " peak=" << PrettySize(peak_footprint_)
+     << " (arena=" << PrettySize(peak_arena_bytes_)
+     << " compiled code=" << PrettySize(peak_compiled_code_bytes_)
+     << (storage_->UsesSwapSpace() ? " in swap" : " in memory") << ")"
+     << " samples over budget=" << num_samples_over_budget_ << "/" << num_samples_
+     << " min threads=" << min_allowed_threads_ << "/" << max_threads_
+     << " throttle steps=" << num_throttle_steps_
+     << " blocked threads=" << num_blocked_threads_;
+}
+
+size_t MemoryBudget::GetResidentSetSize() {
+  std::string statm;
+  if (!android::base::ReadFileToString("/proc/self/statm", &statm)) {
+    return 0u;
+  }
+  // The second field is the number of resident pages.
+  std::vector<std::string> fields = android::base::Split(statm, " ");
+  size_t resident_pages;
+  if (fields.size() < 2u || !android::base::ParseUint(fields[1], &resident_pages)) {
+    return 0u;
+  }
+  return resident_pages * kPageSize;
+}
+
+}  // namespace art
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_DEX2OAT_DRIVER_MEMORY_BUDGET_H_
+#define ART_DEX2OAT_DRIVER_MEMORY_BUDGET_H_
+
+#include <atomic>
+#include <iosfwd>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class CompiledMethodStorage;
+class Compiler;
+class Thread;
+
+// Keeps the memory footprint of dex2oat under a budget while compiling methods.
+//
+// The footprint is the resident set size of the process, as that is what gets the
+// process killed on low-RAM devices. It is sampled between work items by the compiling
+// threads. While it is over the budget, the threads return their cached arenas and one
+// fewer thread is allowed to compile after each sample, down to one thread. Threads come
+// back one per sample once the footprint falls below kResumePercentage of the budget.
+//
+// Compiled code cannot move to the swap space once compilation has started. Whether to
+// use swap is decided up front, see EstimateCompiledCodeSize().
+class MemoryBudget {
+ public:
+  static constexpr uint64_t kSamplingIntervalNs = 20 * 1000 * 1000;
+  static constexpr size_t kResumePercentage = 90u;
+
+  MemoryBudget(size_t budget,
+               size_t max_threads,
+               const CompiledMethodStorage* storage,
+               Compiler* compiler);
+
+  // Called by each compiling thread before it takes its first work item and after it
+  // takes its last one.
+  void ThreadStarted(Thread* self) REQUIRES(!lock_);
+  void ThreadFinished(Thread* self) REQUIRES(!lock_);
+
+  // Called by a compiling thread before it takes the next work item. May block the
+  // thread while too many threads are compiling.
+  void BetweenWorkItems(Thread* self) REQUIRES(!lock_);
+
+  // Samples the footprint now.
+  void Sample(Thread* self) REQUIRES(!lock_);
+
+  size_t GetBudget() const {
+    return budget_;
+  }
+
+  size_t GetPeakFootprint() const REQUIRES(!lock_);
+
+  void Dump(std::ostream& os) const REQUIRES(!lock_);
+
+  // Returns the resident set size of this process, or 0 if it cannot be determined.
+  static size_t GetResidentSetSize();
+
+  // Returns a rough estimate of the memory needed to keep the code, vmap tables and
+  // CFI compiled from dex files with `dex_size` bytes until the oat file is written.
+  static size_t EstimateCompiledCodeSize(size_t dex_size) {
+    return dex_size * 2u;
+  }
+
+ private:
+  const size_t budget_;
+  const size_t max_threads_;
+  const CompiledMethodStorage* const storage_;
+  Compiler* const compiler_;
+
+  std::atomic<uint64_t> next_sample_ns_;
+  // Whether the last sample was over the budget and the budget has not been met since.
+  std::atomic<bool> over_budget_;
+  // Whether fewer than `max_threads_` threads are allowed to compile.
+  std::atomic<bool> throttled_;
+
+  mutable Mutex lock_ BOTTOM_MUTEX_ACQUIRED_AFTER;
+  ConditionVariable thread_allowed_cond_ GUARDED_BY(lock_);
+  size_t running_threads_ GUARDED_BY(lock_);
+  size_t allowed_threads_ GUARDED_BY(lock_);
+
+  // Statistics.
+  size_t peak_footprint_ GUARDED_BY(lock_);
+  size_t peak_arena_bytes_ GUARDED_BY(lock_);
+  size_t peak_compiled_code_bytes_ GUARDED_BY(lock_);
+  size_t min_allowed_threads_ GUARDED_BY(lock_);
+  size_t num_samples_ GUARDED_BY(lock_);
+  size_t num_samples_over_budget_ GUARDED_BY(lock_);
+  size_t num_throttle_steps_ GUARDED_BY(lock_);  // Times `allowed_threads_` was reduced.
+  size_t num_blocked_threads_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryBudget);
+};
+
+}  // namespace art
+
+#endif  // ART_DEX2OAT_DRIVER_MEMORY_BUDGET_H_
@@ -31,7 +31,7 @@
 #include "driver/compiler_options.h"
 #include "elf/elf_builder.h"
 #include "elf/elf_utils.h"
-#include "stream/buffered_output_stream.h"
+#include "pipelined_output_stream.h"
 #include "stream/file_output_stream.h"
 #include "thread-current-inl.h"
 #include "thread_pool.h"
@@ -124,7 +124,7 @@ class ElfWriterQuick final : public ElfWriter {
   size_t data_bimg_rel_ro_size_;
   size_t bss_size_;
   size_t dex_section_size_;
-  std::unique_ptr<BufferedOutputStream> output_stream_;
+  std::unique_ptr<PipelinedOutputStream> output_stream_;
   std::unique_ptr<ElfBuilder<ElfTypes>> builder_;
   std::unique_ptr<DebugInfoTask> debug_info_task_;
   std::unique_ptr<ThreadPool> debug_info_thread_pool_;
@@ -154,7 +154,7 @@ ElfWriterQuick<ElfTypes>::ElfWriterQuick(const CompilerOptions& compiler_options
       bss_size_(0u),
       dex_section_size_(0u),
       output_stream_(
-          std::make_unique<BufferedOutputStream>(std::make_unique<FileOutputStream>(elf_file))),
+          std::make_unique<PipelinedOutputStream>(std::make_unique<FileOutputStream>(elf_file))),
       builder_(new ElfBuilder<ElfTypes>(compiler_options_.GetInstructionSet(),
                                         output_stream_.get())) {}
 
@@ -63,6 +63,38 @@ TEST_F(ImageTest, TestImageLayout) {
   EXPECT_LT(image_sizes.back(), image_sizes_extra.back());
 }
 
+TEST_F(ImageTest, CompressedImageBlocks) {
+  static constexpr uint32_t kMaxBlockSize = 64 * KB;
+  CompilationHelper helper;
+  Compile(ImageHeader::kStorageModeLZ4HC, kMaxBlockSize, helper);
+  for (ScratchFile& image_file : helper.image_files) {
+    std::unique_ptr<File> file(OS::OpenFileForReading(image_file.GetFilename().c_str()));
+    ASSERT_TRUE(file != nullptr);
+    std::vector<uint8_t> data(file->GetLength());
+    ASSERT_TRUE(file->ReadFully(data.data(), data.size()));
+    const ImageHeader* image_header = reinterpret_cast<const ImageHeader*>(data.data());
+    ASSERT_TRUE(image_header->IsValid());
+    ASSERT_GT(image_header->GetBlockCount(), 1u);
+
+    // The blocks cover the image after the header without gaps, and all but the last one
+    // end on a page boundary.
+    std::vector<uint8_t> image(image_header->GetImageSize());
+    uint32_t expected_offset = sizeof(ImageHeader);
+    for (const ImageHeader::Block& block : image_header->GetBlocks(data.data())) {
+      EXPECT_EQ(block.GetStorageMode(), ImageHeader::kStorageModeLZ4HC);
+      EXPECT_EQ(block.GetImageOffset(), expected_offset);
+      EXPECT_LE(block.GetImageSize(), kMaxBlockSize);
+      expected_offset += block.GetImageSize();
+      if (expected_offset != image_header->GetImageSize()) {
+        EXPECT_TRUE(IsAligned<kPageSize>(expected_offset)) << expected_offset;
+      }
+      std::string error_msg;
+      ASSERT_TRUE(block.Decompress(image.data(), data.data(), &error_msg)) << error_msg;
+    }
+    EXPECT_EQ(expected_offset, image_header->GetImageSize());
+  }
+}
+
 TEST_F(ImageTest, ImageHeaderIsValid) {
     uint32_t image_begin = ART_BASE_ADDRESS;
     uint32_t image_size_ = 16 * KB;
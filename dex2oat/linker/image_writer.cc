@@ -83,6 +83,7 @@
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
 #include "subtype_check.h"
+#include "thread_pool.h"
 #include "well_known_classes.h"
 
 using ::art::mirror::Class;
@@ -112,8 +113,11 @@ constexpr double kImageInternTableMinLoadFactor = 0.5;
 // properties (see `Runtime::GetHashTableMaxLoadFactor()` checking for low memory mode).
 constexpr double kImageInternTableMaxLoadFactor = 0.7;
 
+static_assert(CompilerOptions::kMaxImageCompressionLevel == LZ4HC_CLEVEL_MAX);
+
 static ArrayRef<const uint8_t> MaybeCompressData(ArrayRef<const uint8_t> source,
                                                  ImageHeader::StorageMode image_storage_mode,
+                                                 uint32_t compression_level,
                                                  /*out*/ dchecked_vector<uint8_t>* storage) {
   const uint64_t compress_start_time = NanoTime();
 
@@ -136,7 +140,7 @@ static ArrayRef<const uint8_t> MaybeCompressData(ArrayRef<const uint8_t> source,
           reinterpret_cast<char*>(storage->data()),
           source.size(),
           storage->size(),
-          LZ4HC_CLEVEL_MAX);
+          compression_level);
       storage->resize(data_size);
       break;
     }
@@ -436,6 +440,11 @@ bool ImageWriter::Write(int image_fd,
 
   Thread* const self = Thread::Current();
   ScopedDebugDisallowReadBarriers sddrb(self);
+  if (thread_count_ > 1u) {
+    // The calling thread takes part in the work while waiting for the workers.
+    thread_pool_.reset(new ThreadPool("Image writer thread pool", thread_count_ - 1u));
+    thread_pool_->StartWorkers(self);
+  }
   {
     ScopedObjectAccess soa(self);
     for (size_t i = 0; i < oat_filenames_.size(); ++i) {
@@ -499,10 +508,19 @@ bool ImageWriter::Write(int image_fd,
     dchecked_vector<ImageHeader::Block> blocks;
 
     // Add a set of solid blocks such that no block is larger than the maximum size. A solid block
-    // is a block that must be decompressed all at once.
+    // is a block that must be decompressed all at once. Blocks are decompressed in parallel at
+    // load time, so end them on page boundaries where possible to avoid two threads writing to
+    // the same page.
     auto add_blocks = [&](uint32_t offset, uint32_t size) {
+      const uint32_t max_block_size = compiler_options_.MaxImageBlockSize();
       while (size != 0u) {
-        const uint32_t cur_size = std::min(size, compiler_options_.MaxImageBlockSize());
+        uint32_t cur_size = std::min(size, max_block_size);
+        if (cur_size != size) {
+          uint32_t aligned_end = RoundDown(offset + cur_size, kPageSize);
+          if (aligned_end > offset) {
+            cur_size = aligned_end - offset;
+          }
+        }
         block_sources.emplace_back(offset, cur_size);
         offset += cur_size;
         size -= cur_size;
@@ -516,14 +534,41 @@ bool ImageWriter::Write(int image_fd,
     image_checksum = adler32(image_checksum,
                              reinterpret_cast<const uint8_t*>(image_header),
                              sizeof(ImageHeader));
-    // Copy and compress blocks.
-    size_t out_offset = sizeof(ImageHeader);
-    for (const std::pair<uint32_t, uint32_t> block : block_sources) {
+    // Compress the blocks, on all threads if there are several blocks.
+    const uint64_t compress_start_time = NanoTime();
+    dchecked_vector<dchecked_vector<uint8_t>> compressed_data(block_sources.size());
+    dchecked_vector<ArrayRef<const uint8_t>> block_data(block_sources.size());
+    auto compress_block = [&](size_t index) {
+      const std::pair<uint32_t, uint32_t>& block = block_sources[index];
       ArrayRef<const uint8_t> raw_image_data(image_info.image_.Begin() + block.first,
                                              block.second);
-      dchecked_vector<uint8_t> compressed_data;
-      ArrayRef<const uint8_t> image_data =
-          MaybeCompressData(raw_image_data, image_storage_mode_, &compressed_data);
+      block_data[index] = MaybeCompressData(raw_image_data,
+                                            image_storage_mode_,
+                                            compiler_options_.GetImageCompressionLevel(),
+                                            &compressed_data[index]);
+    };
+    if (is_compressed && thread_pool_ != nullptr && block_sources.size() > 1u) {
+      for (size_t index = 0; index != block_sources.size(); ++index) {
+        thread_pool_->AddTask(self, new FunctionTask([&compress_block, index](Thread*) {
+          compress_block(index);
+        }));
+      }
+      thread_pool_->Wait(self, /*do_work=*/ true, /*may_hold_locks=*/ false);
+    } else {
+      for (size_t index = 0; index != block_sources.size(); ++index) {
+        compress_block(index);
+      }
+    }
+    if (is_compressed) {
+      VLOG(compiler) << "Compressed " << block_sources.size() << " image blocks in "
+                     << PrettyDuration(NanoTime() - compress_start_time);
+    }
+
+    // Write the blocks in order.
+    size_t out_offset = sizeof(ImageHeader);
+    for (size_t index = 0; index != block_sources.size(); ++index) {
+      const std::pair<uint32_t, uint32_t>& block = block_sources[index];
+      ArrayRef<const uint8_t> image_data = block_data[index];
 
       if (!is_compressed) {
         // For uncompressed, preserve alignment since the image will be directly mapped.
@@ -624,6 +669,7 @@ bool ImageWriter::Write(int image_fd,
     }
   }
   DCHECK(primary_image_file != nullptr);
+  thread_pool_.reset();
   if (!primary_image_file.WriteHeaderAndClose(image_filenames[0], primary_header)) {
     return false;
   }
@@ -2778,73 +2824,109 @@ void ImageWriter::CopyAndFixupImtConflictTable(ImtConflictTable* orig, ImtConfli
   }
 }
 
+template <typename Fn>
+void ImageWriter::ParallelFor(size_t size, Fn fn) {
+  // Copying a single object or native structure is cheap, so use chunks of at least
+  // kMinChunkSize items. Several chunks per thread balance the load.
+  static constexpr size_t kMinChunkSize = 256u;
+  static constexpr size_t kChunksPerThread = 4u;
+  if (thread_pool_ == nullptr || size <= kMinChunkSize) {
+    fn(0u, size);
+    return;
+  }
+  Thread* const self = Thread::Current();
+  const size_t num_chunks = thread_count_ * kChunksPerThread;
+  const size_t chunk_size = std::max(kMinChunkSize, (size + num_chunks - 1u) / num_chunks);
+  for (size_t begin = 0u; begin < size; begin += chunk_size) {
+    const size_t end = std::min(begin + chunk_size, size);
+    thread_pool_->AddTask(self, new FunctionTask([&fn, begin, end](Thread* worker) {
+      ScopedObjectAccess soa(worker);
+      ScopedDebugDisallowReadBarriers sddrb(worker);
+      fn(begin, end);
+    }));
+  }
+  // Do not hold the mutator lock while waiting, the calling thread acquires it again
+  // for each chunk it takes.
+  ScopedThreadSuspension sts(self, ThreadState::kNative);
+  thread_pool_->Wait(self, /*do_work=*/ true, /*may_hold_locks=*/ false);
+}
+
 void ImageWriter::CopyAndFixupNativeData(size_t oat_index) {
   const ImageInfo& image_info = GetImageInfo(oat_index);
   // Copy ArtFields and methods to their locations and update the array for convenience.
-  for (auto& pair : native_object_relocations_) {
-    NativeObjectRelocation& relocation = pair.second;
-    // Only work with fields and methods that are in the current oat file.
-    if (relocation.oat_index != oat_index) {
-      continue;
-    }
-    auto* dest = image_info.image_.Begin() + relocation.offset;
-    DCHECK_GE(dest, image_info.image_.Begin() + image_info.image_end_);
-    DCHECK(!IsInBootImage(pair.first));
-    switch (relocation.type) {
-      case NativeObjectRelocationType::kRuntimeMethod:
-      case NativeObjectRelocationType::kArtMethodClean:
-      case NativeObjectRelocationType::kArtMethodDirty: {
-        CopyAndFixupMethod(reinterpret_cast<ArtMethod*>(pair.first),
-                           reinterpret_cast<ArtMethod*>(dest),
-                           oat_index);
-        break;
-      }
-      case NativeObjectRelocationType::kArtFieldArray: {
-        // Copy and fix up the entire field array.
-        auto* src_array = reinterpret_cast<LengthPrefixedArray<ArtField>*>(pair.first);
-        auto* dest_array = reinterpret_cast<LengthPrefixedArray<ArtField>*>(dest);
-        size_t size = src_array->size();
-        memcpy(dest_array, src_array, LengthPrefixedArray<ArtField>::ComputeSize(size));
-        for (size_t i = 0; i != size; ++i) {
-          CopyAndFixupReference(
-              dest_array->At(i).GetDeclaringClassAddressWithoutBarrier(),
-              src_array->At(i).GetDeclaringClass<kWithoutReadBarrier>());
+  // Only work with fields and methods that are in the current oat file.
+  std::vector<std::pair<void*, NativeObjectRelocation>> relocations;
+  for (const auto& pair : native_object_relocations_) {
+    if (pair.second.oat_index == oat_index) {
+      relocations.push_back(pair);
+    }
+  }
+  auto copy_and_fixup = [&](size_t begin, size_t end) REQUIRES_SHARED(Locks::mutator_lock_) {
+    for (size_t index = begin; index != end; ++index) {
+      void* orig = relocations[index].first;
+      const NativeObjectRelocation& relocation = relocations[index].second;
+      auto* dest = image_info.image_.Begin() + relocation.offset;
+      DCHECK_GE(dest, image_info.image_.Begin() + image_info.image_end_);
+      DCHECK(!IsInBootImage(orig));
+      switch (relocation.type) {
+        case NativeObjectRelocationType::kRuntimeMethod:
+        case NativeObjectRelocationType::kArtMethodClean:
+        case NativeObjectRelocationType::kArtMethodDirty: {
+          CopyAndFixupMethod(reinterpret_cast<ArtMethod*>(orig),
+                             reinterpret_cast<ArtMethod*>(dest),
+                             oat_index);
+          break;
+        }
+        case NativeObjectRelocationType::kArtFieldArray: {
+          // Copy and fix up the entire field array.
+          auto* src_array = reinterpret_cast<LengthPrefixedArray<ArtField>*>(orig);
+          auto* dest_array = reinterpret_cast<LengthPrefixedArray<ArtField>*>(dest);
+          size_t size = src_array->size();
+          memcpy(dest_array, src_array, LengthPrefixedArray<ArtField>::ComputeSize(size));
+          for (size_t i = 0; i != size; ++i) {
+            CopyAndFixupReference(
+                dest_array->At(i).GetDeclaringClassAddressWithoutBarrier(),
+                src_array->At(i).GetDeclaringClass<kWithoutReadBarrier>());
+          }
+          break;
+        }
+        case NativeObjectRelocationType::kArtMethodArrayClean:
+        case NativeObjectRelocationType::kArtMethodArrayDirty: {
+          // For method arrays, copy just the header since the elements will
+          // get copied by their corresponding relocations.
+          size_t size = ArtMethod::Size(target_ptr_size_);
+          size_t alignment = ArtMethod::Alignment(target_ptr_size_);
+          memcpy(dest, orig, LengthPrefixedArray<ArtMethod>::ComputeSize(0, size, alignment));
+          // Clear padding to avoid non-deterministic data in the image.
+          // Historical note: We also did that to placate Valgrind.
+          reinterpret_cast<LengthPrefixedArray<ArtMethod>*>(dest)->ClearPadding(size, alignment);
+          break;
+        }
+        case NativeObjectRelocationType::kIMTable: {
+          ImTable* orig_imt = reinterpret_cast<ImTable*>(orig);
+          ImTable* dest_imt = reinterpret_cast<ImTable*>(dest);
+          CopyAndFixupImTable(orig_imt, dest_imt);
+          break;
+        }
+        case NativeObjectRelocationType::kIMTConflictTable: {
+          auto* orig_table = reinterpret_cast<ImtConflictTable*>(orig);
+          CopyAndFixupImtConflictTable(
+              orig_table,
+              new(dest) ImtConflictTable(orig_table->NumEntries(target_ptr_size_),
+                                         target_ptr_size_));
+          break;
+        }
+        case NativeObjectRelocationType::kGcRootPointer: {
+          auto* orig_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(orig);
+          auto* dest_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(dest);
+          CopyAndFixupReference(dest_pointer->AddressWithoutBarrier(), orig_pointer->Read());
+          break;
         }
-        break;
-      }
-      case NativeObjectRelocationType::kArtMethodArrayClean:
-      case NativeObjectRelocationType::kArtMethodArrayDirty: {
-        // For method arrays, copy just the header since the elements will
-        // get copied by their corresponding relocations.
-        size_t size = ArtMethod::Size(target_ptr_size_);
-        size_t alignment = ArtMethod::Alignment(target_ptr_size_);
-        memcpy(dest, pair.first, LengthPrefixedArray<ArtMethod>::ComputeSize(0, size, alignment));
-        // Clear padding to avoid non-deterministic data in the image.
-        // Historical note: We also did that to placate Valgrind.
-        reinterpret_cast<LengthPrefixedArray<ArtMethod>*>(dest)->ClearPadding(size, alignment);
-        break;
-      }
-      case NativeObjectRelocationType::kIMTable: {
-        ImTable* orig_imt = reinterpret_cast<ImTable*>(pair.first);
-        ImTable* dest_imt = reinterpret_cast<ImTable*>(dest);
-        CopyAndFixupImTable(orig_imt, dest_imt);
-        break;
-      }
-      case NativeObjectRelocationType::kIMTConflictTable: {
-        auto* orig_table = reinterpret_cast<ImtConflictTable*>(pair.first);
-        CopyAndFixupImtConflictTable(
-            orig_table,
-            new(dest)ImtConflictTable(orig_table->NumEntries(target_ptr_size_), target_ptr_size_));
-        break;
-      }
-      case NativeObjectRelocationType::kGcRootPointer: {
-        auto* orig_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(pair.first);
-        auto* dest_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(dest);
-        CopyAndFixupReference(dest_pointer->AddressWithoutBarrier(), orig_pointer->Read());
-        break;
       }
     }
-  }
+  };
+  ParallelFor(relocations.size(), copy_and_fixup);
+
   // Fixup the image method roots.
   auto* image_header = reinterpret_cast<ImageHeader*>(image_info.image_.Begin());
   for (size_t i = 0; i < ImageHeader::kImageMethodsCount; ++i) {
@@ -2962,7 +3044,8 @@ inline Object* ImageWriter::CopyObject(Object* obj) {
   DCHECK_LT(offset, image_info.image_end_);
   const auto* src = reinterpret_cast<const uint8_t*>(obj);
 
-  bool done = image_info.image_bitmap_.Set(dst);  // Mark the obj as live.
+  // Mark the obj as live. Other threads set bits in the same bitmap words.
+  bool done = image_info.image_bitmap_.AtomicTestAndSet(dst);
   // Check if the object was already copied, unless the caller indicated that it was not.
   if (kCheckIfDone && done) {
     return nullptr;
@@ -3057,11 +3140,22 @@ void ImageWriter::CopyAndFixupObjects() {
     }
   }
 
+  // Each object is copied to and fixed up in its own slot, so the objects can be
+  // processed in any order.
+  std::vector<Object*> objects;
   auto visitor = [&](Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
     DCHECK(obj != nullptr);
-    CopyAndFixupObject(obj);
+    if (IsImageBinSlotAssigned(obj)) {
+      objects.push_back(obj);
+    }
   };
   Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  auto copy_and_fixup = [&](size_t begin, size_t end) REQUIRES_SHARED(Locks::mutator_lock_) {
+    for (size_t i = begin; i != end; ++i) {
+      CopyAndFixupObject(objects[i]);
+    }
+  };
+  ParallelFor(objects.size(), copy_and_fixup);
 
   // Fill the padding objects since they are required for in order traversal of the image space.
   for (ImageInfo& image_info : image_infos_) {
@@ -3566,7 +3660,8 @@ ImageWriter::ImageWriter(
     const std::vector<std::string>& oat_filenames,
     const HashMap<const DexFile*, size_t>& dex_file_oat_index_map,
     jobject class_loader,
-    const HashSet<std::string>* dirty_image_objects)
+    const HashSet<std::string>* dirty_image_objects,
+    size_t thread_count)
     : compiler_options_(compiler_options),
       boot_image_begin_(Runtime::Current()->GetHeap()->GetBootImagesStartAddress()),
       boot_image_size_(Runtime::Current()->GetHeap()->GetBootImagesSize()),
@@ -3582,7 +3677,8 @@ ImageWriter::ImageWriter(
       image_storage_mode_(image_storage_mode),
       oat_filenames_(oat_filenames),
       dex_file_oat_index_map_(dex_file_oat_index_map),
-      dirty_image_objects_(dirty_image_objects) {
+      dirty_image_objects_(dirty_image_objects),
+      thread_count_(std::max<size_t>(thread_count, 1u)) {
   DCHECK(compiler_options.IsBootImage() ||
          compiler_options.IsBootImageExtension() ||
          compiler_options.IsAppImage());
@@ -69,6 +69,7 @@ template<class T> class Handle;
 class ImTable;
 class ImtConflictTable;
 class JavaVMExt;
+class ThreadPool;
 class TimingLogger;
 
 namespace linker {
@@ -82,7 +83,8 @@ class ImageWriter final {
               const std::vector<std::string>& oat_filenames,
               const HashMap<const DexFile*, size_t>& dex_file_oat_index_map,
               jobject class_loader,
-              const HashSet<std::string>* dirty_image_objects);
+              const HashSet<std::string>* dirty_image_objects,
+              size_t thread_count);
   ~ImageWriter();
 
   /*
@@ -463,7 +465,9 @@ class ImageWriter final {
   void CalculateObjectBinSlots(mirror::Object* obj)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Creates the contiguous image in memory and adjusts pointers.
+  // Creates the contiguous image in memory and adjusts pointers. The copies of distinct
+  // objects and native structures do not overlap, so the work is split across threads.
+  // The result does not depend on the number of threads.
   void CopyAndFixupNativeData(size_t oat_index) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupObjects() REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupObject(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_);
@@ -478,6 +482,11 @@ class ImageWriter final {
   void CopyAndFixupImtConflictTable(ImtConflictTable* orig, ImtConflictTable* copy)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Calls `fn(begin, end)` for chunks of [0, size) on the image writer threads and waits
+  // for all of them. Chunks run in no particular order.
+  template <typename Fn>
+  void ParallelFor(size_t size, Fn fn) REQUIRES_SHARED(Locks::mutator_lock_);
+
   /*
    * Copies metadata from the heap into a buffer that will be compressed and
    * written to the image.
@@ -694,6 +703,13 @@ class ImageWriter final {
   // Region alignment bytes wasted.
   size_t region_alignment_wasted_ = 0u;
 
+  // Number of threads copying, fixing up and compressing the image, including the calling thread.
+  const size_t thread_count_;
+
+  // Workers for the copy, fixup and compression, only set in Write() if there is more than
+  // one thread.
+  std::unique_ptr<ThreadPool> thread_pool_;
+
   class FixupClassVisitor;
   class FixupRootVisitor;
   class FixupVisitor;
@@ -66,6 +66,20 @@ class MultiOatRelativePatcher final {
     method_offset_map_.map.Put(method_ref, offset + adjustment_);
   }
 
+  // Get the relative offset of a CodeInfo written to this or an earlier oat file.
+  // Returns 0 when it has not been written yet. As with GetOffset(), the offset
+  // wraps around for earlier oat files and is only meaningful for calculating
+  // distances from offsets in the current oat file.
+  uint32_t GetCodeInfoOffset(const uint8_t* code_info) const {
+    auto it = code_info_offsets_.find(code_info);
+    return (it != code_info_offsets_.end()) ? it->second - adjustment_ : 0u;
+  }
+
+  // Set the offset of a CodeInfo written to the current oat file.
+  void SetCodeInfoOffset(const uint8_t* code_info, uint32_t offset) {
+    code_info_offsets_.Put(code_info, offset + adjustment_);
+  }
+
   // Wrapper around RelativePatcher::ReserveSpace(), doing offset adjustment.
   uint32_t ReserveSpace(uint32_t offset,
                         const CompiledMethod* compiled_method,
@@ -162,6 +176,8 @@ class MultiOatRelativePatcher final {
 
   ThunkProvider thunk_provider_;
   MethodOffsetMap method_offset_map_;
+  // Map deduplicated CodeInfo data to the global offset where it was written.
+  SafeMap<const uint8_t*, uint32_t> code_info_offsets_;
   std::unique_ptr<RelativePatcher> relative_patcher_;
   uint32_t adjustment_;
   InstructionSet instruction_set_;
@@ -172,6 +172,31 @@ TEST_F(MultiOatRelativePatcherTest, Offsets) {
   EXPECT_EQ(off2 + adjustment2 - adjustment3, patcher_.GetOffset(ref2));
 }
 
+TEST_F(MultiOatRelativePatcherTest, CodeInfoOffsets) {
+  const uint8_t* code_info1 = reinterpret_cast<const uint8_t*>(0x100);
+  const uint8_t* code_info2 = reinterpret_cast<const uint8_t*>(0x200);
+  EXPECT_EQ(0u, patcher_.GetCodeInfoOffset(code_info1));
+
+  uint32_t adjustment1 = 0x1000;
+  patcher_.StartOatFile(adjustment1);
+  uint32_t off1 = 0x1234;
+  patcher_.SetCodeInfoOffset(code_info1, off1);
+  EXPECT_EQ(off1, patcher_.GetCodeInfoOffset(code_info1));
+  EXPECT_EQ(0u, patcher_.GetCodeInfoOffset(code_info2));
+
+  uint32_t adjustment2 = 0x30000;
+  patcher_.StartOatFile(adjustment2);
+  uint32_t off2 = 0x4321;
+  patcher_.SetCodeInfoOffset(code_info2, off2);
+  EXPECT_EQ(off1 + adjustment1 - adjustment2, patcher_.GetCodeInfoOffset(code_info1));
+  EXPECT_EQ(off2, patcher_.GetCodeInfoOffset(code_info2));
+
+  // Code in the second oat file finds the CodeInfo in the first one at the global distance.
+  uint32_t code_offset = 0x5000;
+  EXPECT_EQ((code_offset + adjustment2) - (off1 + adjustment1),
+            code_offset - patcher_.GetCodeInfoOffset(code_info1));
+}
+
 TEST_F(MultiOatRelativePatcherTest, OffsetsInReserve) {
   const DexFile* dex_file = reinterpret_cast<const DexFile*>(1);
   MethodReference ref1(dex_file, 1u);
@@ -17,6 +17,7 @@
 #include "oat_writer.h"
 
 #include <algorithm>
+#include <set>
 #include <unistd.h>
 #include <zlib.h>
 
@@ -45,6 +46,7 @@
 #include "dex/dex_file_loader.h"
 #include "dex/dex_file_types.h"
 #include "dex/standard_dex_file.h"
+#include "dex/string_lookup_table.h"
 #include "dex/type_lookup_table.h"
 #include "dex/verification_results.h"
 #include "dex_container.h"
@@ -406,9 +408,12 @@ OatWriter::OatWriter(const CompilerOptions& compiler_options,
     vdex_verifier_deps_offset_(0u),
     vdex_quickening_info_offset_(0u),
     vdex_lookup_tables_offset_(0u),
+    vdex_string_lookup_tables_offset_(0u),
     oat_checksum_(adler32(0L, Z_NULL, 0)),
     code_size_(0u),
     oat_size_(0u),
+    startup_code_pages_(0u),
+    startup_code_size_(0u),
     data_bimg_rel_ro_start_(0u),
     data_bimg_rel_ro_size_(0u),
     bss_start_(0u),
@@ -438,6 +443,7 @@ OatWriter::OatWriter(const CompilerOptions& compiler_options,
     size_quickening_info_alignment_(0),
     size_vdex_lookup_table_alignment_(0),
     size_vdex_lookup_table_(0),
+    size_vdex_string_lookup_table_(0),
     size_interpreter_to_interpreter_bridge_(0),
     size_interpreter_to_compiled_code_bridge_(0),
     size_jni_dlsym_lookup_trampoline_(0),
@@ -1081,6 +1087,13 @@ struct OatWriter::BssMappingInfo {
 //
 // See also OrderedMethodVisitor.
 struct OatWriter::OrderedMethodData {
+  // Note: Bin-to-bin order does not matter. If the kernel does or does not read-ahead
+  // any memory, it only goes into the buffer cache and does not grow the PSS until the
+  // first time that memory is referenced in the process.
+  static constexpr uint32_t kHotBit = 1u;
+  static constexpr uint32_t kStartupBit = 2u;
+  static constexpr uint32_t kPostStartupBit = 4u;
+
   uint32_t hotness_bits;
   OatClass* oat_class;
   CompiledMethod* compiled_method;
@@ -1246,19 +1259,16 @@ class OatWriter::LayoutCodeMethodVisitor final : public OatDexMethodVisitor {
       if (profile_index_ != ProfileCompilationInfo::MaxProfileIndex()) {
         ProfileCompilationInfo* pci = writer_->profile_compilation_info_;
         DCHECK(pci != nullptr);
-        // Note: Bin-to-bin order does not matter. If the kernel does or does not read-ahead
-        // any memory, it only goes into the buffer cache and does not grow the PSS until the
-        // first time that memory is referenced in the process.
-        constexpr uint32_t kHotBit = 1u;
-        constexpr uint32_t kStartupBit = 2u;
-        constexpr uint32_t kPostStartupBit = 4u;
         hotness_bits =
-            (pci->IsHotMethod(profile_index_, method_index) ? kHotBit : 0u) |
-            (pci->IsStartupMethod(profile_index_, method_index) ? kStartupBit : 0u) |
-            (pci->IsPostStartupMethod(profile_index_, method_index) ? kPostStartupBit : 0u);
+            (pci->IsHotMethod(profile_index_, method_index)
+                 ? OrderedMethodData::kHotBit : 0u) |
+            (pci->IsStartupMethod(profile_index_, method_index)
+                 ? OrderedMethodData::kStartupBit : 0u) |
+            (pci->IsPostStartupMethod(profile_index_, method_index)
+                 ? OrderedMethodData::kPostStartupBit : 0u);
         if (kIsDebugBuild) {
           // Check for bins that are always-empty given a real profile.
-          if (hotness_bits == kHotBit) {
+          if (hotness_bits == OrderedMethodData::kHotBit) {
             // This is not fatal, so only warn.
             LOG(WARNING) << "Method " << method_ref.PrettyMethod() << " was hot but wasn't marked "
                          << "either start-up or post-startup. Possible corrupted profile?";
@@ -1292,6 +1302,10 @@ class OatWriter::LayoutCodeMethodVisitor final : public OatDexMethodVisitor {
       // Since most methods will have the same ordering criteria,
       // we preserve the original insertion order within the same sort order.
       std::stable_sort(ordered_methods_.begin(), ordered_methods_.end());
+      if (writer_->profile_compilation_info_ != nullptr &&
+          writer_->GetCompilerOptions().ProfileCodeLayout()) {
+        OrderByCallAffinity();
+      }
     } else {
       // The profile-less behavior is as if every method had 0 hotness
       // associated with it.
@@ -1305,6 +1319,103 @@ class OatWriter::LayoutCodeMethodVisitor final : public OatDexMethodVisitor {
   }
 
  private:
+  // Place the startup methods first, then the other hot methods, then everything else in
+  // the hotness bin order. Within the startup and hot groups, each method is followed by
+  // the methods of the same group that its code calls or references and that are not placed
+  // yet, depth first. The profile does not record when methods first run, so for startup
+  // methods this approximates it by the order of the first calls, starting from the methods
+  // no other startup method calls. For hot methods it keeps callers and callees on the
+  // same pages.
+  void OrderByCallAffinity() {
+    enum Group : uint32_t { kStartup, kHot, kOther };
+    auto get_group = [](const OrderedMethodData& method_data) {
+      if ((method_data.hotness_bits & OrderedMethodData::kStartupBit) != 0u) {
+        return kStartup;
+      } else if ((method_data.hotness_bits & OrderedMethodData::kHotBit) != 0u) {
+        return kHot;
+      } else {
+        return kOther;
+      }
+    };
+
+    const size_t num_methods = ordered_methods_.size();
+    SafeMap<MethodReference, size_t> method_indexes;
+    for (size_t i = 0; i != num_methods; ++i) {
+      method_indexes.FindOrAdd(ordered_methods_[i].method_reference, i);
+    }
+    // Methods of the same group called or referenced by each method, in code order.
+    std::vector<std::vector<size_t>> callees(num_methods);
+    std::vector<bool> has_caller(num_methods, false);
+    for (size_t i = 0; i != num_methods; ++i) {
+      Group group = get_group(ordered_methods_[i]);
+      if (group == kOther) {
+        continue;
+      }
+      for (const LinkerPatch& patch : ordered_methods_[i].compiled_method->GetPatches()) {
+        if (patch.GetType() != LinkerPatch::Type::kCallRelative &&
+            patch.GetType() != LinkerPatch::Type::kMethodRelative &&
+            patch.GetType() != LinkerPatch::Type::kMethodBssEntry) {
+          continue;
+        }
+        auto it = method_indexes.find(patch.TargetMethod());
+        if (it != method_indexes.end() && it->second != i &&
+            get_group(ordered_methods_[it->second]) == group) {
+          callees[i].push_back(it->second);
+          has_caller[it->second] = true;
+        }
+      }
+    }
+
+    std::vector<size_t> order;
+    order.reserve(num_methods);
+    std::vector<bool> placed(num_methods, false);
+    std::vector<size_t> stack;
+    auto place_from = [&](size_t root) {
+      stack.push_back(root);
+      while (!stack.empty()) {
+        size_t index = stack.back();
+        stack.pop_back();
+        if (placed[index]) {
+          continue;
+        }
+        placed[index] = true;
+        order.push_back(index);
+        // Push in reverse so that the first callee is placed next.
+        for (auto it = callees[index].rbegin(); it != callees[index].rend(); ++it) {
+          if (!placed[*it]) {
+            stack.push_back(*it);
+          }
+        }
+      }
+    };
+    for (Group group : {kStartup, kHot}) {
+      // Roots first, then whatever is left in call cycles.
+      for (bool roots_only : {true, false}) {
+        for (size_t i = 0; i != num_methods; ++i) {
+          if (!placed[i] &&
+              get_group(ordered_methods_[i]) == group &&
+              (!roots_only || !has_caller[i])) {
+            place_from(i);
+          }
+        }
+      }
+    }
+    for (size_t i = 0; i != num_methods; ++i) {
+      if (!placed[i]) {
+        DCHECK_EQ(get_group(ordered_methods_[i]), kOther);
+        order.push_back(i);
+      }
+    }
+    DCHECK_EQ(order.size(), num_methods);
+
+    OrderedMethodList ordered_methods;
+    ordered_methods.reserve(num_methods);
+    for (size_t index : order) {
+      ordered_methods.push_back(ordered_methods_[index]);
+    }
+    ordered_methods_ = std::move(ordered_methods);
+  }
+
   // Cached profile index for the current dex file.
   ProfileCompilationInfo::ProfileIndexType profile_index_;
   const DexFile* profile_index_dex_file_;
@@ -1327,6 +1438,8 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
   }
 
   bool VisitComplete() override {
+    writer_->startup_code_pages_ = startup_code_pages_.size();
+    writer_->startup_code_size_ = startup_code_size_;
     offset_ = writer_->relative_patcher_->ReserveSpaceEnd(offset_);
     if (generate_debug_info_) {
       std::vector<debug::MethodDebugInfo> thunk_infos =
@@ -1358,6 +1471,17 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
     uint32_t code_size = quick_code.size() * sizeof(uint8_t);
     uint32_t thumb_offset = compiled_method->CodeDelta();
 
+    // InitMapMethodVisitor leaves the offset at 0 for a CodeInfo in an earlier oat file.
+    DCHECK_LT(method_offsets_index_, oat_class->method_headers_.size());
+    OatQuickMethodHeader* method_header = &oat_class->method_headers_[method_offsets_index_];
+    uint32_t code_info_offset = method_header->GetCodeInfoOffset();
+    uint32_t shared_code_info_offset = 0u;
+    if (code_info_offset == 0u && !compiled_method->GetVmapTable().empty()) {
+      shared_code_info_offset =
+          relative_patcher_->GetCodeInfoOffset(compiled_method->GetVmapTable().data());
+      DCHECK_NE(shared_code_info_offset, 0u);
+    }
+
     // Deduplicate code arrays if we are not producing debuggable code.
     bool deduped = true;
     if (debuggable_) {
@@ -1366,15 +1490,17 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
         // Duplicate methods, we want the same code for both of them so that the oat writer puts
         // the same code in both ArtMethods so that we do not get different oat code at runtime.
       } else {
-        quick_code_offset = NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+        quick_code_offset = NewQuickCodeOffset(
+            compiled_method, method_ref, thumb_offset, shared_code_info_offset);
         deduped = false;
       }
     } else {
       quick_code_offset = dedupe_map_.GetOrCreate(
           compiled_method,
-          [this, &deduped, compiled_method, &method_ref, thumb_offset]() {
+          [this, &deduped, compiled_method, &method_ref, thumb_offset, shared_code_info_offset]() {
             deduped = false;
-            return NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+            return NewQuickCodeOffset(
+                compiled_method, method_ref, thumb_offset, shared_code_info_offset);
           });
     }
 
@@ -1391,9 +1517,6 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
     }
 
     // Update quick method header.
-    DCHECK_LT(method_offsets_index_, oat_class->method_headers_.size());
-    OatQuickMethodHeader* method_header = &oat_class->method_headers_[method_offsets_index_];
-    uint32_t code_info_offset = method_header->GetCodeInfoOffset();
     uint32_t code_offset = quick_code_offset - thumb_offset;
     CHECK(!compiled_method->GetQuickCode().empty());
     // If the code is compiled, we write the offset of the stack map relative
@@ -1401,6 +1524,17 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
     if (code_info_offset != 0u) {
       DCHECK_LT(code_info_offset, code_offset);
       code_info_offset = code_offset - code_info_offset;
+    } else if (shared_code_info_offset != 0u) {
+      auto copy_it = writer_->code_info_copies_.find(code_offset);
+      if (copy_it != writer_->code_info_copies_.end()) {
+        // The shared CodeInfo is out of reach, see NewQuickCodeOffset().
+        code_info_offset = code_offset - copy_it->second;
+      } else {
+        // The CodeInfo is in an earlier oat file, see InitMapMethodVisitor. Its relative
+        // offset wraps around, so the unsigned difference is the distance back to it.
+        code_info_offset = code_offset - shared_code_info_offset;
+      }
+      DCHECK(IsUint<kCodeInfoOffsetBits>(code_info_offset)) << method_ref.PrettyMethod();
     }
     *method_header = OatQuickMethodHeader(code_info_offset);
 
@@ -1410,6 +1544,18 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
       offset_ += code_size;
     }
 
+    if ((method_data.hotness_bits & OrderedMethodData::kStartupBit) != 0u) {
+      // Record the pages touched by the method header and code.
+      uint32_t begin = code_offset - sizeof(OatQuickMethodHeader);
+      for (uint32_t page = begin / kPageSize; page <= (code_offset + code_size - 1u) / kPageSize;
+           ++page) {
+        startup_code_pages_.insert(page);
+      }
+      if (!deduped) {
+        startup_code_size_ += sizeof(OatQuickMethodHeader) + code_size;
+      }
+    }
+
     // Exclude quickened dex methods (code_size == 0) since they have no native code.
     if (generate_debug_info_ && code_size != 0) {
       DCHECK(has_debug_info);
@@ -1487,14 +1633,34 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
 
   uint32_t NewQuickCodeOffset(CompiledMethod* compiled_method,
                               const MethodReference& method_ref,
-                              uint32_t thumb_offset) {
+                              uint32_t thumb_offset,
+                              uint32_t shared_code_info_offset) {
+    uint32_t code_info_copy_offset = 0u;
+    if (shared_code_info_offset != 0u &&
+        !IsUint<kCodeInfoOffsetBits>(offset_ + kMaxCodeDistance - shared_code_info_offset)) {
+      // The method header may not reach the CodeInfo in the earlier oat file. Write a copy
+      // here, only the thunks, alignment and header are between it and the code.
+      code_info_copy_offset = offset_;
+      offset_ += compiled_method->GetVmapTable().size();
+    }
     offset_ = relative_patcher_->ReserveSpace(offset_, compiled_method, method_ref);
     offset_ += CodeAlignmentSize(offset_, *compiled_method);
     DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
                          GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
-    return offset_ + sizeof(OatQuickMethodHeader) + thumb_offset;
+    uint32_t code_offset = offset_ + sizeof(OatQuickMethodHeader);
+    if (code_info_copy_offset != 0u) {
+      DCHECK(IsUint<kCodeInfoOffsetBits>(code_offset - code_info_copy_offset));
+      writer_->code_info_copies_.Put(code_offset, code_info_copy_offset);
+    }
+    return code_offset + thumb_offset;
   }
 
+  // Bits of the CodeInfo offset in the OatQuickMethodHeader.
+  static constexpr size_t kCodeInfoOffsetBits = 30u;
+  // Upper bound of the thunks reserved before a method, its alignment and its method header,
+  // which lie between `offset_` and the code.
+  static constexpr uint32_t kMaxCodeDistance = 1u * MB;
+
   OatWriter* writer_;
 
   // Offset of the code of the compiled methods.
@@ -1504,6 +1670,11 @@ class OatWriter::LayoutReserveOffsetCodeMethodVisitor : public OrderedMethodVisi
   // so we can simply compare the pointers to find out if things are duplicated.
   SafeMap<const CompiledMethod*, uint32_t, CodeOffsetsKeyComparator> dedupe_map_;
 
+  // Pages touched by the code of startup methods, relative to the oat data begin, and the
+  // size of that code.
+  std::set<uint32_t> startup_code_pages_;
+  size_t startup_code_size_ = 0u;
+
   // Cache writer_'s members and compiler options.
   MultiOatRelativePatcher* relative_patcher_;
   uint32_t executable_offset_;
@@ -1530,10 +1701,20 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
       DCHECK_EQ(oat_class->method_headers_[method_offsets_index_].GetCodeInfoOffset(), 0u);
 
       ArrayRef<const uint8_t> map = compiled_method->GetVmapTable();
-      if (map.size() != 0u) {
+      if (map.size() != 0u && deduplicate_across_images_ &&
+          dedupe_code_info_.find(map.data()) == dedupe_code_info_.end() &&
+          writer_->relative_patcher_->GetCodeInfoOffset(map.data()) != 0u) {
+        // The CodeInfo was written to an earlier oat file. Leave the offset at 0 and let
+        // LayoutReserveOffsetCodeMethodVisitor point the method header there.
+        ++num_shared_code_infos_;
+      } else if (map.size() != 0u) {
         size_t offset = dedupe_code_info_.GetOrCreate(map.data(), [=]() {
           // Deduplicate the inner BitTable<>s within the CodeInfo.
-          return offset_ + dedupe_bit_table_.Dedupe(map.data());
+          size_t new_offset = offset_ + dedupe_bit_table_.Dedupe(map.data());
+          if (deduplicate_across_images_) {
+            writer_->relative_patcher_->SetCodeInfoOffset(map.data(), new_offset);
+          }
+          return new_offset;
         });
         // Code offset is not initialized yet, so set file offset for now.
         DCHECK_EQ(oat_class->method_offsets_[method_offsets_index_].code_offset_, 0u);
@@ -1545,7 +1726,17 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
     return true;
   }
 
+  size_t GetNumSharedCodeInfos() const {
+    return num_shared_code_infos_;
+  }
+
  private:
+  // Whether CodeInfo may be shared with earlier oat files of a multi-image compilation.
+  // The MultiOatRelativePatcher offsets only span the oat files when there is an image.
+  const bool deduplicate_across_images_ =
+      writer_->GetCompilerOptions().DeduplicateAcrossImages() && writer_->image_writer_ != nullptr;
+  size_t num_shared_code_infos_ = 0u;
+
   // Deduplicate at CodeInfo level. The value is byte offset within code_info_data_.
   // This deduplicates the whole CodeInfo object without going into the inner tables.
   // The compiler already deduplicated the pointers but it did not dedupe the tables.
@@ -1764,6 +1955,20 @@ class OatWriter::WriteCodeMethodVisitor : public OrderedMethodVisitor {
     // Deduplicate code arrays.
     const OatMethodOffsets& method_offsets = oat_class->method_offsets_[method_offsets_index];
     if (method_offsets.code_offset_ > offset_) {
+      auto copy_it = writer_->code_info_copies_.find(
+          method_offsets.code_offset_ - compiled_method->CodeDelta());
+      if (UNLIKELY(copy_it != writer_->code_info_copies_.end())) {
+        // The shared CodeInfo is out of reach, see LayoutReserveOffsetCodeMethodVisitor.
+        DCHECK_EQ(copy_it->second, offset_);
+        ArrayRef<const uint8_t> code_info = compiled_method->GetVmapTable();
+        if (!out->WriteFully(code_info.data(), code_info.size())) {
+          ReportWriteFailure("CodeInfo copy", method_ref);
+          return false;
+        }
+        writer_->size_vmap_table_ += code_info.size();
+        offset_ += code_info.size();
+        DCHECK_OFFSET_();
+      }
       offset_ = writer_->relative_patcher_->WriteThunks(out, offset_);
       if (offset_ == 0u) {
         ReportWriteFailure("relative call thunk", method_ref);
@@ -2149,6 +2354,7 @@ size_t OatWriter::InitOatMaps(size_t offset) {
     InitMapMethodVisitor visitor(this, offset);
     bool success = VisitDexMethods(&visitor);
     DCHECK(success);
+    VLOG(compiler) << "CodeInfo shared with earlier oat files: " << visitor.GetNumSharedCodeInfos();
     code_info_data_.shrink_to_fit();
     offset += code_info_data_.size();
   }
@@ -2736,6 +2942,7 @@ bool OatWriter::CheckOatSize(OutputStream* out, size_t file_offset, size_t relat
     DO_STAT(size_verifier_deps_alignment_);
     DO_STAT(size_vdex_lookup_table_);
     DO_STAT(size_vdex_lookup_table_alignment_);
+    DO_STAT(size_vdex_string_lookup_table_);
     DO_STAT(size_quickening_info_);
     DO_STAT(size_quickening_info_alignment_);
     DO_STAT(size_interpreter_to_interpreter_bridge_);
@@ -3882,12 +4089,34 @@ void OatWriter::WriteTypeLookupTables(/*out*/std::vector<uint8_t>* buffer) {
   }
 }
 
+void OatWriter::WriteStringLookupTables(/*out*/std::vector<uint8_t>* buffer) {
+  TimingLogger::ScopedTiming split("WriteStringLookupTables", timings_);
+  // The type lookup tables keep the alignment.
+  DCHECK_ALIGNED(vdex_size_, 4u);
+  vdex_string_lookup_tables_offset_ = vdex_size_;
+  for (const DexFile* dex_file : *dex_files_) {
+    // An invalid table is recorded with size 0, lookups then use the dex file.
+    StringLookupTable table = StringLookupTable::Create(*dex_file);
+    uint32_t table_size = table.Valid() ? table.RawDataLength() : 0u;
+    DCHECK_ALIGNED(table_size, 4);
+    size_t old_buffer_size = buffer->size();
+    buffer->resize(old_buffer_size + sizeof(uint32_t) + table_size, 0u);
+    memcpy(buffer->data() + old_buffer_size, &table_size, sizeof(uint32_t));
+    if (table_size != 0u) {
+      memcpy(buffer->data() + old_buffer_size + sizeof(uint32_t), table.RawData(), table_size);
+    }
+    vdex_size_ += sizeof(uint32_t) + table_size;
+    size_vdex_string_lookup_table_ += sizeof(uint32_t) + table_size;
+  }
+}
+
 bool OatWriter::FinishVdexFile(File* vdex_file, verifier::VerifierDeps* verifier_deps) {
   size_t old_vdex_size = vdex_size_;
   std::vector<uint8_t> buffer;
   buffer.reserve(64 * KB);
   WriteVerifierDeps(verifier_deps, &buffer);
   WriteTypeLookupTables(&buffer);
+  WriteStringLookupTables(&buffer);
   DCHECK_EQ(vdex_size_, old_vdex_size + buffer.size());
 
   // Resize the vdex file.
@@ -3979,7 +4208,14 @@ bool OatWriter::FinishVdexFile(File* vdex_file, verifier::VerifierDeps* verifier
   // TypeLookupTable section.
   new (ptr) VdexFile::VdexSectionHeader(VdexSection::kTypeLookupTableSection,
                                         vdex_lookup_tables_offset_,
-                                        vdex_size_ - vdex_lookup_tables_offset_);
+                                        vdex_string_lookup_tables_offset_ -
+                                            vdex_lookup_tables_offset_);
+  ptr += sizeof(VdexFile::VdexSectionHeader);
+
+  // StringLookupTable section.
+  new (ptr) VdexFile::VdexSectionHeader(VdexSection::kStringLookupTableSection,
+                                        vdex_string_lookup_tables_offset_,
+                                        vdex_size_ - vdex_string_lookup_tables_offset_);
 
   // All the contents (except the header) of the vdex file has been emitted in memory. Flush it
   // to disk.
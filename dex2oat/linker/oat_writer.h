@@ -207,6 +207,16 @@ class OatWriter {
     return oat_size_;
   }
 
+  // Number of pages of .text holding code of startup methods from the profile, and the
+  // number of pages their code would need if it was contiguous. Valid after PrepareLayout().
+  size_t GetStartupCodePages() const {
+    return startup_code_pages_;
+  }
+
+  size_t GetMinStartupCodePages() const {
+    return RoundUp(startup_code_size_, kPageSize) / kPageSize;
+  }
+
   size_t GetDataBimgRelRoSize() const {
     return data_bimg_rel_ro_size_;
   }
@@ -299,6 +309,7 @@ class OatWriter {
                     /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files);
   void WriteQuickeningInfo(/*out*/std::vector<uint8_t>* buffer);
   void WriteTypeLookupTables(/*out*/std::vector<uint8_t>* buffer);
+  void WriteStringLookupTables(/*out*/std::vector<uint8_t>* buffer);
   void WriteVerifierDeps(verifier::VerifierDeps* verifier_deps,
                          /*out*/std::vector<uint8_t>* buffer);
 
@@ -389,6 +400,11 @@ class OatWriter {
 
   std::vector<uint8_t> code_info_data_;
 
+  // CodeInfo shared with an earlier oat file but too far from the method header to point at,
+  // see OatWriter::LayoutReserveOffsetCodeMethodVisitor. A copy is written to the code section
+  // before the method header instead. Maps the code offset to the offset of the copy.
+  SafeMap<uint32_t, uint32_t> code_info_copies_;
+
   const CompilerDriver* compiler_driver_;
   const CompilerOptions& compiler_options_;
   ImageWriter* image_writer_;
@@ -421,6 +437,9 @@ class OatWriter {
   // Offset of type lookup tables inside Vdex.
   size_t vdex_lookup_tables_offset_;
 
+  // Offset of string lookup tables inside Vdex.
+  size_t vdex_string_lookup_tables_offset_;
+
   // OAT checksum.
   uint32_t oat_checksum_;
 
@@ -430,6 +449,10 @@ class OatWriter {
   // Size required for Oat data structures.
   size_t oat_size_;
 
+  // Pages touched by the code of startup methods, and the size of that code.
+  size_t startup_code_pages_;
+  size_t startup_code_size_;
+
   // The start of the required .data.bimg.rel.ro section.
   size_t data_bimg_rel_ro_start_;
 
@@ -529,6 +552,7 @@ class OatWriter {
   uint32_t size_quickening_info_alignment_;
   uint32_t size_vdex_lookup_table_alignment_;
   uint32_t size_vdex_lookup_table_;
+  uint32_t size_vdex_string_lookup_table_;
   uint32_t size_interpreter_to_interpreter_bridge_;
   uint32_t size_interpreter_to_compiled_code_bridge_;
   uint32_t size_jni_dlsym_lookup_trampoline_;
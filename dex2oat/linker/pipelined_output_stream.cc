@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipelined_output_stream.h"
+
+#include <algorithm>
+
+#include <android-base/logging.h>
+
+#include "runtime.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace linker {
+
+class PipelinedOutputStream::WriteTask final : public SelfDeletingTask {
+ public:
+  WriteTask(PipelinedOutputStream* stream, std::unique_ptr<std::vector<uint8_t>> buffer)
+      : stream_(stream), buffer_(std::move(buffer)) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) override {
+    stream_->WriteBuffer(std::move(buffer_));
+  }
+
+ private:
+  PipelinedOutputStream* const stream_;
+  std::unique_ptr<std::vector<uint8_t>> buffer_;
+};
+
+PipelinedOutputStream::PipelinedOutputStream(std::unique_ptr<OutputStream> out,
+                                             size_t buffer_size,
+                                             size_t max_buffers)
+    : OutputStream(out->GetLocation()),  // Before out is moved to out_.
+      out_(std::move(out)),
+      buffer_size_(buffer_size),
+      max_buffers_(max_buffers),
+      position_(out_->Seek(0, kSeekCurrent)),
+      current_(std::make_unique<std::vector<uint8_t>>()),
+      lock_("pipelined output stream lock", kGenericBottomLock),
+      buffer_returned_cond_("pipelined output stream buffer returned", lock_),
+      allocated_buffers_(1u),
+      write_failed_(false) {
+  DCHECK_NE(buffer_size_, 0u);
+  DCHECK_NE(max_buffers_, 0u);
+  current_->reserve(buffer_size_);
+}
+
+PipelinedOutputStream::~PipelinedOutputStream() {
+  Drain();
+  // Stops and joins the writer thread.
+  writer_thread_pool_.reset();
+}
+
+bool PipelinedOutputStream::WriteFully(const void* buffer, size_t byte_count) {
+  if (position_ != static_cast<off_t>(-1)) {
+    position_ += byte_count;
+  }
+  // Large writes are split into buffers as well, so that they do not stall the producer.
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(buffer);
+  while (byte_count != 0u) {
+    if (current_->size() == buffer_size_ && !SubmitBuffer()) {
+      return false;
+    }
+    size_t chunk_size = std::min(byte_count, buffer_size_ - current_->size());
+    current_->insert(current_->end(), src, src + chunk_size);
+    src += chunk_size;
+    byte_count -= chunk_size;
+  }
+  return true;
+}
+
+off_t PipelinedOutputStream::Seek(off_t offset, Whence whence) {
+  // Querying the position is frequent (e.g. section sizes and offset checks in the oat
+  // writer) and does not need to wait for the writer thread.
+  if (whence == kSeekCurrent && offset == 0 && position_ != static_cast<off_t>(-1)) {
+    return position_;
+  }
+  if (!Drain()) {
+    position_ = static_cast<off_t>(-1);
+    return position_;
+  }
+  position_ = out_->Seek(offset, whence);
+  return position_;
+}
+
+bool PipelinedOutputStream::Flush() {
+  return Drain() && out_->Flush();
+}
+
+bool PipelinedOutputStream::SubmitBuffer() {
+  if (current_->empty()) {
+    return true;
+  }
+  Thread* self = Thread::Current();
+  if (writer_thread_pool_ == nullptr) {
+    if (self == nullptr || Runtime::Current() == nullptr) {
+      bool success = out_->WriteFully(current_->data(), current_->size());
+      current_->clear();
+      return success;
+    }
+    writer_thread_pool_ = std::make_unique<ThreadPool>("Pipelined output writer", 1u);
+    writer_thread_pool_->StartWorkers(self);
+  }
+  writer_thread_pool_->AddTask(self, new WriteTask(this, std::move(current_)));
+
+  MutexLock mu(self, lock_);
+  while (free_buffers_.empty() && allocated_buffers_ == max_buffers_) {
+    // The caller may hold the mutator lock while writing method code. This is fine as the
+    // writer thread does not take any lock other than `lock_` to return the buffer.
+    buffer_returned_cond_.WaitHoldingLocks(self);
+  }
+  if (!free_buffers_.empty()) {
+    current_ = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+  } else {
+    ++allocated_buffers_;
+    current_ = std::make_unique<std::vector<uint8_t>>();
+    current_->reserve(buffer_size_);
+  }
+  return !write_failed_;
+}
+
+bool PipelinedOutputStream::Drain() {
+  bool success = SubmitBuffer();
+  if (writer_thread_pool_ != nullptr) {
+    Thread* self = Thread::Current();
+    writer_thread_pool_->Wait(self, /* do_work= */ false, /* may_hold_locks= */ true);
+    MutexLock mu(self, lock_);
+    success = success && !write_failed_;
+  }
+  return success;
+}
+
+void PipelinedOutputStream::WriteBuffer(std::unique_ptr<std::vector<uint8_t>> buffer) {
+  Thread* self = Thread::Current();
+  bool write_failed;
+  {
+    MutexLock mu(self, lock_);
+    write_failed = write_failed_;
+  }
+  // After a failure, drop the remaining data. The failure is reported to the producer.
+  if (!write_failed && !out_->WriteFully(buffer->data(), buffer->size())) {
+    PLOG(ERROR) << "Failed to write " << buffer->size() << " bytes to " << GetLocation();
+    write_failed = true;
+  }
+  buffer->clear();
+  MutexLock mu(self, lock_);
+  write_failed_ = write_failed_ || write_failed;
+  free_buffers_.push_back(std::move(buffer));
+  buffer_returned_cond_.Broadcast(self);
+}
+
+}  // namespace linker
+}  // namespace art
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_DEX2OAT_LINKER_PIPELINED_OUTPUT_STREAM_H_
+#define ART_DEX2OAT_LINKER_PIPELINED_OUTPUT_STREAM_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/globals.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "stream/output_stream.h"
+
+namespace art {
+
+class ThreadPool;
+
+namespace linker {
+
+// Buffered output stream that hands full buffers to a background thread for writing,
+// so that the producer (e.g. the oat writer patching and copying method code) keeps
+// working while the previous buffer is written to the file.
+//
+// Buffers are written in the order they were filled. A write error is reported by the
+// next call to WriteFully(), Seek() or Flush(). Seeking relative to the current position
+// with offset 0 does not wait for the pending writes; other seeks do.
+//
+// Without a runtime to attach the writer thread to, writes are done synchronously.
+class PipelinedOutputStream final : public OutputStream {
+ public:
+  static constexpr size_t kDefaultBufferSize = 1 * MB;
+  static constexpr size_t kDefaultMaxBuffers = 4u;
+
+  explicit PipelinedOutputStream(std::unique_ptr<OutputStream> out,
+                                 size_t buffer_size = kDefaultBufferSize,
+                                 size_t max_buffers = kDefaultMaxBuffers);
+
+  ~PipelinedOutputStream() override;
+
+  bool WriteFully(const void* buffer, size_t byte_count) override;
+
+  off_t Seek(off_t offset, Whence whence) override;
+
+  bool Flush() override;
+
+ private:
+  class WriteTask;
+
+  // Hand the current buffer to the writer thread and get an empty one.
+  bool SubmitBuffer() REQUIRES(!lock_);
+
+  // Write the current buffer and wait for all pending writes to finish.
+  bool Drain() REQUIRES(!lock_);
+
+  // Called on the writer thread.
+  void WriteBuffer(std::unique_ptr<std::vector<uint8_t>> buffer) REQUIRES(!lock_);
+
+  std::unique_ptr<OutputStream> const out_;
+  const size_t buffer_size_;
+  const size_t max_buffers_;
+
+  // Position of the stream including the bytes not written yet, or -1 if unknown.
+  off_t position_;
+
+  // The buffer currently being filled. Owned by the producer.
+  std::unique_ptr<std::vector<uint8_t>> current_;
+
+  // Created on the first buffer hand-off.
+  std::unique_ptr<ThreadPool> writer_thread_pool_;
+
+  Mutex lock_ BOTTOM_MUTEX_ACQUIRED_AFTER;
+  ConditionVariable buffer_returned_cond_ GUARDED_BY(lock_);
+  // Empty buffers available for reuse.
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> free_buffers_ GUARDED_BY(lock_);
+  // Number of buffers allocated, including `current_`.
+  size_t allocated_buffers_ GUARDED_BY(lock_);
+  bool write_failed_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(PipelinedOutputStream);
+};
+
+}  // namespace linker
+}  // namespace art
+
+#endif  // ART_DEX2OAT_LINKER_PIPELINED_OUTPUT_STREAM_H_
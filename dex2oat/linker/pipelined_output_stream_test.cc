@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipelined_output_stream.h"
+
+#include "base/unix_file/fd_file.h"
+#include "common_runtime_test.h"
+#include "stream/file_output_stream.h"
+#include "stream/vector_output_stream.h"
+
+namespace art {
+namespace linker {
+
+class PipelinedOutputStreamTest : public CommonRuntimeTest {
+ protected:
+  // Apply the same writes and seeks to `out` and to a reference vector stream.
+  void WriteTestData(OutputStream* out, std::vector<uint8_t>* expected) {
+    VectorOutputStream reference("reference", expected);
+    auto write = [&](size_t size, uint8_t seed) {
+      std::vector<uint8_t> data(size);
+      for (size_t i = 0; i != size; ++i) {
+        data[i] = static_cast<uint8_t>(seed + i * 7u);
+      }
+      EXPECT_TRUE(out->WriteFully(data.data(), data.size()));
+      EXPECT_TRUE(reference.WriteFully(data.data(), data.size()));
+      EXPECT_EQ(reference.Seek(0, kSeekCurrent), out->Seek(0, kSeekCurrent));
+    };
+    auto seek = [&](off_t offset, Whence whence) {
+      EXPECT_EQ(reference.Seek(offset, whence), out->Seek(offset, whence));
+    };
+
+    write(1u, 1u);
+    write(kBufferSize - 1u, 2u);
+    write(kBufferSize * 5u + 3u, 3u);  // Spans several buffers.
+    seek(17, kSeekCurrent);  // Leaves a hole.
+    write(5u, 4u);
+    seek(8, kSeekSet);  // Overwrites data that may still be in flight.
+    write(kBufferSize + 1u, 5u);
+    seek(0, kSeekEnd);
+    write(kBufferSize / 2u, 6u);
+    EXPECT_TRUE(out->Flush());
+  }
+
+  static constexpr size_t kBufferSize = 64u;
+};
+
+TEST_F(PipelinedOutputStreamTest, WriteAndSeek) {
+  for (size_t max_buffers : {1u, 2u, 4u}) {
+    ScratchFile tmp;
+    std::vector<uint8_t> expected;
+    {
+      PipelinedOutputStream out(
+          std::make_unique<FileOutputStream>(tmp.GetFile()), kBufferSize, max_buffers);
+      WriteTestData(&out, &expected);
+    }
+    std::vector<uint8_t> actual(expected.size());
+    ASSERT_EQ(static_cast<int64_t>(expected.size()), tmp.GetFile()->GetLength());
+    ASSERT_TRUE(tmp.GetFile()->PreadFully(actual.data(), actual.size(), 0));
+    EXPECT_EQ(expected, actual) << max_buffers;
+  }
+}
+
+TEST_F(PipelinedOutputStreamTest, WritesEverythingOnDestruction) {
+  ScratchFile tmp;
+  std::vector<uint8_t> data(kBufferSize * 3u + 1u, 0x5a);
+  {
+    PipelinedOutputStream out(std::make_unique<FileOutputStream>(tmp.GetFile()), kBufferSize);
+    ASSERT_TRUE(out.WriteFully(data.data(), data.size()));
+  }
+  EXPECT_EQ(static_cast<int64_t>(data.size()), tmp.GetFile()->GetLength());
+}
+
+}  // namespace linker
+}  // namespace art
@@ -517,6 +517,46 @@ TEST_F(VerifierDepsTest, EncodeDecodeMulti) {
   decoded_deps.Dump(&os);
 }
 
+TEST_F(VerifierDepsTest, CanonicalExtraStrings) {
+  ScopedObjectAccess soa(Thread::Current());
+  LoadDexFile(soa);
+
+  // Record the same dependency with extra strings assigned in two different orders,
+  // as happens when several verifier threads see the strings in different orders.
+  const uint32_t num_ids_in_dex = primary_dex_file_->NumStringIds();
+  const dex::StringIndex first_extra_id(num_ids_in_dex);
+  const dex::StringIndex second_extra_id(num_ids_in_dex + 1u);
+  VerifierDeps deps1(dex_files_);
+  VerifierDeps::DexFileDeps* dex_deps1 = deps1.GetDexFileDeps(*primary_dex_file_);
+  dex_deps1->strings_ = {"LZeta;", "LAlpha;"};
+  dex_deps1->assignable_types_[0].emplace(first_extra_id, second_extra_id);
+  VerifierDeps deps2(dex_files_);
+  VerifierDeps::DexFileDeps* dex_deps2 = deps2.GetDexFileDeps(*primary_dex_file_);
+  dex_deps2->strings_ = {"LAlpha;", "LZeta;"};
+  dex_deps2->assignable_types_[0].emplace(second_extra_id, first_extra_id);
+
+  std::vector<uint8_t> buffer1;
+  deps1.Encode(dex_files_, &buffer1);
+  std::vector<uint8_t> buffer2;
+  deps2.Encode(dex_files_, &buffer2);
+  ASSERT_NE(buffer1, buffer2);
+
+  deps1.Canonicalize();
+  deps2.Canonicalize();
+  ASSERT_TRUE(deps1.Equals(deps2));
+  buffer1.clear();
+  deps1.Encode(dex_files_, &buffer1);
+  buffer2.clear();
+  deps2.Encode(dex_files_, &buffer2);
+  ASSERT_EQ(buffer1, buffer2);
+
+  // The dependency still refers to the same strings after renumbering.
+  ASSERT_EQ(1u, dex_deps1->assignable_types_[0].size());
+  const VerifierDeps::TypeAssignability& entry = *dex_deps1->assignable_types_[0].begin();
+  ASSERT_EQ("LZeta;", deps1.GetStringFromId(*primary_dex_file_, entry.GetDestination()));
+  ASSERT_EQ("LAlpha;", deps1.GetStringFromId(*primary_dex_file_, entry.GetSource()));
+}
+
 TEST_F(VerifierDepsTest, UnverifiedClasses) {
   VerifyDexFile();
   ASSERT_FALSE(HasUnverifiedClass("LMyThread;"));
@@ -1117,11 +1117,13 @@ class ImgDiagDumper {
   explicit ImgDiagDumper(std::ostream* os,
                          pid_t image_diff_pid,
                          pid_t zygote_diff_pid,
-                         bool dump_dirty_objects)
+                         bool dump_dirty_objects,
+                         bool dump_oat_code_residency)
       : os_(os),
         image_diff_pid_(image_diff_pid),
         zygote_diff_pid_(zygote_diff_pid),
         dump_dirty_objects_(dump_dirty_objects),
+        dump_oat_code_residency_(dump_oat_code_residency),
         zygote_pid_only_(false) {}
 
   bool Init() {
@@ -1307,6 +1309,67 @@ class ImgDiagDumper {
     return ret;
   }
 
+  // Count the pages of the compiled code of `oat_file` that are resident in the image diff
+  // process, e.g. to compare code layouts by how many pages startup has touched.
+  bool DumpOatCodeResidency(const OatFile& oat_file) {
+    std::ostream& os = *os_;
+    if (!dump_oat_code_residency_ || image_diff_pid_ < 0) {
+      return true;
+    }
+    os << "OAT CODE RESIDENCY: " << oat_file.GetLocation() << "\n";
+    const uint8_t* code_begin = oat_file.Begin() + oat_file.GetOatHeader().GetExecutableOffset();
+    const size_t code_size = RoundUp(static_cast<size_t>(oat_file.End() - code_begin), kPageSize);
+    if (code_size == 0u) {
+      os << "  no compiled code\n\n";
+      return true;
+    }
+
+    // The oat file is mapped at a different address in the image diff process. Find its
+    // executable mapping there, which starts with the compiled code.
+    std::string oat_base_name = "/" + BaseName(oat_file.GetLocation());
+    std::optional<backtrace_map_t> code_map;
+    for (const backtrace_map_t* map : *image_proc_maps_) {
+      if ((map->flags & PROT_EXEC) != 0 && EndsWith(map->name, oat_base_name)) {
+        code_map = *map;
+        break;
+      }
+    }
+    if (code_map == std::nullopt) {
+      os << "Could not find the executable map for " << oat_file.GetLocation() << "\n";
+      return false;
+    }
+    const size_t begin_page = code_map->start / kPageSize;
+    const size_t end_page = std::min(code_map->start + code_size, code_map->end) / kPageSize;
+
+    std::vector<uint64_t> page_map_entries(end_page - begin_page);
+    if (!image_pagemap_file_.PreadFully(page_map_entries.data(),
+                                        page_map_entries.size() * kPageMapEntrySize,
+                                        begin_page * kPageMapEntrySize)) {
+      os << "Failed to read the page map entries from " << image_pagemap_file_.GetPath()
+         << ", error: " << strerror(errno) << "\n";
+      return false;
+    }
+    size_t resident_pages = 0u;
+    size_t resident_runs = 0u;
+    bool previous_resident = false;
+    for (uint64_t entry : page_map_entries) {
+      bool resident = (entry & kPageMapPresentMask) != 0u;
+      if (resident) {
+        ++resident_pages;
+        if (!previous_resident) {
+          ++resident_runs;
+        }
+      }
+      previous_resident = resident;
+    }
+    os << "  code pages: " << page_map_entries.size() << "\n";
+    os << "  resident pages: " << resident_pages << " ("
+       << StringPrintf("%.2f", 100.0 * resident_pages / page_map_entries.size()) << "%)\n";
+    os << "  resident page runs: " << resident_runs << "\n\n";
+    os << std::flush;
+    return true;
+  }
+
  private:
   bool DumpImageDiff(const ImageHeader& image_header, const std::string& image_location)
       REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -1787,6 +1850,8 @@ class ImgDiagDumper {
   static constexpr size_t kPageMapEntrySize = sizeof(uint64_t);
   // bits 0-54 [in /proc/$pid/pagemap]
   static constexpr uint64_t kPageFrameNumberMask = (1ULL << 55) - 1;
+  // bit 63 [in /proc/$pid/pagemap]
+  static constexpr uint64_t kPageMapPresentMask = (1ULL << 63);
 
   static constexpr size_t kPageFlagsEntrySize = sizeof(uint64_t);
   static constexpr size_t kPageCountEntrySize = sizeof(uint64_t);
@@ -1799,6 +1864,7 @@ class ImgDiagDumper {
   pid_t image_diff_pid_;  // Dump image diff against boot.art if pid is non-negative
   pid_t zygote_diff_pid_;  // Dump image diff against zygote boot.art if pid is non-negative
   bool dump_dirty_objects_;  // Adds dumping of objects that are dirty.
+  bool dump_oat_code_residency_;  // Adds dumping of the resident pages of the boot oat code.
   bool zygote_pid_only_;  // The user only specified a pid for the zygote.
 
   // BacktraceMap used for finding the memory mapping of the image file.
@@ -1829,7 +1895,8 @@ static int DumpImage(Runtime* runtime,
                      std::ostream* os,
                      pid_t image_diff_pid,
                      pid_t zygote_diff_pid,
-                     bool dump_dirty_objects) {
+                     bool dump_dirty_objects,
+                     bool dump_oat_code_residency) {
   ScopedObjectAccess soa(Thread::Current());
   gc::Heap* heap = runtime->GetHeap();
   const std::vector<gc::space::ImageSpace*>& image_spaces = heap->GetBootImageSpaces();
@@ -1837,7 +1904,8 @@ static int DumpImage(Runtime* runtime,
   ImgDiagDumper img_diag_dumper(os,
                                 image_diff_pid,
                                 zygote_diff_pid,
-                                dump_dirty_objects);
+                                dump_dirty_objects,
+                                dump_oat_code_residency);
   if (!img_diag_dumper.Init()) {
     return EXIT_FAILURE;
   }
@@ -1852,6 +1920,11 @@ static int DumpImage(Runtime* runtime,
       return EXIT_FAILURE;
     }
   }
+  for (gc::space::ImageSpace* image_space : image_spaces) {
+    if (!img_diag_dumper.DumpOatCodeResidency(*image_space->GetOatFile())) {
+      return EXIT_FAILURE;
+    }
+  }
   return EXIT_SUCCESS;
 }
 
@@ -1887,6 +1960,8 @@ struct ImgDiagArgs : public CmdlineArgs {
       }
     } else if (option == "--dump-dirty-objects") {
       dump_dirty_objects_ = true;
+    } else if (option == "--dump-oat-code-residency") {
+      dump_oat_code_residency_ = true;
     } else {
       return kParseUnknownArgument;
     }
@@ -1940,6 +2015,8 @@ struct ImgDiagArgs : public CmdlineArgs {
         "against.\n"
         "      Example: --zygote-diff-pid=$(pid zygote)\n"
         "  --dump-dirty-objects: additionally output dirty objects of interest.\n"
+        "  --dump-oat-code-residency: additionally output how many pages of the boot image\n"
+        "      compiled code are resident in the --image-diff-pid process.\n"
         "\n";
 
     return usage;
@@ -1949,6 +2026,7 @@ struct ImgDiagArgs : public CmdlineArgs {
   pid_t image_diff_pid_ = -1;
   pid_t zygote_diff_pid_ = -1;
   bool dump_dirty_objects_ = false;
+  bool dump_oat_code_residency_ = false;
 };
 
 struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
@@ -1959,7 +2037,8 @@ struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
                      args_->os_,
                      args_->image_diff_pid_,
                      args_->zygote_diff_pid_,
-                     args_->dump_dirty_objects_) == EXIT_SUCCESS;
+                     args_->dump_dirty_objects_,
+                     args_->dump_oat_code_residency_) == EXIT_SUCCESS;
   }
 };
 
@@ -214,6 +214,7 @@ class Arena {
   uint8_t* memory_;
   size_t size_;
   Arena* next_;
+  friend class CachingArenaPool;
   friend class MallocArenaPool;
   friend class MemMapArenaPool;
   friend class ArenaAllocator;
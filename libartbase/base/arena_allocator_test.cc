@@ -17,6 +17,7 @@
 #include "arena_allocator-inl.h"
 #include "arena_bit_vector.h"
 #include "base/common_art_test.h"
+#include "caching_arena_pool.h"
 #include "gtest/gtest.h"
 #include "malloc_arena_pool.h"
 #include "memory_tool.h"
@@ -349,5 +350,47 @@ TEST_F(ArenaAllocatorTest, ReallocAlignment) {
   }
 }
 
+TEST_F(ArenaAllocatorTest, CachingArenaPool) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    // Arenas are not reused when tracking.
+    return;
+  }
+  constexpr size_t kArenaSize = arena_allocator::kArenaDefaultSize;
+  MallocArenaPool backing_pool;
+  CachingArenaPool pool(&backing_pool);
+  {
+    // A large use needing two arenas.
+    ArenaAllocator allocator(&pool);
+    allocator.Alloc(kArenaSize * 3 / 4);
+    allocator.Alloc(kArenaSize * 3 / 4);
+    ASSERT_EQ(2u, NumberOfArenas(&allocator));
+  }
+  EXPECT_EQ(0u, pool.GetNumReusedArenas());
+  EXPECT_EQ(2u, pool.GetNumBackingArenas());
+  EXPECT_EQ(2u * kArenaSize, pool.GetCachedBytes());
+
+  // Small uses are served from the cache. The end of the first trim interval keeps
+  // the high-water mark of the interval, i.e. both arenas.
+  for (size_t i = 1u; i != CachingArenaPool::kTrimInterval; ++i) {
+    ArenaAllocator allocator(&pool);
+    allocator.Alloc(16u);
+  }
+  EXPECT_EQ(CachingArenaPool::kTrimInterval - 1u, pool.GetNumReusedArenas());
+  EXPECT_EQ(2u, pool.GetNumBackingArenas());
+  EXPECT_EQ(2u * kArenaSize, pool.GetCachedBytes());
+  EXPECT_EQ(0u, pool.GetTrimmedBytes());
+
+  // An interval of small uses only trims the cache down to one arena.
+  for (size_t i = 0u; i != CachingArenaPool::kTrimInterval; ++i) {
+    ArenaAllocator allocator(&pool);
+    allocator.Alloc(16u);
+  }
+  EXPECT_EQ(2u, pool.GetNumBackingArenas());
+  EXPECT_EQ(kArenaSize, pool.GetCachedBytes());
+  EXPECT_EQ(kArenaSize, pool.GetTrimmedBytes());
+
+  pool.ReclaimMemory();
+  EXPECT_EQ(0u, pool.GetCachedBytes());
+}
 
 }  // namespace art
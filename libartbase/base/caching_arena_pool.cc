@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caching_arena_pool.h"
+
+#include <algorithm>
+
+#include "arena_allocator-inl.h"
+#include "memory_tool.h"
+
+namespace art {
+
+CachingArenaPool::CachingArenaPool(ArenaPool* backing_pool)
+    : backing_pool_(backing_pool),
+      free_arenas_(nullptr),
+      cached_bytes_(0u),
+      used_bytes_(0u),
+      peak_used_bytes_(0u),
+      high_water_mark_(0u),
+      num_uses_(0u),
+      num_reused_arenas_(0u),
+      num_backing_arenas_(0u),
+      trimmed_bytes_(0u) {
+  DCHECK(backing_pool_ != nullptr);
+}
+
+CachingArenaPool::~CachingArenaPool() {
+  DCHECK_EQ(used_bytes_, 0u);
+  ReclaimMemory();
+}
+
+Arena* CachingArenaPool::AllocArena(size_t size) {
+  Arena* ret = nullptr;
+  for (Arena** link = &free_arenas_; *link != nullptr; link = &(*link)->next_) {
+    if ((*link)->Size() >= size) {
+      ret = *link;
+      *link = ret->next_;
+      break;
+    }
+  }
+  if (ret != nullptr) {
+    DCHECK_GE(cached_bytes_, ret->Size());
+    cached_bytes_ -= ret->Size();
+    ret->Reset();
+    ++num_reused_arenas_;
+  } else {
+    ret = backing_pool_->AllocArena(size);
+    ++num_backing_arenas_;
+  }
+  ret->next_ = nullptr;
+  used_bytes_ += ret->Size();
+  peak_used_bytes_ = std::max(peak_used_bytes_, used_bytes_);
+  return ret;
+}
+
+void CachingArenaPool::FreeArenaChain(Arena* first) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    // Do not reuse arenas when tracking.
+    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+      DCHECK_GE(used_bytes_, arena->Size());
+      used_bytes_ -= arena->Size();
+    }
+    backing_pool_->FreeArenaChain(first);
+  } else {
+    while (first != nullptr) {
+      Arena* arena = first;
+      first = first->next_;
+      if (kRunningOnMemoryTool) {
+        MEMORY_TOOL_MAKE_UNDEFINED(arena->memory_, arena->bytes_allocated_);
+      }
+      DCHECK_GE(used_bytes_, arena->Size());
+      used_bytes_ -= arena->Size();
+      cached_bytes_ += arena->Size();
+      arena->next_ = free_arenas_;
+      free_arenas_ = arena;
+    }
+  }
+  if (used_bytes_ == 0u) {
+    EndUse();
+  }
+}
+
+void CachingArenaPool::EndUse() {
+  high_water_mark_ = std::max(high_water_mark_, peak_used_bytes_);
+  peak_used_bytes_ = 0u;
+  ++num_uses_;
+  if (num_uses_ % kTrimInterval == 0u) {
+    Trim(high_water_mark_);
+    high_water_mark_ = 0u;
+  }
+}
+
+void CachingArenaPool::Trim(size_t limit) {
+  // Keep the most recently freed arenas up to `limit` bytes.
+  size_t kept_bytes = 0u;
+  Arena** link = &free_arenas_;
+  while (*link != nullptr && kept_bytes + (*link)->Size() <= limit) {
+    kept_bytes += (*link)->Size();
+    link = &(*link)->next_;
+  }
+  Arena* excess = *link;
+  *link = nullptr;
+  if (excess != nullptr) {
+    DCHECK_GE(cached_bytes_, kept_bytes);
+    trimmed_bytes_ += cached_bytes_ - kept_bytes;
+    cached_bytes_ = kept_bytes;
+    backing_pool_->FreeArenaChain(excess);
+  }
+}
+
+size_t CachingArenaPool::GetBytesAllocated() const {
+  size_t total = 0;
+  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+    total += arena->GetBytesAllocated();
+  }
+  return total;
+}
+
+void CachingArenaPool::ReclaimMemory() {
+  if (free_arenas_ != nullptr) {
+    backing_pool_->FreeArenaChain(free_arenas_);
+    free_arenas_ = nullptr;
+    cached_bytes_ = 0u;
+  }
+}
+
+void CachingArenaPool::LockReclaimMemory() {
+  ReclaimMemory();
+}
+
+void CachingArenaPool::TrimMaps() {
+  backing_pool_->TrimMaps();
+}
+
+}  // namespace art
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_LIBARTBASE_BASE_CACHING_ARENA_POOL_H_
+#define ART_LIBARTBASE_BASE_CACHING_ARENA_POOL_H_
+
+#include "arena_allocator.h"
+
+namespace art {
+
+// An ArenaPool that keeps the arenas freed by its (single) user for the next allocations,
+// in front of a shared backing pool. This avoids taking the lock of the backing pool and
+// keeps the pages of the arenas warm across many short uses, such as the compilation of
+// successive methods by one compiler thread.
+//
+// A use ends when all the arenas handed out have been freed. The cached memory is trimmed
+// to the high-water mark of the last kTrimInterval uses, so that one very large use does
+// not pin its memory for the rest of the compilation.
+//
+// This class is not thread-safe; each thread must have its own CachingArenaPool.
+class CachingArenaPool final : public ArenaPool {
+ public:
+  static constexpr size_t kTrimInterval = 16u;
+
+  explicit CachingArenaPool(ArenaPool* backing_pool);
+  ~CachingArenaPool();
+
+  Arena* AllocArena(size_t size) override;
+  void FreeArenaChain(Arena* first) override;
+  size_t GetBytesAllocated() const override;
+  // Returns all the cached arenas to the backing pool.
+  void ReclaimMemory() override;
+  void LockReclaimMemory() override;
+  void TrimMaps() override;
+
+  size_t GetCachedBytes() const {
+    return cached_bytes_;
+  }
+
+  // Number of arena allocations served from the cache.
+  size_t GetNumReusedArenas() const {
+    return num_reused_arenas_;
+  }
+
+  // Number of arena allocations forwarded to the backing pool.
+  size_t GetNumBackingArenas() const {
+    return num_backing_arenas_;
+  }
+
+  // Number of bytes returned to the backing pool when trimming.
+  size_t GetTrimmedBytes() const {
+    return trimmed_bytes_;
+  }
+
+ private:
+  void EndUse();
+  void Trim(size_t limit);
+
+  ArenaPool* const backing_pool_;
+  Arena* free_arenas_;
+  size_t cached_bytes_;
+  // Bytes of the arenas currently handed out, and their peak in the current use.
+  size_t used_bytes_;
+  size_t peak_used_bytes_;
+  // Largest peak in the current trim interval.
+  size_t high_water_mark_;
+  size_t num_uses_;
+
+  size_t num_reused_arenas_;
+  size_t num_backing_arenas_;
+  size_t trimmed_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(CachingArenaPool);
+};
+
+}  // namespace art
+
+#endif  // ART_LIBARTBASE_BASE_CACHING_ARENA_POOL_H_
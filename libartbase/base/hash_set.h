@@ -664,6 +664,11 @@ class HashSet {
     return num_buckets_;
   }
 
+  // The bucket storage. It stays in place until the set is resized or destroyed.
+  const T* Data() const {
+    return data_;
+  }
+
  private:
   T& ElementForIndex(size_t index) {
     DCHECK_LT(index, NumBuckets());
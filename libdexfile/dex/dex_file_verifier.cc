@@ -16,6 +16,9 @@
 
 #include "dex_file_verifier.h"
 
+#include <pthread.h>
+#include <string.h>
+
 #include <algorithm>
 #include <bitset>
 #include <limits>
@@ -25,6 +28,7 @@
 #include "android-base/macros.h"
 #include "android-base/stringprintf.h"
 
+#include "base/globals.h"
 #include "base/hash_map.h"
 #include "base/leb128.h"
 #include "base/safe_map.h"
@@ -46,6 +50,47 @@ namespace {
 
 constexpr uint32_t kTypeIdLimit = std::numeric_limits<uint16_t>::max();
 
+// Dex files at least this large have their checksum computed on a separate thread while their
+// structure is checked.
+constexpr size_t kMinParallelChecksumSize = 1 * MB;
+
+// Computes the checksum of a dex file on a separate thread.
+class ChecksumThread {
+ public:
+  explicit ChecksumThread(const DexFile* dex_file) : dex_file_(dex_file), checksum_(0u) {}
+
+  // Returns false if the thread could not be created.
+  bool Start() {
+    return pthread_create(&thread_, nullptr, &Run, this) == 0;
+  }
+
+  uint32_t Join() {
+    int rc = pthread_join(thread_, nullptr);
+    CHECK_EQ(rc, 0) << strerror(rc);
+    return checksum_;
+  }
+
+ private:
+  static void* Run(void* arg) {
+    ChecksumThread* self = reinterpret_cast<ChecksumThread*>(arg);
+    self->checksum_ = self->dex_file_->CalculateChecksum();
+    return nullptr;
+  }
+
+  const DexFile* const dex_file_;
+  uint32_t checksum_;
+  pthread_t thread_;
+};
+
+// Returns whether all 8 bytes of `word` are in the range [0x01, 0x7f].
+constexpr bool IsNonZeroAscii(uint64_t word) {
+  constexpr uint64_t kOnes = UINT64_C(0x0101010101010101);
+  constexpr uint64_t kHighBits = UINT64_C(0x8080808080808080);
+  // Bytes of at least 0x80 have their high bit set in `word`. The lowest zero byte, if any,
+  // becomes 0xff in `word - kOnes` as no lower byte borrows.
+  return (((word - kOnes) | word) & kHighBits) == 0u;
+}
+
 constexpr bool IsValidOrNoTypeId(uint16_t low, uint16_t high) {
   return (high == 0) || ((high == 0xffffU) && (low == 0xffffU));
 }
@@ -241,8 +286,12 @@ class DexFileVerifier {
     return true;
   }
 
+  bool CheckFileSize();
+  bool CheckChecksum(uint32_t adler_checksum);
   bool CheckHeader();
   bool CheckMap();
+  // Checks the header and all sections, everything but the file size and the checksum.
+  bool CheckStructure();
 
   uint32_t ReadUnsignedLittleEndian(uint32_t size) {
     uint32_t result = 0;
@@ -569,16 +618,18 @@ bool DexFileVerifier::CheckValidOffsetAndSize(uint32_t offset,
   return true;
 }
 
-bool DexFileVerifier::CheckHeader() {
+bool DexFileVerifier::CheckFileSize() {
   // Check file size from the header.
   uint32_t expected_size = header_->file_size_;
   if (size_ != expected_size) {
     ErrorStringPrintf("Bad file size (%zd, expected %u)", size_, expected_size);
     return false;
   }
+  return true;
+}
 
-  uint32_t adler_checksum = dex_file_->CalculateChecksum();
-  // Compute and verify the checksum in the header.
+bool DexFileVerifier::CheckChecksum(uint32_t adler_checksum) {
+  // Verify the checksum in the header.
   if (adler_checksum != header_->checksum_) {
     if (verify_checksum_) {
       ErrorStringPrintf("Bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
@@ -588,7 +639,10 @@ bool DexFileVerifier::CheckHeader() {
           "Ignoring bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
     }
   }
+  return true;
+}
 
+bool DexFileVerifier::CheckHeader() {
   // Check the contents of the header.
   if (header_->endian_tag_ != DexFile::kDexEndianConstant) {
     ErrorStringPrintf("Unexpected endian_tag: %x", header_->endian_tag_);
@@ -1648,6 +1702,18 @@ bool DexFileVerifier::CheckIntraStringDataItem() {
       return false;
     }
 
+    // Skip over runs of plain ASCII a word at a time.
+    if (size - i >= sizeof(uint64_t) &&
+        static_cast<size_t>(file_end - ptr_) >= sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, ptr_, sizeof(word));
+      if (IsNonZeroAscii(word)) {
+        ptr_ += sizeof(uint64_t);
+        i += sizeof(uint64_t) - 1u;
+        continue;
+      }
+    }
+
     uint8_t byte = *(ptr_++);
 
     // Switch on the high 4 bits.
@@ -3298,6 +3364,26 @@ bool DexFileVerifier::CheckInterSection() {
 }
 
 bool DexFileVerifier::Verify() {
+  if (!CheckFileSize()) {
+    return false;
+  }
+
+  ChecksumThread checksum_thread(dex_file_);
+  if (size_ >= kMinParallelChecksumSize && checksum_thread.Start()) {
+    bool structure_ok = CheckStructure();
+    uint32_t adler_checksum = checksum_thread.Join();
+    // Report a bad checksum rather than the structural errors it likely caused, the same as
+    // when the checksum is checked first.
+    if (adler_checksum != header_->checksum_ && verify_checksum_) {
+      failure_reason_.clear();
+    }
+    return CheckChecksum(adler_checksum) && structure_ok;
+  }
+
+  return CheckChecksum(dex_file_->CalculateChecksum()) && CheckStructure();
+}
+
+bool DexFileVerifier::CheckStructure() {
   // Check the header.
   if (!CheckHeader()) {
     return false;
@@ -18,12 +18,16 @@
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include <android-base/logging.h>
 
 #include "base/bit_utils.h"
+#include "base/globals.h"
 #include "base/leb128.h"
 #include "base/macros.h"
 #include "base64_test_util.h"
@@ -181,6 +185,31 @@ TEST_F(DexFileVerifierTest, MethodId) {
       "Bad index for method_id.name");
 }
 
+// Bad bytes must be found at any position of a string, including within the runs of
+// ASCII that the verifier checks a word at a time.
+TEST_F(DexFileVerifierTest, StringDataBadByte) {
+  static constexpr std::string_view kString = "Ljava/io/PrintStream;";
+  auto set_byte = [](DexFile* dex_file, size_t index, uint8_t value) {
+    uint8_t* begin = const_cast<uint8_t*>(dex_file->Begin());
+    uint8_t* end = begin + dex_file->Size();
+    uint8_t* data = std::search(begin, end, kString.begin(), kString.end());
+    CHECK(data != end);
+    data[index] = value;
+  };
+  for (size_t i = 0; i != kString.size(); ++i) {
+    VerifyModification(
+        kGoodTestDex,
+        "string_data_bad_start_byte",
+        [&](DexFile* dex_file) { set_byte(dex_file, i, 0x80u); },
+        "Illegal start byte 80 in string data");
+    VerifyModification(
+        kGoodTestDex,
+        "string_data_zero_byte",
+        [&](DexFile* dex_file) { set_byte(dex_file, i, 0u); },
+        "String data shorter than indicated");
+  }
+}
+
 TEST_F(DexFileVerifierTest, InitCachingWithUnicode) {
   static const char kInitWithUnicode[] =
       "ZGV4CjAzNQDhN60rgMnSK13MoRscTuD+NZe7f6rIkHAAAgAAcAAAAHhWNBIAAAAAAAAAAGwBAAAJ"
@@ -2172,4 +2201,50 @@ TEST_F(DexFileVerifierTest, GoodStaticFieldInitialValuesArray) {
                           &error_msg));
 }
 
+// Dex files of at least 1MiB have their checksum computed while their structure is checked.
+// A bad checksum must still be reported instead of the structural errors it likely caused.
+TEST_F(DexFileVerifierTest, LargeDexChecksum) {
+  size_t length;
+  std::unique_ptr<uint8_t[]> good_bytes(DecodeBase64(kGoodTestDex, &length));
+  ASSERT_TRUE(good_bytes != nullptr);
+  static constexpr size_t kLargeSize = 1 * MB + 4 * KB;
+  std::vector<uint8_t> large_bytes(kLargeSize, 0u);
+  memcpy(large_bytes.data(), good_bytes.get(), length);
+  // Extend the data section, which ends the file, with zeros.
+  DexFile::Header* header = reinterpret_cast<DexFile::Header*>(large_bytes.data());
+  ASSERT_EQ(length, header->data_off_ + header->data_size_);
+  header->data_size_ += kLargeSize - length;
+  header->file_size_ = kLargeSize;
+  FixUpChecksum(large_bytes.data());
+
+  auto verify = [&](std::string* error_msg) {
+    std::unique_ptr<DexFile> dex_file(GetDexFile(large_bytes.data(), large_bytes.size()));
+    return dex::Verify(dex_file.get(),
+                       dex_file->Begin(),
+                       dex_file->Size(),
+                       kLocationString,
+                       /*verify_checksum=*/ true,
+                       error_msg);
+  };
+
+  std::string error_msg;
+  EXPECT_TRUE(verify(&error_msg)) << error_msg;
+
+  // A structural error alone is reported.
+  dex::MethodId* method_id =
+      reinterpret_cast<dex::MethodId*>(large_bytes.data() + header->method_ids_off_);
+  method_id->class_idx_ = dex::TypeIndex(0xFF);
+  FixUpChecksum(large_bytes.data());
+  error_msg.clear();
+  EXPECT_FALSE(verify(&error_msg));
+  EXPECT_NE(error_msg.find("Bad index for method_id.class"), std::string::npos) << error_msg;
+
+  // With a bad checksum as well, only the checksum is reported.
+  header->checksum_ ^= 1u;
+  error_msg.clear();
+  EXPECT_FALSE(verify(&error_msg));
+  EXPECT_NE(error_msg.find("Bad checksum"), std::string::npos) << error_msg;
+  EXPECT_EQ(error_msg.find("method_id"), std::string::npos) << error_msg;
+}
+
 }  // namespace art
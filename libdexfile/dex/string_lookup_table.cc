@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "string_lookup_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "base/bit_utils.h"
+#include "dex/dex_file-inl.h"
+
+namespace art {
+
+// The average number of strings per bucket is between kStringsPerBucket / 2 and
+// kStringsPerBucket. More strings per bucket make the table smaller but slower to create.
+static constexpr uint32_t kStringsPerBucket = 4u;
+
+// Keeps the raw data length within 32 bits.
+static constexpr uint32_t kMaxStringIds = 1u << 24;
+
+// The number of seeds to try for one bucket before giving up on the table. Only strings
+// with the same hash cannot be separated by some seed.
+static constexpr uint32_t kMaxSeedAttempts = 1u << 24;
+
+// Mixes the bits of `value`, using the finalizer of MurmurHash3.
+static inline uint64_t Mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= UINT64_C(0xff51afd7ed558ccd);
+  value ^= value >> 33;
+  value *= UINT64_C(0xc4ceb9fe1a85ec53);
+  value ^= value >> 33;
+  return value;
+}
+
+uint64_t StringLookupTable::ComputeHash(const char* str) {
+  // FNV-1a over the MUTF-8 bytes. Equal strings have equal bytes.
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  for (const uint8_t* ptr = reinterpret_cast<const uint8_t*>(str); *ptr != 0u; ++ptr) {
+    hash = (hash ^ *ptr) * UINT64_C(0x100000001b3);
+  }
+  return Mix(hash);
+}
+
+StringLookupTable StringLookupTable::Create(const DexFile& dex_file) {
+  const uint32_t num_string_ids = dex_file.NumStringIds();
+  if (UNLIKELY(!SupportedSize(num_string_ids))) {
+    return StringLookupTable();
+  }
+  const uint32_t num_buckets = CalculateNumBuckets(num_string_ids);
+  const uint32_t bucket_mask = num_buckets - 1u;
+
+  // Group the string indexes by bucket.
+  std::vector<uint64_t> hashes(num_string_ids);
+  std::vector<uint32_t> bucket_starts(num_buckets + 1u, 0u);
+  for (uint32_t i = 0; i != num_string_ids; ++i) {
+    hashes[i] = ComputeHash(dex_file.StringDataByIdx(dex::StringIndex(i)));
+    ++bucket_starts[(hashes[i] & bucket_mask) + 1u];
+  }
+  std::partial_sum(bucket_starts.begin(), bucket_starts.end(), bucket_starts.begin());
+  std::vector<uint32_t> bucket_strings(num_string_ids);
+  std::vector<uint32_t> bucket_ends(bucket_starts.begin(), bucket_starts.end() - 1);
+  for (uint32_t i = 0; i != num_string_ids; ++i) {
+    bucket_strings[bucket_ends[hashes[i] & bucket_mask]++] = i;
+  }
+  auto bucket_size = [&](uint32_t bucket) {
+    return bucket_starts[bucket + 1u] - bucket_starts[bucket];
+  };
+
+  // Place the largest buckets first, while most slots are still free. The sort is stable to
+  // keep the output deterministic.
+  std::vector<uint32_t> buckets(num_buckets);
+  std::iota(buckets.begin(), buckets.end(), 0u);
+  std::stable_sort(buckets.begin(),
+                   buckets.end(),
+                   [&](uint32_t lhs, uint32_t rhs) { return bucket_size(lhs) > bucket_size(rhs); });
+
+  std::unique_ptr<uint32_t[]> owned_data(new uint32_t[num_buckets + num_string_ids]);
+  uint32_t* data = owned_data.get();
+  uint32_t* seeds = data;
+  uint32_t* slots = data + num_buckets;
+  std::fill_n(seeds, num_buckets, 0u);
+  std::vector<bool> used_slots(num_string_ids, false);
+  std::vector<uint32_t> bucket_slots;
+  for (uint32_t bucket : buckets) {
+    const uint32_t begin = bucket_starts[bucket];
+    const uint32_t end = bucket_starts[bucket + 1u];
+    if (begin == end) {
+      break;  // All remaining buckets are empty.
+    }
+    // Find the first seed that maps all strings of the bucket to distinct free slots.
+    uint32_t seed = 0u;
+    while (true) {
+      bucket_slots.clear();
+      for (uint32_t i = begin; i != end; ++i) {
+        uint32_t slot = GetSlot(hashes[bucket_strings[i]], seed, num_string_ids);
+        if (used_slots[slot] ||
+            std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+          break;
+        }
+        bucket_slots.push_back(slot);
+      }
+      if (bucket_slots.size() == end - begin) {
+        break;
+      }
+      ++seed;
+      if (UNLIKELY(seed == kMaxSeedAttempts)) {
+        return StringLookupTable();
+      }
+    }
+    seeds[bucket] = seed;
+    for (uint32_t i = begin; i != end; ++i) {
+      uint32_t slot = bucket_slots[i - begin];
+      slots[slot] = bucket_strings[i];
+      used_slots[slot] = true;
+    }
+  }
+  DCHECK(std::all_of(used_slots.begin(), used_slots.end(), [](bool used) { return used; }));
+
+  return StringLookupTable(num_string_ids, data, std::move(owned_data));
+}
+
+StringLookupTable StringLookupTable::Open(const uint8_t* raw_data, uint32_t num_string_ids) {
+  DCHECK_ALIGNED(raw_data, alignof(uint32_t));
+  if (UNLIKELY(!SupportedSize(num_string_ids))) {
+    return StringLookupTable();
+  }
+  return StringLookupTable(num_string_ids,
+                           reinterpret_cast<const uint32_t*>(raw_data),
+                           /* owned_data= */ nullptr);
+}
+
+uint32_t StringLookupTable::Lookup(const DexFile& dex_file, const char* str) const {
+  DCHECK(Valid());
+  DCHECK_EQ(num_string_ids_, dex_file.NumStringIds());
+  uint64_t hash = ComputeHash(str);
+  uint32_t seed = GetSeeds()[hash & (num_buckets_ - 1u)];
+  uint32_t string_idx = GetSlots()[GetSlot(hash, seed, num_string_ids_)];
+  CHECK_LT(string_idx, num_string_ids_) << dex_file.GetLocation();
+  // The slot holds some string of the dex file, check that it is the one we are looking for.
+  const char* candidate = dex_file.StringDataByIdx(dex::StringIndex(string_idx));
+  return (strcmp(str, candidate) == 0) ? string_idx : dex::kDexNoIndex;
+}
+
+uint32_t StringLookupTable::RawDataLength(uint32_t num_string_ids) {
+  return SupportedSize(num_string_ids)
+      ? (CalculateNumBuckets(num_string_ids) + num_string_ids) * sizeof(uint32_t)
+      : 0u;
+}
+
+bool StringLookupTable::SupportedSize(uint32_t num_string_ids) {
+  return num_string_ids != 0u && num_string_ids <= kMaxStringIds;
+}
+
+uint32_t StringLookupTable::CalculateNumBuckets(uint32_t num_string_ids) {
+  DCHECK(SupportedSize(num_string_ids));
+  return RoundUpToPowerOfTwo((num_string_ids + kStringsPerBucket - 1u) / kStringsPerBucket);
+}
+
+uint32_t StringLookupTable::GetSlot(uint64_t hash, uint32_t seed, uint32_t num_string_ids) {
+  // Take 32 bits of the hash mixed with the seed and scale them to [0, num_string_ids).
+  uint64_t mixed = Mix(hash ^ (seed * UINT64_C(0x9e3779b97f4a7c15)));
+  return static_cast<uint32_t>(((mixed >> 32) * num_string_ids) >> 32);
+}
+
+StringLookupTable::StringLookupTable(uint32_t num_string_ids,
+                                     const uint32_t* data,
+                                     std::unique_ptr<uint32_t[]> owned_data)
+    : num_string_ids_(num_string_ids),
+      num_buckets_(CalculateNumBuckets(num_string_ids)),
+      data_(data),
+      owned_data_(std::move(owned_data)) {}
+
+}  // namespace art
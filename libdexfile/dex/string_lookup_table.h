@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_LIBDEXFILE_DEX_STRING_LOOKUP_TABLE_H_
+#define ART_LIBDEXFILE_DEX_STRING_LOOKUP_TABLE_H_
+
+#include <memory>
+
+#include <android-base/logging.h>
+
+#include "dex/dex_file_types.h"
+
+namespace art {
+
+class DexFile;
+
+/**
+ * StringLookupTable is used to find the string_id index of a string quickly, instead of the
+ * binary search over all string ids done by DexFile::FindStringId().
+ *
+ * It is a minimal perfect hash table built at compile time by Create() and written into the
+ * vdex file. At runtime, the raw data is read from the memory-mapped file by Open() and the
+ * table memory remains clean.
+ *
+ * Each string hashes to one of the buckets, with about four strings per bucket, and the seed
+ * stored for that bucket maps each of its strings to a distinct slot. The slots hold string
+ * indexes, one per string in the dex file. A lookup reads one seed and one slot and compares
+ * the string found there with the one looked up.
+ */
+class StringLookupTable {
+ public:
+  // Creates the lookup table for `dex_file`. The table is invalid if the dex file has
+  // no strings, too many strings, or if no seed is found for some bucket.
+  static StringLookupTable Create(const DexFile& dex_file);
+
+  // Opens the lookup table from binary data. The table does not own `raw_data`.
+  static StringLookupTable Open(const uint8_t* raw_data, uint32_t num_string_ids);
+
+  // Create an invalid lookup table.
+  StringLookupTable()
+      : num_string_ids_(0u),
+        num_buckets_(0u),
+        data_(nullptr),
+        owned_data_(nullptr) {}
+
+  StringLookupTable(StringLookupTable&& src) noexcept = default;
+  StringLookupTable& operator=(StringLookupTable&& src) noexcept = default;
+
+  // Returns whether the StringLookupTable is valid.
+  bool Valid() const {
+    return data_ != nullptr;
+  }
+
+  // Returns the index of the string id of `str` in `dex_file`, which must be the dex file
+  // the table was created for, or dex::kDexNoIndex if there is none.
+  uint32_t Lookup(const DexFile& dex_file, const char* str) const;
+
+  // Returns pointer to binary data of lookup table. Used by the vdex writer.
+  const uint8_t* RawData() const {
+    DCHECK(Valid());
+    return reinterpret_cast<const uint8_t*>(data_);
+  }
+
+  // Returns length of binary data. Used by the vdex writer.
+  uint32_t RawDataLength() const {
+    DCHECK(Valid());
+    return RawDataLength(num_string_ids_);
+  }
+
+  // Returns length of binary data for the specified number of string ids.
+  static uint32_t RawDataLength(uint32_t num_string_ids);
+
+  // Returns the hash used by the table for `str`.
+  static uint64_t ComputeHash(const char* str);
+
+ private:
+  StringLookupTable(uint32_t num_string_ids,
+                    const uint32_t* data,
+                    std::unique_ptr<uint32_t[]> owned_data);
+
+  static bool SupportedSize(uint32_t num_string_ids);
+  static uint32_t CalculateNumBuckets(uint32_t num_string_ids);
+  static uint32_t GetSlot(uint64_t hash, uint32_t seed, uint32_t num_string_ids);
+
+  const uint32_t* GetSeeds() const {
+    return data_;
+  }
+
+  const uint32_t* GetSlots() const {
+    return data_ + num_buckets_;
+  }
+
+  uint32_t num_string_ids_;
+  uint32_t num_buckets_;
+  // The seeds for all buckets followed by the string indexes for all slots.
+  const uint32_t* data_;
+  // `owned_data_` is either null (not owning `data_`) or same pointer as `data_`.
+  std::unique_ptr<uint32_t[]> owned_data_;
+};
+
+}  // namespace art
+
+#endif  // ART_LIBDEXFILE_DEX_STRING_LOOKUP_TABLE_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "string_lookup_table.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/common_art_test.h"
+#include "dex/dex_file-inl.h"
+
+namespace art {
+
+class StringLookupTableTest : public CommonArtTest {};
+
+TEST_F(StringLookupTableTest, FindAllStrings) {
+  for (const char* name : {"Lookup", "Main", "Nested"}) {
+    std::unique_ptr<const DexFile> dex_file(OpenTestDexFile(name));
+    StringLookupTable table = StringLookupTable::Create(*dex_file);
+    ASSERT_TRUE(table.Valid()) << name;
+    ASSERT_EQ(StringLookupTable::RawDataLength(dex_file->NumStringIds()), table.RawDataLength());
+    for (uint32_t i = 0; i != dex_file->NumStringIds(); ++i) {
+      const char* str = dex_file->StringDataByIdx(dex::StringIndex(i));
+      EXPECT_EQ(i, table.Lookup(*dex_file, str)) << name << " " << str;
+    }
+  }
+}
+
+TEST_F(StringLookupTableTest, FindNonExistingString) {
+  std::unique_ptr<const DexFile> dex_file(OpenTestDexFile("Lookup"));
+  StringLookupTable table = StringLookupTable::Create(*dex_file);
+  ASSERT_TRUE(table.Valid());
+  for (const char* str : {"", "LDA;", "LAB", "Lookup", "<clinit>"}) {
+    EXPECT_EQ(dex_file->FindStringId(str) != nullptr
+                  ? dex_file->GetIndexForStringId(*dex_file->FindStringId(str)).index_
+                  : dex::kDexNoIndex,
+              table.Lookup(*dex_file, str)) << str;
+  }
+}
+
+TEST_F(StringLookupTableTest, OpenRawData) {
+  std::unique_ptr<const DexFile> dex_file(OpenTestDexFile("Nested"));
+  StringLookupTable created = StringLookupTable::Create(*dex_file);
+  ASSERT_TRUE(created.Valid());
+  std::vector<uint8_t> raw_data(created.RawData(), created.RawData() + created.RawDataLength());
+  StringLookupTable opened = StringLookupTable::Open(raw_data.data(), dex_file->NumStringIds());
+  ASSERT_TRUE(opened.Valid());
+  for (uint32_t i = 0; i != dex_file->NumStringIds(); ++i) {
+    const char* str = dex_file->StringDataByIdx(dex::StringIndex(i));
+    EXPECT_EQ(i, opened.Lookup(*dex_file, str)) << str;
+  }
+}
+
+}  // namespace art
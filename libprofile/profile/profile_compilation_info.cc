@@ -222,8 +222,12 @@ enum class ProfileCompilationInfo::FileSectionType : uint32_t {
   // an optional reserved section not implemented on client yet.
   kAggregationCounts = 4,
 
+  // Execution counts of the call sites recorded in the inline caches of hot methods.
+  // This section is optional and must come after the methods section.
+  kInvokeCounts = 5,
+
   // The number of known sections.
-  kNumberOfSections = 5
+  kNumberOfSections = 6
 };
 
 class ProfileCompilationInfo::FileSectionInfo {
@@ -879,6 +883,7 @@ static bool WriteBuffer(int fd, const void* buffer, size_t byte_count) {
  *   Classes - optional, zipped
  *   Methods - optional, zipped
  *   AggregationCounts - optional, zipped, server-side
+ *   InvokeCounts - optional, zipped
  *
  * DexFiles:
  *    number_of_dex_files
@@ -917,6 +922,12 @@ static bool WriteBuffer(int fd, const void* buffer, size_t byte_count) {
  *    type_index_diff[dex_map_size]
  * where `M` stands for special encodings indicating missing types (kIsMissingTypesEncoding)
  * or memamorphic call (kIsMegamorphicEncoding) which both imply `dex_map_size == 0`.
+ *
+ * InvokeCounts contains records for any number of dex files, each consisting of:
+ *    profile_index  // Index of the dex file in DexFiles section.
+ *    following_data_size  // For easy skipping of remaining data when dex file is filtered out.
+ *    (method_index_diff,number_of_counts,(dex_pc,invoke_count)[number_of_counts])[]
+ * where the records only reference inline caches already present in the Methods section.
  **/
 bool ProfileCompilationInfo::Save(int fd) {
   uint64_t start = NanoTime();
@@ -936,6 +947,7 @@ bool ProfileCompilationInfo::Save(int fd) {
   uint64_t dex_files_section_size = sizeof(ProfileIndexType);  // Number of dex files.
   uint64_t classes_section_size = 0u;
   uint64_t methods_section_size = 0u;
+  uint64_t invoke_counts_section_size = 0u;
   DCHECK_LE(info_.size(), MaxProfileIndex());
   for (const std::unique_ptr<DexFileData>& dex_data : info_) {
     if (dex_data->profile_key.size() > kMaxDexFileKeyLength) {
@@ -948,13 +960,15 @@ bool ProfileCompilationInfo::Save(int fd) {
         sizeof(uint16_t) + dex_data->profile_key.size();
     classes_section_size += dex_data->ClassesDataSize();
     methods_section_size += dex_data->MethodsDataSize();
+    invoke_counts_section_size += dex_data->InvokeCountsDataSize();
   }
 
   const uint32_t file_section_count =
       /* dex files */ 1u +
       /* extra descriptors */ (extra_descriptors_section_size != 0u ? 1u : 0u) +
       /* classes */ (classes_section_size != 0u ? 1u : 0u) +
-      /* methods */ (methods_section_size != 0u ? 1u : 0u);
+      /* methods */ (methods_section_size != 0u ? 1u : 0u) +
+      /* invoke counts */ (invoke_counts_section_size != 0u ? 1u : 0u);
   uint64_t header_and_infos_size =
       sizeof(FileHeader) + file_section_count * sizeof(FileSectionInfo);
 
@@ -965,7 +979,8 @@ bool ProfileCompilationInfo::Save(int fd) {
       dex_files_section_size +
       extra_descriptors_section_size +
       classes_section_size +
-      methods_section_size;
+      methods_section_size +
+      invoke_counts_section_size;
   VLOG(profiler) << "Required capacity: " << total_uncompressed_size << " bytes.";
   if (total_uncompressed_size > GetSizeErrorThresholdBytes()) {
     LOG(WARNING) << "Profile data size exceeds "
@@ -1064,6 +1079,21 @@ bool ProfileCompilationInfo::Save(int fd) {
     add_section_info(FileSectionType::kMethods, buffer.Size(), methods_section_size);
   }
 
+  // Write the invoke counts section.
+  if (invoke_counts_section_size != 0u) {
+    SafeBuffer buffer(invoke_counts_section_size);
+    for (const std::unique_ptr<DexFileData>& dex_data : info_) {
+      dex_data->WriteInvokeCounts(buffer);
+    }
+    if (!buffer.Deflate()) {
+      return false;
+    }
+    if (!WriteBuffer(fd, buffer.Get(), buffer.Size())) {
+      return false;
+    }
+    add_section_info(FileSectionType::kInvokeCounts, buffer.Size(), invoke_counts_section_size);
+  }
+
   if (file_offset > GetSizeWarningThresholdBytes()) {
     LOG(WARNING) << "Profile data size exceeds "
         << GetSizeWarningThresholdBytes()
@@ -1252,6 +1282,11 @@ bool ProfileCompilationInfo::AddMethod(const ProfileMethodInfo& pmi,
   DCHECK(inline_cache != nullptr);
 
   for (const ProfileMethodInfo::ProfileInlineCache& cache : pmi.inline_caches) {
+    // Only record counts of call sites that get an inline cache entry below.
+    if (cache.invoke_count != 0u &&
+        (cache.is_missing_types || cache.is_megamorphic || !cache.classes.empty())) {
+      FindOrAddDexPc(inline_cache, cache.dex_pc)->MergeInvokeCount(cache.invoke_count);
+    }
     if (cache.is_missing_types) {
       FindOrAddDexPc(inline_cache, cache.dex_pc)->SetIsMissingTypes();
       continue;
@@ -1676,6 +1711,41 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::ReadMethodsSec
   return ProfileLoadStatus::kSuccess;
 }
 
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::ReadInvokeCountsSection(
+    ProfileSource& source,
+    const FileSectionInfo& section_info,
+    const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+    /*out*/ std::string* error) {
+  DCHECK(section_info.GetType() == FileSectionType::kInvokeCounts);
+  SafeBuffer buffer;
+  ProfileLoadStatus status = ReadSectionData(source, section_info, &buffer, error);
+  if (status != ProfileLoadStatus::kSuccess) {
+    return status;
+  }
+
+  while (buffer.GetAvailableBytes() != 0u) {
+    ProfileIndexType profile_index;
+    if (!buffer.ReadUintAndAdvance(&profile_index)) {
+      *error = "Error profile index in invoke counts section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (profile_index >= dex_profile_index_remap.size()) {
+      *error = "Invalid profile index in invoke counts section.";
+      return ProfileLoadStatus::kBadData;
+    }
+    profile_index = dex_profile_index_remap[profile_index];
+    if (profile_index == MaxProfileIndex()) {
+      status = DexFileData::SkipInvokeCounts(buffer, error);
+    } else {
+      status = info_[profile_index]->ReadInvokeCounts(buffer, error);
+    }
+    if (status != ProfileLoadStatus::kSuccess) {
+      return status;
+    }
+  }
+  return ProfileLoadStatus::kSuccess;
+}
+
 // TODO(calin): fail fast if the dex checksums don't match.
 ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::LoadInternal(
     int32_t fd,
@@ -1800,6 +1870,12 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::LoadInternal(
       case FileSectionType::kAggregationCounts:
         // This section is only used on server side.
         break;
+      case FileSectionType::kInvokeCounts:
+        // Skip if all dex files were filtered out.
+        if (!info_.empty()) {
+          status = ReadInvokeCountsSection(*source, section_info, dex_profile_index_remap, error);
+        }
+        break;
       default:
         // Unknown section. Skip it. New versions of ART are allowed
         // to add sections that shall be ignored by old versions.
@@ -1916,6 +1992,7 @@ bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
         uint16_t other_dex_pc = other_ic_it.first;
         const ArenaSet<dex::TypeIndex>& other_class_set = other_ic_it.second.classes;
         DexPcData* dex_pc_data = FindOrAddDexPc(inline_cache, other_dex_pc);
+        dex_pc_data->MergeInvokeCount(other_ic_it.second.invoke_count);
         if (other_ic_it.second.is_missing_types) {
           dex_pc_data->SetIsMissingTypes();
         } else if (other_ic_it.second.is_megamorphic) {
@@ -2047,6 +2124,9 @@ std::string ProfileCompilationInfo::DumpInfo(const std::vector<const DexFile*>&
             separator = ",";
           }
         }
+        if (inline_cache_it.second.invoke_count != 0u) {
+          os << "x" << inline_cache_it.second.invoke_count;
+        }
         os << "}";
       }
       os << "], ";
@@ -2825,6 +2905,159 @@ ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::S
   return ProfileLoadStatus::kSuccess;
 }
 
+uint32_t ProfileCompilationInfo::DexFileData::InvokeCountsDataSize() const {
+  size_t num_methods = 0u;
+  size_t num_count_entries = 0u;
+  for (const auto& method_entry : method_map) {
+    size_t num_method_count_entries = 0u;
+    for (const auto& inline_cache_entry : method_entry.second) {
+      if (inline_cache_entry.second.invoke_count != 0u) {
+        ++num_method_count_entries;
+      }
+    }
+    if (num_method_count_entries != 0u) {
+      ++num_methods;
+      num_count_entries += num_method_count_entries;
+    }
+  }
+  if (num_methods == 0u) {
+    return 0u;
+  }
+
+  constexpr size_t kPerMethodSize =
+      sizeof(uint16_t) +  // Method index diff.
+      sizeof(uint16_t);   // Number of counts.
+  constexpr size_t kPerCountEntrySize =
+      sizeof(uint16_t) +  // Dex PC.
+      sizeof(uint32_t);   // Invoke count.
+  return sizeof(ProfileIndexType) +                   // Which dex file.
+         sizeof(uint32_t) +                           // Total size of following data.
+         num_methods * kPerMethodSize +               // Data for methods.
+         num_count_entries * kPerCountEntrySize;      // Data for count entries.
+}
+
+void ProfileCompilationInfo::DexFileData::WriteInvokeCounts(SafeBuffer& buffer) const {
+  uint32_t invoke_counts_data_size = InvokeCountsDataSize();
+  if (invoke_counts_data_size == 0u) {
+    return;  // No data to write.
+  }
+  DCHECK_GE(buffer.GetAvailableBytes(), invoke_counts_data_size);
+  uint32_t expected_available_bytes_at_end = buffer.GetAvailableBytes() - invoke_counts_data_size;
+
+  // Write the profile index and the total size of the following data.
+  buffer.WriteUintAndAdvance(profile_index);
+  uint32_t following_data_size =
+      invoke_counts_data_size - sizeof(ProfileIndexType) - sizeof(uint32_t);
+  buffer.WriteUintAndAdvance(following_data_size);
+
+  uint16_t last_method_index = 0;
+  for (const auto& method_entry : method_map) {
+    const InlineCacheMap& inline_cache_map = method_entry.second;
+    uint16_t num_counts = 0u;
+    for (const auto& inline_cache_entry : inline_cache_map) {
+      if (inline_cache_entry.second.invoke_count != 0u) {
+        ++num_counts;
+      }
+    }
+    if (num_counts == 0u) {
+      continue;
+    }
+    uint16_t method_index = method_entry.first;
+    DCHECK_GE(method_index, last_method_index);
+    buffer.WriteUintAndAdvance(static_cast<uint16_t>(method_index - last_method_index));
+    last_method_index = method_index;
+    buffer.WriteUintAndAdvance(num_counts);
+    for (const auto& inline_cache_entry : inline_cache_map) {
+      if (inline_cache_entry.second.invoke_count != 0u) {
+        buffer.WriteUintAndAdvance(inline_cache_entry.first);
+        buffer.WriteUintAndAdvance(inline_cache_entry.second.invoke_count);
+      }
+    }
+  }
+
+  // Check if we've written the right number of bytes.
+  DCHECK_EQ(buffer.GetAvailableBytes(), expected_available_bytes_at_end);
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::ReadInvokeCounts(
+    SafeBuffer& buffer,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading invoke counts data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Invoke counts data size exceeds available data size.";
+    return ProfileLoadStatus::kBadData;
+  }
+  uint32_t expected_available_bytes_at_end = buffer.GetAvailableBytes() - following_data_size;
+
+  uint32_t method_index = 0u;
+  bool first_diff = true;
+  while (buffer.GetAvailableBytes() > expected_available_bytes_at_end) {
+    uint16_t diff_with_last_method_index;
+    if (!buffer.ReadUintAndAdvance(&diff_with_last_method_index)) {
+      *error = "Error reading invoke counts method index diff.";
+      return ProfileLoadStatus::kBadData;
+    }
+    if (diff_with_last_method_index == 0u && !first_diff) {
+      *error = "Duplicate invoke counts method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    first_diff = false;
+    method_index += diff_with_last_method_index;
+    if (method_index >= num_method_ids) {
+      *error = "Invalid invoke counts method index.";
+      return ProfileLoadStatus::kBadData;
+    }
+    uint16_t num_counts;
+    if (!buffer.ReadUintAndAdvance(&num_counts)) {
+      *error = "Error reading number of invoke counts.";
+      return ProfileLoadStatus::kBadData;
+    }
+    // Counts only annotate inline caches of hot methods read from the methods section.
+    auto method_it = method_map.find(method_index);
+    for (uint16_t i = 0; i != num_counts; ++i) {
+      uint16_t dex_pc;
+      uint32_t invoke_count;
+      if (!buffer.ReadUintAndAdvance(&dex_pc) || !buffer.ReadUintAndAdvance(&invoke_count)) {
+        *error = "Error reading invoke count.";
+        return ProfileLoadStatus::kBadData;
+      }
+      if (method_it != method_map.end()) {
+        auto dex_pc_it = method_it->second.find(dex_pc);
+        if (dex_pc_it != method_it->second.end()) {
+          dex_pc_it->second.MergeInvokeCount(invoke_count);
+        }
+      }
+    }
+  }
+
+  if (buffer.GetAvailableBytes() != expected_available_bytes_at_end) {
+    *error = "Invoke counts data did not end at expected position.";
+    return ProfileLoadStatus::kBadData;
+  }
+
+  return ProfileLoadStatus::kSuccess;
+}
+
+ProfileCompilationInfo::ProfileLoadStatus ProfileCompilationInfo::DexFileData::SkipInvokeCounts(
+    SafeBuffer& buffer,
+    std::string* error) {
+  uint32_t following_data_size;
+  if (!buffer.ReadUintAndAdvance(&following_data_size)) {
+    *error = "Error reading invoke counts data size to skip.";
+    return ProfileLoadStatus::kBadData;
+  }
+  if (following_data_size > buffer.GetAvailableBytes()) {
+    *error = "Invoke counts data size to skip exceeds remaining data.";
+    return ProfileLoadStatus::kBadData;
+  }
+  buffer.Advance(following_data_size);
+  return ProfileLoadStatus::kSuccess;
+}
+
 void ProfileCompilationInfo::DexFileData::WriteClassSet(
     SafeBuffer& buffer,
     const ArenaSet<dex::TypeIndex>& class_set) {
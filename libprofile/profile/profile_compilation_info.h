@@ -17,6 +17,7 @@
 #ifndef ART_LIBPROFILE_PROFILE_PROFILE_COMPILATION_INFO_H_
 #define ART_LIBPROFILE_PROFILE_PROFILE_COMPILATION_INFO_H_
 
+#include <algorithm>
 #include <array>
 #include <list>
 #include <set>
@@ -50,11 +51,13 @@ struct ProfileMethodInfo {
                        bool missing_types,
                        const std::vector<TypeReference>& profile_classes,
                        // Only used by profman for creating profiles from text
-                       bool megamorphic = false)
+                       bool megamorphic = false,
+                       uint32_t count = 0u)
         : dex_pc(pc),
           is_missing_types(missing_types),
           classes(profile_classes),
-          is_megamorphic(megamorphic) {}
+          is_megamorphic(megamorphic),
+          invoke_count(count) {}
 
     const uint32_t dex_pc;
     const bool is_missing_types;
@@ -63,6 +66,8 @@ struct ProfileMethodInfo {
     // by the profman. See `ProfileCompilationInfo::FindOrCreateTypeIndex()`.
     const std::vector<TypeReference> classes;
     const bool is_megamorphic;
+    // Number of times the call site was executed, zero if unknown.
+    const uint32_t invoke_count;
   };
 
   explicit ProfileMethodInfo(MethodReference reference) : ref(reference) {}
@@ -138,6 +143,7 @@ class ProfileCompilationInfo {
     explicit DexPcData(const ArenaAllocatorAdapter<void>& allocator)
         : is_missing_types(false),
           is_megamorphic(false),
+          invoke_count(0u),
           classes(std::less<dex::TypeIndex>(), allocator) {}
     void AddClass(const dex::TypeIndex& type_idx);
     void SetIsMegamorphic() {
@@ -150,9 +156,15 @@ class ProfileCompilationInfo {
       is_missing_types = true;
       classes.clear();
     }
+    void MergeInvokeCount(uint32_t count) {
+      // Counts are relative weights of the call sites. Take the maximum so that
+      // merging repeated snapshots of the same process does not inflate them.
+      invoke_count = std::max(invoke_count, count);
+    }
     bool operator==(const DexPcData& other) const {
       return is_megamorphic == other.is_megamorphic &&
           is_missing_types == other.is_missing_types &&
+          invoke_count == other.invoke_count &&
           classes == other.classes;
     }
 
@@ -161,6 +173,9 @@ class ProfileCompilationInfo {
     // encoded. When types are missing this field will be set to true.
     bool is_missing_types;
     bool is_megamorphic;
+    // The number of times the call site was executed, as sampled by the JIT.
+    // Zero if unknown. Used by the compiler to prioritize inlining.
+    uint32_t invoke_count;
     ArenaSet<dex::TypeIndex> classes;
   };
 
@@ -873,6 +888,11 @@ class ProfileCompilationInfo {
         std::string* error);
     static ProfileLoadStatus SkipMethods(SafeBuffer& buffer, std::string* error);
 
+    uint32_t InvokeCountsDataSize() const;
+    void WriteInvokeCounts(SafeBuffer& buffer) const;
+    ProfileLoadStatus ReadInvokeCounts(SafeBuffer& buffer, std::string* error);
+    static ProfileLoadStatus SkipInvokeCounts(SafeBuffer& buffer, std::string* error);
+
     // The allocator used to allocate new inline cache maps.
     ArenaAllocator* const allocator_;
     // The profile key this data belongs to.
@@ -1013,6 +1033,12 @@ class ProfileCompilationInfo {
       const dchecked_vector<ExtraDescriptorIndex>& extra_descriptors_remap,
       /*out*/ std::string* error);
 
+  ProfileLoadStatus ReadInvokeCountsSection(
+      ProfileSource& source,
+      const FileSectionInfo& section_info,
+      const dchecked_vector<ProfileIndexType>& dex_profile_index_remap,
+      /*out*/ std::string* error);
+
   // Entry point for profile loading functionality.
   ProfileLoadStatus LoadInternal(
       int32_t fd,
@@ -799,6 +799,64 @@ TEST_F(ProfileCompilationInfoTest, MissingTypesInlineCachesMerge) {
   ASSERT_TRUE(info_no_inline_cache.Save(GetFd(profile)));
 }
 
+TEST_F(ProfileCompilationInfoTest, InvokeCountsSaveLoadAndMerge) {
+  std::vector<TypeReference> types = {TypeReference(dex1, dex::TypeIndex(0))};
+  std::vector<ProfileInlineCache> inline_caches;
+  inline_caches.push_back(ProfileInlineCache(/*pc=*/ 1,
+                                             /*missing_types=*/ false,
+                                             types,
+                                             /*megamorphic=*/ false,
+                                             /*count=*/ 100u));
+  inline_caches.push_back(ProfileInlineCache(/*pc=*/ 2,
+                                             /*missing_types=*/ false,
+                                             types,
+                                             /*megamorphic=*/ false,
+                                             /*count=*/ 0u));
+  inline_caches.push_back(ProfileInlineCache(/*pc=*/ 3,
+                                             /*missing_types=*/ true,
+                                             {},
+                                             /*megamorphic=*/ false,
+                                             /*count=*/ 7u));
+  ProfileCompilationInfo saved_info;
+  ASSERT_TRUE(AddMethod(&saved_info, dex1, /*method_idx=*/ 3, inline_caches));
+
+  ScratchFile profile;
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(loaded_info.Load(GetFd(profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  ProfileCompilationInfo::MethodHotness hotness = GetMethod(loaded_info, dex1, 3);
+  ASSERT_TRUE(hotness.IsHot());
+  const ProfileCompilationInfo::InlineCacheMap* inline_cache_map = hotness.GetInlineCacheMap();
+  ASSERT_EQ(inline_cache_map->size(), 3u);
+  EXPECT_EQ(inline_cache_map->Get(1).invoke_count, 100u);
+  EXPECT_EQ(inline_cache_map->Get(2).invoke_count, 0u);
+  EXPECT_EQ(inline_cache_map->Get(3).invoke_count, 7u);
+
+  // Merging keeps the maximum count of each call site.
+  std::vector<ProfileInlineCache> other_inline_caches;
+  other_inline_caches.push_back(ProfileInlineCache(/*pc=*/ 1,
+                                                   /*missing_types=*/ false,
+                                                   types,
+                                                   /*megamorphic=*/ false,
+                                                   /*count=*/ 50u));
+  other_inline_caches.push_back(ProfileInlineCache(/*pc=*/ 2,
+                                                   /*missing_types=*/ false,
+                                                   types,
+                                                   /*megamorphic=*/ false,
+                                                   /*count=*/ 20u));
+  ProfileCompilationInfo other_info;
+  ASSERT_TRUE(AddMethod(&other_info, dex1, /*method_idx=*/ 3, other_inline_caches));
+  ASSERT_TRUE(loaded_info.MergeWith(other_info));
+  inline_cache_map = GetMethod(loaded_info, dex1, 3).GetInlineCacheMap();
+  EXPECT_EQ(inline_cache_map->Get(1).invoke_count, 100u);
+  EXPECT_EQ(inline_cache_map->Get(2).invoke_count, 20u);
+  EXPECT_EQ(inline_cache_map->Get(3).invoke_count, 7u);
+}
+
 TEST_F(ProfileCompilationInfoTest, SampledMethodsTest) {
   ProfileCompilationInfo test_info;
   AddMethod(&test_info, dex1, 1, Hotness::kFlagStartup);
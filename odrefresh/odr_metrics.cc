@@ -16,6 +16,7 @@
 
 #include "odr_metrics.h"
 
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -89,6 +90,18 @@ void OdrMetrics::SetStage(Stage stage) {
   }
 }
 
+void OdrMetrics::UpdateDex2oatPeakRss() {
+  // For children, `ru_maxrss` is the peak of the largest terminated child in KiB. The only
+  // children of odrefresh are dex2oat processes.
+  struct rusage usage;
+  if (getrusage(RUSAGE_CHILDREN, &usage) != 0) {
+    PLOG(WARNING) << "Failed to get the resource usage of dex2oat";
+    return;
+  }
+  int32_t peak_rss_mib = static_cast<int32_t>(usage.ru_maxrss / 1024);
+  dex2oat_peak_rss_mib_ = std::max(dex2oat_peak_rss_mib_, peak_rss_mib);
+}
+
 int32_t OdrMetrics::GetFreeSpaceMiB(const std::string& path) {
   static constexpr uint32_t kBytesPerMiB = 1024 * 1024;
   static constexpr uint64_t kNominalMaximumCacheBytes = 1024 * kBytesPerMiB;
@@ -128,6 +141,7 @@ bool OdrMetrics::ToRecord(/*out*/OdrMetricsRecord* record) const {
   record->system_server_compilation_seconds = system_server_compilation_seconds_;
   record->cache_space_free_start_mib = cache_space_free_start_mib_;
   record->cache_space_free_end_mib = cache_space_free_end_mib_;
+  record->dex2oat_peak_rss_mib = dex2oat_peak_rss_mib_;
   return true;
 }
 
@@ -115,6 +115,9 @@ class OdrMetrics final {
   // Sets the current odrefresh processing stage.
   void SetStage(Stage stage);
 
+  // Records the peak resident set size of the dex2oat processes that have terminated so far.
+  void UpdateDex2oatPeakRss();
+
   // Record metrics into an OdrMetricsRecord.
   // returns true on success, false if instance is not valid (because the trigger value is not set).
   bool ToRecord(/*out*/OdrMetricsRecord* record) const;
@@ -142,6 +145,7 @@ class OdrMetrics final {
   int32_t system_server_compilation_seconds_ = 0;
   int32_t cache_space_free_start_mib_ = 0;
   int32_t cache_space_free_end_mib_ = 0;
+  int32_t dex2oat_peak_rss_mib_ = 0;
 
   friend class ScopedOdrCompilationTimer;
 };
@@ -40,6 +40,11 @@ std::istream& operator>>(std::istream& is, OdrMetricsRecord& record) {
   is >> record.system_server_compilation_seconds >> std::ws;
   is >> record.cache_space_free_start_mib >> std::ws;
   is >> record.cache_space_free_end_mib >> std::ws;
+  // Files written by older versions end here.
+  record.dex2oat_peak_rss_mib = 0;
+  if (!is.eof()) {
+    is >> record.dex2oat_peak_rss_mib >> std::ws;
+  }
 
   // Restore I/O related exceptions
   is.exceptions(saved_exceptions);
@@ -62,7 +67,8 @@ std::ostream& operator<<(std::ostream& os, const OdrMetricsRecord& record) {
   os << record.secondary_bcp_compilation_seconds << kSpace;
   os << record.system_server_compilation_seconds << kSpace;
   os << record.cache_space_free_start_mib << kSpace;
-  os << record.cache_space_free_end_mib << std::endl;
+  os << record.cache_space_free_end_mib << kSpace;
+  os << record.dex2oat_peak_rss_mib << std::endl;
 
   // Restore I/O related exceptions
   os.exceptions(saved_exceptions);
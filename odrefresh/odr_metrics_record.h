@@ -39,6 +39,8 @@ struct OdrMetricsRecord {
   int32_t system_server_compilation_seconds;
   int32_t cache_space_free_start_mib;
   int32_t cache_space_free_end_mib;
+  // Not part of `OdrefreshReported` yet, only written to the metrics file.
+  int32_t dex2oat_peak_rss_mib;
 };
 
 // Read a `MetricsRecord` from an `istream`.
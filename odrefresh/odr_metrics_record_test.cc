@@ -37,7 +37,8 @@ TEST_F(OdrMetricsRecordTest, HappyPath) {
     .secondary_bcp_compilation_seconds = 0x41424344,
     .system_server_compilation_seconds = 0x51525354,
     .cache_space_free_start_mib = 0x61626364,
-    .cache_space_free_end_mib = 0x71727374
+    .cache_space_free_end_mib = 0x71727374,
+    .dex2oat_peak_rss_mib = 0x00010203
   };
 
   ScratchDir dir(/*keep_files=*/false);
@@ -66,6 +67,7 @@ TEST_F(OdrMetricsRecordTest, HappyPath) {
   ASSERT_EQ(expected.system_server_compilation_seconds, actual.system_server_compilation_seconds);
   ASSERT_EQ(expected.cache_space_free_start_mib, actual.cache_space_free_start_mib);
   ASSERT_EQ(expected.cache_space_free_end_mib, actual.cache_space_free_end_mib);
+  ASSERT_EQ(expected.dex2oat_peak_rss_mib, actual.dex2oat_peak_rss_mib);
   ASSERT_EQ(0, memcmp(&expected, &actual, sizeof(expected)));
 }
 
@@ -18,11 +18,13 @@
 #include "base/casts.h"
 #include "odr_metrics_record.h"
 
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/common_art_test.h"
 
@@ -216,5 +218,28 @@ TEST_F(OdrMetricsTest, CacheSpaceValuesAreUpdated) {
   EXPECT_NE(0, on_disk.cache_space_free_end_mib);
 }
 
+TEST_F(OdrMetricsTest, Dex2oatPeakRssIsRecorded) {
+  OdrMetrics metrics(GetCacheDirectory(), GetMetricsFilePath());
+  metrics.SetTrigger(OdrMetrics::Trigger::kMissingArtifacts);
+
+  // Stand in for dex2oat with a child process that touches 32MiB.
+  static constexpr size_t kChildMemorySize = 32 * 1024 * 1024;
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    std::vector<uint8_t> memory(kChildMemorySize, 1u);
+    _exit(memory[kChildMemorySize - 1u] == 1u ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  metrics.UpdateDex2oatPeakRss();
+  OdrMetricsRecord record{};
+  EXPECT_TRUE(metrics.ToRecord(&record));
+  EXPECT_LE(32, record.dex2oat_peak_rss_mib);
+}
+
 }  // namespace odrefresh
 }  // namespace art
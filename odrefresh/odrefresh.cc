@@ -397,6 +397,20 @@ bool AddDex2OatConcurrencyArguments(/*inout*/ std::vector<std::string>& args) {
   return true;
 }
 
+bool AddDex2OatMemoryBudget(/*inout*/ std::vector<std::string>& args) {
+  std::string budget = android::base::GetProperty("dalvik.vm.boot-dex2oat-memory-budget", "");
+  if (budget.empty()) {
+    return true;
+  }
+  unsigned int budget_mb;
+  if (!android::base::ParseUint(budget, &budget_mb) || budget_mb == 0u) {
+    LOG(ERROR) << "Invalid dex2oat memory budget: " << budget;
+    return false;
+  }
+  args.push_back("--memory-budget=" + budget);
+  return true;
+}
+
 void AddDex2OatDebugInfo(/*inout*/ std::vector<std::string>& args) {
   args.emplace_back("--generate-mini-debug-info");
   args.emplace_back("--strip");
@@ -1327,6 +1341,9 @@ WARN_UNUSED bool OnDeviceRefresh::CompileBootClasspathArtifacts(
   if (!AddDex2OatConcurrencyArguments(args)) {
     return false;
   }
+  if (!AddDex2OatMemoryBudget(args)) {
+    return false;
+  }
 
   std::vector<std::unique_ptr<File>> readonly_files_raii;
   const std::string art_boot_profile_file = GetArtRoot() + "/etc/boot-image.prof";
@@ -1423,6 +1440,7 @@ WARN_UNUSED bool OnDeviceRefresh::CompileBootClasspathArtifacts(
 
   bool timed_out = false;
   int dex2oat_exit_code = exec_utils_->ExecAndReturnCode(args, timeout, &timed_out, error_msg);
+  metrics.UpdateDex2oatPeakRss();
 
   if (dex2oat_exit_code != 0) {
     if (timed_out) {
@@ -1481,6 +1499,9 @@ WARN_UNUSED bool OnDeviceRefresh::CompileSystemServerArtifacts(
     if (!AddDex2OatConcurrencyArguments(args)) {
       return false;
     }
+    if (!AddDex2OatMemoryBudget(args)) {
+      return false;
+    }
 
     const std::string jar_name(android::base::Basename(jar));
     const std::string profile = Concatenate({GetAndroidRoot(), "/framework/", jar_name, ".prof"});
@@ -1579,6 +1600,7 @@ WARN_UNUSED bool OnDeviceRefresh::CompileSystemServerArtifacts(
 
     bool timed_out = false;
     int dex2oat_exit_code = exec_utils_->ExecAndReturnCode(args, timeout, &timed_out, error_msg);
+    metrics.UpdateDex2oatPeakRss();
 
     if (dex2oat_exit_code != 0) {
       if (timed_out) {
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_DESCRIPTOR_FILTER_H_
+#define ART_RUNTIME_CLASS_DESCRIPTOR_FILTER_H_
+
+#include <vector>
+
+#include "base/bit_utils.h"
+#include "base/locks.h"
+#include "base/macros.h"
+#include "gc_root.h"
+#include "obj_ptr.h"
+
+namespace art {
+
+class DexFile;
+
+namespace mirror {
+class Object;
+}  // namespace mirror
+
+// Bloom filter over the descriptors of the classes defined by the dex files of a class loader
+// or by the boot class path. Without it, looking up a class that none of the dex files defines
+// searches the type lookup table of each dex file in turn. That adds up for class loaders with
+// many dex files and for the boot class path, which is searched first for every app class.
+class ClassDescriptorFilter {
+ public:
+  // 12 bits per class and 3 hash functions give about 1% false positives.
+  static constexpr size_t kBitsPerClass = 12u;
+  static constexpr size_t kNumHashFunctions = 3u;
+
+  // `dex_elements` is the DexPathList.dexElements array that the `dex_files` were taken from,
+  // or null for the boot class path.
+  ClassDescriptorFilter(const std::vector<const DexFile*>& dex_files,
+                        ObjPtr<mirror::Object> dex_elements)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Returns false if none of the dex files defines a class with a descriptor of this hash,
+  // as computed by ComputeModifiedUtf8Hash().
+  bool MayContain(uint32_t hash) const {
+    uint32_t h1;
+    uint32_t h2;
+    GetBitHashes(hash, &h1, &h2);
+    for (size_t i = 0; i != kNumHashFunctions; ++i) {
+      size_t bit = (h1 + i * h2) & bit_mask_;
+      if ((bits_[bit / kBitsPerWord] & (UINT64_C(1) << (bit % kBitsPerWord))) == 0u) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t GetNumDexFiles() const {
+    return num_dex_files_;
+  }
+
+  template <ReadBarrierOption kReadBarrierOption = kWithReadBarrier>
+  ObjPtr<mirror::Object> GetDexElements() const REQUIRES_SHARED(Locks::mutator_lock_) {
+    return dex_elements_.Read<kReadBarrierOption>();
+  }
+
+  // The GC updates the root if the array moves.
+  GcRoot<mirror::Object>& GetDexElementsRoot() const {
+    return dex_elements_;
+  }
+
+  size_t GetSizeInBytes() const {
+    return bits_.size() * sizeof(uint64_t);
+  }
+
+ private:
+  static constexpr size_t kBitsPerWord = BitSizeOf<uint64_t>();
+
+  // Derive the hash functions from two halves of the mixed descriptor hash, so that they do
+  // not depend on its low bits alone like the type lookup tables do.
+  static void GetBitHashes(uint32_t hash, /*out*/ uint32_t* h1, /*out*/ uint32_t* h2) {
+    uint64_t mixed = static_cast<uint64_t>(hash) * UINT64_C(0x9e3779b97f4a7c15);
+    *h1 = static_cast<uint32_t>(mixed >> 32);
+    *h2 = static_cast<uint32_t>(mixed) | 1u;  // Odd, to reach all bits of the filter.
+  }
+
+  void Add(uint32_t hash);
+
+  std::vector<uint64_t> bits_;
+  size_t bit_mask_;
+  const size_t num_dex_files_;
+  mutable GcRoot<mirror::Object> dex_elements_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassDescriptorFilter);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_DESCRIPTOR_FILTER_H_
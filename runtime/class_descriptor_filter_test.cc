@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_descriptor_filter.h"
+
+#include <string>
+
+#include "class_linker-inl.h"
+#include "class_loader_utils.h"
+#include "class_table-inl.h"
+#include "common_runtime_test.h"
+#include "dex/dex_file-inl.h"
+#include "dex/utf.h"
+#include "handle_scope-inl.h"
+#include "mirror/class_loader-inl.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class ClassDescriptorFilterTest : public CommonRuntimeTest {};
+
+TEST_F(ClassDescriptorFilterTest, BootClassPath) {
+  ScopedObjectAccess soa(Thread::Current());
+  const std::vector<const DexFile*>& dex_files = class_linker_->GetBootClassPath();
+  ClassDescriptorFilter filter(dex_files, /*dex_elements=*/ nullptr);
+  EXPECT_EQ(dex_files.size(), filter.GetNumDexFiles());
+  size_t num_classes = 0u;
+  size_t num_false_positives = 0u;
+  for (const DexFile* dex_file : dex_files) {
+    for (uint32_t i = 0, num_class_defs = dex_file->NumClassDefs(); i != num_class_defs; ++i) {
+      std::string descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(i));
+      EXPECT_TRUE(filter.MayContain(ComputeModifiedUtf8Hash(descriptor.c_str()))) << descriptor;
+      // The same class in a package that is not on the boot class path.
+      std::string absent = "Lnot/on/boot/class/path/" + descriptor.substr(1u);
+      if (filter.MayContain(ComputeModifiedUtf8Hash(absent.c_str()))) {
+        ++num_false_positives;
+      }
+      ++num_classes;
+    }
+  }
+  ASSERT_NE(num_classes, 0u);
+  // About 1% are expected.
+  EXPECT_LT(num_false_positives, num_classes / 20u);
+}
+
+TEST_F(ClassDescriptorFilterTest, BuiltAfterMisses) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(LoadDex("Nested"))));
+  // Defining a class creates the class table.
+  ASSERT_TRUE(class_linker_->FindClass(soa.Self(), "LNested;", class_loader) != nullptr);
+  ClassTable* class_table = class_loader->GetClassTable();
+  ASSERT_TRUE(class_table != nullptr);
+  EXPECT_TRUE(class_table->GetClassDescriptorFilter() == nullptr);
+
+  for (uint32_t i = 0; i != ClassTable::kUnfilteredMissesPerFilterBuild; ++i) {
+    EXPECT_TRUE(class_linker_->FindClass(soa.Self(), "LMissing;", class_loader) == nullptr);
+    ASSERT_TRUE(soa.Self()->IsExceptionPending());
+    soa.Self()->ClearException();
+  }
+  const ClassDescriptorFilter* filter = class_table->GetClassDescriptorFilter();
+  ASSERT_TRUE(filter != nullptr);
+  EXPECT_TRUE(filter->GetDexElements() == GetClassLoaderDexElements(class_loader));
+  EXPECT_TRUE(filter->MayContain(ComputeModifiedUtf8Hash("LNested$Inner;")));
+
+  // Classes that were not defined yet are still found through the filter.
+  EXPECT_TRUE(class_linker_->FindClass(soa.Self(), "LNested$Inner;", class_loader) != nullptr);
+  EXPECT_TRUE(class_linker_->FindClass(soa.Self(), "LMissing;", class_loader) == nullptr);
+  soa.Self()->ClearException();
+}
+
+}  // namespace art
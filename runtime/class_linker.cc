@@ -57,6 +57,7 @@
 #include "base/utils.h"
 #include "base/value_object.h"
 #include "cha.h"
+#include "class_descriptor_filter.h"
 #include "class_linker-inl.h"
 #include "class_loader_utils.h"
 #include "class_root-inl.h"
@@ -82,6 +83,7 @@
 #include "gc/scoped_gc_critical_section.h"
 #include "gc/space/image_space.h"
 #include "gc/space/space-inl.h"
+#include "gc/task_processor.h"
 #include "gc_root-inl.h"
 #include "handle_scope-inl.h"
 #include "hidden_api.h"
@@ -566,6 +568,11 @@ static void WrapExceptionInInitializer(Handle<mirror::Class> klass)
 ClassLinker::ClassLinker(InternTable* intern_table, bool fast_class_not_found_exceptions)
     : boot_class_table_(new ClassTable()),
       failed_dex_cache_class_lookups_(0),
+      descriptor_filter_skips_(0u),
+      descriptor_filter_false_positives_(0u),
+      unfiltered_class_path_misses_(0u),
+      next_dex_cache_array_retire_seq_(0u),
+      recycle_dex_cache_arrays_pending_(false),
       class_roots_(nullptr),
       find_array_class_cache_next_victim_(0),
       init_done_(false),
@@ -2372,6 +2379,21 @@ void ClassLinker::DeleteClassLoader(Thread* self, const ClassLoaderData& data, b
     }
   }
 
+  {
+    MutexLock lock(self, *Locks::dex_cache_lock_);
+    auto uses_allocator = [&](const DexCacheArrayBlock& block) {
+      return block.alloc == data.allocator;
+    };
+    retired_dex_cache_arrays_.erase(std::remove_if(retired_dex_cache_arrays_.begin(),
+                                                   retired_dex_cache_arrays_.end(),
+                                                   uses_allocator),
+                                    retired_dex_cache_arrays_.end());
+    free_dex_cache_arrays_.erase(std::remove_if(free_dex_cache_arrays_.begin(),
+                                                free_dex_cache_arrays_.end(),
+                                                uses_allocator),
+                                 free_dex_cache_arrays_.end());
+  }
+
   delete data.allocator;
   delete data.class_table;
 }
@@ -2795,13 +2817,61 @@ ALWAYS_INLINE void FilterDexFileCaughtExceptions(Thread* self, ClassLinker* clas
 
 }  // namespace
 
+ClassPathEntry ClassLinker::FindInBootClassPath(const char* descriptor, size_t hash) {
+  ClassTable* const class_table = ClassTableForClassLoader(nullptr);
+  const ClassDescriptorFilter* filter = class_table->GetClassDescriptorFilter();
+  // AppendToBootClassPath() makes older filters incomplete.
+  const bool filter_valid =
+      filter != nullptr && filter->GetNumDexFiles() == boot_class_path_.size();
+  if (filter_valid && !filter->MayContain(hash)) {
+    descriptor_filter_skips_.fetch_add(1u, std::memory_order_relaxed);
+    return ClassPathEntry(nullptr, nullptr);
+  }
+  ClassPathEntry pair = FindInClassPath(descriptor, hash, boot_class_path_);
+  if (pair.second == nullptr) {
+    if (filter_valid) {
+      descriptor_filter_false_positives_.fetch_add(1u, std::memory_order_relaxed);
+    } else {
+      unfiltered_class_path_misses_.fetch_add(1u, std::memory_order_relaxed);
+      if (class_table->CountUnfilteredMiss()) {
+        EnsureBootClassPathDescriptorFilter();
+      }
+    }
+  }
+  return pair;
+}
+
+void ClassLinker::EnsureBootClassPathDescriptorFilter() {
+  ClassTable* const class_table = ClassTableForClassLoader(nullptr);
+  const ClassDescriptorFilter* filter = class_table->GetClassDescriptorFilter();
+  if (filter == nullptr || filter->GetNumDexFiles() != boot_class_path_.size()) {
+    class_table->SetClassDescriptorFilter(
+        std::make_unique<ClassDescriptorFilter>(boot_class_path_, /*dex_elements=*/ nullptr));
+  }
+}
+
+void ClassLinker::BuildClassLoaderDescriptorFilter(ScopedObjectAccessAlreadyRunnable& soa,
+                                                   Handle<mirror::ClassLoader> class_loader,
+                                                   ClassTable* class_table) {
+  // Read the array before visiting its dex files. If DexPathList.addDexPath() replaces it in the
+  // meantime, the filter may cover more dex files than the array it is tagged with, never fewer.
+  ObjPtr<mirror::Object> dex_elements = GetClassLoaderDexElements(class_loader);
+  std::vector<const DexFile*> dex_files;
+  VisitClassLoaderDexFiles(soa, class_loader, [&](const DexFile* dex_file) {
+    dex_files.push_back(dex_file);
+    return true;  // Continue with the next DexFile.
+  });
+  class_table->SetClassDescriptorFilter(
+      std::make_unique<ClassDescriptorFilter>(dex_files, dex_elements));
+}
+
 // Finds the class in the boot class loader.
 // If the class is found the method returns the resolved class. Otherwise it returns null.
 bool ClassLinker::FindClassInBootClassLoaderClassPath(Thread* self,
                                                       const char* descriptor,
                                                       size_t hash,
                                                       /*out*/ ObjPtr<mirror::Class>* result) {
-  ClassPathEntry pair = FindInClassPath(descriptor, hash, boot_class_path_);
+  ClassPathEntry pair = FindInBootClassPath(descriptor, hash);
   if (pair.second != nullptr) {
     ObjPtr<mirror::Class> klass = LookupClass(self, descriptor, hash, nullptr);
     if (klass != nullptr) {
@@ -2834,6 +2904,18 @@ bool ClassLinker::FindClassInBaseDexClassLoaderClassPath(
          IsDelegateLastClassLoader(soa, class_loader))
       << "Unexpected class loader for descriptor " << descriptor;
 
+  // The class table is null until the class loader defines its first class.
+  ClassTable* const class_table = ClassTableForClassLoader(class_loader.Get());
+  const ClassDescriptorFilter* filter =
+      (class_table != nullptr) ? class_table->GetClassDescriptorFilter() : nullptr;
+  // DexPathList.addDexPath() replaces the array, which makes older filters incomplete.
+  const bool filter_valid =
+      filter != nullptr && filter->GetDexElements() == GetClassLoaderDexElements(class_loader);
+  if (filter_valid && !filter->MayContain(hash)) {
+    descriptor_filter_skips_.fetch_add(1u, std::memory_order_relaxed);
+    return true;
+  }
+
   const DexFile* dex_file = nullptr;
   const dex::ClassDef* class_def = nullptr;
   ObjPtr<mirror::Class> ret;
@@ -2856,6 +2938,13 @@ bool ClassLinker::FindClassInBaseDexClassLoaderClassPath(
     } else {
       DCHECK(!soa.Self()->IsExceptionPending());
     }
+  } else if (filter_valid) {
+    descriptor_filter_false_positives_.fetch_add(1u, std::memory_order_relaxed);
+  } else {
+    unfiltered_class_path_misses_.fetch_add(1u, std::memory_order_relaxed);
+    if (class_table != nullptr && class_table->CountUnfilteredMiss()) {
+      BuildClassLoaderDescriptorFilter(soa, class_loader, class_table);
+    }
   }
   // A BaseDexClassLoader is always a known lookup.
   return true;
@@ -2882,7 +2971,7 @@ ObjPtr<mirror::Class> ClassLinker::FindClass(Thread* self,
   // Class is not yet loaded.
   if (descriptor[0] != '[' && class_loader == nullptr) {
     // Non-array class and the boot class loader, search the boot class path.
-    ClassPathEntry pair = FindInClassPath(descriptor, hash, boot_class_path_);
+    ClassPathEntry pair = FindInBootClassPath(descriptor, hash);
     if (pair.second != nullptr) {
       return DefineClass(self,
                          descriptor,
@@ -3516,6 +3605,85 @@ LinearAlloc* ClassLinker::GetOrCreateAllocatorForClassLoader(ObjPtr<mirror::Clas
   return allocator;
 }
 
+void* ClassLinker::AllocDexCacheArray(Thread* self, LinearAlloc* alloc, size_t size) {
+  // Use the smallest free block that is large enough. The rest of the block is not reused.
+  auto best = free_dex_cache_arrays_.end();
+  for (auto it = free_dex_cache_arrays_.begin(); it != free_dex_cache_arrays_.end(); ++it) {
+    if (it->alloc == alloc && it->size >= size && (best == free_dex_cache_arrays_.end() ||
+                                                   it->size < best->size)) {
+      best = it;
+    }
+  }
+  if (best == free_dex_cache_arrays_.end()) {
+    return alloc->AllocAlign16(self, size);
+  }
+  void* data = best->data;
+  free_dex_cache_arrays_.erase(best);
+  memset(data, 0, size);
+  return data;
+}
+
+void ClassLinker::RetireDexCacheArray(Thread* self ATTRIBUTE_UNUSED,
+                                      LinearAlloc* alloc,
+                                      void* data,
+                                      size_t size) {
+  DCHECK(alloc->Contains(data));
+  retired_dex_cache_arrays_.push_back(
+      DexCacheArrayBlock{alloc, data, size, next_dex_cache_array_retire_seq_});
+  ++next_dex_cache_array_retire_seq_;
+}
+
+class ClassLinker::RecycleDexCacheArraysTask : public gc::HeapTask {
+ public:
+  RecycleDexCacheArraysTask() : gc::HeapTask(/*target_run_time=*/ NanoTime()) {}
+
+  void Run(Thread* self) override {
+    ScopedObjectAccess soa(self);
+    Runtime::Current()->GetClassLinker()->RecycleDexCacheArrays(self);
+  }
+};
+
+void ClassLinker::ScheduleRecycleDexCacheArrays(Thread* self ATTRIBUTE_UNUSED) {
+  if (recycle_dex_cache_arrays_pending_.exchange(true, std::memory_order_relaxed)) {
+    return;
+  }
+  // Use the heap task processor so that the checkpoint does not block the caller.
+  std::unique_ptr<RecycleDexCacheArraysTask> task(new RecycleDexCacheArraysTask());
+  if (Runtime::Current()->GetHeap()->AddHeapTask(task.get())) {
+    task.release();
+  } else {
+    recycle_dex_cache_arrays_pending_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void ClassLinker::RecycleDexCacheArrays(Thread* self) {
+  // Arrays retired after this point are left for the next task.
+  recycle_dex_cache_arrays_pending_.store(false, std::memory_order_relaxed);
+  uint64_t retire_seq_limit;
+  {
+    MutexLock mu(self, *Locks::dex_cache_lock_);
+    if (retired_dex_cache_arrays_.empty()) {
+      return;
+    }
+    retire_seq_limit = next_dex_cache_array_retire_seq_;
+  }
+  // Readers do not keep a dex cache array across suspend points, so once every thread
+  // passed a checkpoint, no reader uses the arrays retired before it.
+  {
+    gc::ScopedInterruptibleGCCriticalSection sigcs(self,
+                                                   gc::kGcCauseRunEmptyCheckpoint,
+                                                   gc::kCollectorTypeCriticalSection);
+    Runtime::Current()->GetThreadList()->RunEmptyCheckpoint();
+  }
+  MutexLock mu(self, *Locks::dex_cache_lock_);
+  auto it = retired_dex_cache_arrays_.begin();
+  while (it != retired_dex_cache_arrays_.end() && it->retire_seq < retire_seq_limit) {
+    free_dex_cache_arrays_.push_back(*it);
+    ++it;
+  }
+  retired_dex_cache_arrays_.erase(retired_dex_cache_arrays_.begin(), it);
+}
+
 void ClassLinker::LoadClass(Thread* self,
                             const DexFile& dex_file,
                             const dex::ClassDef& dex_class_def,
@@ -4307,11 +4475,13 @@ ObjPtr<mirror::Class> ClassLinker::LookupClass(Thread* self,
   return LookupClass(self, descriptor, ComputeModifiedUtf8Hash(descriptor), class_loader);
 }
 
-ObjPtr<mirror::Class> ClassLinker::LookupClass(Thread* self,
+ObjPtr<mirror::Class> ClassLinker::LookupClass(Thread* self ATTRIBUTE_UNUSED,
                                                const char* descriptor,
                                                size_t hash,
                                                ObjPtr<mirror::ClassLoader> class_loader) {
-  ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
+  // No need for the `classlinker_classes_lock_`. The class table of a live class loader is not
+  // deleted and ClassTable::Lookup() is safe to use concurrently with insertions. The fences
+  // in ClassTable make the fields of a class that it finds visible to this thread.
   ClassTable* const class_table = ClassTableForClassLoader(class_loader);
   if (class_table != nullptr) {
     ObjPtr<mirror::Class> result = class_table->Lookup(descriptor, hash);
@@ -5792,6 +5962,8 @@ void ClassLinker::RegisterClassLoader(ObjPtr<mirror::ClassLoader> class_loader)
   data.weak_root = self->GetJniEnv()->GetVm()->AddWeakGlobalRef(self, class_loader);
   // Create and set the class table.
   data.class_table = new ClassTable;
+  // Publish the constructed table to LookupClass(), which reads it without locks.
+  std::atomic_thread_fence(std::memory_order_release);
   class_loader->SetClassTable(data.class_table);
   // Create and set the linear allocator.
   data.allocator = Runtime::Current()->CreateLinearAlloc();
@@ -7944,35 +8116,111 @@ size_t ClassLinker::LinkMethodsHelper<kPointerSize>::AssignVTableIndexes(
       super_vtable_buffer_ptr,
       super_vtable_buffer_size,
       allocator_.Adapter());
-  ArrayRef<uint32_t> same_signature_vtable_lists;
-  // Insert the first `mirror::Object::kVTableLength` indexes with pre-calculated hashes.
-  DCHECK_GE(super_vtable_length, mirror::Object::kVTableLength);
-  for (uint32_t i = 0; i != mirror::Object::kVTableLength; ++i) {
-    size_t hash = class_linker_->object_virtual_method_hashes_[i];
-    // There are no duplicate signatures in `java.lang.Object`, so use `HashSet<>::PutWithHash()`.
-    // This avoids equality comparison for the three `java.lang.Object.wait()` overloads.
-    super_vtable_signatures.PutWithHash(i, hash);
-  }
-  // Insert the remaining indexes, check for duplicate signatures.
-  if (super_vtable_length > mirror::Object::kVTableLength) {
+  ArrayRef<const uint32_t> same_signature_vtable_lists;
+  // Classes with many subclasses, such as views and activities, tend to have long vtables.
+  // Once such a class is seen as a superclass for the second time, record the signature data
+  // of its vtable in its class loader's class table and reuse it for further subclasses.
+  // The recorded data holds a flag for the presence of same signature lists, the hashes
+  // and then the lists, if any. It lives only in this process; the vtable itself, as well
+  // as the iftable and IMT, are still built for every subclass.
+  static constexpr size_t kMinRecordedVTableLength = 64u;
+  ClassTable* super_class_table = nullptr;
+  const uint32_t* recorded_signatures = nullptr;
+  bool record_signatures = false;
+  if (super_vtable_length >= kMinRecordedVTableLength && super_class->GetMethodsPtr() != nullptr) {
+    super_class_table = class_linker_->ClassTableForClassLoader(super_class->GetClassLoader());
+    DCHECK(super_class_table != nullptr);
+    bool first_use = false;
+    recorded_signatures =
+        super_class_table->GetVTableSignatures(super_class->GetMethodsPtr(), &first_use);
+    record_signatures = (recorded_signatures == nullptr) && !first_use;
+  }
+  if (recorded_signatures != nullptr) {
+    const uint32_t* hashes = recorded_signatures + 1u;
+    if (recorded_signatures[0] != 0u) {
+      same_signature_vtable_lists =
+          ArrayRef<const uint32_t>(hashes + super_vtable_length, super_vtable_length);
+    }
+    if (kIsDebugBuild) {
+      for (uint32_t i = 0; i != super_vtable_length; ++i) {
+        size_t hash = (i < mirror::Object::kVTableLength)
+            ? class_linker_->object_virtual_method_hashes_[i]
+            : ComputeMethodHash(super_vtable_accessor.GetVTableEntry(i));
+        DCHECK_EQ(hashes[i], static_cast<uint32_t>(hash));
+      }
+    }
+    // Insert only the last index with each signature, the lists lead to the others.
+    // No equality comparison is needed, all inserted signatures are known to be distinct.
+    uint32_t* superseded = nullptr;
+    if (!same_signature_vtable_lists.empty()) {
+      superseded = allocator_.AllocArray<uint32_t>(super_vtable_length);
+      std::fill_n(superseded, super_vtable_length, 0u);
+      for (uint32_t previous_index : same_signature_vtable_lists) {
+        if (previous_index != dex::kDexNoIndex) {
+          superseded[previous_index] = 1u;
+        }
+      }
+    }
+    for (uint32_t i = 0; i != super_vtable_length; ++i) {
+      if (superseded == nullptr || superseded[i] == 0u) {
+        super_vtable_signatures.PutWithHash(i, hashes[i]);
+      }
+    }
+  } else {
+    uint32_t* hashes = record_signatures
+        ? allocator_.AllocArray<uint32_t>(super_vtable_length)
+        : nullptr;
+    uint32_t* lists = nullptr;
+    // Insert the first `mirror::Object::kVTableLength` indexes with pre-calculated hashes.
+    DCHECK_GE(super_vtable_length, mirror::Object::kVTableLength);
+    for (uint32_t i = 0; i != mirror::Object::kVTableLength; ++i) {
+      size_t hash = class_linker_->object_virtual_method_hashes_[i];
+      // There are no duplicate signatures in `java.lang.Object`, so use
+      // `HashSet<>::PutWithHash()`. This avoids equality comparison for the three
+      // `java.lang.Object.wait()` overloads.
+      super_vtable_signatures.PutWithHash(i, hash);
+      if (hashes != nullptr) {
+        hashes[i] = hash;
+      }
+    }
+    // Insert the remaining indexes, check for duplicate signatures.
     for (size_t i = mirror::Object::kVTableLength; i < super_vtable_length; ++i) {
       // Use `super_vtable_accessor` for getting the method for hash calculation.
       // Letting `HashSet<>::insert()` use the internal accessor copy in the hash
       // function prevents the compiler from optimizing this properly because the
       // compiler cannot prove that the accessor copy is immutable.
       size_t hash = ComputeMethodHash(super_vtable_accessor.GetVTableEntry(i));
+      if (hashes != nullptr) {
+        hashes[i] = hash;
+      }
       auto [it, inserted] = super_vtable_signatures.InsertWithHash(i, hash);
       if (UNLIKELY(!inserted)) {
-        if (same_signature_vtable_lists.empty()) {
-          same_signature_vtable_lists = ArrayRef<uint32_t>(
-              allocator_.AllocArray<uint32_t>(super_vtable_length), super_vtable_length);
-          std::fill_n(same_signature_vtable_lists.data(), super_vtable_length, dex::kDexNoIndex);
+        if (lists == nullptr) {
+          lists = allocator_.AllocArray<uint32_t>(super_vtable_length);
+          std::fill_n(lists, super_vtable_length, dex::kDexNoIndex);
         }
         DCHECK_LT(*it, i);
-        same_signature_vtable_lists[i] = *it;
+        lists[i] = *it;
         *it = i;
       }
     }
+    if (lists != nullptr) {
+      same_signature_vtable_lists = ArrayRef<const uint32_t>(lists, super_vtable_length);
+    }
+    if (record_signatures) {
+      // Both the class table and the LinearAlloc belong to the superclass loader, so
+      // the recorded data lives as long as the superclass.
+      const size_t size = 1u + (lists != nullptr ? 2u : 1u) * super_vtable_length;
+      LinearAlloc* linear_alloc =
+          class_linker_->GetAllocatorForClassLoader(super_class->GetClassLoader());
+      uint32_t* data = linear_alloc->AllocArray<uint32_t>(self_, size);
+      data[0] = (lists != nullptr) ? 1u : 0u;
+      std::copy_n(hashes, super_vtable_length, data + 1u);
+      if (lists != nullptr) {
+        std::copy_n(lists, super_vtable_length, data + 1u + super_vtable_length);
+      }
+      super_class_table->SetVTableSignatures(super_class->GetMethodsPtr(), data);
+    }
   }
 
   // For each declared virtual method, look for a superclass virtual method
@@ -9814,6 +10062,11 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
   ReaderMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
   os << "Zygote loaded classes=" << NumZygoteClasses() << " post zygote classes="
      << NumNonZygoteClasses() << "\n";
+  os << "Class path searches skipped by descriptor filters="
+     << descriptor_filter_skips_.load(std::memory_order_relaxed)
+     << " false positives=" << descriptor_filter_false_positives_.load(std::memory_order_relaxed)
+     << " unfiltered misses=" << unfiltered_class_path_misses_.load(std::memory_order_relaxed)
+     << "\n";
   ReaderMutexLock mu2(soa.Self(), *Locks::dex_lock_);
   os << "Dumping registered class loaders\n";
   size_t class_loader_index = 0;
@@ -244,6 +244,10 @@ class ClassLinker {
 
   void DumpForSigQuit(std::ostream& os) REQUIRES(!Locks::classlinker_classes_lock_);
 
+  // Build the descriptor filter of the boot class path unless an up-to-date one exists.
+  // The zygote builds it before forking so that apps share it, see ClassDescriptorFilter.
+  void EnsureBootClassPathDescriptorFilter() REQUIRES_SHARED(Locks::mutator_lock_);
+
   size_t NumLoadedClasses()
       REQUIRES(!Locks::classlinker_classes_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -704,6 +708,24 @@ class ClassLinker {
       REQUIRES(!Locks::classlinker_classes_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Allocate memory for a native dex cache array in `alloc`, reusing the memory of a replaced
+  // array if possible. The memory is zero-initialized.
+  void* AllocDexCacheArray(Thread* self, LinearAlloc* alloc, size_t size)
+      REQUIRES(Locks::dex_cache_lock_);
+
+  // Record that a native dex cache array in `alloc` was replaced. Readers may still use it,
+  // so its memory is reused only after RecycleDexCacheArrays() ran a checkpoint.
+  void RetireDexCacheArray(Thread* self, LinearAlloc* alloc, void* data, size_t size)
+      REQUIRES(Locks::dex_cache_lock_);
+
+  // Add a heap task that calls RecycleDexCacheArrays(), unless one is already pending.
+  void ScheduleRecycleDexCacheArrays(Thread* self) REQUIRES(!Locks::dex_cache_lock_);
+
+  // Run an empty checkpoint, then make the dex cache arrays retired before it reusable.
+  void RecycleDexCacheArrays(Thread* self)
+      REQUIRES(!Locks::dex_cache_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // May be called with null class_loader due to legacy code. b/27954959
   void InsertDexFileInToClassLoader(ObjPtr<mirror::Object> dex_file,
                                     ObjPtr<mirror::ClassLoader> class_loader)
@@ -1051,6 +1073,17 @@ class ClassLinker {
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::dex_lock_);
 
+  // Searches the boot class path for the class definition. Skips the search if the descriptor
+  // filter of the boot class path shows that no dex file defines the class.
+  std::pair<const DexFile*, const dex::ClassDef*> FindInBootClassPath(const char* descriptor,
+                                                                      size_t hash)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void BuildClassLoaderDescriptorFilter(ScopedObjectAccessAlreadyRunnable& soa,
+                                        Handle<mirror::ClassLoader> class_loader,
+                                        ClassTable* class_table)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Implementation of LookupResolvedType() called when the type was not found in the dex cache.
   ObjPtr<mirror::Class> DoLookupResolvedType(dex::TypeIndex type_idx,
                                              ObjPtr<mirror::Class> referrer)
@@ -1301,6 +1334,25 @@ class ClassLinker {
   // the classes into the class_table_ to avoid dex cache based searches.
   Atomic<uint32_t> failed_dex_cache_class_lookups_;
 
+  // Class path searches skipped thanks to a descriptor filter, searches that a filter did not
+  // skip but that found no class, and searches that found no class without a usable filter.
+  Atomic<uint64_t> descriptor_filter_skips_;
+  Atomic<uint64_t> descriptor_filter_false_positives_;
+  Atomic<uint64_t> unfiltered_class_path_misses_;
+
+  // Memory of native dex cache arrays replaced by larger ones. Retired arrays may still be
+  // used by readers, free ones are reused by AllocDexCacheArray().
+  struct DexCacheArrayBlock {
+    LinearAlloc* alloc;
+    void* data;
+    size_t size;
+    uint64_t retire_seq;
+  };
+  std::vector<DexCacheArrayBlock> retired_dex_cache_arrays_ GUARDED_BY(Locks::dex_cache_lock_);
+  std::vector<DexCacheArrayBlock> free_dex_cache_arrays_ GUARDED_BY(Locks::dex_cache_lock_);
+  uint64_t next_dex_cache_array_retire_seq_ GUARDED_BY(Locks::dex_cache_lock_);
+  Atomic<bool> recycle_dex_cache_arrays_pending_;
+
   // Well known mirror::Class roots.
   GcRoot<mirror::ObjectArray<mirror::Class>> class_roots_;
 
@@ -1351,6 +1403,7 @@ class ClassLinker {
   std::unique_ptr<ClassHierarchyAnalysis> cha_;
 
   class FindVirtualMethodHolderVisitor;
+  class RecycleDexCacheArraysTask;
 
   friend class AppImageLoadingHelper;
   friend class ImageDumper;  // for DexLock
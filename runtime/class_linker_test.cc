@@ -27,6 +27,7 @@
 #include "base/enums.h"
 #include "class_linker-inl.h"
 #include "class_root-inl.h"
+#include "class_table.h"
 #include "common_runtime_test.h"
 #include "dex/dex_file_types.h"
 #include "dex/signature-inl.h"
@@ -1354,6 +1355,92 @@ TEST_F(ClassLinkerTest, ErroneousClass) {
   EXPECT_TRUE(klass->GetIfTable() != nullptr);
 }
 
+// Subclasses of a class with a long vtable are linked with the signature hashes recorded
+// for its vtable from the third subclass on. Check that they get the same vtable indexes,
+// also when the vtable has two package-private methods with the same signature.
+TEST_F(ClassLinkerTest, LongVTableWithSameSignatures) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<3> hs(soa.Self());
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(LoadDex("LongVTable"))));
+  auto find_class = [&](const char* descriptor) REQUIRES_SHARED(Locks::mutator_lock_) {
+    ObjPtr<mirror::Class> klass = class_linker_->FindClass(soa.Self(), descriptor, class_loader);
+    EXPECT_TRUE(klass != nullptr) << descriptor;
+    EXPECT_TRUE(klass == nullptr || klass->IsResolved()) << descriptor;
+    return klass;
+  };
+  auto find_method = [](ObjPtr<mirror::Class> klass, const char* name)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    ArtMethod* method = klass->FindDeclaredVirtualMethodByName(name, kRuntimePointerSize);
+    EXPECT_TRUE(method != nullptr) << name;
+    return method;
+  };
+
+  Handle<mirror::Class> base = hs.NewHandle(find_class("Lvtable1/Base;"));
+  Handle<mirror::Class> mid = hs.NewHandle(find_class("Lvtable2/Mid;"));
+  ASSERT_TRUE(base != nullptr);
+  ASSERT_TRUE(mid != nullptr);
+  ArtMethod* base_m = find_method(base.Get(), "m");
+  ArtMethod* base_v00 = find_method(base.Get(), "v00");
+  ArtMethod* mid_m = find_method(mid.Get(), "m");
+  ASSERT_TRUE(base_m != nullptr);
+  ASSERT_TRUE(base_v00 != nullptr);
+  ASSERT_TRUE(mid_m != nullptr);
+  const int32_t mid_vtable_length = mid->GetVTableLength();
+  ASSERT_GE(mid_vtable_length, 64);
+  ASSERT_EQ(base->GetVTableLength() + 1, mid_vtable_length);
+  ASSERT_NE(base_m->GetMethodIndex(), mid_m->GetMethodIndex());
+  EXPECT_EQ(mid_m->GetMethodIndex(), base->GetVTableLength());
+
+  // The first subclass is linked without recorded hashes, the second one records them.
+  for (const char* descriptor : { "Lvtable2/First;", "Lvtable2/Second;" }) {
+    ObjPtr<mirror::Class> klass = find_class(descriptor);
+    ASSERT_TRUE(klass != nullptr);
+    ASSERT_EQ(mid_vtable_length, klass->GetVTableLength()) << descriptor;
+    EXPECT_EQ(base_m, klass->GetVTableEntry(base_m->GetMethodIndex(), kRuntimePointerSize));
+    EXPECT_EQ(mid_m, klass->GetVTableEntry(mid_m->GetMethodIndex(), kRuntimePointerSize));
+  }
+  ClassTable* class_table = class_linker_->ClassTableForClassLoader(class_loader.Get());
+  ASSERT_TRUE(class_table != nullptr);
+  bool first_use = false;
+  ASSERT_TRUE(class_table->GetVTableSignatures(mid->GetMethodsPtr(), &first_use) != nullptr);
+
+  // In the package of Base, m() overrides Base.m() but not the inaccessible Mid.m().
+  ObjPtr<mirror::Class> sub_in_base_package = find_class("Lvtable1/SubInBasePackage;");
+  ASSERT_TRUE(sub_in_base_package != nullptr);
+  ASSERT_EQ(mid_vtable_length, sub_in_base_package->GetVTableLength());
+  ArtMethod* method = find_method(sub_in_base_package, "m");
+  ASSERT_TRUE(method != nullptr);
+  EXPECT_EQ(base_m->GetMethodIndex(), method->GetMethodIndex());
+  EXPECT_EQ(mid_m,
+            sub_in_base_package->GetVTableEntry(mid_m->GetMethodIndex(), kRuntimePointerSize));
+  method = find_method(sub_in_base_package, "v00");
+  ASSERT_TRUE(method != nullptr);
+  EXPECT_EQ(base_v00->GetMethodIndex(), method->GetMethodIndex());
+
+  // In the package of Mid, m() overrides Mid.m() but not the inaccessible Base.m().
+  ObjPtr<mirror::Class> sub_in_mid_package = find_class("Lvtable2/SubInMidPackage;");
+  ASSERT_TRUE(sub_in_mid_package != nullptr);
+  ASSERT_EQ(mid_vtable_length, sub_in_mid_package->GetVTableLength());
+  method = find_method(sub_in_mid_package, "m");
+  ASSERT_TRUE(method != nullptr);
+  EXPECT_EQ(mid_m->GetMethodIndex(), method->GetMethodIndex());
+  EXPECT_EQ(base_m,
+            sub_in_mid_package->GetVTableEntry(base_m->GetMethodIndex(), kRuntimePointerSize));
+
+  // In another package, m() overrides neither and gets a new vtable index.
+  ObjPtr<mirror::Class> sub_in_other_package = find_class("Lvtable3/SubInOtherPackage;");
+  ASSERT_TRUE(sub_in_other_package != nullptr);
+  ASSERT_EQ(mid_vtable_length + 1, sub_in_other_package->GetVTableLength());
+  method = find_method(sub_in_other_package, "m");
+  ASSERT_TRUE(method != nullptr);
+  EXPECT_EQ(mid_vtable_length, method->GetMethodIndex());
+  EXPECT_EQ(base_m,
+            sub_in_other_package->GetVTableEntry(base_m->GetMethodIndex(), kRuntimePointerSize));
+  EXPECT_EQ(mid_m,
+            sub_in_other_package->GetVTableEntry(mid_m->GetMethodIndex(), kRuntimePointerSize));
+}
+
 TEST_F(ClassLinkerTest, FinalizableBit) {
   ScopedObjectAccess soa(Thread::Current());
   ObjPtr<mirror::Class> c;
@@ -68,6 +68,20 @@ inline bool IsDelegateLastClassLoader(ScopedObjectAccessAlreadyRunnable& soa,
       soa.Decode<mirror::Class>(WellKnownClasses::dalvik_system_DelegateLastClassLoader);
 }
 
+// Returns the DexPathList.dexElements array of the given classloader, or null if it has none.
+// This function assumes that the given classloader is a subclass of BaseDexClassLoader!
+inline ObjPtr<mirror::Object> GetClassLoaderDexElements(Handle<mirror::ClassLoader> class_loader)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  ObjPtr<mirror::Object> dex_path_list =
+      jni::DecodeArtField(WellKnownClasses::dalvik_system_BaseDexClassLoader_pathList)->
+          GetObject(class_loader.Get());
+  if (dex_path_list == nullptr) {
+    return nullptr;
+  }
+  return jni::DecodeArtField(WellKnownClasses::dalvik_system_DexPathList_dexElements)->
+      GetObject(dex_path_list);
+}
+
 // Visit the DexPathList$Element instances in the given classloader with the given visitor.
 // Constraints on the visitor:
 //   * The visitor should return true to continue visiting more Elements.
@@ -81,29 +95,22 @@ inline RetType VisitClassLoaderDexElements(ScopedObjectAccessAlreadyRunnable& so
                                            RetType defaultReturn)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   Thread* self = soa.Self();
-  ObjPtr<mirror::Object> dex_path_list =
-      jni::DecodeArtField(WellKnownClasses::dalvik_system_BaseDexClassLoader_pathList)->
-          GetObject(class_loader.Get());
-  if (dex_path_list != nullptr) {
-    // DexPathList has an array dexElements of Elements[] which each contain a dex file.
-    ObjPtr<mirror::Object> dex_elements_obj =
-        jni::DecodeArtField(WellKnownClasses::dalvik_system_DexPathList_dexElements)->
-            GetObject(dex_path_list);
-    // Loop through each dalvik.system.DexPathList$Element's dalvik.system.DexFile and look
-    // at the mCookie which is a DexFile vector.
-    if (dex_elements_obj != nullptr) {
-      StackHandleScope<1> hs(self);
-      Handle<mirror::ObjectArray<mirror::Object>> dex_elements =
-          hs.NewHandle(dex_elements_obj->AsObjectArray<mirror::Object>());
-      for (auto element : dex_elements.Iterate<mirror::Object>()) {
-        if (element == nullptr) {
-          // Should never happen, fail.
-          break;
-        }
-        RetType ret_value;
-        if (!fn(element, &ret_value)) {
-          return ret_value;
-        }
+  // DexPathList has an array dexElements of Elements[] which each contain a dex file.
+  ObjPtr<mirror::Object> dex_elements_obj = GetClassLoaderDexElements(class_loader);
+  // Loop through each dalvik.system.DexPathList$Element's dalvik.system.DexFile and look
+  // at the mCookie which is a DexFile vector.
+  if (dex_elements_obj != nullptr) {
+    StackHandleScope<1> hs(self);
+    Handle<mirror::ObjectArray<mirror::Object>> dex_elements =
+        hs.NewHandle(dex_elements_obj->AsObjectArray<mirror::Object>());
+    for (auto element : dex_elements.Iterate<mirror::Object>()) {
+      if (element == nullptr) {
+        // Should never happen, fail.
+        break;
+      }
+      RetType ret_value;
+      if (!fn(element, &ret_value)) {
+        return ret_value;
       }
     }
   }
@@ -82,6 +82,11 @@ void ClassTable::VisitRoots(Visitor& visitor) {
       visitor.VisitRootIfNonNull(root.AddressWithoutBarrier());
     }
   }
+  // Older filters no longer match any class path and their roots are not used.
+  const ClassDescriptorFilter* filter = class_descriptor_filter_.load(std::memory_order_relaxed);
+  if (filter != nullptr) {
+    visitor.VisitRootIfNonNull(filter->GetDexElementsRoot().AddressWithoutBarrier());
+  }
 }
 
 template<class Visitor>
@@ -100,6 +105,11 @@ void ClassTable::VisitRoots(const Visitor& visitor) {
       visitor.VisitRootIfNonNull(root.AddressWithoutBarrier());
     }
   }
+  // Older filters no longer match any class path and their roots are not used.
+  const ClassDescriptorFilter* filter = class_descriptor_filter_.load(std::memory_order_relaxed);
+  if (filter != nullptr) {
+    visitor.VisitRootIfNonNull(filter->GetDexElementsRoot().AddressWithoutBarrier());
+  }
 }
 
 template <ReadBarrierOption kReadBarrierOption, typename Visitor>
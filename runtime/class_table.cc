@@ -22,15 +22,22 @@
 
 namespace art {
 
-ClassTable::ClassTable() : lock_("Class loader classes", kClassLoaderClassesLock) {
+ClassTable::ClassTable()
+    : lock_("Class loader classes", kClassLoaderClassesLock),
+      lookup_snapshot_(nullptr),
+      removal_sequence_(0u),
+      class_descriptor_filter_(nullptr),
+      num_unfiltered_misses_(0u) {
   Runtime* const runtime = Runtime::Current();
   classes_.push_back(ClassSet(runtime->GetHashTableMinLoadFactor(),
                               runtime->GetHashTableMaxLoadFactor()));
+  PublishLookupSnapshotLocked();
 }
 
 void ClassTable::FreezeSnapshot() {
   WriterMutexLock mu(Thread::Current(), lock_);
   classes_.push_back(ClassSet());
+  PublishLookupSnapshotLocked();
 }
 
 ObjPtr<mirror::Class> ClassTable::UpdateClass(const char* descriptor,
@@ -55,7 +62,8 @@ ObjPtr<mirror::Class> ClassTable::UpdateClass(const char* descriptor,
   CHECK(!klass->IsTemp()) << descriptor;
   VerifyObject(klass);
   // Update the element in the hash set with the new class. This is safe to do since the descriptor
-  // doesn't change.
+  // doesn't change. Lock-free lookups that find the new class must also see its fields.
+  std::atomic_thread_fence(std::memory_order_release);
   *existing_it = TableSlot(klass, hash);
   return existing;
 }
@@ -101,6 +109,11 @@ size_t ClassTable::NumReferencedNonZygoteClasses() const {
 
 ObjPtr<mirror::Class> ClassTable::Lookup(const char* descriptor, size_t hash) {
   DescriptorHashPair pair(descriptor, hash);
+  bool retry = false;
+  ObjPtr<mirror::Class> result = LookupLockFree(pair, hash, &retry);
+  if (LIKELY(!retry)) {
+    return result;
+  }
   ReaderMutexLock mu(Thread::Current(), lock_);
   for (ClassSet& class_set : classes_) {
     auto it = class_set.FindWithHash(pair, hash);
@@ -111,22 +124,132 @@ ObjPtr<mirror::Class> ClassTable::Lookup(const char* descriptor, size_t hash) {
   return nullptr;
 }
 
+ObjPtr<mirror::Class> ClassTable::LookupLockFree(const DescriptorHashPair& pair,
+                                                 size_t hash,
+                                                 bool* retry) {
+  uint32_t sequence = removal_sequence_.load(std::memory_order_acquire);
+  const LookupSnapshot* snapshot = lookup_snapshot_.load(std::memory_order_acquire);
+  ClassDescriptorEquals equals;
+  for (const SetView& view : *snapshot) {
+    if (view.num_buckets == 0u) {
+      continue;
+    }
+    // Same probe sequence as HashSet::FindIndex(). Copy each slot before looking at it, as
+    // a concurrent removal may clear it.
+    size_t index = hash % view.num_buckets;
+    while (true) {
+      TableSlot slot(view.data[index]);
+      if (slot.IsNull()) {
+        break;
+      }
+      if (slot.MaskedHashEquals(pair.second)) {
+        // Pairs with the release fence of the writer that stored the class into the slot.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (equals(slot, pair)) {
+          return slot.Read();
+        }
+      }
+      index = (index + 1u != view.num_buckets) ? index + 1u : 0u;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  *retry = (sequence & 1u) != 0u || removal_sequence_.load(std::memory_order_relaxed) != sequence;
+  return nullptr;
+}
+
 void ClassTable::Insert(ObjPtr<mirror::Class> klass) {
   InsertWithHash(klass, TableSlot::HashDescriptor(klass));
 }
 
 void ClassTable::InsertWithHash(ObjPtr<mirror::Class> klass, size_t hash) {
   WriterMutexLock mu(Thread::Current(), lock_);
+  if (classes_.back().size() >= classes_.back().ElementsUntilExpand()) {
+    // Inserting would resize storage that lock-free lookups may be probing.
+    GrowLastSetLocked();
+  }
+  // Lock-free lookups that find the class must also see its fields.
+  std::atomic_thread_fence(std::memory_order_release);
   classes_.back().InsertWithHash(TableSlot(klass, hash), hash);
 }
 
+void ClassTable::GrowLastSetLocked() {
+  ClassSet& last = classes_.back();
+  ClassSet grown(last.GetMinLoadFactor(), last.GetMaxLoadFactor());
+  // Reserve the size that HashSet::Expand() would use, size() / min load factor buckets.
+  grown.reserve(
+      static_cast<size_t>(last.size() * last.GetMaxLoadFactor() / last.GetMinLoadFactor()));
+  for (const TableSlot& slot : last) {
+    grown.Put(slot);
+  }
+  retired_sets_.push_back(std::move(last));
+  last = std::move(grown);
+  PublishLookupSnapshotLocked();
+}
+
+void ClassTable::PublishLookupSnapshotLocked() {
+  std::unique_ptr<LookupSnapshot> snapshot(new LookupSnapshot());
+  snapshot->reserve(classes_.size());
+  for (const ClassSet& class_set : classes_) {
+    snapshot->push_back(SetView{class_set.Data(), class_set.NumBuckets()});
+  }
+  lookup_snapshot_.store(snapshot.get(), std::memory_order_release);
+  lookup_snapshots_.push_back(std::move(snapshot));
+}
+
+void ClassTable::SetClassDescriptorFilter(std::unique_ptr<const ClassDescriptorFilter> filter) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  class_descriptor_filter_.store(filter.get(), std::memory_order_release);
+  class_descriptor_filters_.push_back(std::move(filter));
+}
+
+bool ClassTable::IsUnresolvableDescriptor(std::string_view descriptor) const {
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  return unresolvable_descriptors_.find(descriptor) != unresolvable_descriptors_.end();
+}
+
+void ClassTable::AddUnresolvableDescriptor(std::string_view descriptor) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  unresolvable_descriptors_.insert(std::string(descriptor));
+}
+
+const uint32_t* ClassTable::GetVTableSignatures(const void* methods, /*out*/ bool* first_use) {
+  DCHECK(methods != nullptr);
+  Thread* self = Thread::Current();
+  {
+    ReaderMutexLock mu(self, lock_);
+    auto it = vtable_signatures_.find(methods);
+    if (it != vtable_signatures_.end()) {
+      *first_use = false;
+      return it->second;
+    }
+  }
+  WriterMutexLock mu(self, lock_);
+  auto [it, inserted] = vtable_signatures_.insert(
+      std::make_pair(methods, static_cast<const uint32_t*>(nullptr)));
+  *first_use = inserted;
+  return it->second;
+}
+
+void ClassTable::SetVTableSignatures(const void* methods, const uint32_t* signatures) {
+  DCHECK(signatures != nullptr);
+  WriterMutexLock mu(Thread::Current(), lock_);
+  auto [it, inserted] = vtable_signatures_.insert(std::make_pair(methods, signatures));
+  if (!inserted && it->second == nullptr) {
+    // Keep the first recorded signatures if another thread linked a subclass concurrently.
+    it->second = signatures;
+  }
+}
+
 bool ClassTable::Remove(const char* descriptor) {
   DescriptorHashPair pair(descriptor, ComputeModifiedUtf8Hash(descriptor));
   WriterMutexLock mu(Thread::Current(), lock_);
   for (ClassSet& class_set : classes_) {
     auto it = class_set.find(pair);
     if (it != class_set.end()) {
+      removal_sequence_.fetch_add(1u, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
       class_set.erase(it);
+      removal_sequence_.fetch_add(1u, std::memory_order_release);
       return true;
     }
   }
@@ -177,6 +300,7 @@ size_t ClassTable::ReadFromMemory(uint8_t* ptr) {
 void ClassTable::AddClassSet(ClassSet&& set) {
   WriterMutexLock mu(Thread::Current(), lock_);
   classes_.insert(classes_.begin(), std::move(set));
+  PublishLookupSnapshotLocked();
 }
 
 void ClassTable::ClearStrongRoots() {
@@ -17,14 +17,19 @@
 #ifndef ART_RUNTIME_CLASS_TABLE_H_
 #define ART_RUNTIME_CLASS_TABLE_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "base/allocator.h"
+#include "base/hash_map.h"
 #include "base/hash_set.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_descriptor_filter.h"
 #include "gc_root.h"
 #include "obj_ptr.h"
 
@@ -199,6 +204,7 @@ class ClassTable {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Return the first class that matches the descriptor. Returns null if there are none.
+  // Does not take `lock_` unless a class is being removed concurrently.
   ObjPtr<mirror::Class> Lookup(const char* descriptor, size_t hash)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -257,7 +263,69 @@ class ClassTable {
     return lock_;
   }
 
+  // Returns the filter over the classes that the dex files of the class loader define, or null
+  // if none has been built. The caller checks that the filter still matches the dex files.
+  const ClassDescriptorFilter* GetClassDescriptorFilter() const {
+    return class_descriptor_filter_.load(std::memory_order_acquire);
+  }
+
+  // Replace the filter. The old one is kept until the table is destroyed, as lock-free readers
+  // may still be using it.
+  void SetClassDescriptorFilter(std::unique_ptr<const ClassDescriptorFilter> filter)
+      REQUIRES(!lock_);
+
+  // Count a search of the dex files of the class loader that did not find the class and could
+  // not use a filter. Returns true every kUnfilteredMissesPerFilterBuild misses, when the caller
+  // should build a new filter.
+  bool CountUnfilteredMiss() {
+    uint32_t old_misses = num_unfiltered_misses_.fetch_add(1u, std::memory_order_relaxed);
+    return (old_misses + 1u) % kUnfilteredMissesPerFilterBuild == 0u;
+  }
+
+  static constexpr uint32_t kUnfilteredMissesPerFilterBuild = 16u;
+
+  // Descriptors that the verifier failed to resolve with this class loader. Only recorded by the
+  // AOT compiler, which does not add dex files to class loaders once it has started verifying.
+  bool IsUnresolvableDescriptor(std::string_view descriptor) const REQUIRES(!lock_);
+  void AddUnresolvableDescriptor(std::string_view descriptor) REQUIRES(!lock_);
+
+  // Signature hashes of the vtable of a class defined by this class loader, recorded while
+  // linking its subclasses. The class is identified by its methods array, which does not move.
+  // Returns null if none are recorded and sets `*first_use` if the class was not seen before.
+  const uint32_t* GetVTableSignatures(const void* methods, /*out*/ bool* first_use)
+      REQUIRES(!lock_);
+  // The `signatures` must be allocated in the LinearAlloc of the class loader.
+  void SetVTableSignatures(const void* methods, const uint32_t* signatures) REQUIRES(!lock_);
+
  private:
+  // Lock-free lookups probe the bucket storage of `classes_` through a snapshot published with
+  // release semantics. Writers never resize the storage of a published set. A full set is
+  // replaced by a larger copy instead and any change to `classes_` publishes a new snapshot.
+  // The replaced storage and old snapshots are kept until the table is destroyed, since
+  // readers may still be probing them.
+  //
+  // Slots are stored and loaded with relaxed atomics. A writer issues a release fence before
+  // storing a new class into a slot, and a reader issues an acquire fence after loading a slot
+  // whose hash bits match and before dereferencing the class. So a reader that finds a class
+  // also sees the descriptor and status written before it was inserted.
+  struct SetView {
+    const TableSlot* data;
+    size_t num_buckets;
+  };
+  using LookupSnapshot = std::vector<SetView>;
+
+  // Returns null if not found. Sets `*retry` if the miss may be due to a concurrent removal.
+  ObjPtr<mirror::Class> LookupLockFree(const DescriptorHashPair& pair, size_t hash, bool* retry)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Replace the last class set with a copy that has room for more classes.
+  void GrowLastSetLocked()
+      REQUIRES(lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void PublishLookupSnapshotLocked() REQUIRES(lock_);
+
   size_t CountDefiningLoaderClasses(ObjPtr<mirror::ClassLoader> defining_loader,
                                     const ClassSet& set) const
       REQUIRES(lock_)
@@ -272,12 +340,29 @@ class ClassTable {
   mutable ReaderWriterMutex lock_;
   // We have a vector to help prevent dirty pages after the zygote forks by calling FreezeSnapshot.
   std::vector<ClassSet> classes_ GUARDED_BY(lock_);
+  // Storage of class sets replaced by GrowLastSetLocked().
+  std::vector<ClassSet> retired_sets_ GUARDED_BY(lock_);
+  // The snapshot used by lock-free lookups, and all snapshots published so far.
+  std::atomic<const LookupSnapshot*> lookup_snapshot_;
+  std::vector<std::unique_ptr<const LookupSnapshot>> lookup_snapshots_ GUARDED_BY(lock_);
+  // Odd while a class is being removed. Erasing shifts other classes back along their probe
+  // sequences, so a lock-free lookup that misses while this changes retries under `lock_`.
+  Atomic<uint32_t> removal_sequence_;
   // Extra strong roots that can be either dex files or dex caches. Dex files used by the class
   // loader which may not be owned by the class loader must be held strongly live. Also dex caches
   // are held live to prevent them being unloading once they have classes in them.
   std::vector<GcRoot<mirror::Object>> strong_roots_ GUARDED_BY(lock_);
   // Keep track of oat files with GC roots associated with dex caches in `strong_roots_`.
   std::vector<const OatFile*> oat_files_ GUARDED_BY(lock_);
+  // The filter used by lock-free lookups, and all filters built so far.
+  std::atomic<const ClassDescriptorFilter*> class_descriptor_filter_;
+  std::vector<std::unique_ptr<const ClassDescriptorFilter>> class_descriptor_filters_
+      GUARDED_BY(lock_);
+  std::atomic<uint32_t> num_unfiltered_misses_;
+  HashSet<std::string> unresolvable_descriptors_ GUARDED_BY(lock_);
+  // Maps a methods array to the signatures of the vtable of its class, null until the class
+  // has been seen twice.
+  HashMap<const void*, const uint32_t*> vtable_signatures_ GUARDED_BY(lock_);
 
   friend class linker::ImageWriter;  // for InsertWithoutLocks.
 };
@@ -27,6 +27,7 @@
 #include "mirror/class-alloc-inl.h"
 #include "obj_ptr.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace mirror {
@@ -161,5 +162,96 @@ TEST_F(ClassTableTest, ClassTable) {
   // TODO: Add tests for UpdateClass, InsertOatFile.
 }
 
+// Checks that lookups racing with insertions, removals and set growth find every inserted
+// class. The boot image classes used here are fully initialized before the test starts, so
+// this does not check the publication of class fields to lock-free readers. That relies on
+// the fences described in ClassTable and can only fail on weakly ordered CPUs.
+TEST_F(ClassTableTest, LookupWhileInserting) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  // Boot image classes do not move, so the lookup threads can compare raw pointers.
+  std::vector<std::pair<std::string, mirror::Class*>> classes;
+  ClassFuncVisitor visitor([&classes](ObjPtr<mirror::Class> klass)
+                               REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (Runtime::Current()->GetHeap()->ObjectIsInBootImageSpace(klass)) {
+      std::string temp;
+      classes.emplace_back(klass->GetDescriptor(&temp), klass.Ptr());
+    }
+    return true;
+  });
+  class_linker_->VisitClasses(&visitor);
+  // Enough classes for the table to replace its class set a few times.
+  ASSERT_GT(classes.size(), 2000u);
+  // Inserted and removed while the other classes are looked up.
+  std::pair<std::string, mirror::Class*> removed = classes.back();
+  classes.pop_back();
+
+  ClassTable table;
+  std::atomic<size_t> num_inserted(0u);
+  std::atomic<size_t> num_failures(0u);
+  static constexpr size_t kNumThreads = 4u;
+  ThreadPool thread_pool("Class table test thread pool", kNumThreads);
+  for (size_t i = 0; i != kNumThreads; ++i) {
+    thread_pool.AddTask(self, new FunctionTask([&](Thread* worker) {
+      ScopedObjectAccess worker_soa(worker);
+      size_t checked = 0u;
+      while (checked != classes.size()) {
+        checked = num_inserted.load(std::memory_order_acquire);
+        for (size_t j = 0; j != checked; ++j) {
+          const char* descriptor = classes[j].first.c_str();
+          if (table.Lookup(descriptor, ComputeModifiedUtf8Hash(descriptor)) != classes[j].second) {
+            num_failures.fetch_add(1u, std::memory_order_relaxed);
+          }
+        }
+      }
+    }));
+  }
+  thread_pool.StartWorkers(self);
+  for (size_t i = 0; i != classes.size(); ++i) {
+    table.Insert(classes[i].second);
+    num_inserted.store(i + 1u, std::memory_order_release);
+    if (i % 100u == 0u) {
+      // Removals move other classes around, lookups racing with them must still find those.
+      table.Insert(removed.second);
+      EXPECT_TRUE(table.Remove(removed.first.c_str()));
+    }
+  }
+  {
+    ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+    thread_pool.Wait(self, /*do_work=*/ false, /*may_hold_locks=*/ false);
+  }
+  EXPECT_EQ(num_failures.load(), 0u);
+  EXPECT_EQ(table.NumReferencedNonZygoteClasses(), classes.size());
+  EXPECT_EQ(table.NumReferencedZygoteClasses(), 0u);
+}
+
+TEST_F(ClassTableTest, UnresolvableDescriptors) {
+  ScopedObjectAccess soa(Thread::Current());
+  ClassTable table;
+  EXPECT_FALSE(table.IsUnresolvableDescriptor("LMissing;"));
+  table.AddUnresolvableDescriptor("LMissing;");
+  table.AddUnresolvableDescriptor("LMissing;");
+  EXPECT_TRUE(table.IsUnresolvableDescriptor("LMissing;"));
+  EXPECT_TRUE(table.IsUnresolvableDescriptor(std::string_view("LMissing;Other", 9u)));
+  EXPECT_FALSE(table.IsUnresolvableDescriptor("LMissing2;"));
+}
+
+TEST_F(ClassTableTest, VTableSignatures) {
+  ScopedObjectAccess soa(Thread::Current());
+  ClassTable table;
+  static const uint32_t kSignatures[] = { 0u, 1u, 2u };
+  static const uint32_t kOtherSignatures[] = { 0u, 3u, 4u };
+  const void* methods = &table;
+  bool first_use = false;
+  EXPECT_EQ(nullptr, table.GetVTableSignatures(methods, &first_use));
+  EXPECT_TRUE(first_use);
+  EXPECT_EQ(nullptr, table.GetVTableSignatures(methods, &first_use));
+  EXPECT_FALSE(first_use);
+  table.SetVTableSignatures(methods, kSignatures);
+  table.SetVTableSignatures(methods, kOtherSignatures);
+  EXPECT_EQ(kSignatures, table.GetVTableSignatures(methods, &first_use));
+  EXPECT_FALSE(first_use);
+}
+
 }  // namespace mirror
 }  // namespace art
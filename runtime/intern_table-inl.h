@@ -82,6 +82,44 @@ inline bool InternTable::StringEquals::operator()(const GcRoot<mirror::String>&
   }
 }
 
+template <typename Key>
+inline ObjPtr<mirror::String> InternTable::Table::FindLockFree(const Key& key,
+                                                               /*out*/ bool* retry) const {
+  const size_t hash = StringHash()(key);
+  uint32_t sequence = removal_sequence_.load(std::memory_order_acquire);
+  const LookupSnapshot* snapshot = lookup_snapshot_.load(std::memory_order_acquire);
+  StringEquals equals;
+  for (const SetView& view : *snapshot) {
+    if (view.num_buckets == 0u) {
+      continue;
+    }
+    // Same probe sequence as HashSet::FindIndex(). Copy each slot before looking at it, as
+    // a concurrent removal may clear it.
+    size_t index = hash % view.num_buckets;
+    while (true) {
+      GcRoot<mirror::String> slot(view.data[index]);
+      if (slot.IsNull()) {
+        break;
+      }
+      if (equals(slot, key)) {
+        return slot.Read();
+      }
+      index = (index + 1u != view.num_buckets) ? index + 1u : 0u;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  *retry = (sequence & 1u) != 0u || removal_sequence_.load(std::memory_order_relaxed) != sequence;
+  return nullptr;
+}
+
+// NO_THREAD_SAFETY_ANALYSIS: The lock-free lookup reads `strong_interns_` without the lock.
+template <typename Key>
+inline ObjPtr<mirror::String> InternTable::LookupStrongLockFree(const Key& key,
+                                                                /*out*/ bool* retry)
+    NO_THREAD_SAFETY_ANALYSIS {
+  return strong_interns_.FindLockFree(key, retry);
+}
+
 template <typename Visitor>
 inline void InternTable::AddImageStringsToTable(gc::space::ImageSpace* image_space,
                                                 const Visitor& visitor) {
@@ -128,6 +166,7 @@ inline void InternTable::Table::AddInternStrings(UnorderedSet&& intern_strings,
   // Insert at the front since we add new interns into the back.
   tables_.insert(tables_.begin(),
                  InternalTable(std::move(intern_strings), is_boot_image));
+  PublishLookupSnapshot();
 }
 
 template <typename Visitor>
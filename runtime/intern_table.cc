@@ -96,6 +96,11 @@ ObjPtr<mirror::String> InternTable::LookupWeak(Thread* self, ObjPtr<mirror::Stri
 }
 
 ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self, ObjPtr<mirror::String> s) {
+  bool retry = false;
+  ObjPtr<mirror::String> result = LookupStrongLockFree(GcRoot<mirror::String>(s), &retry);
+  if (LIKELY(!retry)) {
+    return result;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
   return LookupStrongLocked(s);
 }
@@ -104,8 +109,17 @@ ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self,
                                                  uint32_t utf16_length,
                                                  const char* utf8_data) {
   int32_t hash = Utf8String::Hash(utf16_length, utf8_data);
+  return LookupStrong(self, Utf8String(utf16_length, utf8_data, hash));
+}
+
+ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self, const Utf8String& string) {
+  bool retry = false;
+  ObjPtr<mirror::String> result = LookupStrongLockFree(string, &retry);
+  if (LIKELY(!retry)) {
+    return result;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
-  return strong_interns_.Find(Utf8String(utf16_length, utf8_data, hash));
+  return strong_interns_.Find(string);
 }
 
 ObjPtr<mirror::String> InternTable::LookupWeakLocked(ObjPtr<mirror::String> s) {
@@ -201,6 +215,13 @@ ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
   if (s == nullptr) {
     return nullptr;
   }
+  // Strings interned again are usually strong interns already, look for them without the lock.
+  // A miss is checked again with the lock held below.
+  bool retry = false;
+  ObjPtr<mirror::String> strong = LookupStrongLockFree(GcRoot<mirror::String>(s), &retry);
+  if (strong != nullptr) {
+    return strong;
+  }
   Thread* const self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
   if (kDebugLocking && !holding_locks) {
@@ -255,12 +276,8 @@ ObjPtr<mirror::String> InternTable::InternStrong(uint32_t utf16_length, const ch
   DCHECK(utf8_data != nullptr);
   int32_t hash = Utf8String::Hash(utf16_length, utf8_data);
   Thread* self = Thread::Current();
-  ObjPtr<mirror::String> s;
-  {
-    // Try to avoid allocation. If we need to allocate, release the mutex before the allocation.
-    MutexLock mu(self, *Locks::intern_table_lock_);
-    s = strong_interns_.Find(Utf8String(utf16_length, utf8_data, hash));
-  }
+  // Try to avoid allocation. The lookup does not hold the mutex across the allocation.
+  ObjPtr<mirror::String> s = LookupStrong(self, Utf8String(utf16_length, utf8_data, hash));
   if (s != nullptr) {
     return s;
   }
@@ -317,7 +334,10 @@ void InternTable::Table::Remove(ObjPtr<mirror::String> s) {
   for (InternalTable& table : tables_) {
     auto it = table.set_.find(GcRoot<mirror::String>(s));
     if (it != table.set_.end()) {
+      removal_sequence_.fetch_add(1u, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
       table.set_.erase(it);
+      removal_sequence_.fetch_add(1u, std::memory_order_release);
       return;
     }
   }
@@ -348,15 +368,47 @@ ObjPtr<mirror::String> InternTable::Table::Find(const Utf8String& string) {
 
 void InternTable::Table::AddNewTable() {
   tables_.push_back(InternalTable());
+  PublishLookupSnapshot();
 }
 
 void InternTable::Table::Insert(ObjPtr<mirror::String> s) {
   // Always insert the last table, the image tables are before and we avoid inserting into these
   // to prevent dirty pages.
   DCHECK(!tables_.empty());
+  UnorderedSet& set = tables_.back().set_;
+  if (set.size() >= set.ElementsUntilExpand()) {
+    // Inserting would resize storage that lock-free lookups may be probing.
+    GrowLastTable();
+  }
+  // Lock-free lookups that find the string must also see its contents.
+  std::atomic_thread_fence(std::memory_order_release);
   tables_.back().set_.insert(GcRoot<mirror::String>(s));
 }
 
+void InternTable::Table::GrowLastTable() {
+  UnorderedSet& last = tables_.back().set_;
+  UnorderedSet grown(last.GetMinLoadFactor(), last.GetMaxLoadFactor());
+  // Reserve the size that HashSet::Expand() would use, size() / min load factor buckets.
+  grown.reserve(
+      static_cast<size_t>(last.size() * last.GetMaxLoadFactor() / last.GetMinLoadFactor()));
+  for (const GcRoot<mirror::String>& root : last) {
+    grown.Put(root);
+  }
+  retired_sets_.push_back(std::move(last));
+  last = std::move(grown);
+  PublishLookupSnapshot();
+}
+
+void InternTable::Table::PublishLookupSnapshot() {
+  std::unique_ptr<LookupSnapshot> snapshot(new LookupSnapshot());
+  snapshot->reserve(tables_.size());
+  for (const InternalTable& table : tables_) {
+    snapshot->push_back(SetView{table.set_.Data(), table.set_.NumBuckets()});
+  }
+  lookup_snapshot_.store(snapshot.get(), std::memory_order_release);
+  lookup_snapshots_.push_back(std::move(snapshot));
+}
+
 void InternTable::Table::VisitRoots(RootVisitor* visitor) {
   BufferedRootVisitor<kDefaultBufferedRootCount> buffered_visitor(
       visitor, RootInfo(kRootInternedString));
@@ -409,12 +461,13 @@ void InternTable::ChangeWeakRootStateLocked(gc::WeakRootState new_state) {
   }
 }
 
-InternTable::Table::Table() {
+InternTable::Table::Table() : lookup_snapshot_(nullptr), removal_sequence_(0u) {
   Runtime* const runtime = Runtime::Current();
   InternalTable initial_table;
   initial_table.set_.SetLoadFactor(runtime->GetHashTableMinLoadFactor(),
                                    runtime->GetHashTableMaxLoadFactor());
   tables_.push_back(std::move(initial_table));
+  PublishLookupSnapshot();
 }
 
 }  // namespace art
@@ -17,7 +17,12 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "base/allocator.h"
+#include "base/atomic.h"
 #include "base/hash_set.h"
 #include "base/mutex.h"
 #include "gc/weak_root_state.h"
@@ -53,6 +58,9 @@ class Transaction;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * Strong interns are looked up without taking Locks::intern_table_lock_, so that resolving string
+ * literals and interning strings that are interned already do not contend with insertions.
  */
 class InternTable {
  public:
@@ -146,7 +154,8 @@ class InternTable {
   bool ContainsWeak(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::intern_table_lock_);
 
-  // Lookup a strong intern, returns null if not found.
+  // Lookup a strong intern, returns null if not found. Does not take `Locks::intern_table_lock_`
+  // unless a string is being removed concurrently.
   ObjPtr<mirror::String> LookupStrong(Thread* self, ObjPtr<mirror::String> s)
       REQUIRES(!Locks::intern_table_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -245,6 +254,12 @@ class InternTable {
         REQUIRES(Locks::intern_table_lock_);
     ObjPtr<mirror::String> Find(const Utf8String& string) REQUIRES_SHARED(Locks::mutator_lock_)
         REQUIRES(Locks::intern_table_lock_);
+    // Find without holding `Locks::intern_table_lock_`. Returns null if not found and sets
+    // `*retry` if the miss may be due to a concurrent removal. The `key` is either a
+    // `GcRoot<mirror::String>` or a `Utf8String`.
+    template <typename Key>
+    ObjPtr<mirror::String> FindLockFree(const Key& key, /*out*/ bool* retry) const
+        REQUIRES_SHARED(Locks::mutator_lock_);
     void Insert(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_)
         REQUIRES(Locks::intern_table_lock_);
     void Remove(ObjPtr<mirror::String> s)
@@ -265,9 +280,26 @@ class InternTable {
         REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
    private:
+    // Lock-free lookups probe the storage of the sets through a snapshot published with release
+    // semantics. Insertions never resize the storage of a published set. A full set is replaced
+    // by a larger copy instead and any change to `tables_` publishes a new snapshot. The replaced
+    // storage and old snapshots are kept until the table is destroyed, since readers may still
+    // be probing them. Only the strong interns are read this way, weak interns may be cleared
+    // by the GC and are only read with the lock held.
+    struct SetView {
+      const GcRoot<mirror::String>* data;
+      size_t num_buckets;
+    };
+    using LookupSnapshot = std::vector<SetView>;
+
     void SweepWeaks(UnorderedSet* set, IsMarkedVisitor* visitor)
         REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
 
+    // Replace the set of the last table with a copy that has room for more strings.
+    void GrowLastTable() REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+
+    void PublishLookupSnapshot() REQUIRES(Locks::intern_table_lock_);
+
     // Add a table to the front of the tables vector.
     void AddInternStrings(UnorderedSet&& intern_strings, bool is_boot_image)
         REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
@@ -275,12 +307,30 @@ class InternTable {
     // We call AddNewTable when we create the zygote to reduce private dirty pages caused by
     // modifying the zygote intern table. The back of table is modified when strings are interned.
     std::vector<InternalTable> tables_;
+    // Storage of sets replaced by GrowLastTable().
+    std::vector<UnorderedSet> retired_sets_;
+    // The snapshot used by lock-free lookups, and all snapshots published so far.
+    std::atomic<const LookupSnapshot*> lookup_snapshot_;
+    std::vector<std::unique_ptr<const LookupSnapshot>> lookup_snapshots_;
+    // Odd while a string is being removed. Erasing shifts other strings back along their probe
+    // sequences, so a lock-free lookup that misses while this changes retries under the lock.
+    Atomic<uint32_t> removal_sequence_;
 
     friend class InternTable;
     friend class linker::ImageWriter;
     ART_FRIEND_TEST(InternTableTest, CrossHash);
   };
 
+  // Lookup a strong intern without holding `Locks::intern_table_lock_`, see
+  // Table::FindLockFree().
+  template <typename Key>
+  ObjPtr<mirror::String> LookupStrongLockFree(const Key& key, /*out*/ bool* retry)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  ObjPtr<mirror::String> LookupStrong(Thread* self, const Utf8String& string)
+      REQUIRES(!Locks::intern_table_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Insert if non null, otherwise return null. Must be called holding the mutator lock.
   // If holding_locks is true, then we may also hold other locks. If holding_locks is true, then we
   // require GC is not running since it is not safe to wait while holding locks.
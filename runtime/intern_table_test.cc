@@ -16,6 +16,10 @@
 
 #include "intern_table-inl.h"
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "base/hash_set.h"
 #include "common_runtime_test.h"
 #include "dex/utf.h"
@@ -24,6 +28,7 @@
 #include "mirror/object.h"
 #include "mirror/string.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -234,4 +239,51 @@ TEST_F(InternTableTest, LookupStrong) {
   EXPECT_TRUE(lookup_foobbS == nullptr);
 }
 
+TEST_F(InternTableTest, LookupStrongWhileInterning) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  // Enough strings for the table to replace its set a few times.
+  static constexpr size_t kNumStrings = 5000u;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i != kNumStrings; ++i) {
+    strings.push_back("intern" + std::to_string(i));
+  }
+
+  InternTable intern_table;
+  std::atomic<size_t> num_interned(0u);
+  std::atomic<size_t> num_failures(0u);
+  static constexpr size_t kNumThreads = 4u;
+  ThreadPool thread_pool("Intern table test thread pool", kNumThreads);
+  for (size_t i = 0; i != kNumThreads; ++i) {
+    thread_pool.AddTask(self, new FunctionTask([&](Thread* worker) {
+      ScopedObjectAccess worker_soa(worker);
+      size_t checked = 0u;
+      while (checked != strings.size()) {
+        // Interning allocates, let the GC suspend this thread.
+        worker->AllowThreadSuspension();
+        checked = num_interned.load(std::memory_order_acquire);
+        for (size_t j = 0; j != checked; ++j) {
+          const std::string& str = strings[j];
+          ObjPtr<mirror::String> result =
+              intern_table.LookupStrong(worker, str.length(), str.c_str());
+          if (result == nullptr || !result->Equals(str.c_str())) {
+            num_failures.fetch_add(1u, std::memory_order_relaxed);
+          }
+        }
+      }
+    }));
+  }
+  thread_pool.StartWorkers(self);
+  for (size_t i = 0; i != strings.size(); ++i) {
+    EXPECT_TRUE(intern_table.InternStrong(strings[i].length(), strings[i].c_str()) != nullptr);
+    num_interned.store(i + 1u, std::memory_order_release);
+  }
+  {
+    ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+    thread_pool.Wait(self, /*do_work=*/ false, /*may_hold_locks=*/ false);
+  }
+  EXPECT_EQ(num_failures.load(), 0u);
+  EXPECT_EQ(intern_table.StrongSize(), strings.size());
+}
+
 }  // namespace art
@@ -503,6 +503,11 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(MathRoundDouble /* (D)J */)
     UNIMPLEMENTED_CASE(MathRoundFloat /* (F)I */)
     UNIMPLEMENTED_CASE(MathMultiplyHigh /* (JJ)J */)
+    UNIMPLEMENTED_CASE(ArraysEqualsByte /* ([B[B)Z */)
+    UNIMPLEMENTED_CASE(ArraysEqualsInt /* ([I[I)Z */)
+    UNIMPLEMENTED_CASE(ArraysFillByte /* ([BB)V */)
+    UNIMPLEMENTED_CASE(ArraysFillInt /* ([II)V */)
+    UNIMPLEMENTED_CASE(ArraysHashCodeInt /* ([I)I */)
     UNIMPLEMENTED_CASE(SystemArrayCopyByte /* ([BI[BII)V */)
     UNIMPLEMENTED_CASE(SystemArrayCopyChar /* ([CI[CII)V */)
     UNIMPLEMENTED_CASE(SystemArrayCopyInt /* ([II[III)V */)
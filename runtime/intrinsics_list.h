@@ -159,6 +159,11 @@
   V(MathRoundDouble, kStatic, kNeedsEnvironment, kNoSideEffects, kNoThrow, "Ljava/lang/Math;", "round", "(D)J") \
   V(MathRoundFloat, kStatic, kNeedsEnvironment, kNoSideEffects, kNoThrow, "Ljava/lang/Math;", "round", "(F)I") \
   V(MathMultiplyHigh, kStatic, kNeedsEnvironment, kNoSideEffects, kNoThrow, "Ljava/lang/Math;", "multiplyHigh", "(JJ)J") \
+  V(ArraysEqualsByte, kStatic, kNeedsEnvironment, kReadSideEffects, kNoThrow, "Ljava/util/Arrays;", "equals", "([B[B)Z") \
+  V(ArraysEqualsInt, kStatic, kNeedsEnvironment, kReadSideEffects, kNoThrow, "Ljava/util/Arrays;", "equals", "([I[I)Z") \
+  V(ArraysFillByte, kStatic, kNeedsEnvironment, kAllSideEffects, kCanThrow, "Ljava/util/Arrays;", "fill", "([BB)V") \
+  V(ArraysFillInt, kStatic, kNeedsEnvironment, kAllSideEffects, kCanThrow, "Ljava/util/Arrays;", "fill", "([II)V") \
+  V(ArraysHashCodeInt, kStatic, kNeedsEnvironment, kReadSideEffects, kNoThrow, "Ljava/util/Arrays;", "hashCode", "([I)I") \
   V(SystemArrayCopyByte, kStatic, kNeedsEnvironment, kAllSideEffects, kCanThrow, "Ljava/lang/System;", "arraycopy", "([BI[BII)V") \
   V(SystemArrayCopyChar, kStatic, kNeedsEnvironment, kAllSideEffects, kCanThrow, "Ljava/lang/System;", "arraycopy", "([CI[CII)V") \
   V(SystemArrayCopyInt, kStatic, kNeedsEnvironment, kAllSideEffects, kCanThrow, "Ljava/lang/System;", "arraycopy", "([II[III)V") \
@@ -1581,7 +1581,11 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
       }
       if (!profile_classes.empty()) {
         inline_caches.emplace_back(/*ProfileMethodInfo::ProfileInlineCache*/
-            cache.dex_pc_, is_missing_types, profile_classes);
+            cache.dex_pc_,
+            is_missing_types,
+            profile_classes,
+            /*megamorphic=*/ false,
+            cache.count_);
       }
     }
     methods.emplace_back(/*ProfileMethodInfo*/
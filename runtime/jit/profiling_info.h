@@ -50,9 +50,20 @@ class InlineCache {
     return MemberOffset(OFFSETOF_MEMBER(InlineCache, classes_));
   }
 
+  static constexpr MemberOffset CountOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(InlineCache, count_));
+  }
+
+  uint32_t GetCount() const {
+    return count_;
+  }
+
  private:
   uint32_t dex_pc_;
   GcRoot<mirror::Class> classes_[kIndividualCacheSize];
+  // Number of times the INVOKE was executed by baseline compiled code. The increments
+  // are not atomic for performance reasons, so we accept races, like for hotness counts.
+  uint32_t count_;
 
   friend class jit::JitCodeCache;
   friend class ProfilingInfo;
@@ -83,6 +94,10 @@ class ProfilingInfo {
 
   InlineCache* GetInlineCache(uint32_t dex_pc);
 
+  // Returns the number of times the INVOKE at `dex_pc` was executed, or 0 if
+  // the instruction is not profiled.
+  uint32_t GetInvokeCount(uint32_t dex_pc) const;
+
   // Increments the number of times this method is currently being inlined.
   // Returns whether it was successful, that is it could increment without
   // overflowing.
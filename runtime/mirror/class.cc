@@ -46,6 +46,7 @@
 #include "jni_id_type.h"
 #include "subtype_check.h"
 #include "method.h"
+#include "oat_file.h"
 #include "object-inl.h"
 #include "object-refvisitor-inl.h"
 #include "object_array-alloc-inl.h"
@@ -1731,7 +1732,7 @@ uint32_t Class::Depth() {
 
 dex::TypeIndex Class::FindTypeIndexInOtherDexFile(const DexFile& dex_file) {
   std::string temp;
-  const dex::TypeId* type_id = dex_file.FindTypeId(GetDescriptor(&temp));
+  const dex::TypeId* type_id = OatDexFile::FindTypeId(dex_file, GetDescriptor(&temp));
   return (type_id == nullptr) ? dex::TypeIndex() : dex_file.GetIndexForTypeId(*type_id);
 }
 
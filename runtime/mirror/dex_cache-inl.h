@@ -59,6 +59,15 @@ T* DexCache::AllocArray(MemberOffset obj_offset, MemberOffset num_offset, size_t
   if (num == 0) {
     return nullptr;
   }
+  return ReplaceArray<T>(obj_offset, num_offset, num, /*old_array=*/ nullptr);
+}
+
+template<typename T>
+T* DexCache::ReplaceArray(MemberOffset obj_offset,
+                          MemberOffset num_offset,
+                          size_t num,
+                          T* old_array) {
+  DCHECK_NE(num, 0u);
   mirror::DexCache* dex_cache = this;
   if (kUseReadBarrier && Thread::Current()->GetIsGcMarking()) {
     // Several code paths use DexCache without read-barrier for performance.
@@ -70,14 +79,73 @@ T* DexCache::AllocArray(MemberOffset obj_offset, MemberOffset num_offset, size_t
   LinearAlloc* alloc = linker->GetOrCreateAllocatorForClassLoader(GetClassLoader());
   MutexLock mu(self, *Locks::dex_cache_lock_);  // Avoid allocation by multiple threads.
   T* array = dex_cache->GetFieldPtr64<T*>(obj_offset);
-  if (array != nullptr) {
+  if (array != old_array) {
     DCHECK(alloc->Contains(array));
-    return array;  // Other thread just allocated the array.
+    return array;  // Other thread just allocated or replaced the array.
   }
-  array = reinterpret_cast<T*>(alloc->AllocAlign16(self, RoundUp(num * sizeof(T), 16)));
+  static_assert(sizeof(NativeArrayHeader) == 16u);
+  void* data = linker->AllocDexCacheArray(self, alloc, ArraySizeInBytes<T>(num));
+  NativeArrayHeader* header = new (data) NativeArrayHeader();
+  header->num_slots = dchecked_integral_cast<uint32_t>(num);
+  header->num_conflicts.store(0u, std::memory_order_relaxed);
+  array = reinterpret_cast<T*>(header + 1);
   InitializeArray(array);  // Ensure other threads see the array initialized.
-  dex_cache->SetField32Volatile<false, false>(num_offset, num);
+  // Readers take the number of slots from the header, so a larger array can be published
+  // before its size.
   dex_cache->SetField64Volatile<false, false>(obj_offset, reinterpret_cast64<uint64_t>(array));
+  dex_cache->SetField32Volatile<false, false>(num_offset, num);
+  if (old_array != nullptr) {
+    // Readers that loaded the old array may still use it, so it is only reused after
+    // every thread passed a checkpoint.
+    linker->RetireDexCacheArray(self,
+                                alloc,
+                                GetArrayHeader(old_array),
+                                ArraySizeInBytes<T>(GetArrayHeader(old_array)->num_slots));
+  }
+  return array;
+}
+
+template<typename T, size_t kMaxCacheSize>
+T* DexCache::PrepareStore(MemberOffset obj_offset,
+                          MemberOffset num_offset,
+                          size_t num_ids,
+                          uint32_t idx,
+                          /*out*/ uint32_t* slot_idx) {
+  metrics::ArtMetrics* metrics = GetMetrics();
+  metrics->DexCacheStoreCount()->AddOne();
+  T* array = GetFieldPtr64<T*>(obj_offset);
+  if (UNLIKELY(array == nullptr)) {
+    array = AllocArray<T, kMaxCacheSize>(obj_offset, num_offset, num_ids);
+  }
+  NativeArrayHeader* header = GetArrayHeader(array);
+  uint32_t num_slots = header->num_slots;
+  *slot_idx = SlotIndex(idx, num_slots);
+  uint32_t old_idx;
+  if constexpr (std::is_same_v<T, FieldDexCacheType> || std::is_same_v<T, MethodDexCacheType>) {
+    old_idx = GetNativePair(array, *slot_idx).index;
+  } else {
+    old_idx = array[*slot_idx].load(std::memory_order_relaxed).index;
+  }
+  if (old_idx == idx || old_idx == T::value_type::InvalidIndexForSlot(*slot_idx)) {
+    return array;
+  }
+  // The slot holds the entry for another index which we are about to evict.
+  metrics->DexCacheConflictCount()->AddOne();
+  const size_t max_slots = std::min(num_ids, kMaxCacheSize * kDexCacheMaxGrowthFactor);
+  uint32_t num_conflicts = header->num_conflicts.fetch_add(1u, std::memory_order_relaxed) + 1u;
+  if (LIKELY(num_conflicts != num_slots * kDexCacheConflictsPerSlotToGrow) ||
+      num_slots >= max_slots) {
+    return array;
+  }
+  // Start over with an empty array twice as large, or with a slot for each index if that
+  // is not larger. Entries are not copied; they are resolved again when needed.
+  size_t new_num_slots = 2u * num_slots;
+  if (new_num_slots >= num_ids) {
+    new_num_slots = num_ids;
+  }
+  array = ReplaceArray<T>(obj_offset, num_offset, new_num_slots, array);
+  Runtime::Current()->GetClassLinker()->ScheduleRecycleDexCacheArrays(Thread::Current());
+  *slot_idx = SlotIndex(idx, GetArrayHeader(array)->num_slots);
   return array;
 }
 
@@ -115,11 +183,10 @@ inline uint32_t DexCache::ClassSize(PointerSize pointer_size) {
   return Class::ComputeClassSize(true, vtable_entries, 0, 0, 0, 0, 0, pointer_size);
 }
 
-inline uint32_t DexCache::StringSlotIndex(dex::StringIndex string_idx) {
+inline uint32_t DexCache::StringSlotIndex(StringDexCacheType* strings,
+                                          dex::StringIndex string_idx) {
   DCHECK_LT(string_idx.index_, GetDexFile()->NumStringIds());
-  const uint32_t slot_idx = string_idx.index_ % kDexCacheStringCacheSize;
-  DCHECK_LT(slot_idx, NumStrings());
-  return slot_idx;
+  return SlotIndex(string_idx.index_, NumSlots(strings));
 }
 
 inline String* DexCache::GetResolvedString(dex::StringIndex string_idx) {
@@ -127,18 +194,20 @@ inline String* DexCache::GetResolvedString(dex::StringIndex string_idx) {
   if (UNLIKELY(strings == nullptr)) {
     return nullptr;
   }
-  return strings[StringSlotIndex(string_idx)].load(
+  return strings[StringSlotIndex(strings, string_idx)].load(
       std::memory_order_relaxed).GetObjectForIndex(string_idx.index_);
 }
 
 inline void DexCache::SetResolvedString(dex::StringIndex string_idx, ObjPtr<String> resolved) {
   DCHECK(resolved != nullptr);
-  StringDexCacheType* strings = GetStrings();
-  if (UNLIKELY(strings == nullptr)) {
-    strings = AllocArray<StringDexCacheType, kDexCacheStringCacheSize>(
-        StringsOffset(), NumStringsOffset(), GetDexFile()->NumStringIds());
-  }
-  strings[StringSlotIndex(string_idx)].store(
+  uint32_t slot_idx;
+  StringDexCacheType* strings = PrepareStore<StringDexCacheType, kDexCacheStringCacheSize>(
+      StringsOffset(),
+      NumStringsOffset(),
+      GetDexFile()->NumStringIds(),
+      string_idx.index_,
+      &slot_idx);
+  strings[slot_idx].store(
       StringDexCachePair(resolved, string_idx.index_), std::memory_order_relaxed);
   Runtime* const runtime = Runtime::Current();
   if (UNLIKELY(runtime->IsActiveTransaction())) {
@@ -151,11 +220,11 @@ inline void DexCache::SetResolvedString(dex::StringIndex string_idx, ObjPtr<Stri
 
 inline void DexCache::ClearString(dex::StringIndex string_idx) {
   DCHECK(Runtime::Current()->IsAotCompiler());
-  uint32_t slot_idx = StringSlotIndex(string_idx);
   StringDexCacheType* strings = GetStrings();
   if (UNLIKELY(strings == nullptr)) {
     return;
   }
+  uint32_t slot_idx = StringSlotIndex(strings, string_idx);
   StringDexCacheType* slot = &strings[slot_idx];
   // This is racy but should only be called from the transactional interpreter.
   if (slot->load(std::memory_order_relaxed).index == string_idx.index_) {
@@ -164,11 +233,10 @@ inline void DexCache::ClearString(dex::StringIndex string_idx) {
   }
 }
 
-inline uint32_t DexCache::TypeSlotIndex(dex::TypeIndex type_idx) {
+inline uint32_t DexCache::TypeSlotIndex(TypeDexCacheType* resolved_types,
+                                        dex::TypeIndex type_idx) {
   DCHECK_LT(type_idx.index_, GetDexFile()->NumTypeIds());
-  const uint32_t slot_idx = type_idx.index_ % kDexCacheTypeCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedTypes());
-  return slot_idx;
+  return SlotIndex(type_idx.index_, NumSlots(resolved_types));
 }
 
 inline Class* DexCache::GetResolvedType(dex::TypeIndex type_idx) {
@@ -178,23 +246,25 @@ inline Class* DexCache::GetResolvedType(dex::TypeIndex type_idx) {
   if (UNLIKELY(resolved_types == nullptr)) {
     return nullptr;
   }
-  return resolved_types[TypeSlotIndex(type_idx)].load(
+  return resolved_types[TypeSlotIndex(resolved_types, type_idx)].load(
       std::memory_order_relaxed).GetObjectForIndex(type_idx.index_);
 }
 
 inline void DexCache::SetResolvedType(dex::TypeIndex type_idx, ObjPtr<Class> resolved) {
   DCHECK(resolved != nullptr);
   DCHECK(resolved->IsResolved()) << resolved->GetStatus();
-  TypeDexCacheType* resolved_types = GetResolvedTypes();
-  if (UNLIKELY(resolved_types == nullptr)) {
-    resolved_types = AllocArray<TypeDexCacheType, kDexCacheTypeCacheSize>(
-        ResolvedTypesOffset(), NumResolvedTypesOffset(), GetDexFile()->NumTypeIds());
-  }
+  uint32_t slot_idx;
+  TypeDexCacheType* resolved_types = PrepareStore<TypeDexCacheType, kDexCacheTypeCacheSize>(
+      ResolvedTypesOffset(),
+      NumResolvedTypesOffset(),
+      GetDexFile()->NumTypeIds(),
+      type_idx.index_,
+      &slot_idx);
   // TODO default transaction support.
   // Use a release store for SetResolvedType. This is done to prevent other threads from seeing a
   // class but not necessarily seeing the loaded members like the static fields array.
   // See b/32075261.
-  resolved_types[TypeSlotIndex(type_idx)].store(
+  resolved_types[slot_idx].store(
       TypeDexCachePair(resolved, type_idx.index_), std::memory_order_release);
   // TODO: Fine-grained marking, so that we don't need to go through all arrays in full.
   WriteBarrier::ForEveryFieldWrite(this);
@@ -206,7 +276,7 @@ inline void DexCache::ClearResolvedType(dex::TypeIndex type_idx) {
   if (UNLIKELY(resolved_types == nullptr)) {
     return;
   }
-  uint32_t slot_idx = TypeSlotIndex(type_idx);
+  uint32_t slot_idx = TypeSlotIndex(resolved_types, type_idx);
   TypeDexCacheType* slot = &resolved_types[slot_idx];
   // This is racy but should only be called from the single-threaded ImageWriter and tests.
   if (slot->load(std::memory_order_relaxed).index == type_idx.index_) {
@@ -215,12 +285,11 @@ inline void DexCache::ClearResolvedType(dex::TypeIndex type_idx) {
   }
 }
 
-inline uint32_t DexCache::MethodTypeSlotIndex(dex::ProtoIndex proto_idx) {
+inline uint32_t DexCache::MethodTypeSlotIndex(MethodTypeDexCacheType* method_types,
+                                              dex::ProtoIndex proto_idx) {
   DCHECK(Runtime::Current()->IsMethodHandlesEnabled());
   DCHECK_LT(proto_idx.index_, GetDexFile()->NumProtoIds());
-  const uint32_t slot_idx = proto_idx.index_ % kDexCacheMethodTypeCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedMethodTypes());
-  return slot_idx;
+  return SlotIndex(proto_idx.index_, NumSlots(method_types));
 }
 
 inline MethodType* DexCache::GetResolvedMethodType(dex::ProtoIndex proto_idx) {
@@ -228,18 +297,21 @@ inline MethodType* DexCache::GetResolvedMethodType(dex::ProtoIndex proto_idx) {
   if (UNLIKELY(methods == nullptr)) {
     return nullptr;
   }
-  return methods[MethodTypeSlotIndex(proto_idx)].load(
+  return methods[MethodTypeSlotIndex(methods, proto_idx)].load(
       std::memory_order_relaxed).GetObjectForIndex(proto_idx.index_);
 }
 
 inline void DexCache::SetResolvedMethodType(dex::ProtoIndex proto_idx, MethodType* resolved) {
   DCHECK(resolved != nullptr);
-  MethodTypeDexCacheType* methods = GetResolvedMethodTypes();
-  if (UNLIKELY(methods == nullptr)) {
-    methods = AllocArray<MethodTypeDexCacheType, kDexCacheMethodTypeCacheSize>(
-        ResolvedMethodTypesOffset(), NumResolvedMethodTypesOffset(), GetDexFile()->NumProtoIds());
-  }
-  methods[MethodTypeSlotIndex(proto_idx)].store(
+  uint32_t slot_idx;
+  MethodTypeDexCacheType* methods =
+      PrepareStore<MethodTypeDexCacheType, kDexCacheMethodTypeCacheSize>(
+          ResolvedMethodTypesOffset(),
+          NumResolvedMethodTypesOffset(),
+          GetDexFile()->NumProtoIds(),
+          proto_idx.index_,
+          &slot_idx);
+  methods[slot_idx].store(
       MethodTypeDexCachePair(resolved, proto_idx.index_), std::memory_order_relaxed);
   Runtime* const runtime = Runtime::Current();
   if (UNLIKELY(runtime->IsActiveTransaction())) {
@@ -252,8 +324,12 @@ inline void DexCache::SetResolvedMethodType(dex::ProtoIndex proto_idx, MethodTyp
 
 inline void DexCache::ClearMethodType(dex::ProtoIndex proto_idx) {
   DCHECK(Runtime::Current()->IsAotCompiler());
-  uint32_t slot_idx = MethodTypeSlotIndex(proto_idx);
-  MethodTypeDexCacheType* slot = &GetResolvedMethodTypes()[slot_idx];
+  MethodTypeDexCacheType* methods = GetResolvedMethodTypes();
+  if (UNLIKELY(methods == nullptr)) {
+    return;
+  }
+  uint32_t slot_idx = MethodTypeSlotIndex(methods, proto_idx);
+  MethodTypeDexCacheType* slot = &methods[slot_idx];
   // This is racy but should only be called from the transactional interpreter.
   if (slot->load(std::memory_order_relaxed).index == proto_idx.index_) {
     MethodTypeDexCachePair cleared(nullptr,
@@ -301,11 +377,9 @@ inline ObjPtr<CallSite> DexCache::SetResolvedCallSite(uint32_t call_site_idx,
   }
 }
 
-inline uint32_t DexCache::FieldSlotIndex(uint32_t field_idx) {
+inline uint32_t DexCache::FieldSlotIndex(FieldDexCacheType* fields, uint32_t field_idx) {
   DCHECK_LT(field_idx, GetDexFile()->NumFieldIds());
-  const uint32_t slot_idx = field_idx % kDexCacheFieldCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedFields());
-  return slot_idx;
+  return SlotIndex(field_idx, NumSlots(fields));
 }
 
 inline ArtField* DexCache::GetResolvedField(uint32_t field_idx) {
@@ -313,26 +387,26 @@ inline ArtField* DexCache::GetResolvedField(uint32_t field_idx) {
   if (UNLIKELY(fields == nullptr)) {
     return nullptr;
   }
-  auto pair = GetNativePair(fields, FieldSlotIndex(field_idx));
+  auto pair = GetNativePair(fields, FieldSlotIndex(fields, field_idx));
   return pair.GetObjectForIndex(field_idx);
 }
 
 inline void DexCache::SetResolvedField(uint32_t field_idx, ArtField* field) {
   DCHECK(field != nullptr);
   FieldDexCachePair pair(field, field_idx);
-  FieldDexCacheType* fields = GetResolvedFields();
-  if (UNLIKELY(fields == nullptr)) {
-    fields = AllocArray<FieldDexCacheType, kDexCacheFieldCacheSize>(
-        ResolvedFieldsOffset(), NumResolvedFieldsOffset(), GetDexFile()->NumFieldIds());
-  }
-  SetNativePair(fields, FieldSlotIndex(field_idx), pair);
+  uint32_t slot_idx;
+  FieldDexCacheType* fields = PrepareStore<FieldDexCacheType, kDexCacheFieldCacheSize>(
+      ResolvedFieldsOffset(),
+      NumResolvedFieldsOffset(),
+      GetDexFile()->NumFieldIds(),
+      field_idx,
+      &slot_idx);
+  SetNativePair(fields, slot_idx, pair);
 }
 
-inline uint32_t DexCache::MethodSlotIndex(uint32_t method_idx) {
+inline uint32_t DexCache::MethodSlotIndex(MethodDexCacheType* methods, uint32_t method_idx) {
   DCHECK_LT(method_idx, GetDexFile()->NumMethodIds());
-  const uint32_t slot_idx = method_idx % kDexCacheMethodCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedMethods());
-  return slot_idx;
+  return SlotIndex(method_idx, NumSlots(methods));
 }
 
 inline ArtMethod* DexCache::GetResolvedMethod(uint32_t method_idx) {
@@ -340,19 +414,21 @@ inline ArtMethod* DexCache::GetResolvedMethod(uint32_t method_idx) {
   if (UNLIKELY(methods == nullptr)) {
     return nullptr;
   }
-  auto pair = GetNativePair(methods, MethodSlotIndex(method_idx));
+  auto pair = GetNativePair(methods, MethodSlotIndex(methods, method_idx));
   return pair.GetObjectForIndex(method_idx);
 }
 
 inline void DexCache::SetResolvedMethod(uint32_t method_idx, ArtMethod* method) {
   DCHECK(method != nullptr);
   MethodDexCachePair pair(method, method_idx);
-  MethodDexCacheType* methods = GetResolvedMethods();
-  if (UNLIKELY(methods == nullptr)) {
-    methods = AllocArray<MethodDexCacheType, kDexCacheMethodCacheSize>(
-        ResolvedMethodsOffset(), NumResolvedMethodsOffset(), GetDexFile()->NumMethodIds());
-  }
-  SetNativePair(methods, MethodSlotIndex(method_idx), pair);
+  uint32_t slot_idx;
+  MethodDexCacheType* methods = PrepareStore<MethodDexCacheType, kDexCacheMethodCacheSize>(
+      ResolvedMethodsOffset(),
+      NumResolvedMethodsOffset(),
+      GetDexFile()->NumMethodIds(),
+      method_idx,
+      &slot_idx);
+  SetNativePair(methods, slot_idx, pair);
 }
 
 template <typename T>
@@ -379,9 +455,7 @@ inline void VisitDexCachePairs(std::atomic<DexCachePair<T>>* pairs,
                                size_t num_pairs,
                                const Visitor& visitor)
     REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_) {
-  // Check both the data pointer and count since the array might be initialized
-  // concurrently on other thread, and we might observe just one of the values.
-  for (size_t i = 0; pairs != nullptr && i < num_pairs; ++i) {
+  for (size_t i = 0; i < num_pairs; ++i) {
     DexCachePair<T> source = pairs[i].load(std::memory_order_relaxed);
     // NOTE: We need the "template" keyword here to avoid a compilation
     // failure. GcRoot<T> is a template argument-dependent type and we need to
@@ -405,18 +479,22 @@ inline void DexCache::VisitReferences(ObjPtr<Class> klass, const Visitor& visito
   VisitInstanceFieldsReferences<kVerifyFlags, kReadBarrierOption>(klass, visitor);
   // Visit arrays after.
   if (kVisitNativeRoots) {
-    VisitDexCachePairs<String, kReadBarrierOption, Visitor>(
-        GetStrings<kVerifyFlags>(), NumStrings<kVerifyFlags>(), visitor);
+    // Take the number of slots from the array header since the array might be allocated
+    // or replaced concurrently on other thread.
+    StringDexCacheType* strings = GetStrings<kVerifyFlags>();
+    VisitDexCachePairs<String, kReadBarrierOption, Visitor>(strings, NumSlots(strings), visitor);
 
+    TypeDexCacheType* resolved_types = GetResolvedTypes<kVerifyFlags>();
     VisitDexCachePairs<Class, kReadBarrierOption, Visitor>(
-        GetResolvedTypes<kVerifyFlags>(), NumResolvedTypes<kVerifyFlags>(), visitor);
+        resolved_types, NumSlots(resolved_types), visitor);
 
+    MethodTypeDexCacheType* method_types = GetResolvedMethodTypes<kVerifyFlags>();
     VisitDexCachePairs<MethodType, kReadBarrierOption, Visitor>(
-        GetResolvedMethodTypes<kVerifyFlags>(), NumResolvedMethodTypes<kVerifyFlags>(), visitor);
+        method_types, NumSlots(method_types), visitor);
 
     GcRoot<mirror::CallSite>* resolved_call_sites = GetResolvedCallSites<kVerifyFlags>();
-    size_t num_call_sites = NumResolvedCallSites<kVerifyFlags>();
-    for (size_t i = 0; resolved_call_sites != nullptr && i != num_call_sites; ++i) {
+    size_t num_call_sites = NumSlots(resolved_call_sites);
+    for (size_t i = 0; i != num_call_sites; ++i) {
       visitor.VisitRootIfNonNull(resolved_call_sites[i].AddressWithoutBarrier());
     }
   }
@@ -53,10 +53,8 @@ void DexCache::Initialize(const DexFile* dex_file, ObjPtr<ClassLoader> class_loa
 void DexCache::VisitReflectiveTargets(ReflectiveValueVisitor* visitor) {
   bool wrote = false;
   FieldDexCacheType* fields = GetResolvedFields();
-  size_t num_fields = NumResolvedFields();
-  // Check both the data pointer and count since the array might be initialized
-  // concurrently on other thread, and we might observe just one of the values.
-  for (size_t i = 0; fields != nullptr && i < num_fields; i++) {
+  size_t num_fields = NumSlots(fields);
+  for (size_t i = 0; i < num_fields; i++) {
     auto pair(GetNativePair(fields, i));
     if (pair.index == FieldDexCachePair::InvalidIndexForSlot(i)) {
       continue;
@@ -74,10 +72,8 @@ void DexCache::VisitReflectiveTargets(ReflectiveValueVisitor* visitor) {
     }
   }
   MethodDexCacheType* methods = GetResolvedMethods();
-  size_t num_methods = NumResolvedMethods();
-  // Check both the data pointer and count since the array might be initialized
-  // concurrently on other thread, and we might observe just one of the values.
-  for (size_t i = 0; methods != nullptr && i < num_methods; i++) {
+  size_t num_methods = NumSlots(methods);
+  for (size_t i = 0; i < num_methods; i++) {
     auto pair(GetNativePair(methods, i));
     if (pair.index == MethodDexCachePair::InvalidIndexForSlot(i)) {
       continue;
@@ -432,11 +432,16 @@ class MANAGED DexCache final : public Object {
     return sizeof(GcRoot<mirror::String>) * num_strings;
   }
 
-  uint32_t StringSlotIndex(dex::StringIndex string_idx) REQUIRES_SHARED(Locks::mutator_lock_);
-  uint32_t TypeSlotIndex(dex::TypeIndex type_idx) REQUIRES_SHARED(Locks::mutator_lock_);
-  uint32_t FieldSlotIndex(uint32_t field_idx) REQUIRES_SHARED(Locks::mutator_lock_);
-  uint32_t MethodSlotIndex(uint32_t method_idx) REQUIRES_SHARED(Locks::mutator_lock_);
-  uint32_t MethodTypeSlotIndex(dex::ProtoIndex proto_idx) REQUIRES_SHARED(Locks::mutator_lock_);
+  uint32_t StringSlotIndex(StringDexCacheType* strings, dex::StringIndex string_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  uint32_t TypeSlotIndex(TypeDexCacheType* resolved_types, dex::TypeIndex type_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  uint32_t FieldSlotIndex(FieldDexCacheType* fields, uint32_t field_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  uint32_t MethodSlotIndex(MethodDexCacheType* methods, uint32_t method_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  uint32_t MethodTypeSlotIndex(MethodTypeDexCacheType* method_types, dex::ProtoIndex proto_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
   void VisitReflectiveTargets(ReflectiveValueVisitor* visitor) REQUIRES(Locks::mutator_lock_);
 
@@ -445,11 +450,67 @@ class MANAGED DexCache final : public Object {
   ObjPtr<ClassLoader> GetClassLoader() REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  // An array that keeps evicting entries is replaced by a larger one, up to this many times
+  // its initial size, or by one with a slot for each index if that is not larger.
+  static constexpr size_t kDexCacheMaxGrowthFactor = 8;
+
+  // The average number of conflicts per slot after which an array is replaced.
+  static constexpr uint32_t kDexCacheConflictsPerSlotToGrow = 4;
+
+  // Native arrays are preceded by this header. The number of slots of an array never changes,
+  // so readers take it from the array they loaded rather than from the `num_*` fields, which
+  // are updated when an array is replaced by a larger one.
+  struct alignas(16) NativeArrayHeader {
+    uint32_t num_slots;
+    std::atomic<uint32_t> num_conflicts;
+  };
+
+  template <typename T>
+  static NativeArrayHeader* GetArrayHeader(T* array) {
+    return reinterpret_cast<NativeArrayHeader*>(array) - 1;
+  }
+
+  // Returns the size of the memory for a native array with `num` slots, including the header.
+  template <typename T>
+  static size_t ArraySizeInBytes(size_t num) {
+    return sizeof(NativeArrayHeader) + RoundUp(num * sizeof(T), 16);
+  }
+
+  // Returns the number of slots of a native array, or 0 for a null array.
+  template <typename T>
+  static uint32_t NumSlots(T* array) {
+    return (array != nullptr) ? GetArrayHeader(array)->num_slots : 0u;
+  }
+
+  // Returns the slot of `idx` in an array with `num_slots` slots. Arrays that do not have
+  // a slot for each index have a power of two number of slots.
+  static uint32_t SlotIndex(uint32_t idx, uint32_t num_slots) {
+    DCHECK(idx < num_slots || IsPowerOfTwo(num_slots));
+    return LIKELY(idx < num_slots) ? idx : (idx & (num_slots - 1u));
+  }
+
   // Allocate new array in linear alloc and save it in the given fields.
   template<typename T, size_t kMaxCacheSize>
   T* AllocArray(MemberOffset obj_offset, MemberOffset num_offset, size_t num)
      REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Allocate new array in linear alloc and save it in the given fields, unless they no longer
+  // hold `old_array`. Returns the array held by the fields. The memory of a replaced array is
+  // handed to the class linker for reuse.
+  template<typename T>
+  T* ReplaceArray(MemberOffset obj_offset, MemberOffset num_offset, size_t num, T* old_array)
+     REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Returns the array to store the entry for `idx` into, allocating it if needed, and the slot
+  // for `idx` in `slot_idx`. Counts a conflict if the slot holds the entry for another index,
+  // and replaces an array with too many conflicts by a larger one.
+  template<typename T, size_t kMaxCacheSize>
+  T* PrepareStore(MemberOffset obj_offset,
+                  MemberOffset num_offset,
+                  size_t num_ids,
+                  uint32_t idx,
+                  /*out*/ uint32_t* slot_idx) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Visit instance fields of the dex cache as well as its associated arrays.
   template <bool kVisitNativeRoots,
             VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags,
@@ -72,6 +72,54 @@ TEST_F(DexCacheMethodHandlesTest, Open) {
   EXPECT_EQ(0u, dex_cache->NumResolvedMethodTypes());
 }
 
+TEST_F(DexCacheTest, GrowOnConflicts) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<3> hs(soa.Self());
+  ASSERT_TRUE(java_lang_dex_file_ != nullptr);
+  Handle<DexCache> dex_cache(
+      hs.NewHandle(class_linker_->AllocAndInitializeDexCache(
+          soa.Self(), *java_lang_dex_file_, /*class_loader=*/nullptr)));
+  ASSERT_TRUE(dex_cache != nullptr);
+  Handle<String> string = hs.NewHandle(String::AllocFromModifiedUtf8(soa.Self(), "dex cache"));
+  ASSERT_TRUE(string != nullptr);
+
+  // Use twice as many string indexes as there are slots initially, so that they keep evicting
+  // each other until the array is replaced by one with a slot for each of them.
+  const uint32_t num_indexes = 2u * DexCache::StaticStringSize();
+  ASSERT_GT(java_lang_dex_file_->NumStringIds(), num_indexes);
+  metrics::ArtMetrics* metrics = Runtime::Current()->GetMetrics();
+  const uint64_t stores_before = metrics->DexCacheStoreCount()->Value();
+  const uint64_t conflicts_before = metrics->DexCacheConflictCount()->Value();
+  dex_cache->SetResolvedString(dex::StringIndex(0), string.Get());
+  StringDexCacheType* initial_strings = dex_cache->GetStrings();
+  ASSERT_TRUE(initial_strings != nullptr);
+  for (uint32_t i = 0; dex_cache->NumStrings() != num_indexes && i != 100u * num_indexes; ++i) {
+    dex_cache->SetResolvedString(dex::StringIndex(i % num_indexes), string.Get());
+  }
+  ASSERT_EQ(num_indexes, dex_cache->NumStrings());
+  EXPECT_GT(metrics->DexCacheStoreCount()->Value(), stores_before);
+  EXPECT_GT(metrics->DexCacheConflictCount()->Value(), conflicts_before);
+  EXPECT_NE(initial_strings, dex_cache->GetStrings());
+
+  // Once every thread passed a checkpoint, the memory of the replaced array is reused.
+  class_linker_->RecycleDexCacheArrays(soa.Self());
+  Handle<DexCache> other_dex_cache(
+      hs.NewHandle(class_linker_->AllocAndInitializeDexCache(
+          soa.Self(), *java_lang_dex_file_, /*class_loader=*/nullptr)));
+  ASSERT_TRUE(other_dex_cache != nullptr);
+  other_dex_cache->SetResolvedString(dex::StringIndex(0), string.Get());
+  EXPECT_EQ(initial_strings, other_dex_cache->GetStrings());
+  EXPECT_OBJ_PTR_EQ(string.Get(), other_dex_cache->GetResolvedString(dex::StringIndex(0)));
+  EXPECT_TRUE(other_dex_cache->GetResolvedString(dex::StringIndex(1)) == nullptr);
+
+  for (uint32_t i = 0; i != num_indexes; ++i) {
+    dex_cache->SetResolvedString(dex::StringIndex(i), string.Get());
+  }
+  for (uint32_t i = 0; i != num_indexes; ++i) {
+    EXPECT_OBJ_PTR_EQ(string.Get(), dex_cache->GetResolvedString(dex::StringIndex(i))) << i;
+  }
+}
+
 TEST_F(DexCacheTest, TestResolvedFieldAccess) {
   ScopedObjectAccess soa(Thread::Current());
   jobject jclass_loader(LoadDex("Packages"));
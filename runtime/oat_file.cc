@@ -56,6 +56,7 @@
 #include "dex/dex_file_structs.h"
 #include "dex/dex_file_types.h"
 #include "dex/standard_dex_file.h"
+#include "dex/string_lookup_table.h"
 #include "dex/type_lookup_table.h"
 #include "dex/utf-inl.h"
 #include "elf/elf_utils.h"
@@ -460,63 +461,97 @@ static bool ReadIndexBssMapping(OatFile* oat_file,
   return true;
 }
 
-static bool ComputeAndCheckTypeLookupTableData(const DexFile::Header& header,
-                                               const uint8_t* type_lookup_table_start,
-                                               const VdexFile* vdex_file,
-                                               const uint8_t** type_lookup_table_data,
-                                               std::string* error_msg) {
-  if (type_lookup_table_start == nullptr ||
-      reinterpret_cast<const uint32_t*>(type_lookup_table_start)[0] == 0) {
-    *type_lookup_table_data = nullptr;
+// Checks the lookup table of the given `kind` found at `lookup_table_start` in the vdex file,
+// where the table data is preceded by its size, 0 if there is no table.
+static bool ComputeAndCheckLookupTableData(const char* kind,
+                                           size_t expected_table_size,
+                                           const uint8_t* lookup_table_start,
+                                           const VdexFile* vdex_file,
+                                           const uint8_t** lookup_table_data,
+                                           std::string* error_msg) {
+  if (lookup_table_start == nullptr ||
+      reinterpret_cast<const uint32_t*>(lookup_table_start)[0] == 0) {
+    *lookup_table_data = nullptr;
     return true;
   }
 
-  *type_lookup_table_data = type_lookup_table_start + sizeof(uint32_t);
-  size_t expected_table_size = TypeLookupTable::RawDataLength(header.class_defs_size_);
-  size_t found_size = reinterpret_cast<const uint32_t*>(type_lookup_table_start)[0];
+  *lookup_table_data = lookup_table_start + sizeof(uint32_t);
+  size_t found_size = reinterpret_cast<const uint32_t*>(lookup_table_start)[0];
   if (UNLIKELY(found_size != expected_table_size)) {
     *error_msg =
-        StringPrintf("In vdex file '%s' unexpected type lookup table size: found %zu, expected %zu",
+        StringPrintf("In vdex file '%s' unexpected %s lookup table size: found %zu, expected %zu",
                      vdex_file->GetName().c_str(),
+                     kind,
                      found_size,
                      expected_table_size);
     return false;
   }
-  if (UNLIKELY(!vdex_file->Contains(*type_lookup_table_data))) {
+  if (UNLIKELY(!vdex_file->Contains(*lookup_table_data))) {
     *error_msg =
-        StringPrintf("In vdex file '%s' found invalid type lookup table pointer %p not in [%p, %p]",
+        StringPrintf("In vdex file '%s' found invalid %s lookup table pointer %p not in [%p, %p]",
                      vdex_file->GetName().c_str(),
-                     type_lookup_table_data,
+                     kind,
+                     lookup_table_data,
                      vdex_file->Begin(),
                      vdex_file->End());
     return false;
   }
-  if (UNLIKELY(!vdex_file->Contains(*type_lookup_table_data + expected_table_size - 1))) {
+  if (UNLIKELY(!vdex_file->Contains(*lookup_table_data + expected_table_size - 1))) {
     *error_msg =
-        StringPrintf("In vdex file '%s' found overflowing type lookup table %p not in [%p, %p]",
+        StringPrintf("In vdex file '%s' found overflowing %s lookup table %p not in [%p, %p]",
                      vdex_file->GetName().c_str(),
-                     type_lookup_table_data + expected_table_size,
+                     kind,
+                     lookup_table_data + expected_table_size,
                      vdex_file->Begin(),
                      vdex_file->End());
     return false;
   }
-  if (UNLIKELY(!IsAligned<4>(type_lookup_table_start))) {
+  if (UNLIKELY(!IsAligned<4>(lookup_table_start))) {
     *error_msg =
-        StringPrintf("In vdex file '%s' found invalid type lookup table alignment %p",
+        StringPrintf("In vdex file '%s' found invalid %s lookup table alignment %p",
                      vdex_file->GetName().c_str(),
-                     type_lookup_table_start);
+                     kind,
+                     lookup_table_start);
     return false;
   }
   return true;
 }
 
+static bool ComputeAndCheckTypeLookupTableData(const DexFile::Header& header,
+                                               const uint8_t* type_lookup_table_start,
+                                               const VdexFile* vdex_file,
+                                               const uint8_t** type_lookup_table_data,
+                                               std::string* error_msg) {
+  return ComputeAndCheckLookupTableData("type",
+                                        TypeLookupTable::RawDataLength(header.class_defs_size_),
+                                        type_lookup_table_start,
+                                        vdex_file,
+                                        type_lookup_table_data,
+                                        error_msg);
+}
+
+static bool ComputeAndCheckStringLookupTableData(const DexFile::Header& header,
+                                                 const uint8_t* string_lookup_table_start,
+                                                 const VdexFile* vdex_file,
+                                                 const uint8_t** string_lookup_table_data,
+                                                 std::string* error_msg) {
+  return ComputeAndCheckLookupTableData("string",
+                                        StringLookupTable::RawDataLength(header.string_ids_size_),
+                                        string_lookup_table_start,
+                                        vdex_file,
+                                        string_lookup_table_data,
+                                        error_msg);
+}
+
 bool OatFileBase::Setup(const std::vector<const DexFile*>& dex_files, std::string* error_msg) {
   uint32_t i = 0;
   const uint8_t* type_lookup_table_start = nullptr;
+  const uint8_t* string_lookup_table_start = nullptr;
   for (const DexFile* dex_file : dex_files) {
     std::string dex_location = dex_file->GetLocation();
     std::string canonical_location = DexFileLoader::GetDexCanonicalLocation(dex_location.c_str());
 
+    string_lookup_table_start = vdex_->GetNextStringLookupTableData(string_lookup_table_start, i);
     type_lookup_table_start = vdex_->GetNextTypeLookupTableData(type_lookup_table_start, i++);
     const uint8_t* type_lookup_table_data = nullptr;
     if (!ComputeAndCheckTypeLookupTableData(dex_file->GetHeader(),
@@ -526,6 +561,14 @@ bool OatFileBase::Setup(const std::vector<const DexFile*>& dex_files, std::strin
                                             error_msg)) {
       return false;
     }
+    const uint8_t* string_lookup_table_data = nullptr;
+    if (!ComputeAndCheckStringLookupTableData(dex_file->GetHeader(),
+                                              string_lookup_table_start,
+                                              vdex_.get(),
+                                              &string_lookup_table_data,
+                                              error_msg)) {
+      return false;
+    }
     // Create an OatDexFile and add it to the owning container.
     OatDexFile* oat_dex_file = new OatDexFile(
         this,
@@ -533,7 +576,8 @@ bool OatFileBase::Setup(const std::vector<const DexFile*>& dex_files, std::strin
         dex_file->GetLocationChecksum(),
         dex_location,
         canonical_location,
-        type_lookup_table_data);
+        type_lookup_table_data,
+        string_lookup_table_data);
     oat_dex_files_storage_.push_back(oat_dex_file);
 
     // Add the location and canonical location (if different) to the oat_dex_files_ table.
@@ -641,6 +685,7 @@ bool OatFileBase::Setup(int zip_fd,
   size_t dex_filenames_pos = 0u;
   uint32_t dex_file_count = GetOatHeader().GetDexFileCount();
   oat_dex_files_storage_.reserve(dex_file_count);
+  const uint8_t* string_lookup_table_start = nullptr;
   for (size_t i = 0; i < dex_file_count; i++) {
     uint32_t dex_file_location_size;
     if (UNLIKELY(!ReadOatDexFileData(*this, &oat, &dex_file_location_size))) {
@@ -974,6 +1019,18 @@ bool OatFileBase::Setup(int zip_fd,
       return false;
     }
 
+    string_lookup_table_start = (vdex_ != nullptr)
+        ? vdex_->GetNextStringLookupTableData(string_lookup_table_start, i)
+        : nullptr;
+    const uint8_t* string_lookup_table_data = nullptr;
+    if (!ComputeAndCheckStringLookupTableData(*header,
+                                              string_lookup_table_start,
+                                              vdex_.get(),
+                                              &string_lookup_table_data,
+                                              error_msg)) {
+      return false;
+    }
+
     // Create the OatDexFile and add it to the owning container.
     OatDexFile* oat_dex_file = new OatDexFile(
         this,
@@ -982,6 +1039,7 @@ bool OatFileBase::Setup(int zip_fd,
         dex_file_checksum,
         dex_file_pointer,
         lookup_table_data,
+        string_lookup_table_data,
         method_bss_mapping,
         type_bss_mapping,
         public_type_bss_mapping,
@@ -1734,6 +1792,7 @@ class OatFileBackedByVdex final : public OatFileBase {
     if (vdex_file->HasDexSection()) {
       uint32_t i = 0;
       const uint8_t* type_lookup_table_start = nullptr;
+      const uint8_t* string_lookup_table_start = nullptr;
       for (const uint8_t* dex_file_start = vdex_file->GetNextDexFileData(nullptr, i);
            dex_file_start != nullptr;
            dex_file_start = vdex_file->GetNextDexFileData(dex_file_start, ++i)) {
@@ -1774,13 +1833,24 @@ class OatFileBackedByVdex final : public OatFileBase {
                                                 error_msg)) {
           return nullptr;
         }
+        string_lookup_table_start =
+            vdex_file->GetNextStringLookupTableData(string_lookup_table_start, i);
+        const uint8_t* string_lookup_table_data = nullptr;
+        if (!ComputeAndCheckStringLookupTableData(*header,
+                                                  string_lookup_table_start,
+                                                  vdex_file,
+                                                  &string_lookup_table_data,
+                                                  error_msg)) {
+          return nullptr;
+        }
 
         OatDexFile* oat_dex_file = new OatDexFile(oat_file.get(),
                                                   dex_file_start,
                                                   vdex_file->GetLocationChecksum(i),
                                                   location,
                                                   canonical_location,
-                                                  type_lookup_table_data);
+                                                  type_lookup_table_data,
+                                                  string_lookup_table_data);
         oat_file->oat_dex_files_storage_.push_back(oat_dex_file);
 
         std::string_view key(oat_dex_file->GetDexFileLocation());
@@ -2162,6 +2232,7 @@ OatDexFile::OatDexFile(const OatFile* oat_file,
                        uint32_t dex_file_location_checksum,
                        const uint8_t* dex_file_pointer,
                        const uint8_t* lookup_table_data,
+                       const uint8_t* string_lookup_table_data,
                        const IndexBssMapping* method_bss_mapping_data,
                        const IndexBssMapping* type_bss_mapping_data,
                        const IndexBssMapping* public_type_bss_mapping_data,
@@ -2175,6 +2246,7 @@ OatDexFile::OatDexFile(const OatFile* oat_file,
       dex_file_location_checksum_(dex_file_location_checksum),
       dex_file_pointer_(dex_file_pointer),
       lookup_table_data_(lookup_table_data),
+      string_lookup_table_data_(string_lookup_table_data),
       method_bss_mapping_(method_bss_mapping_data),
       type_bss_mapping_(type_bss_mapping_data),
       public_type_bss_mapping_(public_type_bss_mapping_data),
@@ -2184,6 +2256,7 @@ OatDexFile::OatDexFile(const OatFile* oat_file,
       lookup_table_(),
       dex_layout_sections_(dex_layout_sections) {
   InitializeTypeLookupTable();
+  InitializeStringLookupTable();
   DCHECK(!IsBackedByVdexOnly());
 }
 
@@ -2207,19 +2280,31 @@ void OatDexFile::InitializeTypeLookupTable() {
   }
 }
 
+void OatDexFile::InitializeStringLookupTable() {
+  // The size and bounds of the table were checked against the vdex file when it was found.
+  if (string_lookup_table_data_ != nullptr) {
+    const DexFile::Header* dex_header = reinterpret_cast<const DexFile::Header*>(dex_file_pointer_);
+    string_lookup_table_ =
+        StringLookupTable::Open(string_lookup_table_data_, dex_header->string_ids_size_);
+  }
+}
+
 OatDexFile::OatDexFile(const OatFile* oat_file,
                        const uint8_t* dex_file_pointer,
                        uint32_t dex_file_location_checksum,
                        const std::string& dex_file_location,
                        const std::string& canonical_dex_file_location,
-                       const uint8_t* lookup_table_data)
+                       const uint8_t* lookup_table_data,
+                       const uint8_t* string_lookup_table_data)
     : oat_file_(oat_file),
       dex_file_location_(dex_file_location),
       canonical_dex_file_location_(canonical_dex_file_location),
       dex_file_location_checksum_(dex_file_location_checksum),
       dex_file_pointer_(dex_file_pointer),
-      lookup_table_data_(lookup_table_data) {
+      lookup_table_data_(lookup_table_data),
+      string_lookup_table_data_(string_lookup_table_data) {
   InitializeTypeLookupTable();
+  InitializeStringLookupTable();
   DCHECK(IsBackedByVdexOnly());
 }
 
@@ -2347,7 +2432,7 @@ const dex::ClassDef* OatDexFile::FindClassDef(const DexFile& dex_file,
     DCHECK(!used_lookup_table);
     return nullptr;
   }
-  const dex::TypeId* type_id = dex_file.FindTypeId(descriptor);
+  const dex::TypeId* type_id = FindTypeId(dex_file, descriptor);
   if (type_id != nullptr) {
     dex::TypeIndex type_idx = dex_file.GetIndexForTypeId(*type_id);
     const dex::ClassDef* found_class_def = dex_file.FindClassDef(type_idx);
@@ -2359,6 +2444,30 @@ const dex::ClassDef* OatDexFile::FindClassDef(const DexFile& dex_file,
   return nullptr;
 }
 
+const dex::StringId* OatDexFile::FindStringId(const DexFile& dex_file, const char* string) {
+  const OatDexFile* oat_dex_file = dex_file.GetOatDexFile();
+  if (LIKELY(oat_dex_file != nullptr) && oat_dex_file->GetStringLookupTable().Valid()) {
+    uint32_t string_idx = oat_dex_file->GetStringLookupTable().Lookup(dex_file, string);
+    const dex::StringId* string_id = (string_idx != dex::kDexNoIndex)
+        ? &dex_file.GetStringId(dex::StringIndex(string_idx))
+        : nullptr;
+    DCHECK_EQ(string_id, dex_file.FindStringId(string));
+    return string_id;
+  }
+  return dex_file.FindStringId(string);
+}
+
+const dex::TypeId* OatDexFile::FindTypeId(const DexFile& dex_file, const char* descriptor) {
+  const OatDexFile* oat_dex_file = dex_file.GetOatDexFile();
+  if (LIKELY(oat_dex_file != nullptr) && oat_dex_file->GetStringLookupTable().Valid()) {
+    const dex::StringId* string_id = FindStringId(dex_file, descriptor);
+    return (string_id != nullptr)
+        ? dex_file.FindTypeId(dex_file.GetIndexForStringId(*string_id))
+        : nullptr;
+  }
+  return dex_file.FindTypeId(descriptor);
+}
+
 // Madvise the dex file based on the state we are moving to.
 void OatDexFile::MadviseDexFileAtLoad(const DexFile& dex_file) {
   Runtime* const runtime = Runtime::Current();
@@ -30,6 +30,7 @@
 #include "base/tracking_safe_map.h"
 #include "class_status.h"
 #include "dex/dex_file_layout.h"
+#include "dex/string_lookup_table.h"
 #include "dex/type_lookup_table.h"
 #include "dex/utf.h"
 #include "index_bss_mapping.h"
@@ -561,6 +562,11 @@ class OatDexFile final {
                                            const char* descriptor,
                                            size_t hash);
 
+  // Looks up a string id by its contents, or a type id by its descriptor. Use the string lookup
+  // table of the vdex file when there is one, instead of a binary search over the dex file.
+  static const dex::StringId* FindStringId(const DexFile& dex_file, const char* string);
+  static const dex::TypeId* FindTypeId(const DexFile& dex_file, const char* descriptor);
+
   // Madvise the dex file for load-time usage.
   static void MadviseDexFileAtLoad(const DexFile& dex_file);
 
@@ -568,6 +574,10 @@ class OatDexFile final {
     return lookup_table_;
   }
 
+  const StringLookupTable& GetStringLookupTable() const {
+    return string_lookup_table_;
+  }
+
   ~OatDexFile();
 
   // Create only with a type lookup table, used by the compiler to speed up compilation.
@@ -585,6 +595,7 @@ class OatDexFile final {
              uint32_t dex_file_checksum,
              const uint8_t* dex_file_pointer,
              const uint8_t* lookup_table_data,
+             const uint8_t* string_lookup_table_data,
              const IndexBssMapping* method_bss_mapping,
              const IndexBssMapping* type_bss_mapping,
              const IndexBssMapping* public_type_bss_mapping,
@@ -600,10 +611,12 @@ class OatDexFile final {
              uint32_t dex_file_checksum,
              const std::string& dex_file_location,
              const std::string& canonical_dex_file_location,
-             const uint8_t* lookup_table_data);
+             const uint8_t* lookup_table_data,
+             const uint8_t* string_lookup_table_data);
 
   bool IsBackedByVdexOnly() const;
   void InitializeTypeLookupTable();
+  void InitializeStringLookupTable();
 
   static void AssertAotCompiler();
 
@@ -613,6 +626,7 @@ class OatDexFile final {
   const uint32_t dex_file_location_checksum_ = 0u;
   const uint8_t* const dex_file_pointer_ = nullptr;
   const uint8_t* const lookup_table_data_ = nullptr;
+  const uint8_t* const string_lookup_table_data_ = nullptr;
   const IndexBssMapping* const method_bss_mapping_ = nullptr;
   const IndexBssMapping* const type_bss_mapping_ = nullptr;
   const IndexBssMapping* const public_type_bss_mapping_ = nullptr;
@@ -621,6 +635,7 @@ class OatDexFile final {
   const uint32_t* const oat_class_offsets_pointer_ = nullptr;
   TypeLookupTable lookup_table_;
   const DexLayoutSections* const dex_layout_sections_ = nullptr;
+  StringLookupTable string_lookup_table_;
 
   friend class OatFile;
   friend class OatFileBase;
@@ -16,8 +16,12 @@
 
 #include "oat_file_manager.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <queue>
+#include <set>
+#include <thread>
 #include <vector>
 #include <sys/stat.h>
 
@@ -33,8 +37,10 @@
 #include "base/sdk_version.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
+#include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "class_loader_context.h"
+#include "class_loader_utils.h"
 #include "dex/art_dex_file_loader.h"
 #include "dex/dex_file-inl.h"
 #include "dex/dex_file_loader.h"
@@ -45,11 +51,14 @@
 #include "jit/jit.h"
 #include "jni/java_vm_ext.h"
 #include "jni/jni_internal.h"
+#include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
+#include "mirror/iftable-inl.h"
 #include "mirror/object-inl.h"
 #include "oat_file.h"
 #include "oat_file_assistant.h"
 #include "obj_ptr-inl.h"
+#include "profile/profile_compilation_info.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "thread_list.h"
@@ -145,7 +154,8 @@ std::vector<const OatFile*> OatFileManager::GetBootOatFiles() const {
 }
 
 OatFileManager::OatFileManager()
-    : only_use_system_oat_files_(false) {}
+    : only_use_system_oat_files_(false),
+      startup_app_registered_(false) {}
 
 OatFileManager::~OatFileManager() {
   // Explicitly clear oat_files_ since the OatFile destructor calls back into OatFileManager for
@@ -419,6 +429,10 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
     }
   }
 
+  if (!dex_files.empty() && class_loader != nullptr && context != nullptr) {
+    RecordStartupDexLocation(dex_location, class_loader);
+  }
+
   if (Runtime::Current()->GetJit() != nullptr) {
     Runtime::Current()->GetJit()->RegisterDexFiles(dex_files, class_loader);
   }
@@ -805,24 +819,332 @@ void OatFileManager::RunBackgroundVerification(const std::vector<const DexFile*>
       GetVdexFilename(odex_filename)));
 }
 
+class StartupClassPreloadTask final : public Task {
+ public:
+  StartupClassPreloadTask(ObjPtr<mirror::ClassLoader> class_loader,
+                          std::vector<std::string>&& descriptors)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      : descriptors_(std::move(descriptors)) {
+    Thread* const self = Thread::Current();
+    // Create a global ref for `class_loader` because it will be accessed from a different thread.
+    class_loader_ = Runtime::Current()->GetJavaVM()->AddGlobalRef(self, class_loader);
+    CHECK(class_loader_ != nullptr);
+  }
+
+  ~StartupClassPreloadTask() {
+    Thread* const self = Thread::Current();
+    ScopedObjectAccess soa(self);
+    soa.Vm()->DeleteGlobalRef(self, class_loader_);
+  }
+
+  void Run(Thread* self) override {
+    ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
+    for (const std::string& descriptor : descriptors_) {
+      // Take handles inside the loop, so that the mutator lock is released between classes.
+      ScopedObjectAccess soa(self);
+      StackHandleScope<2> hs(self);
+      Handle<mirror::ClassLoader> h_loader(hs.NewHandle(
+          soa.Decode<mirror::ClassLoader>(class_loader_)));
+      Handle<mirror::Class> h_class(hs.NewHandle<mirror::Class>(class_linker->FindClass(
+          self,
+          descriptor.c_str(),
+          h_loader)));
+      if (h_class == nullptr) {
+        CHECK(self->IsExceptionPending());
+        self->ClearException();
+        continue;
+      }
+      // Another thread may have verified the class, or be verifying it, in which case
+      // ClassLinker::VerifyClass waits for it.
+      if (!h_class->IsVerified() && !h_class->IsErroneous()) {
+        class_linker->VerifyClass(self, /*verifier_deps=*/ nullptr, h_class);
+        if (h_class->IsErroneous()) {
+          // ClassLinker::VerifyClass throws, which isn't useful here. The class throws
+          // again when the app uses it.
+          CHECK(self->IsExceptionPending());
+          self->ClearException();
+          continue;
+        }
+      }
+      if (h_class->IsVerified() &&
+          !h_class->IsInitialized() &&
+          InitializesWithoutJavaCode(h_class.Get(), class_linker->GetImagePointerSize())) {
+        // Nothing the app could observe runs on this thread, EnsureInitialized only sets the
+        // static fields to their constant values and marks the class and its superclasses
+        // initialized. It waits for, or returns to, a thread initializing the class already.
+        if (!class_linker->EnsureInitialized(self,
+                                             h_class,
+                                             /*can_init_fields=*/ true,
+                                             /*can_init_parents=*/ true)) {
+          CHECK(self->IsExceptionPending());
+          self->ClearException();
+        }
+      }
+    }
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  // Whether initializing `klass` runs no class initializer, neither its own nor those of the
+  // superclasses and interfaces it would initialize.
+  static bool InitializesWithoutJavaCode(ObjPtr<mirror::Class> klass, PointerSize pointer_size)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    for (ObjPtr<mirror::Class> k = klass;
+         k != nullptr && !k->IsInitialized();
+         k = k->GetSuperClass()) {
+      if (k->FindClassInitializer(pointer_size) != nullptr) {
+        return false;
+      }
+    }
+    // Be conservative and check all interfaces, not only those with default methods.
+    ObjPtr<mirror::IfTable> iftable = klass->GetIfTable();
+    for (size_t i = 0, count = iftable->Count(); i != count; ++i) {
+      ObjPtr<mirror::Class> iface = iftable->GetInterface(i);
+      if (!iface->IsInitialized() && iface->FindClassInitializer(pointer_size) != nullptr) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<std::string> descriptors_;
+  jobject class_loader_;
+
+  DISALLOW_COPY_AND_ASSIGN(StartupClassPreloadTask);
+};
+
+void OatFileManager::RecordStartupDexLocation(const char* dex_location, jobject class_loader) {
+  Runtime* const runtime = Runtime::Current();
+  if (runtime->IsZygote() || runtime->IsJavaDebuggable()) {
+    // Only apps register their code paths, and runtime threads are not allowed to load classes
+    // when debuggable, see RunBackgroundVerification().
+    return;
+  }
+  Thread* const self = Thread::Current();
+  {
+    ReaderMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    if (startup_app_registered_ || startup_dex_locations_.size() >= kMaxStartupDexLocations) {
+      return;
+    }
+  }
+  jweak weak_class_loader;
+  {
+    ScopedObjectAccess soa(self);
+    weak_class_loader =
+        soa.Vm()->AddWeakGlobalRef(self, soa.Decode<mirror::ClassLoader>(class_loader));
+  }
+  {
+    WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    if (!startup_app_registered_ && startup_dex_locations_.size() < kMaxStartupDexLocations) {
+      startup_dex_locations_.emplace_back(dex_location, weak_class_loader);
+      return;
+    }
+  }
+  // The app registered its code paths, or another thread filled the list, in the meantime.
+  ScopedObjectAccess soa(self);
+  soa.Vm()->DeleteWeakGlobalRef(self, weak_class_loader);
+}
+
+static bool LoadStartupProfile(const std::string& filename, ProfileCompilationInfo* profile) {
+  if (filename.empty()) {
+    return false;
+  }
+  // Profiles are updated by renaming a new file over the old one, no need to lock.
+  unix_file::FdFile file(filename.c_str(), O_RDONLY, /*check_usage=*/ false);
+  return file.Fd() != -1 && profile->Load(file.Fd());
+}
+
+// Reads the startup classes of the app from its profile and spreads them over
+// StartupClassPreloadTasks on the same thread pool.
+class StartupProfileTask final : public Task {
+ public:
+  StartupProfileTask(ThreadPool* thread_pool,
+                     std::vector<jweak>&& weak_class_loaders,
+                     const std::vector<std::string>& code_paths,
+                     const std::string& profile_output_filename,
+                     const std::string& ref_profile_filename)
+      : thread_pool_(thread_pool),
+        weak_class_loaders_(std::move(weak_class_loaders)),
+        code_paths_(code_paths),
+        profile_output_filename_(profile_output_filename),
+        ref_profile_filename_(ref_profile_filename) {}
+
+  ~StartupProfileTask() {
+    Thread* const self = Thread::Current();
+    ScopedObjectAccess soa(self);
+    for (jweak weak_class_loader : weak_class_loaders_) {
+      soa.Vm()->DeleteWeakGlobalRef(self, weak_class_loader);
+    }
+  }
+
+  void Run(Thread* self) override {
+    // The reference profile covers more launches than the current one, if there is one.
+    ProfileCompilationInfo ref_profile;
+    ProfileCompilationInfo cur_profile;
+    const ProfileCompilationInfo* profile = nullptr;
+    if (LoadStartupProfile(ref_profile_filename_, &ref_profile)) {
+      profile = &ref_profile;
+    } else if (LoadStartupProfile(profile_output_filename_, &cur_profile)) {
+      profile = &cur_profile;
+    } else {
+      // There is no profile to tell the startup classes.
+      return;
+    }
+
+    size_t num_classes = 0u;
+    // Several code paths may share a class loader, visit its dex files once.
+    std::set<const DexFile*> visited_dex_files;
+    ScopedObjectAccess soa(self);
+    StackHandleScope<1> hs(self);
+    MutableHandle<mirror::ClassLoader> h_loader = hs.NewHandle<mirror::ClassLoader>(nullptr);
+    for (jweak weak_class_loader : weak_class_loaders_) {
+      h_loader.Assign(soa.Decode<mirror::ClassLoader>(weak_class_loader));
+      if (h_loader == nullptr) {
+        // The class loader was collected.
+        continue;
+      }
+      // The profile lists the classes that were resolved during startup.
+      std::vector<std::string> descriptors;
+      VisitClassLoaderDexFiles(soa, h_loader, [&](const DexFile* dex_file) {
+        if (ContainsElement(code_paths_,
+                            DexFileLoader::GetBaseLocation(dex_file->GetLocation())) &&
+            visited_dex_files.insert(dex_file).second) {
+          std::set<dex::TypeIndex> classes;
+          std::set<uint16_t> methods;
+          if (profile->GetClassesAndMethods(*dex_file, &classes, &methods, &methods, &methods)) {
+            for (dex::TypeIndex type_index : classes) {
+              const char* descriptor = dex_file->StringByTypeIdx(type_index);
+              if (descriptor[0] == 'L') {
+                descriptors.push_back(descriptor);
+              }
+            }
+          }
+        }
+        return true;  // Continue with the next DexFile.
+      });
+      num_classes += descriptors.size();
+      // Spread the classes over tasks, in batches small enough to keep all workers busy.
+      constexpr size_t kBatchSize = OatFileManager::kStartupPreloadBatchSize;
+      for (size_t begin = 0; begin < descriptors.size(); begin += kBatchSize) {
+        size_t end = std::min(begin + kBatchSize, descriptors.size());
+        std::vector<std::string> batch(std::make_move_iterator(descriptors.begin() + begin),
+                                       std::make_move_iterator(descriptors.begin() + end));
+        thread_pool_->AddTask(self, new StartupClassPreloadTask(h_loader.Get(), std::move(batch)));
+      }
+    }
+    VLOG(class_linker) << "Preloading " << num_classes << " startup classes in the background";
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  ThreadPool* const thread_pool_;
+  const std::vector<jweak> weak_class_loaders_;
+  const std::vector<std::string> code_paths_;
+  const std::string profile_output_filename_;
+  const std::string ref_profile_filename_;
+
+  DISALLOW_COPY_AND_ASSIGN(StartupProfileTask);
+};
+
+void OatFileManager::RunStartupClassPreloading(const std::vector<std::string>& code_paths,
+                                               const std::string& profile_output_filename,
+                                               const std::string& ref_profile_filename) {
+  Runtime* const runtime = Runtime::Current();
+  Thread* const self = Thread::Current();
+
+  std::vector<jweak> weak_class_loaders;
+  std::vector<jweak> unused_weak_class_loaders;
+  {
+    WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    // Dex files opened after the app registered its code paths are not needed for startup.
+    startup_app_registered_ = true;
+    for (const std::pair<std::string, jweak>& entry : startup_dex_locations_) {
+      if (ContainsElement(code_paths, entry.first)) {
+        weak_class_loaders.push_back(entry.second);
+      } else {
+        unused_weak_class_loaders.push_back(entry.second);
+      }
+    }
+    startup_dex_locations_.clear();
+  }
+
+  bool can_preload = true;
+  if (!IsSdkVersionSetAndAtLeast(runtime->GetTargetSdkVersion(), SdkVersion::kQ)) {
+    // Do not run for legacy apps as they may depend on the previous class loader behaviour.
+    can_preload = false;
+  } else if (runtime->IsShuttingDown(self)) {
+    // Not allowed to create new threads during runtime shutdown.
+    can_preload = false;
+  }
+  if (!can_preload) {
+    unused_weak_class_loaders.insert(
+        unused_weak_class_loaders.end(), weak_class_loaders.begin(), weak_class_loaders.end());
+    weak_class_loaders.clear();
+  }
+  if (!unused_weak_class_loaders.empty()) {
+    ScopedObjectAccess soa(self);
+    for (jweak weak_class_loader : unused_weak_class_loaders) {
+      soa.Vm()->DeleteWeakGlobalRef(self, weak_class_loader);
+    }
+  }
+  if (weak_class_loaders.empty()) {
+    // The dex files of the code paths were not opened by an app class loader, or the app
+    // cannot preload.
+    return;
+  }
+
+  {
+    WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    if (startup_preload_thread_pool_ == nullptr) {
+      const size_t num_threads = std::min(
+          static_cast<size_t>(std::thread::hardware_concurrency()), kMaxStartupPreloadThreads);
+      startup_preload_thread_pool_.reset(new ThreadPool("Startup class preloading thread pool",
+                                                        std::max<size_t>(num_threads, 1u)));
+      startup_preload_thread_pool_->StartWorkers(self);
+    }
+  }
+  // Reading the profile and the dex files is left to the pool, this runs on the main thread
+  // of the app.
+  startup_preload_thread_pool_->AddTask(self, new StartupProfileTask(
+      startup_preload_thread_pool_.get(),
+      std::move(weak_class_loaders),
+      code_paths,
+      profile_output_filename,
+      ref_profile_filename));
+}
+
 void OatFileManager::WaitForWorkersToBeCreated() {
   DCHECK(!Runtime::Current()->IsShuttingDown(Thread::Current()))
       << "Cannot create new threads during runtime shutdown";
   if (verification_thread_pool_ != nullptr) {
     verification_thread_pool_->WaitForWorkersToBeCreated();
   }
+  if (startup_preload_thread_pool_ != nullptr) {
+    startup_preload_thread_pool_->WaitForWorkersToBeCreated();
+  }
 }
 
 void OatFileManager::DeleteThreadPool() {
   verification_thread_pool_.reset(nullptr);
+  startup_preload_thread_pool_.reset(nullptr);
 }
 
 void OatFileManager::WaitForBackgroundVerificationTasks() {
+  Thread* const self = Thread::Current();
   if (verification_thread_pool_ != nullptr) {
-    Thread* const self = Thread::Current();
     verification_thread_pool_->WaitForWorkersToBeCreated();
     verification_thread_pool_->Wait(self, /* do_work= */ true, /* may_hold_locks= */ false);
   }
+  if (startup_preload_thread_pool_ != nullptr) {
+    startup_preload_thread_pool_->WaitForWorkersToBeCreated();
+    startup_preload_thread_pool_->Wait(self, /* do_work= */ true, /* may_hold_locks= */ false);
+  }
 }
 
 void OatFileManager::ClearOnlyUseTrustedOatFiles() {
@@ -21,6 +21,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "base/compiler_filter.h"
@@ -127,6 +128,16 @@ class OatFileManager {
   void RunBackgroundVerification(const std::vector<const DexFile*>& dex_files,
                                  jobject class_loader);
 
+  // Spawn background threads which load the startup classes of the app, as listed in its
+  // profiles, from the dex files of `code_paths`. The classes are linked, verified if that was
+  // not done ahead of time, and initialized if that runs no Java code. The main thread then
+  // finds them ready instead of loading them one at a time on first use. The profiles are
+  // read by the background threads too, the caller only hands over the class loaders.
+  void RunStartupClassPreloading(const std::vector<std::string>& code_paths,
+                                 const std::string& profile_output_filename,
+                                 const std::string& ref_profile_filename)
+      REQUIRES(!Locks::oat_file_manager_lock_, !Locks::mutator_lock_);
+
   // Wait for thread pool workers to be created. This is used during shutdown as
   // threads are not allowed to attach while runtime is in shutdown lock.
   void WaitForWorkersToBeCreated();
@@ -140,6 +151,10 @@ class OatFileManager {
   // Maximum number of anonymous vdex files kept in the process' data folder.
   static constexpr size_t kAnonymousVdexCacheSize = 8u;
 
+  // Startup classes are preloaded in batches of this size on up to this many threads.
+  static constexpr size_t kStartupPreloadBatchSize = 32u;
+  static constexpr size_t kMaxStartupPreloadThreads = 4u;
+
   bool ContainsPc(const void* pc) REQUIRES(!Locks::oat_file_manager_lock_);
 
  private:
@@ -157,6 +172,10 @@ class OatFileManager {
   // Return true if we should attempt to load the app image.
   bool ShouldLoadAppImage(const OatFile* source_oat_file) const;
 
+  // Remember the class loader of dex files opened for an app, for RunStartupClassPreloading().
+  void RecordStartupDexLocation(const char* dex_location, jobject class_loader)
+      REQUIRES(!Locks::oat_file_manager_lock_, !Locks::mutator_lock_);
+
   std::set<std::unique_ptr<const OatFile>> oat_files_ GUARDED_BY(Locks::oat_file_manager_lock_);
 
   // Only use the compiled code in an OAT file when the file is on /system. If the OAT file
@@ -166,6 +185,19 @@ class OatFileManager {
   // Single-thread pool used to run the verifier in the background.
   std::unique_ptr<ThreadPool> verification_thread_pool_;
 
+  // Pool used to preload startup classes in the background, see RunStartupClassPreloading().
+  std::unique_ptr<ThreadPool> startup_preload_thread_pool_;
+
+  // Weak references to the class loaders of dex files opened for an app, by dex location.
+  // Only the first kMaxStartupDexLocations are kept, as the app registers its code paths
+  // soon after opening them.
+  static constexpr size_t kMaxStartupDexLocations = 16u;
+  std::vector<std::pair<std::string, jweak>> startup_dex_locations_
+      GUARDED_BY(Locks::oat_file_manager_lock_);
+
+  // Whether RunStartupClassPreloading() ran. Dex files are not recorded after that.
+  bool startup_app_registered_ GUARDED_BY(Locks::oat_file_manager_lock_);
+
   DISALLOW_COPY_AND_ASSIGN(OatFileManager);
 };
 
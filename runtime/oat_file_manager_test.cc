@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "oat_file_manager.h"
+
+#include <string>
+#include <vector>
+
+#include "android-base/strings.h"
+
+#include "app_info.h"
+#include "base/sdk_version.h"
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "dex/dex_file.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "profile/profile_compilation_info.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class OatFileManagerTest : public CommonRuntimeTest {
+ protected:
+  // Opens the StartupPreload dex file for an app, registers the app with a profile listing
+  // `startup_classes` and waits for the preloading to finish.
+  jobject RegisterAppWithStartupClasses(const std::vector<const char*>& startup_classes) {
+    Runtime* const runtime = Runtime::Current();
+    runtime->SetTargetSdkVersion(static_cast<uint32_t>(SdkVersion::kQ));
+    jobject class_loader;
+    {
+      ScopedObjectAccess soa(Thread::Current());
+      class_loader = LoadDex("StartupPreload");
+    }
+    // Open the dex file through the OatFileManager, as the class loader of an app does, which
+    // records its location for RegisterAppInfo.
+    const std::string dex_location = GetTestDexFileName("StartupPreload");
+    const OatFile* oat_file = nullptr;
+    std::vector<std::string> error_msgs;
+    std::vector<std::unique_ptr<const DexFile>> dex_files =
+        runtime->GetOatFileManager().OpenDexFilesFromOat(dex_location.c_str(),
+                                                         class_loader,
+                                                         /*dex_elements=*/ nullptr,
+                                                         &oat_file,
+                                                         &error_msgs);
+    EXPECT_EQ(dex_files.size(), 1u) << android::base::Join(error_msgs, '\n');
+    if (dex_files.empty()) {
+      return class_loader;
+    }
+
+    ProfileCompilationInfo info;
+    for (const char* descriptor : startup_classes) {
+      EXPECT_TRUE(info.AddClass(*dex_files[0], descriptor)) << descriptor;
+    }
+    ScratchFile profile;
+    EXPECT_TRUE(info.Save(profile.GetFd()));
+
+    runtime->RegisterAppInfo("test.app",
+                             { dex_location },
+                             /*profile_output_filename=*/ "",
+                             profile.GetFilename(),
+                             kVMRuntimePrimaryApk);
+    runtime->GetOatFileManager().WaitForBackgroundVerificationTasks();
+    return class_loader;
+  }
+
+  ObjPtr<mirror::Class> LookupClass(jobject class_loader, const char* descriptor)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    Thread* const self = Thread::Current();
+    return class_linker_->LookupClass(
+        self, descriptor, self->DecodeJObject(class_loader)->AsClassLoader());
+  }
+};
+
+TEST_F(OatFileManagerTest, StartupClassPreloading) {
+  jobject class_loader = RegisterAppWithStartupClasses({ "LListed;", "LAlsoListed;" });
+
+  ScopedObjectAccess soa(Thread::Current());
+  for (const char* descriptor : { "LListed;", "LAlsoListed;" }) {
+    ObjPtr<mirror::Class> klass = LookupClass(class_loader, descriptor);
+    ASSERT_TRUE(klass != nullptr) << descriptor;
+    EXPECT_TRUE(klass->IsVerified()) << descriptor;
+  }
+  // Only the classes listed in the profile are loaded.
+  EXPECT_TRUE(LookupClass(class_loader, "LNotListed;") == nullptr);
+}
+
+TEST_F(OatFileManagerTest, StartupClassPreloadingRunsNoClassInitializer) {
+  jobject class_loader = RegisterAppWithStartupClasses(
+      { "LConstantStatics;", "LWithClinit;", "LSubOfClinit;", "LImplOfIface;" });
+
+  ScopedObjectAccess soa(Thread::Current());
+  // Initializing the class only sets its static fields to constant values.
+  ObjPtr<mirror::Class> constant_statics = LookupClass(class_loader, "LConstantStatics;");
+  ASSERT_TRUE(constant_statics != nullptr);
+  EXPECT_TRUE(constant_statics->IsInitialized());
+
+  // Initializing these classes would run the <clinit> of the class, of its superclass or of
+  // its interface.
+  for (const char* descriptor : { "LWithClinit;", "LSubOfClinit;", "LImplOfIface;" }) {
+    ObjPtr<mirror::Class> klass = LookupClass(class_loader, descriptor);
+    ASSERT_TRUE(klass != nullptr) << descriptor;
+    EXPECT_TRUE(klass->IsVerified()) << descriptor;
+    EXPECT_FALSE(klass->IsInitialized()) << descriptor;
+  }
+  for (const char* descriptor : { "LSuperWithClinit;", "LIfaceWithClinit;" }) {
+    ObjPtr<mirror::Class> klass = LookupClass(class_loader, descriptor);
+    ASSERT_TRUE(klass != nullptr) << descriptor;
+    EXPECT_FALSE(klass->IsInitialized()) << descriptor;
+  }
+}
+
+}  // namespace art
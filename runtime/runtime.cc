@@ -744,6 +744,9 @@ void Runtime::PreZygoteFork() {
     // Update native method JNI entrypoints.
     FindNativeMethodsVisitor visitor(soa.Self(), class_linker_);
     class_linker_->VisitClasses(&visitor);
+    // Apps search the boot class path first for each of their classes. Build the filter that
+    // lets them skip it here, so that they share it rather than each building its own.
+    class_linker_->EnsureBootClassPathDescriptorFilter();
   }
   heap_->PreZygoteFork();
   PreZygoteForkNativeBridge();
@@ -2682,6 +2685,11 @@ void Runtime::RegisterAppInfo(const std::string& package_name,
     metrics_reporter_->NotifyAppInfoUpdated(&app_info_);
   }
 
+  // Load the startup classes of the code paths in the background, before the app gets to
+  // use them.
+  oat_file_manager_->RunStartupClassPreloading(
+      code_paths, profile_output_filename, ref_profile_filename);
+
   if (jit_.get() == nullptr) {
     // We are not JITing. Nothing to do.
     return;
@@ -37,6 +37,7 @@
 #include "dex/art_dex_file_loader.h"
 #include "dex/class_accessor-inl.h"
 #include "dex/dex_file_loader.h"
+#include "dex/string_lookup_table.h"
 #include "gc/heap.h"
 #include "gc/space/image_space.h"
 #include "mirror/class-inl.h"
@@ -217,6 +218,19 @@ const uint8_t* VdexFile::GetNextTypeLookupTableData(const uint8_t* cursor,
   }
 }
 
+const uint8_t* VdexFile::GetNextStringLookupTableData(const uint8_t* cursor,
+                                                      uint32_t dex_file_index) const {
+  if (cursor == nullptr) {
+    // Beginning of the iteration, return the first table if there is one.
+    return HasStringLookupTableSection() ? StringLookupTableDataBegin() : nullptr;
+  } else if (dex_file_index >= GetNumberOfDexFiles()) {
+    return nullptr;
+  } else {
+    // As for the type lookup tables, callers check the returned value.
+    return cursor + sizeof(uint32_t) + reinterpret_cast<const uint32_t*>(cursor)[0];
+  }
+}
+
 bool VdexFile::OpenAllDexFiles(std::vector<std::unique_ptr<const DexFile>>* dex_files,
                                std::string* error_msg) const {
   const ArtDexFileLoader dex_file_loader;
@@ -282,6 +296,16 @@ bool VdexFile::WriteToDisk(const std::string& path,
         sizeof(uint32_t) + TypeLookupTable::RawDataLength(dex_file->NumClassDefs());
   }
 
+  // Create the string lookup tables up front, their creation can fail.
+  std::vector<StringLookupTable> string_lookup_tables;
+  string_lookup_tables.reserve(dex_files.size());
+  size_t string_lookup_table_size = 0u;
+  for (const DexFile* dex_file : dex_files) {
+    string_lookup_tables.push_back(StringLookupTable::Create(*dex_file));
+    const StringLookupTable& table = string_lookup_tables.back();
+    string_lookup_table_size += sizeof(uint32_t) + (table.Valid() ? table.RawDataLength() : 0u);
+  }
+
   VdexFile::VdexFileHeader vdex_header(/* has_dex_section= */ false);
   VdexFile::VdexSectionHeader sections[static_cast<uint32_t>(VdexSection::kNumberOfSections)];
 
@@ -309,6 +333,13 @@ bool VdexFile::WriteToDisk(const std::string& path,
       sections[VdexSection::kVerifierDepsSection].section_offset + verifier_deps_with_padding_size;
   sections[VdexSection::kTypeLookupTableSection].section_size = type_lookup_table_size;
 
+  // Set StringLookupTable section.
+  sections[VdexSection::kStringLookupTableSection].section_kind =
+      VdexSection::kStringLookupTableSection;
+  sections[VdexSection::kStringLookupTableSection].section_offset =
+      sections[VdexSection::kTypeLookupTableSection].section_offset + type_lookup_table_size;
+  sections[VdexSection::kStringLookupTableSection].section_size = string_lookup_table_size;
+
   if (!CreateDirectories(path, error_msg)) {
     return false;
   }
@@ -368,6 +399,21 @@ bool VdexFile::WriteToDisk(const std::string& path,
   }
   DCHECK_EQ(written_type_lookup_table_size, type_lookup_table_size);
 
+  size_t written_string_lookup_table_size = 0;
+  for (const StringLookupTable& string_lookup_table : string_lookup_tables) {
+    uint32_t size = string_lookup_table.Valid() ? string_lookup_table.RawDataLength() : 0u;
+    DCHECK_ALIGNED(size, 4);
+    if (!out->WriteFully(reinterpret_cast<const char*>(&size), sizeof(uint32_t)) ||
+        (size != 0u &&
+         !out->WriteFully(reinterpret_cast<const char*>(string_lookup_table.RawData()), size))) {
+      *error_msg = "Could not write string lookup table " + path;
+      out->Unlink();
+      return false;
+    }
+    written_string_lookup_table_size += sizeof(uint32_t) + size;
+  }
+  DCHECK_EQ(written_string_lookup_table_size, string_lookup_table_size);
+
   if (out->FlushClose() != 0) {
     *error_msg = "Could not flush and close " + path;
     out->Unlink();
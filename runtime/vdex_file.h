@@ -75,6 +75,14 @@ class VerifierDeps;
 //        uint32                     Number of strings
 //        uint32[]                   String data offsets for each string
 //        uint8[]                    String data
+//
+//   TypeLookupTable section
+//      4-byte alignment
+//      uint32 + TypeLookupTable[D]    size (0 if none) and table for each dex file
+//
+//   StringLookupTable section
+//      4-byte alignment
+//      uint32 + StringLookupTable[D]  size (0 if none) and table for each dex file
 
 
 enum VdexSection : uint32_t {
@@ -82,7 +90,8 @@ enum VdexSection : uint32_t {
   kDexFileSection = 1,
   kVerifierDepsSection = 2,
   kTypeLookupTableSection = 3,
-  kNumberOfSections = 4,
+  kStringLookupTableSection = 4,
+  kNumberOfSections = 5,
 };
 
 class VdexFile {
@@ -123,8 +132,8 @@ class VdexFile {
     static constexpr uint8_t kVdexMagic[] = { 'v', 'd', 'e', 'x' };
 
     // The format version of the verifier deps header and the verifier deps.
-    // Last update: Introduce vdex sections.
-    static constexpr uint8_t kVdexVersion[] = { '0', '2', '7', '\0' };
+    // Last update: Add string lookup table section.
+    static constexpr uint8_t kVdexVersion[] = { '0', '2', '8', '\0' };
 
     uint8_t magic_[4];
     uint8_t vdex_version_[4];
@@ -171,6 +180,10 @@ class VdexFile {
     return GetVdexFileHeader().GetNumberOfSections() >= (kTypeLookupTableSection + 1);
   }
 
+  bool HasStringLookupTableSection() const {
+    return GetVdexFileHeader().GetNumberOfSections() >= (kStringLookupTableSection + 1);
+  }
+
   const VdexChecksum* GetDexChecksumsArray() const {
     return reinterpret_cast<const VdexChecksum*>(
         Begin() + GetSectionHeader(VdexSection::kChecksumSection).section_offset);
@@ -272,6 +285,9 @@ class VdexFile {
 
   const uint8_t* GetNextTypeLookupTableData(const uint8_t* cursor, uint32_t dex_file_index) const;
 
+  const uint8_t* GetNextStringLookupTableData(const uint8_t* cursor,
+                                              uint32_t dex_file_index) const;
+
   // Get the location checksum of the dex file number `dex_file_index`.
   uint32_t GetLocationChecksum(uint32_t dex_file_index) const {
     DCHECK_LT(dex_file_index, GetNumberOfDexFiles());
@@ -318,6 +334,11 @@ class VdexFile {
     return Begin() + GetSectionHeader(VdexSection::kTypeLookupTableSection).section_offset;
   }
 
+  const uint8_t* StringLookupTableDataBegin() const {
+    DCHECK(HasStringLookupTableSection());
+    return Begin() + GetSectionHeader(VdexSection::kStringLookupTableSection).section_offset;
+  }
+
   MemMap mmap_;
 
   DISALLOW_COPY_AND_ASSIGN(VdexFile);
@@ -25,11 +25,13 @@
 #include "base/scoped_arena_allocator.h"
 #include "base/stl_util.h"
 #include "class_linker-inl.h"
+#include "class_table.h"
 #include "dex/descriptors_names.h"
 #include "dex/dex_file-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "reg_type-inl.h"
+#include "runtime.h"
 
 namespace art {
 namespace verifier {
@@ -160,11 +162,31 @@ ObjPtr<mirror::Class> RegTypeCache::ResolveClass(const char* descriptor,
   // Class was not found, must create new type.
   // Try resolving class
   Thread* self = Thread::Current();
-  StackHandleScope<1> hs(self);
-  Handle<mirror::ClassLoader> class_loader(hs.NewHandle(loader));
   ObjPtr<mirror::Class> klass = nullptr;
   if (can_load_classes_) {
+    // The classes that a class loader can load do not change in the AOT compiler. Remember the
+    // ones that failed to resolve so that verifying other methods and classes with the same
+    // class loader does not search its class path for them again. The set is consulted only
+    // after the lock-free class table lookup missed, so classes that resolve never take its lock.
+    ClassTable* const class_table = Runtime::Current()->IsAotCompiler()
+        ? class_linker_->ClassTableForClassLoader(loader)
+        : nullptr;
+    if (class_table != nullptr &&
+        class_linker_->LookupClass(self, descriptor, loader) == nullptr &&
+        class_table->IsUnresolvableDescriptor(descriptor)) {
+      return nullptr;
+    }
+    StackHandleScope<1> hs(self);
+    Handle<mirror::ClassLoader> class_loader(hs.NewHandle(loader));
     klass = class_linker_->FindClass(self, descriptor, class_loader);
+    if (klass == nullptr) {
+      // We tried loading the class and failed, clear the exception before we go on.
+      DCHECK(self->IsExceptionPending());
+      self->ClearException();
+      if (class_table != nullptr) {
+        class_table->AddUnresolvableDescriptor(descriptor);
+      }
+    }
   } else {
     klass = class_linker_->LookupClass(self, descriptor, loader);
     if (klass != nullptr && !klass->IsResolved()) {
@@ -216,14 +238,7 @@ const RegType& RegTypeCache::From(ObjPtr<mirror::ClassLoader> loader,
     }
     return AddEntry(entry);
   } else {  // Class not resolved.
-    // We tried loading the class and failed, this might get an exception raised
-    // so we want to clear it before we go on.
-    if (can_load_classes_) {
-      DCHECK(Thread::Current()->IsExceptionPending());
-      Thread::Current()->ClearException();
-    } else {
-      DCHECK(!Thread::Current()->IsExceptionPending());
-    }
+    DCHECK(!Thread::Current()->IsExceptionPending());
     if (IsValidDescriptor(descriptor)) {
       return AddEntry(
           new (&allocator_) UnresolvedReferenceType(AddString(sv_descriptor), entries_.size()));
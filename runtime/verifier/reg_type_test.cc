@@ -21,8 +21,12 @@
 #include "base/bit_vector.h"
 #include "base/casts.h"
 #include "base/scoped_arena_allocator.h"
+#include "class_linker.h"
+#include "class_table.h"
 #include "common_runtime_test.h"
 #include "compiler_callbacks.h"
+#include "handle_scope-inl.h"
+#include "mirror/class_loader.h"
 #include "reg_type-inl.h"
 #include "reg_type_cache-inl.h"
 #include "scoped_thread_state_change-inl.h"
@@ -398,6 +402,50 @@ TEST_F(RegTypeReferenceTest, UnresolvedType) {
   EXPECT_TRUE(unresolved_super_class.IsNonZeroReferenceTypes());
 }
 
+TEST_F(RegTypeReferenceTest, UnresolvableTypeNotSearchedAgain) {
+  ArenaStack stack(Runtime::Current()->GetArenaPool());
+  ScopedArenaAllocator allocator(&stack);
+  ScopedObjectAccess soa(Thread::Current());
+  ASSERT_TRUE(Runtime::Current()->IsAotCompiler());
+  jobject jclass_loader = LoadDex("Nested");
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  // Loading a class makes sure that the class loader has a class table.
+  ASSERT_TRUE(class_linker->FindClass(soa.Self(), "LNested;", class_loader) != nullptr);
+  ClassTable* class_table = class_linker->ClassTableForClassLoader(class_loader.Get());
+  ASSERT_TRUE(class_table != nullptr);
+
+  {
+    RegTypeCache cache(class_linker, /*can_load_classes=*/ true, allocator);
+    const RegType& type = cache.FromDescriptor(class_loader.Get(), "LDoesNotExist;", true);
+    EXPECT_TRUE(type.IsUnresolvedReference());
+    EXPECT_FALSE(soa.Self()->IsExceptionPending());
+  }
+  EXPECT_TRUE(class_table->IsUnresolvableDescriptor("LDoesNotExist;"));
+
+  // A descriptor recorded as unresolvable is not searched for by later caches. Record one that
+  // the class loader could load and check that the class is not loaded.
+  class_table->AddUnresolvableDescriptor("LNested$Inner;");
+  {
+    RegTypeCache cache(class_linker, /*can_load_classes=*/ true, allocator);
+    const RegType& type = cache.FromDescriptor(class_loader.Get(), "LNested$Inner;", true);
+    EXPECT_TRUE(type.IsUnresolvedReference());
+    EXPECT_FALSE(soa.Self()->IsExceptionPending());
+  }
+  EXPECT_TRUE(
+      class_linker->LookupClass(soa.Self(), "LNested$Inner;", class_loader.Get()) == nullptr);
+
+  // Classes that are already loaded are found before the set is consulted.
+  class_table->AddUnresolvableDescriptor("LNested;");
+  {
+    RegTypeCache cache(class_linker, /*can_load_classes=*/ true, allocator);
+    const RegType& type = cache.FromDescriptor(class_loader.Get(), "LNested;", true);
+    EXPECT_FALSE(type.IsUnresolvedReference());
+  }
+}
+
 TEST_F(RegTypeReferenceTest, UnresolvedUnintializedType) {
   // Tests creating types uninitialized types from unresolved types.
   ArenaStack stack(Runtime::Current()->GetArenaPool());
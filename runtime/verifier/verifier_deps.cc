@@ -16,7 +16,9 @@
 
 #include "verifier_deps.h"
 
+#include <algorithm>
 #include <cstring>
+#include <numeric>
 #include <sstream>
 
 #include "art_field-inl.h"
@@ -79,6 +81,47 @@ void VerifierDeps::MergeWith(std::unique_ptr<VerifierDeps> other,
   }
 }
 
+void VerifierDeps::Canonicalize() {
+  for (auto& entry : dex_deps_) {
+    const DexFile& dex_file = *entry.first;
+    DexFileDeps* deps = entry.second.get();
+    if (deps->strings_.empty()) {
+      continue;
+    }
+    uint32_t num_ids_in_dex = dex_file.NumStringIds();
+    std::vector<uint32_t> order(deps->strings_.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(),
+              order.end(),
+              [deps](uint32_t lhs, uint32_t rhs) {
+                return deps->strings_[lhs] < deps->strings_[rhs];
+              });
+    if (std::is_sorted(order.begin(), order.end())) {
+      continue;
+    }
+    std::vector<uint32_t> new_index(order.size());
+    std::vector<std::string> sorted_strings;
+    sorted_strings.reserve(order.size());
+    for (uint32_t i = 0; i != order.size(); ++i) {
+      new_index[order[i]] = i;
+      sorted_strings.push_back(std::move(deps->strings_[order[i]]));
+    }
+    deps->strings_ = std::move(sorted_strings);
+    auto remap = [&](dex::StringIndex string_id) {
+      return (string_id.index_ < num_ids_in_dex)
+          ? string_id
+          : dex::StringIndex(num_ids_in_dex + new_index[string_id.index_ - num_ids_in_dex]);
+    };
+    for (std::set<TypeAssignability>& set : deps->assignable_types_) {
+      std::set<TypeAssignability> remapped;
+      for (const TypeAssignability& assignability : set) {
+        remapped.emplace(remap(assignability.GetDestination()), remap(assignability.GetSource()));
+      }
+      set = std::move(remapped);
+    }
+  }
+}
+
 VerifierDeps::DexFileDeps* VerifierDeps::GetDexFileDeps(const DexFile& dex_file) {
   auto it = dex_deps_.find(&dex_file);
   return (it == dex_deps_.end()) ? nullptr : it->second.get();
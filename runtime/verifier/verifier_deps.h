@@ -73,6 +73,12 @@ class VerifierDeps {
   // same set of dex files.
   void MergeWith(std::unique_ptr<VerifierDeps> other, const std::vector<const DexFile*>& dex_files);
 
+  // Sort the extra strings of each dex file and renumber the recorded dependencies
+  // accordingly. Extra string ids are assigned in the order in which verifier threads
+  // first see the strings, so this makes the encoded data independent of the thread
+  // count and scheduling. Must not run concurrently with recording dependencies.
+  void Canonicalize();
+
   // Record information that a class was verified.
   // Note that this function is different from MaybeRecordVerificationStatus() which
   // looks up thread-local VerifierDeps first.
@@ -257,6 +263,7 @@ class VerifierDeps {
   ART_FRIEND_TEST(VerifierDepsTest, StringToId);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecode);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecodeMulti);
+  ART_FRIEND_TEST(VerifierDepsTest, CanonicalExtraStrings);
   ART_FRIEND_TEST(VerifierDepsTest, VerifyDeps);
   ART_FRIEND_TEST(VerifierDepsTest, CompilerDriver);
 };
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+  // Lengths around the 16-byte vector size of the intrinsics.
+  private static final int MAX_LENGTH = 70;
+
+  public static void main(String[] args) {
+    for (int length = 0; length <= MAX_LENGTH; ++length) {
+      testFill(length);
+      testEquals(length);
+      testHashCode(length);
+    }
+    testNull();
+    System.out.println("passed");
+  }
+
+  /// CHECK-START: void Main.$noinline$fill(byte[], byte) builder (after)
+  /// CHECK: InvokeStaticOrDirect intrinsic:ArraysFillByte
+  private static void $noinline$fill(byte[] array, byte value) {
+    Arrays.fill(array, value);
+  }
+
+  /// CHECK-START: void Main.$noinline$fill(int[], int) builder (after)
+  /// CHECK: InvokeStaticOrDirect intrinsic:ArraysFillInt
+  private static void $noinline$fill(int[] array, int value) {
+    Arrays.fill(array, value);
+  }
+
+  /// CHECK-START: boolean Main.$noinline$equals(byte[], byte[]) builder (after)
+  /// CHECK: InvokeStaticOrDirect intrinsic:ArraysEqualsByte
+  private static boolean $noinline$equals(byte[] a, byte[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  /// CHECK-START: boolean Main.$noinline$equals(int[], int[]) builder (after)
+  /// CHECK: InvokeStaticOrDirect intrinsic:ArraysEqualsInt
+  private static boolean $noinline$equals(int[] a, int[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  /// CHECK-START: int Main.$noinline$hashCode(int[]) builder (after)
+  /// CHECK: InvokeStaticOrDirect intrinsic:ArraysHashCodeInt
+  private static int $noinline$hashCode(int[] array) {
+    return Arrays.hashCode(array);
+  }
+
+  private static void testFill(int length) {
+    byte[] bytes = new byte[length + 1];
+    byte[] byteSlice = new byte[length];
+    $noinline$fill(byteSlice, (byte) -3);
+    for (int i = 0; i < length; ++i) {
+      assertEquals(-3, byteSlice[i]);
+    }
+    $noinline$fill(bytes, (byte) 0x7f);
+    for (int i = 0; i <= length; ++i) {
+      assertEquals(0x7f, bytes[i]);
+    }
+
+    int[] ints = new int[length];
+    $noinline$fill(ints, 0x12345678);
+    for (int i = 0; i < length; ++i) {
+      assertEquals(0x12345678, ints[i]);
+    }
+  }
+
+  private static void testEquals(int length) {
+    byte[] bytes1 = new byte[length];
+    byte[] bytes2 = new byte[length];
+    int[] ints1 = new int[length];
+    int[] ints2 = new int[length];
+    for (int i = 0; i < length; ++i) {
+      bytes1[i] = bytes2[i] = (byte) (i * 7);
+      ints1[i] = ints2[i] = i * 0x01010101;
+    }
+    assertTrue($noinline$equals(bytes1, bytes1));
+    assertTrue($noinline$equals(bytes1, bytes2));
+    assertTrue($noinline$equals(ints1, ints1));
+    assertTrue($noinline$equals(ints1, ints2));
+    // A difference in any single element.
+    for (int i = 0; i < length; ++i) {
+      bytes2[i] ^= (byte) 0x80;
+      assertFalse($noinline$equals(bytes1, bytes2));
+      bytes2[i] ^= (byte) 0x80;
+      ints2[i] ^= 0x80000000;
+      assertFalse($noinline$equals(ints1, ints2));
+      ints2[i] ^= 0x80000000;
+    }
+    // Different lengths.
+    assertFalse($noinline$equals(bytes1, new byte[length + 1]));
+    assertFalse($noinline$equals(ints1, new int[length + 1]));
+  }
+
+  private static void testHashCode(int length) {
+    int[] ints = new int[length];
+    for (int i = 0; i < length; ++i) {
+      ints[i] = i * 0x9e3779b9;
+    }
+    int expected = 1;
+    for (int value : ints) {
+      expected = 31 * expected + value;
+    }
+    assertEquals(expected, $noinline$hashCode(ints));
+  }
+
+  private static void testNull() {
+    assertTrue($noinline$equals((byte[]) null, (byte[]) null));
+    assertFalse($noinline$equals(new byte[0], (byte[]) null));
+    assertFalse($noinline$equals((int[]) null, new int[0]));
+    assertEquals(0, $noinline$hashCode(null));
+    try {
+      $noinline$fill((int[]) null, 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    try {
+      $noinline$fill((byte[]) null, (byte) 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+  }
+
+  private static void assertEquals(int expected, int actual) {
+    if (expected != actual) {
+      throw new Error("Expected: " + expected + ", found: " + actual);
+    }
+  }
+
+  private static void assertTrue(boolean condition) {
+    if (!condition) {
+      throw new Error("Expected true");
+    }
+  }
+
+  private static void assertFalse(boolean condition) {
+    if (condition) {
+      throw new Error("Expected false");
+    }
+  }
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Methods are laid out in the order of their names unless calls say otherwise.
+class CodeLayout {
+    static int a0Caller(int x) {
+        return a3Callee(x) + 1;
+    }
+
+    static int a1Other(int x) {
+        return x * 11 + 5;
+    }
+
+    static int a2Other(int x) {
+        return x * 13 + 7;
+    }
+
+    // The try block keeps the compiler from inlining this method into its caller.
+    static int a3Callee(int x) {
+        try {
+            return 100 / x;
+        } catch (ArithmeticException e) {
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Methods compiled by dex2oat and reused from the compilation record or the compiled
+// method cache. CompilationRecordModified changes only the body of callee().
+class CompilationRecord {
+    static int callee() {
+        return 1;
+    }
+
+    static int caller() {
+        return callee() + 1;
+    }
+
+    static int unchanged(int x) {
+        return x * 3 + 7;
+    }
+
+    int unchangedToo(int[] array) {
+        int sum = 0;
+        for (int value : array) {
+            sum += value;
+        }
+        return sum;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package vtable1;
+
+// With the 11 methods of java.lang.Object, the vtable has 72 entries.
+public class Base {
+    void m() {}
+    public void v00() {}
+    public void v01() {}
+    public void v02() {}
+    public void v03() {}
+    public void v04() {}
+    public void v05() {}
+    public void v06() {}
+    public void v07() {}
+    public void v08() {}
+    public void v09() {}
+    public void v10() {}
+    public void v11() {}
+    public void v12() {}
+    public void v13() {}
+    public void v14() {}
+    public void v15() {}
+    public void v16() {}
+    public void v17() {}
+    public void v18() {}
+    public void v19() {}
+    public void v20() {}
+    public void v21() {}
+    public void v22() {}
+    public void v23() {}
+    public void v24() {}
+    public void v25() {}
+    public void v26() {}
+    public void v27() {}
+    public void v28() {}
+    public void v29() {}
+    public void v30() {}
+    public void v31() {}
+    public void v32() {}
+    public void v33() {}
+    public void v34() {}
+    public void v35() {}
+    public void v36() {}
+    public void v37() {}
+    public void v38() {}
+    public void v39() {}
+    public void v40() {}
+    public void v41() {}
+    public void v42() {}
+    public void v43() {}
+    public void v44() {}
+    public void v45() {}
+    public void v46() {}
+    public void v47() {}
+    public void v48() {}
+    public void v49() {}
+    public void v50() {}
+    public void v51() {}
+    public void v52() {}
+    public void v53() {}
+    public void v54() {}
+    public void v55() {}
+    public void v56() {}
+    public void v57() {}
+    public void v58() {}
+    public void v59() {}
+}
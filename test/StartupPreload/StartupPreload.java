@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Classes of an app whose profile lists some of them as startup classes.
+class Listed {
+    int field;
+}
+
+class AlsoListed extends Listed {
+    void method() {
+        field = 1;
+    }
+}
+
+class NotListed {
+}
+
+// Only sets its static fields to constant values when initialized.
+class ConstantStatics {
+    static final int INT = 42;
+    static final String STRING = "constant";
+}
+
+class WithClinit {
+    static int value = compute();
+
+    static int compute() {
+        return 42;
+    }
+}
+
+class SuperWithClinit {
+    static Object object = new Object();
+}
+
+class SubOfClinit extends SuperWithClinit {
+}
+
+interface IfaceWithClinit {
+    Object OBJECT = new Object();
+
+    default int method() {
+        return 42;
+    }
+}
+
+class ImplOfIface implements IfaceWithClinit {
+}